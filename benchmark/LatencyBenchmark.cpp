@@ -0,0 +1,414 @@
+#include "LatencyHistogram.h"
+#include "utilities.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*----------------------------------------------------------------------------*/
+/*-----------------------------------------------------------------------------
+Handoff latency, enqueue to dequeue, of every queue under every wait strategy.
+
+One producer sends at a fixed rate (open loop): message i is due at
+start + i / rate on steady_clock, whether or not the queue kept up with the
+messages before it. The latency of a message is taken from the time it was
+due, not from the time enqueue() was called, so a stall of the producer
+(a full queue, a slow wakeup) is charged to every message it delayed. This
+corrects for coordinated omission: a closed-loop sender waits out a stall and
+records one slow sample where a real client would have seen many. The raw
+columns, taken from the time enqueue() was called, show what the closed-loop
+view would have reported.
+
+The producer and consumer threads live for the whole run; the messages due
+in the warmup period are passed but not recorded. Each consumer records
+into its own nanosecond histogram (see LatencyHistogram), merged at the end.
+
+Build with -DCMAKE_BUILD_TYPE=Release; run with --help for the options.
+------------------------------------------------------------------------------*/
+
+struct Message
+{
+    // Nanoseconds on steady_clock
+    std::int64_t dueTime;
+    std::int64_t sendTime;
+};
+
+using Kind = QueueKind< Message >;
+
+/*----------------------------------------------------------------------------*/
+
+struct Options
+{
+    std::vector< std::string > queues;
+    std::vector< std::string > strategies;
+    std::size_t rate = 100000;
+    std::size_t consumers = 1;
+    std::size_t capacity = 1024;
+    std::size_t warmupMilliseconds = 500;
+    std::size_t durationMilliseconds = 2000;
+    bool pin = true;
+    std::string csvPath;
+};
+
+/*----------------------------------------------------------------------------*/
+
+struct Result
+{
+    const Kind * pKind;
+    const char * strategy;
+
+    // From the due time, and from the enqueue() call
+    LatencyHistogram corrected;
+    LatencyHistogram raw;
+};
+
+/*----------------------------------------------------------------------------*/
+
+constexpr double g_percentiles[] { 50, 99, 99.9, 99.99 };
+
+/*----------------------------------------------------------------------------*/
+
+void usage ( std::ostream & _rOut )
+{
+    _rOut
+        <<  "Usage: queue_latency [options]\n"
+            "  --queues a,b,...      queues to run (default: all)\n"
+            "  --strategies a,b,...  wait strategies to run (default: all):\n"
+            "                        block, spin, spin-then-yield,\n"
+            "                        spin-then-block\n"
+            "  --rate 100000         messages per second\n"
+            "  --consumers 1         consumer threads\n"
+            "  --capacity 1024       queue capacity\n"
+            "  --warmup 500          milliseconds sent but not recorded\n"
+            "  --duration 2000       milliseconds recorded\n"
+            "  --no-pin              do not pin threads to cores\n"
+            "  --csv FILE            write the percentiles as CSV\n"
+            "  --quick               a short run, for a smoke test\n"
+            "Queues:";
+
+    for ( const Kind & kind: queueKinds< Message >() )
+        _rOut << " " << kind.name;
+    _rOut << "\n";
+}
+
+/*----------------------------------------------------------------------------*/
+
+Options parseOptions ( int _argc, char ** _argv )
+{
+    Options options;
+
+    for ( int i = 1; i < _argc; ++i )
+    {
+        const std::string argument = _argv[ i ];
+
+        auto value = [ & ] () -> std::string {
+            if ( i + 1 >= _argc )
+                throw std::invalid_argument( argument + " needs a value" );
+            return _argv[ ++i ];
+        };
+
+        if ( argument == "--help" || argument == "-h" )
+        {
+            usage( std::cout );
+            std::exit( EXIT_SUCCESS );
+        }
+        else if ( argument == "--queues" )
+            options.queues = splitList( value() );
+        else if ( argument == "--strategies" )
+            options.strategies = splitList( value() );
+        else if ( argument == "--rate" )
+            options.rate = parseCounts( value() ).at( 0 );
+        else if ( argument == "--consumers" )
+            options.consumers = parseCounts( value() ).at( 0 );
+        else if ( argument == "--capacity" )
+            options.capacity = parseCounts( value() ).at( 0 );
+        else if ( argument == "--warmup" )
+            options.warmupMilliseconds = std::stoul( value() );
+        else if ( argument == "--duration" )
+            options.durationMilliseconds = parseCounts( value() ).at( 0 );
+        else if ( argument == "--no-pin" )
+            options.pin = false;
+        else if ( argument == "--csv" )
+            options.csvPath = value();
+        else if ( argument == "--quick" )
+        {
+            options.rate = 20000;
+            options.capacity = 256;
+            options.warmupMilliseconds = 20;
+            options.durationMilliseconds = 100;
+        }
+        else
+            throw std::invalid_argument( "unknown option " + argument );
+    }
+
+    return options;
+}
+
+/*----------------------------------------------------------------------------*/
+
+void run (
+        Result & _rResult
+    ,   const Options & _options
+    ,   WaitStrategy _waitStrategy
+)
+{
+    auto pQueue =
+        _rResult.pKind->create( _options.capacity, _waitStrategy );
+
+    const std::int64_t interval = 1000000000 / _options.rate;
+    const std::size_t total =
+            ( _options.warmupMilliseconds + _options.durationMilliseconds )
+        *   _options.rate / 1000;
+
+    std::vector< Message > messages( total );
+    Message stop {};
+
+    // Histograms are large: allocated before the clock starts
+    std::vector< LatencyHistogram > corrected( _options.consumers );
+    std::vector< LatencyHistogram > raw( _options.consumers );
+
+    std::atomic< bool > go( false );
+    std::atomic< std::int64_t > start( 0 );
+    std::vector< std::thread > threads;
+
+    threads.emplace_back( [ & ] {
+        while ( !go.load( std::memory_order_acquire ) )
+            std::this_thread::yield();
+
+        const std::int64_t firstDue = start.load();
+        for ( std::size_t i = 0; i < total; ++i )
+        {
+            Message & message = messages[ i ];
+            message.dueTime = firstDue + std::int64_t( i ) * interval;
+
+            waitUntil( message.dueTime );
+
+            message.sendTime = nowNanoseconds();
+            pQueue->enqueue( &message );
+        }
+
+        for ( std::size_t c = 0; c < _options.consumers; ++c )
+            pQueue->enqueue( &stop );
+    } );
+
+    for ( std::size_t c = 0; c < _options.consumers; ++c )
+        threads.emplace_back( [ &, c ] {
+            while ( !go.load( std::memory_order_acquire ) )
+                std::this_thread::yield();
+
+            const std::int64_t recordFrom =
+                    start.load()
+                +   std::int64_t( _options.warmupMilliseconds ) * 1000000;
+
+            for (
+                Message * pMessage = pQueue->dequeue();
+                pMessage != &stop;
+                pMessage = pQueue->dequeue()
+            )
+            {
+                const std::int64_t now = nowNanoseconds();
+                if ( pMessage->dueTime < recordFrom )
+                    continue;
+
+                corrected[ c ].record( now - pMessage->dueTime );
+                raw[ c ].record( now - pMessage->sendTime );
+            }
+        } );
+
+    // The producer takes the first core, consumers the next ones
+    if ( _options.pin )
+        for ( std::size_t i = 0; i < threads.size(); ++i )
+            pinToCore( threads[ i ], i );
+
+    // A little headroom so that the first message is not already late
+    start.store( nowNanoseconds() + 1000000 );
+    go.store( true, std::memory_order_release );
+
+    for ( auto & thread: threads )
+        thread.join();
+
+    for ( std::size_t c = 0; c < _options.consumers; ++c )
+    {
+        _rResult.corrected.merge( corrected[ c ] );
+        _rResult.raw.merge( raw[ c ] );
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+void printHeader ()
+{
+    std::cout
+        <<  std::left << std::setw( 11 ) << "queue"
+        <<  std::setw( 16 ) << "strategy" << std::right
+        <<  std::setw( 9 ) << "count"
+        <<  std::setw( 10 ) << "p50"
+        <<  std::setw( 10 ) << "p99"
+        <<  std::setw( 10 ) << "p99.9"
+        <<  std::setw( 10 ) << "p99.99"
+        <<  std::setw( 11 ) << "max"
+        <<  std::setw( 11 ) << "raw p99.9"
+        <<  std::setw( 11 ) << "raw max"
+        <<  std::endl;
+}
+
+/*----------------------------------------------------------------------------*/
+
+void printRow ( const Result & _result )
+{
+    std::cout
+        <<  std::left << std::setw( 11 ) << _result.pKind->name
+        <<  std::setw( 16 ) << _result.strategy << std::right
+        <<  std::setw( 9 ) << _result.corrected.count();
+
+    for ( double percentile: g_percentiles )
+        std::cout
+            <<  std::setw( 10 ) << _result.corrected.percentile( percentile );
+
+    std::cout
+        <<  std::setw( 11 ) << _result.corrected.max()
+        <<  std::setw( 11 ) << _result.raw.percentile( 99.9 )
+        <<  std::setw( 11 ) << _result.raw.max()
+        <<  std::endl;
+}
+
+/*----------------------------------------------------------------------------*/
+
+void writeCsv (
+        const std::string & _path
+    ,   const std::vector< Result > & _results
+)
+{
+    std::ofstream out( _path );
+    if ( !out )
+        throw std::runtime_error( "cannot write " + _path );
+
+    out <<  "queue,strategy,count,p50_ns,p99_ns,p99.9_ns,p99.99_ns,max_ns,"
+            "raw_p50_ns,raw_p99_ns,raw_p99.9_ns,raw_p99.99_ns,raw_max_ns\n";
+
+    for ( const Result & result: _results )
+    {
+        out <<  result.pKind->name
+            <<  ',' << result.strategy
+            <<  ',' << result.corrected.count();
+
+        for ( const LatencyHistogram * pHistogram: {
+                &result.corrected, &result.raw
+            } )
+        {
+            for ( double percentile: g_percentiles )
+                out << ',' << pHistogram->percentile( percentile );
+            out << ',' << pHistogram->max();
+        }
+
+        out << '\n';
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+int main ( int _argc, char ** _argv )
+{
+    Options options;
+    try
+    {
+        options = parseOptions( _argc, _argv );
+    }
+    catch ( const std::exception & _error )
+    {
+        std::cerr << "queue_latency: " << _error.what() << "\n";
+        usage( std::cerr );
+        return EXIT_FAILURE;
+    }
+
+    const auto kinds = selectQueues< Message >( options.queues );
+    if ( kinds.empty() )
+    {
+        std::cerr << "queue_latency: no known queue selected\n";
+        usage( std::cerr );
+        return EXIT_FAILURE;
+    }
+
+    std::vector< std::pair< const char *, WaitStrategy > > strategies;
+    for ( const auto & strategy: g_waitStrategies )
+        if (
+                options.strategies.empty()
+            ||  std::find(
+                        options.strategies.begin()
+                    ,   options.strategies.end()
+                    ,   strategy.first
+                ) != options.strategies.end()
+        )
+            strategies.push_back( strategy );
+
+    if ( strategies.empty() )
+    {
+        std::cerr << "queue_latency: no known strategy selected\n";
+        usage( std::cerr );
+        return EXIT_FAILURE;
+    }
+
+#if !defined( NDEBUG )
+    std::cout << "Warning: assertions are on, numbers are not representative"
+              << std::endl;
+#endif
+
+    std::cout
+        <<  options.rate << " messages/s, " << options.consumers
+        <<  " consumer(s), capacity " << options.capacity
+        <<  "; latencies in nanoseconds" << std::endl;
+    printHeader();
+
+    std::vector< Result > results;
+
+    for ( const Kind * pKind: kinds )
+    {
+        if ( pKind->spsc && options.consumers > 1 )
+            continue;
+
+        for ( const auto & strategy: strategies )
+        {
+            // Spinning threads sharing a core only hand over on preemption
+            if (
+                    strategy.second == WaitStrategy::Spin
+                &&  std::thread::hardware_concurrency() < options.consumers + 1
+            )
+            {
+                std::cout
+                    <<  std::left << std::setw( 11 ) << pKind->name
+                    <<  std::setw( 16 ) << strategy.first << std::right
+                    <<  "skipped: needs " << options.consumers + 1
+                    <<  " hardware threads" << std::endl;
+                continue;
+            }
+
+            results.push_back( { pKind, strategy.first, {}, {} } );
+            run( results.back(), options, strategy.second );
+            printRow( results.back() );
+        }
+    }
+
+    try
+    {
+        if ( !options.csvPath.empty() )
+            writeCsv( options.csvPath, results );
+    }
+    catch ( const std::exception & _error )
+    {
+        std::cerr << "queue_latency: " << _error.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/*----------------------------------------------------------------------------*/
@@ -0,0 +1,127 @@
+#include "LatencyHistogram.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+/*----------------------------------------------------------------------------*/
+
+namespace
+{
+
+// Counters per power-of-two range above the linear part
+constexpr std::size_t s_subBucketBits = 10;
+constexpr std::size_t s_subBucketCount = std::size_t( 1 ) << s_subBucketBits;
+
+// Values below this get a counter each
+constexpr std::uint64_t s_linearLimit = 2 * s_subBucketCount;
+
+constexpr std::size_t s_counterCount =
+    ( std::bit_width( LatencyHistogram::s_maxValue ) - s_subBucketBits )
+        * s_subBucketCount
+    +   s_subBucketCount;
+
+} // namespace
+
+/*----------------------------------------------------------------------------*/
+
+LatencyHistogram::LatencyHistogram ()
+    :   m_counts( s_counterCount, 0 )
+    ,   m_totalCount( 0 )
+    ,   m_max( 0 )
+{
+}
+
+/*----------------------------------------------------------------------------*/
+
+void
+LatencyHistogram::record ( std::uint64_t _value ) noexcept
+{
+    _value = std::min( _value, s_maxValue );
+
+    ++m_counts[ indexOf( _value ) ];
+    ++m_totalCount;
+    m_max = std::max( m_max, _value );
+}
+
+/*----------------------------------------------------------------------------*/
+
+void
+LatencyHistogram::merge ( const LatencyHistogram & _other ) noexcept
+{
+    for ( std::size_t i = 0; i < m_counts.size(); ++i )
+        m_counts[ i ] += _other.m_counts[ i ];
+
+    m_totalCount += _other.m_totalCount;
+    m_max = std::max( m_max, _other.m_max );
+}
+
+/*----------------------------------------------------------------------------*/
+
+std::uint64_t
+LatencyHistogram::count () const noexcept
+{
+    return m_totalCount;
+}
+
+/*----------------------------------------------------------------------------*/
+
+std::uint64_t
+LatencyHistogram::max () const noexcept
+{
+    return m_max;
+}
+
+/*----------------------------------------------------------------------------*/
+
+std::uint64_t
+LatencyHistogram::percentile ( double _percentile ) const noexcept
+{
+    if ( m_totalCount == 0 )
+        return 0;
+
+    const double share = std::clamp( _percentile, 0.0, 100.0 ) / 100;
+    const std::uint64_t rank = std::max< std::uint64_t >(
+            static_cast< std::uint64_t >( std::ceil( share * m_totalCount ) )
+        ,   1
+    );
+
+    std::uint64_t seen = 0;
+    for ( std::size_t i = 0; i < m_counts.size(); ++i )
+    {
+        seen += m_counts[ i ];
+        if ( seen >= rank )
+            return std::min( highestValueAt( i ), m_max );
+    }
+
+    return m_max;
+}
+
+/*----------------------------------------------------------------------------*/
+
+std::size_t
+LatencyHistogram::indexOf ( std::uint64_t _value ) noexcept
+{
+    if ( _value < s_linearLimit )
+        return static_cast< std::size_t >( _value );
+
+    // _value >> shift lies in [ s_subBucketCount, 2 * s_subBucketCount )
+    const std::size_t shift = std::bit_width( _value ) - s_subBucketBits - 1;
+    return shift * s_subBucketCount
+        +   static_cast< std::size_t >( _value >> shift );
+}
+
+/*----------------------------------------------------------------------------*/
+
+std::uint64_t
+LatencyHistogram::highestValueAt ( std::size_t _index ) noexcept
+{
+    if ( _index < s_linearLimit )
+        return _index;
+
+    const std::size_t shift = _index / s_subBucketCount - 1;
+    const std::uint64_t subBucket = _index - shift * s_subBucketCount;
+    return ( ( subBucket + 1 ) << shift ) - 1;
+}
+
+/*----------------------------------------------------------------------------*/
@@ -0,0 +1,62 @@
+#ifndef __SHAREDQUEUE_BENCHMARK_LATENCYHISTOGRAM_H__
+#define __SHAREDQUEUE_BENCHMARK_LATENCYHISTOGRAM_H__
+
+/*----------------------------------------------------------------------------*/
+
+#include <cstdint>
+#include <vector>
+
+/*----------------------------------------------------------------------------*/
+
+/**
+ * @class LatencyHistogram
+ *
+ * @brief HDR-style histogram of nanosecond values with three significant
+ *        digits over the whole range, in a fixed 248 KiB of counters.
+ *
+ * Values below 2048 get a counter each; above, every power-of-two range is
+ * split into 1024 equal counters, so a recorded value is off by at most one
+ * part in 1024 whatever its magnitude. Recording is an index computation and
+ * an increment, cheap enough for the measuring thread itself.
+ *
+ * Values beyond s_maxValue (about 18 minutes) are recorded as s_maxValue.
+ */
+class LatencyHistogram
+{
+public:
+
+    static constexpr std::uint64_t s_maxValue =
+        ( std::uint64_t( 1 ) << 40 ) - 1;
+
+    LatencyHistogram ();
+
+    void record ( std::uint64_t _value ) noexcept;
+
+    void merge ( const LatencyHistogram & _other ) noexcept;
+
+    std::uint64_t count () const noexcept;
+
+    std::uint64_t max () const noexcept;
+
+    /**
+     * @brief The highest value of the counter holding the _percentile-th
+     *        percentile (0 to 100), never more than max().
+     */
+    std::uint64_t percentile ( double _percentile ) const noexcept;
+
+private:
+
+    static std::size_t indexOf ( std::uint64_t _value ) noexcept;
+
+    static std::uint64_t highestValueAt ( std::size_t _index ) noexcept;
+
+private:
+
+    std::vector< std::uint64_t > m_counts;
+    std::uint64_t m_totalCount;
+    std::uint64_t m_max;
+};
+
+/*----------------------------------------------------------------------------*/
+
+#endif // __SHAREDQUEUE_BENCHMARK_LATENCYHISTOGRAM_H__
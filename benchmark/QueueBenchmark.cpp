@@ -0,0 +1,537 @@
+#include "utilities.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+/*----------------------------------------------------------------------------*/
+/*-----------------------------------------------------------------------------
+Throughput matrix: every queue x producers x consumers x capacity x batch size.
+
+A trial starts all threads, already created and pinned, at once and stops the
+clock when the last consumer has its share of the items; warmup trials run
+first and are not reported. Each configuration reports the median, minimum
+and maximum over its trials, and the scaling efficiency of the median against
+the same queue, capacity and batch size with one producer and one consumer:
+
+    efficiency = ( ops/s / ops/s at 1x1 ) / ( ( producers + consumers ) / 2 )
+
+so 1.0 means throughput grows in proportion to the threads added.
+
+Build with -DCMAKE_BUILD_TYPE=Release; run with --help for the options.
+------------------------------------------------------------------------------*/
+
+using Clock = std::chrono::steady_clock;
+
+using Kind = QueueKind< int >;
+
+/*----------------------------------------------------------------------------*/
+
+struct Options
+{
+    std::vector< std::string > queues;
+    std::vector< std::size_t > producers { 1, 2, 4 };
+    std::vector< std::size_t > consumers { 1, 2, 4 };
+    std::vector< std::size_t > capacities { 1024 };
+    std::vector< std::size_t > batchSizes { 1, 32 };
+    std::size_t items = 200000;
+    std::size_t warmups = 1;
+    std::size_t trials = 5;
+    std::string strategy = "block";
+    bool pin = true;
+    std::string jsonPath;
+    std::string csvPath;
+};
+
+/*----------------------------------------------------------------------------*/
+
+struct Config
+{
+    const Kind * pKind;
+    std::size_t producers;
+    std::size_t consumers;
+    std::size_t capacity;
+    std::size_t batchSize;
+};
+
+struct Result
+{
+    Config config;
+    std::vector< double > opsPerSecond; // one per trial, sorted
+
+    double median () const { return opsPerSecond[ opsPerSecond.size() / 2 ]; }
+
+    double nsPerOp () const { return 1e9 / median(); }
+
+    // Negative when the sweep has no 1x1 baseline for this configuration
+    double efficiency = -1;
+};
+
+/*----------------------------------------------------------------------------*/
+
+void usage ( std::ostream & _rOut )
+{
+    _rOut
+        <<  "Usage: queue_benchmark [options]\n"
+            "  --queues a,b,...      queues to run (default: all)\n"
+            "  --producers 1,2,4     producer thread counts\n"
+            "  --consumers 1,2,4     consumer thread counts\n"
+            "  --capacity 1024       queue capacities\n"
+            "  --batch 1,32          batch sizes; 1 uses enqueue/dequeue,\n"
+            "                        more uses enqueueBulk/dequeueBulk\n"
+            "  --items 200000        items passed per trial\n"
+            "  --warmup 1            unreported trials per configuration\n"
+            "  --trials 5            reported trials per configuration\n"
+            "  --strategy block      block, spin, spin-then-yield or\n"
+            "                        spin-then-block\n"
+            "  --no-pin              do not pin threads to cores\n"
+            "  --json FILE           write the results as JSON\n"
+            "  --csv FILE            write the results as CSV\n"
+            "  --quick               a small matrix, for a smoke run\n"
+            "Queues:";
+
+    for ( const Kind & kind: queueKinds< int >() )
+        _rOut << " " << kind.name;
+    _rOut << "\n";
+}
+
+/*----------------------------------------------------------------------------*/
+
+Options parseOptions ( int _argc, char ** _argv )
+{
+    Options options;
+
+    for ( int i = 1; i < _argc; ++i )
+    {
+        const std::string argument = _argv[ i ];
+
+        auto value = [ & ] () -> std::string {
+            if ( i + 1 >= _argc )
+                throw std::invalid_argument( argument + " needs a value" );
+            return _argv[ ++i ];
+        };
+
+        if ( argument == "--help" || argument == "-h" )
+        {
+            usage( std::cout );
+            std::exit( EXIT_SUCCESS );
+        }
+        else if ( argument == "--queues" )
+            options.queues = splitList( value() );
+        else if ( argument == "--producers" )
+            options.producers = parseCounts( value() );
+        else if ( argument == "--consumers" )
+            options.consumers = parseCounts( value() );
+        else if ( argument == "--capacity" )
+            options.capacities = parseCounts( value() );
+        else if ( argument == "--batch" )
+            options.batchSizes = parseCounts( value() );
+        else if ( argument == "--items" )
+            options.items = parseCounts( value() ).at( 0 );
+        else if ( argument == "--warmup" )
+            options.warmups = std::stoul( value() );
+        else if ( argument == "--trials" )
+            options.trials = parseCounts( value() ).at( 0 );
+        else if ( argument == "--strategy" )
+            options.strategy = value();
+        else if ( argument == "--no-pin" )
+            options.pin = false;
+        else if ( argument == "--json" )
+            options.jsonPath = value();
+        else if ( argument == "--csv" )
+            options.csvPath = value();
+        else if ( argument == "--quick" )
+        {
+            options.producers = { 1, 2 };
+            options.consumers = { 1, 2 };
+            options.capacities = { 256 };
+            options.batchSizes = { 1, 16 };
+            options.items = 20000;
+            options.warmups = 0;
+            options.trials = 1;
+        }
+        else
+            throw std::invalid_argument( "unknown option " + argument );
+    }
+
+    return options;
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Every producer sends, and every consumer takes, an exact share of the
+// items, so a trial ends without timeouts or end markers
+std::size_t shareOf (
+        std::size_t _items
+    ,   std::size_t _threads
+    ,   std::size_t _index
+)
+{
+    return _items / _threads + ( _index < _items % _threads ? 1 : 0 );
+}
+
+/*----------------------------------------------------------------------------*/
+
+double runTrial (
+        const Config & _config
+    ,   const Options & _options
+    ,   WaitStrategy _waitStrategy
+)
+{
+    auto pQueue = _config.pKind->create( _config.capacity, _waitStrategy );
+
+    int value = 0;
+    const std::size_t batchSize = _config.batchSize;
+
+    std::atomic< bool > go( false );
+    std::atomic< std::size_t > ready( 0 );
+    std::vector< std::thread > threads;
+
+    for ( std::size_t p = 0; p < _config.producers; ++p )
+    {
+        const std::size_t share =
+            shareOf( _options.items, _config.producers, p );
+        threads.emplace_back( [ &, share ] {
+            std::vector< int * > batch( batchSize, &value );
+
+            ready.fetch_add( 1 );
+            while ( !go.load( std::memory_order_acquire ) )
+                std::this_thread::yield();
+
+            if ( batchSize == 1 )
+            {
+                for ( std::size_t i = 0; i < share; ++i )
+                    pQueue->enqueue( &value );
+                return;
+            }
+
+            for ( std::size_t pushed = 0; pushed < share; )
+            {
+                const std::size_t count = std::min( batchSize, share - pushed );
+                pQueue->enqueueBulk( batch.data(), count );
+                pushed += count;
+            }
+        } );
+    }
+
+    for ( std::size_t c = 0; c < _config.consumers; ++c )
+    {
+        const std::size_t share =
+            shareOf( _options.items, _config.consumers, c );
+        threads.emplace_back( [ &, share ] {
+            std::vector< int * > batch( batchSize );
+
+            ready.fetch_add( 1 );
+            while ( !go.load( std::memory_order_acquire ) )
+                std::this_thread::yield();
+
+            if ( batchSize == 1 )
+            {
+                for ( std::size_t i = 0; i < share; ++i )
+                    pQueue->dequeue();
+                return;
+            }
+
+            for ( std::size_t popped = 0; popped < share; )
+                popped += pQueue->dequeueBulk(
+                    batch.data(), std::min( batchSize, share - popped )
+                );
+        } );
+    }
+
+    // Producers take the first cores, consumers the next ones
+    if ( _options.pin )
+        for ( std::size_t i = 0; i < threads.size(); ++i )
+            pinToCore( threads[ i ], i );
+
+    // Thread creation stays out of the measurement
+    while ( ready.load() < threads.size() )
+        std::this_thread::yield();
+
+    const Clock::time_point start = Clock::now();
+    go.store( true, std::memory_order_release );
+
+    for ( auto & thread: threads )
+        thread.join();
+
+    const double seconds =
+        std::chrono::duration< double >( Clock::now() - start ).count();
+
+    return _options.items / std::max( seconds, 1e-9 );
+}
+
+/*----------------------------------------------------------------------------*/
+
+Result runConfig (
+        const Config & _config
+    ,   const Options & _options
+    ,   WaitStrategy _waitStrategy
+)
+{
+    for ( std::size_t i = 0; i < _options.warmups; ++i )
+        runTrial( _config, _options, _waitStrategy );
+
+    Result result { _config, {} };
+    for ( std::size_t i = 0; i < _options.trials; ++i )
+        result.opsPerSecond.push_back(
+            runTrial( _config, _options, _waitStrategy )
+        );
+
+    std::sort( result.opsPerSecond.begin(), result.opsPerSecond.end() );
+    return result;
+}
+
+/*----------------------------------------------------------------------------*/
+
+void computeEfficiency ( std::vector< Result > & _rResults )
+{
+    // Baselines keyed by queue, capacity and batch size
+    std::map< std::tuple< std::string, std::size_t, std::size_t >, double >
+        baselines;
+
+    for ( const Result & result: _rResults )
+    {
+        const Config & config = result.config;
+        if ( config.producers == 1 && config.consumers == 1 )
+            baselines[ {
+                config.pKind->name, config.capacity, config.batchSize
+            } ] = result.median();
+    }
+
+    for ( Result & result: _rResults )
+    {
+        const Config & config = result.config;
+        const auto found = baselines.find( {
+            config.pKind->name, config.capacity, config.batchSize
+        } );
+        if ( found == baselines.end() )
+            continue;
+
+        const double threads = config.producers + config.consumers;
+        result.efficiency = result.median() / found->second / ( threads / 2 );
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+void printRow ( const Result & _result )
+{
+    const Config & config = _result.config;
+
+    std::cout
+        <<  std::left << std::setw( 11 ) << config.pKind->name << std::right
+        <<  std::setw( 4 ) << config.producers
+        <<  std::setw( 4 ) << config.consumers
+        <<  std::setw( 9 ) << config.capacity
+        <<  std::setw( 7 ) << config.batchSize
+        <<  std::setw( 14 ) << static_cast< long long >( _result.median() )
+        <<  std::setw( 14 )
+        <<  static_cast< long long >( _result.opsPerSecond.front() )
+        <<  std::setw( 14 )
+        <<  static_cast< long long >( _result.opsPerSecond.back() )
+        <<  std::setw( 9 ) << std::fixed << std::setprecision( 1 )
+        <<  _result.nsPerOp()
+    ;
+
+    if ( _result.efficiency >= 0 )
+        std::cout << std::setw( 8 ) << std::setprecision( 2 )
+                  << _result.efficiency;
+    else
+        std::cout << std::setw( 8 ) << "-";
+
+    std::cout << std::endl;
+}
+
+/*----------------------------------------------------------------------------*/
+
+void writeCsv (
+        const std::string & _path
+    ,   const std::vector< Result > & _results
+)
+{
+    std::ofstream out( _path );
+    if ( !out )
+        throw std::runtime_error( "cannot write " + _path );
+
+    out <<  "queue,producers,consumers,capacity,batch,ops_per_sec_median,"
+            "ops_per_sec_min,ops_per_sec_max,ns_per_op,efficiency\n";
+
+    out << std::setprecision( 10 );
+    for ( const Result & result: _results )
+    {
+        const Config & config = result.config;
+        out <<  config.pKind->name
+            <<  ',' << config.producers
+            <<  ',' << config.consumers
+            <<  ',' << config.capacity
+            <<  ',' << config.batchSize
+            <<  ',' << result.median()
+            <<  ',' << result.opsPerSecond.front()
+            <<  ',' << result.opsPerSecond.back()
+            <<  ',' << result.nsPerOp()
+            <<  ',';
+        if ( result.efficiency >= 0 )
+            out << result.efficiency;
+        out << '\n';
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+void writeJson (
+        const std::string & _path
+    ,   const Options & _options
+    ,   const std::vector< Result > & _results
+)
+{
+    std::ofstream out( _path );
+    if ( !out )
+        throw std::runtime_error( "cannot write " + _path );
+
+    out << std::setprecision( 10 );
+    out <<  "{\n"
+        <<  "  \"items\": " << _options.items << ",\n"
+        <<  "  \"warmups\": " << _options.warmups << ",\n"
+        <<  "  \"trials\": " << _options.trials << ",\n"
+        <<  "  \"strategy\": \"" << _options.strategy << "\",\n"
+        <<  "  \"pinned\": " << ( _options.pin ? "true" : "false" ) << ",\n"
+        <<  "  \"hardware_threads\": "
+        <<  std::thread::hardware_concurrency() << ",\n"
+        <<  "  \"results\": [";
+
+    for ( std::size_t i = 0; i < _results.size(); ++i )
+    {
+        const Result & result = _results[ i ];
+        const Config & config = result.config;
+
+        out <<  ( i == 0 ? "\n" : ",\n" )
+            <<  "    { \"queue\": \"" << config.pKind->name << "\""
+            <<  ", \"producers\": " << config.producers
+            <<  ", \"consumers\": " << config.consumers
+            <<  ", \"capacity\": " << config.capacity
+            <<  ", \"batch\": " << config.batchSize
+            <<  ", \"ops_per_sec\": [";
+
+        for ( std::size_t t = 0; t < result.opsPerSecond.size(); ++t )
+            out << ( t == 0 ? "" : ", " ) << result.opsPerSecond[ t ];
+
+        out <<  "], \"ops_per_sec_median\": " << result.median()
+            <<  ", \"ns_per_op\": " << result.nsPerOp()
+            <<  ", \"efficiency\": ";
+        if ( result.efficiency >= 0 )
+            out << result.efficiency;
+        else
+            out << "null";
+        out << " }";
+    }
+
+    out << "\n  ]\n}\n";
+}
+
+/*----------------------------------------------------------------------------*/
+
+int main ( int _argc, char ** _argv )
+{
+    Options options;
+    try
+    {
+        options = parseOptions( _argc, _argv );
+    }
+    catch ( const std::exception & _error )
+    {
+        std::cerr << "queue_benchmark: " << _error.what() << "\n";
+        usage( std::cerr );
+        return EXIT_FAILURE;
+    }
+
+    const auto strategy = std::find_if(
+            g_waitStrategies.begin()
+        ,   g_waitStrategies.end()
+        ,   [ & ] ( const auto & _strategy ) {
+                return options.strategy == _strategy.first;
+            }
+    );
+    if ( strategy == g_waitStrategies.end() )
+    {
+        std::cerr << "queue_benchmark: unknown strategy " << options.strategy
+                  << "\n";
+        return EXIT_FAILURE;
+    }
+
+    const auto kinds = selectQueues< int >( options.queues );
+
+    if ( kinds.empty() )
+    {
+        std::cerr << "queue_benchmark: no known queue selected\n";
+        usage( std::cerr );
+        return EXIT_FAILURE;
+    }
+
+#if !defined( NDEBUG )
+    std::cout << "Warning: assertions are on, numbers are not representative"
+              << std::endl;
+#endif
+
+    std::cout
+        <<  std::left << std::setw( 11 ) << "queue" << std::right
+        <<  std::setw( 4 ) << "P" << std::setw( 4 ) << "C"
+        <<  std::setw( 9 ) << "capacity" << std::setw( 7 ) << "batch"
+        <<  std::setw( 14 ) << "ops/s median" << std::setw( 14 ) << "min"
+        <<  std::setw( 14 ) << "max" << std::setw( 9 ) << "ns/op"
+        <<  std::setw( 8 ) << "scaling"
+        <<  std::endl;
+
+    std::vector< Result > results;
+    for ( const Kind * pKind: kinds )
+        for ( std::size_t capacity: options.capacities )
+            for ( std::size_t batchSize: options.batchSizes )
+                for ( std::size_t producers: options.producers )
+                    for ( std::size_t consumers: options.consumers )
+                    {
+                        if ( pKind->spsc && ( producers > 1 || consumers > 1 ) )
+                            continue;
+
+                        const Config config {
+                            pKind, producers, consumers, capacity, batchSize
+                        };
+                        results.push_back(
+                            runConfig( config, options, strategy->second )
+                        );
+                        printRow( results.back() );
+                    }
+
+    // Printed rows have no efficiency yet: the baseline may come later
+    computeEfficiency( results );
+
+    std::cout << "\nScaling against one producer and one consumer:\n";
+    for ( const Result & result: results )
+        if ( result.efficiency >= 0 )
+            printRow( result );
+
+    try
+    {
+        if ( !options.csvPath.empty() )
+            writeCsv( options.csvPath, results );
+        if ( !options.jsonPath.empty() )
+            writeJson( options.jsonPath, options, results );
+    }
+    catch ( const std::exception & _error )
+    {
+        std::cerr << "queue_benchmark: " << _error.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/*----------------------------------------------------------------------------*/
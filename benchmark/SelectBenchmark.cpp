@@ -0,0 +1,435 @@
+#include "LatencyHistogram.h"
+#include "utilities.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*----------------------------------------------------------------------------*/
+/*-----------------------------------------------------------------------------
+Wakeup latency of one consumer serving several queues.
+
+One producer sends at a fixed rate (open loop, as in queue_latency), message
+i going to input queue i % inputs, and one consumer takes them from all the
+inputs in one of three ways:
+
+    select       QueueSelector::select(), asleep on one shared waiter
+    round-robin  dequeue( 1 ) on each input in turn, what routers did before
+    poll         tryDequeue() on each input in turn, never sleeping
+
+Latency counts from the time a message was due. The consumer's CPU time is
+reported per second of run time: round-robin wakes up every millisecond per
+empty input, poll burns its core.
+
+Build with -DCMAKE_BUILD_TYPE=Release; run with --help for the options.
+------------------------------------------------------------------------------*/
+
+struct Message
+{
+    // Nanoseconds on steady_clock
+    std::int64_t dueTime;
+};
+
+using Kind = QueueKind< Message >;
+
+/*----------------------------------------------------------------------------*/
+
+enum class Mode
+{
+        Select
+    ,   RoundRobin
+    ,   Poll
+};
+
+const std::vector< std::pair< const char *, Mode > > g_modes {
+        { "select", Mode::Select }
+    ,   { "round-robin", Mode::RoundRobin }
+    ,   { "poll", Mode::Poll }
+};
+
+/*----------------------------------------------------------------------------*/
+
+struct Options
+{
+    std::string queue = "standard";
+    std::vector< std::string > modes;
+    std::size_t inputs = 3;
+    std::size_t rate = 10000;
+    std::size_t capacity = 1024;
+    std::size_t warmupMilliseconds = 500;
+    std::size_t durationMilliseconds = 2000;
+    bool pin = true;
+    std::string csvPath;
+};
+
+/*----------------------------------------------------------------------------*/
+
+struct Result
+{
+    const char * mode;
+    LatencyHistogram latency;
+
+    // Consumer CPU time per second of run time, in percent
+    double cpuPercent;
+};
+
+/*----------------------------------------------------------------------------*/
+
+constexpr double g_percentiles[] { 50, 99, 99.9, 99.99 };
+
+/*----------------------------------------------------------------------------*/
+
+// CPU time of the calling thread, in nanoseconds; 0 where it is not known
+std::int64_t threadCpuNanoseconds ()
+{
+#if defined( __linux__ )
+    timespec time;
+    if ( ::clock_gettime( CLOCK_THREAD_CPUTIME_ID, &time ) == 0 )
+        return std::int64_t( time.tv_sec ) * 1000000000 + time.tv_nsec;
+#endif
+    return 0;
+}
+
+/*----------------------------------------------------------------------------*/
+
+void usage ( std::ostream & _rOut )
+{
+    _rOut
+        <<  "Usage: select_latency [options]\n"
+            "  --queue standard      kind of the input queues\n"
+            "  --modes a,b,...       consumer modes to run (default: all):\n"
+            "                        select, round-robin, poll\n"
+            "  --inputs 3            input queues\n"
+            "  --rate 10000          messages per second, over all inputs\n"
+            "  --capacity 1024       capacity of each input\n"
+            "  --warmup 500          milliseconds sent but not recorded\n"
+            "  --duration 2000       milliseconds recorded\n"
+            "  --no-pin              do not pin threads to cores\n"
+            "  --csv FILE            write the percentiles as CSV\n"
+            "  --quick               a short run, for a smoke test\n"
+            "Queues:";
+
+    for ( const Kind & kind: queueKinds< Message >() )
+        if ( !kind.spsc )
+            _rOut << " " << kind.name;
+    _rOut << "\n";
+}
+
+/*----------------------------------------------------------------------------*/
+
+Options parseOptions ( int _argc, char ** _argv )
+{
+    Options options;
+
+    for ( int i = 1; i < _argc; ++i )
+    {
+        const std::string argument = _argv[ i ];
+
+        auto value = [ & ] () -> std::string {
+            if ( i + 1 >= _argc )
+                throw std::invalid_argument( argument + " needs a value" );
+            return _argv[ ++i ];
+        };
+
+        if ( argument == "--help" || argument == "-h" )
+        {
+            usage( std::cout );
+            std::exit( EXIT_SUCCESS );
+        }
+        else if ( argument == "--queue" )
+            options.queue = value();
+        else if ( argument == "--modes" )
+            options.modes = splitList( value() );
+        else if ( argument == "--inputs" )
+            options.inputs = parseCounts( value() ).at( 0 );
+        else if ( argument == "--rate" )
+            options.rate = parseCounts( value() ).at( 0 );
+        else if ( argument == "--capacity" )
+            options.capacity = parseCounts( value() ).at( 0 );
+        else if ( argument == "--warmup" )
+            options.warmupMilliseconds = std::stoul( value() );
+        else if ( argument == "--duration" )
+            options.durationMilliseconds = parseCounts( value() ).at( 0 );
+        else if ( argument == "--no-pin" )
+            options.pin = false;
+        else if ( argument == "--csv" )
+            options.csvPath = value();
+        else if ( argument == "--quick" )
+        {
+            options.rate = 2000;
+            options.warmupMilliseconds = 20;
+            options.durationMilliseconds = 100;
+        }
+        else
+            throw std::invalid_argument( "unknown option " + argument );
+    }
+
+    return options;
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Takes messages until every input is closed and drained; _record is called
+// with each one as soon as it is taken
+template < typename _RecordT >
+void consume (
+        Mode _mode
+    ,   QueueSelector< Message > & _rSelector
+    ,   _RecordT _record
+)
+{
+    const std::size_t inputs = _rSelector.queueCount();
+
+    if ( _mode == Mode::Select )
+    {
+        while ( Message * pMessage = _rSelector.select() )
+            _record( *pMessage );
+        return;
+    }
+
+    for ( std::size_t open = inputs; open > 0; )
+    {
+        open = 0;
+        for ( std::size_t i = 0; i < inputs; ++i )
+        {
+            IQueue< Message > & rInput = _rSelector.queue( i );
+
+            Message * const pMessage = _mode == Mode::RoundRobin
+                ?   rInput.dequeue( 1 )
+                :   rInput.tryDequeue()
+            ;
+
+            if ( pMessage )
+                _record( *pMessage );
+
+            if ( pMessage || !rInput.isClosed() || rInput.count() > 0 )
+                ++open;
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+void run ( Result & _rResult, const Options & _options, Mode _mode )
+{
+    const Kind * const pKind =
+        selectQueues< Message >( { _options.queue } ).at( 0 );
+
+    // The polling modes take from the inputs directly; they still enqueue
+    // through the selector's wrappers, so every mode pays the same for that
+    QueueSelector< Message > selector;
+    for ( std::size_t i = 0; i < _options.inputs; ++i )
+        selector.add( pKind->create( _options.capacity, WaitStrategy::Block ) );
+
+    const std::int64_t interval = 1000000000 / _options.rate;
+    const std::size_t total =
+            ( _options.warmupMilliseconds + _options.durationMilliseconds )
+        *   _options.rate / 1000;
+
+    std::vector< Message > messages( total );
+
+    std::atomic< bool > go( false );
+    std::atomic< std::int64_t > start( 0 );
+    std::int64_t cpuTime = 0;
+    std::vector< std::thread > threads;
+
+    threads.emplace_back( [ & ] {
+        while ( !go.load( std::memory_order_acquire ) )
+            std::this_thread::yield();
+
+        const std::int64_t firstDue = start.load();
+        for ( std::size_t i = 0; i < total; ++i )
+        {
+            Message & message = messages[ i ];
+            message.dueTime = firstDue + std::int64_t( i ) * interval;
+
+            waitUntil( message.dueTime );
+
+            selector.queue( i % _options.inputs ).enqueue( &message );
+        }
+
+        for ( std::size_t i = 0; i < _options.inputs; ++i )
+            selector.queue( i ).close();
+    } );
+
+    threads.emplace_back( [ & ] {
+        while ( !go.load( std::memory_order_acquire ) )
+            std::this_thread::yield();
+
+        const std::int64_t recordFrom =
+                start.load()
+            +   std::int64_t( _options.warmupMilliseconds ) * 1000000;
+        const std::int64_t cpuStart = threadCpuNanoseconds();
+
+        consume( _mode, selector, [ & ] ( const Message & _message ) {
+            const std::int64_t now = nowNanoseconds();
+            if ( _message.dueTime >= recordFrom )
+                _rResult.latency.record( now - _message.dueTime );
+        } );
+
+        cpuTime = threadCpuNanoseconds() - cpuStart;
+    } );
+
+    if ( _options.pin )
+        for ( std::size_t i = 0; i < threads.size(); ++i )
+            pinToCore( threads[ i ], i );
+
+    start.store( nowNanoseconds() + 1000000 );
+    go.store( true, std::memory_order_release );
+
+    for ( auto & thread: threads )
+        thread.join();
+
+    const double runTime = double(
+        _options.warmupMilliseconds + _options.durationMilliseconds
+    ) * 1000000;
+    _rResult.cpuPercent = 100 * double( cpuTime ) / runTime;
+}
+
+/*----------------------------------------------------------------------------*/
+
+void printHeader ()
+{
+    std::cout
+        <<  std::left << std::setw( 13 ) << "mode" << std::right
+        <<  std::setw( 9 ) << "count"
+        <<  std::setw( 10 ) << "p50"
+        <<  std::setw( 10 ) << "p99"
+        <<  std::setw( 10 ) << "p99.9"
+        <<  std::setw( 10 ) << "p99.99"
+        <<  std::setw( 11 ) << "max"
+        <<  std::setw( 8 ) << "cpu%"
+        <<  std::endl;
+}
+
+/*----------------------------------------------------------------------------*/
+
+void printRow ( const Result & _result )
+{
+    std::cout
+        <<  std::left << std::setw( 13 ) << _result.mode << std::right
+        <<  std::setw( 9 ) << _result.latency.count();
+
+    for ( double percentile: g_percentiles )
+        std::cout
+            <<  std::setw( 10 ) << _result.latency.percentile( percentile );
+
+    std::cout
+        <<  std::setw( 11 ) << _result.latency.max()
+        <<  std::setw( 8 ) << std::fixed << std::setprecision( 1 )
+        <<  _result.cpuPercent
+        <<  std::endl;
+}
+
+/*----------------------------------------------------------------------------*/
+
+void writeCsv (
+        const std::string & _path
+    ,   const std::vector< Result > & _results
+)
+{
+    std::ofstream out( _path );
+    if ( !out )
+        throw std::runtime_error( "cannot write " + _path );
+
+    out <<  "mode,count,p50_ns,p99_ns,p99.9_ns,p99.99_ns,max_ns,cpu_percent\n";
+
+    for ( const Result & result: _results )
+    {
+        out << result.mode << ',' << result.latency.count();
+        for ( double percentile: g_percentiles )
+            out << ',' << result.latency.percentile( percentile );
+        out << ',' << result.latency.max() << ',' << result.cpuPercent << '\n';
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+int main ( int _argc, char ** _argv )
+{
+    Options options;
+    try
+    {
+        options = parseOptions( _argc, _argv );
+
+        const auto kinds = selectQueues< Message >( { options.queue } );
+        if ( kinds.empty() || kinds.front()->spsc )
+            throw std::invalid_argument(
+                "unknown or single-consumer queue " + options.queue
+            );
+    }
+    catch ( const std::exception & _error )
+    {
+        std::cerr << "select_latency: " << _error.what() << "\n";
+        usage( std::cerr );
+        return EXIT_FAILURE;
+    }
+
+#if !defined( NDEBUG )
+    std::cout << "Warning: assertions are on, numbers are not representative"
+              << std::endl;
+#endif
+
+    std::cout
+        <<  options.rate << " messages/s over " << options.inputs << " "
+        <<  options.queue << " queues; latencies in nanoseconds" << std::endl;
+    printHeader();
+
+    std::vector< Result > results;
+
+    for ( const auto & mode: g_modes )
+    {
+        if (
+                !options.modes.empty()
+            &&  std::find(
+                        options.modes.begin()
+                    ,   options.modes.end()
+                    ,   mode.first
+                ) == options.modes.end()
+        )
+            continue;
+
+        // A polling consumer sharing the producer's core only lets it run
+        // on preemption
+        if (
+                mode.second == Mode::Poll
+            &&  std::thread::hardware_concurrency() < 2
+        )
+        {
+            std::cout
+                <<  std::left << std::setw( 13 ) << mode.first << std::right
+                <<  "skipped: needs 2 hardware threads" << std::endl;
+            continue;
+        }
+
+        results.push_back( { mode.first, {}, 0 } );
+        run( results.back(), options, mode.second );
+        printRow( results.back() );
+    }
+
+    try
+    {
+        if ( !options.csvPath.empty() )
+            writeCsv( options.csvPath, results );
+    }
+    catch ( const std::exception & _error )
+    {
+        std::cerr << "select_latency: " << _error.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/*----------------------------------------------------------------------------*/
@@ -0,0 +1,198 @@
+#ifndef __SHAREDQUEUE_BENCHMARK_UTILITIES_H__
+#define __SHAREDQUEUE_BENCHMARK_UTILITIES_H__
+
+/*----------------------------------------------------------------------------*/
+
+#include "QueueFactory.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined( __linux__ )
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+struct QueueKind
+{
+    using Creator = std::function<
+        std::unique_ptr< IQueue< _T > > ( std::size_t, WaitStrategy )
+    >;
+
+    const char * name;
+    Creator create;
+
+    // One producer and one consumer only
+    bool spsc;
+};
+
+/*----------------------------------------------------------------------------*/
+
+// Every IQueue the factory builds from a size and a wait strategy
+template < typename _T >
+const std::vector< QueueKind< _T > > & queueKinds ()
+{
+    static const std::vector< QueueKind< _T > > s_kinds {
+            {
+                    "standard"
+                ,   &QueueFactory::createStandardSharedQueue< _T >
+                ,   false
+            }
+        ,   { "pimpl", &QueueFactory::createSharedQueueWithPImpl< _T >, false }
+        ,   { "lock-free", &QueueFactory::createLockFreeQueue< _T >, false }
+        ,   { "spsc", &QueueFactory::createSpscQueue< _T >, true }
+        ,   {
+                    "sharded"
+                ,   [] ( std::size_t _size, WaitStrategy _waitStrategy ) {
+                        return QueueFactory::createShardedQueue< _T >(
+                            _size, _waitStrategy
+                        );
+                    }
+                ,   false
+            }
+        ,   { "segmented", &QueueFactory::createSegmentedQueue< _T >, false }
+        ,   {
+                    "priority"
+                ,   [] ( std::size_t _size, WaitStrategy _waitStrategy )
+                        -> std::unique_ptr< IQueue< _T > >
+                    {
+                        return QueueFactory::createPriorityQueue< _T >(
+                            _size, 4, _waitStrategy
+                        );
+                    }
+                ,   false
+            }
+        ,   {
+                    "async"
+                ,   [] ( std::size_t _size, WaitStrategy _waitStrategy )
+                        -> std::unique_ptr< IQueue< _T > >
+                    {
+                        return QueueFactory::createAsyncQueue< _T >(
+                            _size, _waitStrategy
+                        );
+                    }
+                ,   false
+            }
+    };
+
+    return s_kinds;
+}
+
+/*----------------------------------------------------------------------------*/
+
+const std::vector< std::pair< const char *, WaitStrategy > > g_waitStrategies {
+        { "block", WaitStrategy::Block }
+    ,   { "spin", WaitStrategy::Spin }
+    ,   { "spin-then-yield", WaitStrategy::SpinThenYield }
+    ,   { "spin-then-block", WaitStrategy::SpinThenBlock }
+};
+
+/*----------------------------------------------------------------------------*/
+
+inline std::vector< std::string > splitList ( const std::string & _list )
+{
+    std::vector< std::string > values;
+    std::stringstream stream( _list );
+    for ( std::string value; std::getline( stream, value, ',' ); )
+        if ( !value.empty() )
+            values.push_back( value );
+    return values;
+}
+
+/*----------------------------------------------------------------------------*/
+
+inline std::vector< std::size_t > parseCounts ( const std::string & _list )
+{
+    std::vector< std::size_t > counts;
+    for ( const std::string & value: splitList( _list ) )
+    {
+        const long long count = std::stoll( value );
+        if ( count <= 0 )
+            throw std::invalid_argument( "counts must be positive: " + value );
+        counts.push_back( static_cast< std::size_t >( count ) );
+    }
+    return counts;
+}
+
+/*----------------------------------------------------------------------------*/
+
+// The queues named in _names, all of them if there is none, in list order
+template < typename _T >
+std::vector< const QueueKind< _T > * >
+selectQueues ( const std::vector< std::string > & _names )
+{
+    std::vector< const QueueKind< _T > * > kinds;
+    for ( const QueueKind< _T > & kind: queueKinds< _T >() )
+        if (
+                _names.empty()
+            ||  std::find( _names.begin(), _names.end(), kind.name )
+                    != _names.end()
+        )
+            kinds.push_back( &kind );
+    return kinds;
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Nanoseconds on steady_clock
+inline std::int64_t nowNanoseconds ()
+{
+    return std::chrono::duration_cast< std::chrono::nanoseconds >(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Sleeps while the due time is far, then yields up to it: a sleep alone
+// would add the timer slack to every message
+inline void waitUntil ( std::int64_t _dueTime )
+{
+    constexpr std::int64_t sleepMargin = 100000;
+
+    for ( std::int64_t now = nowNanoseconds(); now < _dueTime;
+          now = nowNanoseconds() )
+    {
+        if ( _dueTime - now > sleepMargin )
+            std::this_thread::sleep_for(
+                std::chrono::nanoseconds( _dueTime - now - sleepMargin )
+            );
+        else
+            std::this_thread::yield();
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+// The _index-th core, wrapping around when there are more threads than cores
+inline void pinToCore ( std::thread & _rThread, std::size_t _index )
+{
+#if defined( __linux__ )
+    const unsigned cores = std::max( std::thread::hardware_concurrency(), 1u );
+
+    cpu_set_t cpuSet;
+    CPU_ZERO( &cpuSet );
+    CPU_SET( _index % cores, &cpuSet );
+    ::pthread_setaffinity_np(
+        _rThread.native_handle(), sizeof( cpuSet ), &cpuSet
+    );
+#else
+    ( void ) _rThread;
+    ( void ) _index;
+#endif
+}
+
+/*----------------------------------------------------------------------------*/
+
+#endif // __SHAREDQUEUE_BENCHMARK_UTILITIES_H__
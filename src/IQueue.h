@@ -3,6 +3,33 @@
 
 /*----------------------------------------------------------------------------*/
 
+#include "QueueStats.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+/*----------------------------------------------------------------------------*/
+
+/**
+ * @brief Thrown by the blocking enqueue calls of a closed queue, which have
+ *        no other way to report that an item did not get in.
+ */
+class QueueClosed
+    :   public std::runtime_error
+{
+public:
+
+    QueueClosed ()
+        :   std::runtime_error( "enqueue on a closed queue" )
+    {
+    }
+};
+
+/*----------------------------------------------------------------------------*/
+
 /**
  * @class IQueue
  *
@@ -11,6 +38,17 @@
  * Please note: The queue DOES NOT own the pointers to T. It is the caller's
  * responsibility to ensure memory is allocated before enqueueing and freed
  * after dequeueing (or when no longer needed).
+ *
+ * Bulk operations move up to N items under a single lock acquisition (or a
+ * single claim of ring positions) and issue a single wakeup; woken threads
+ * pass the wakeup on while there is still work left for the next waiter.
+ *
+ * close() stops a queue for good: enqueues fail from then on, consumers
+ * still get the items left and, once there are none, every dequeue call
+ * returns nullptr (0 for bulk calls) at once instead of waiting.
+ *
+ * As nullptr is how a dequeue says "nothing", it can never be an item: every
+ * enqueue call asserts that the pointers it is given are not null.
  */
 template < typename _T >
 class IQueue
@@ -22,13 +60,162 @@ public:
 
     virtual int count () const = 0;
 
+    /**
+     * @return The number of items enqueue blocks at.
+     */
+    virtual std::size_t capacity () const = 0;
+
+    /**
+     * @brief Moves the bound while producers and consumers keep going.
+     *        Growing wakes blocked producers at once; after shrinking below
+     *        count(), producers block until consumers get under the new bound.
+     * @return false if this kind of queue has a fixed capacity.
+     */
+    virtual bool setCapacity ( std::size_t _capacity );
+
+    /**
+     * @brief Lets a producer whose items do not fit grow the capacity (at
+     *        least doubling it) instead of blocking, up to _maxCapacity; 0
+     *        turns auto-growth off. Capacity gained this way is kept.
+     * @return false if this kind of queue has a fixed capacity.
+     */
+    virtual bool setAutoGrow ( std::size_t _maxCapacity );
+
+    /**
+     * @brief Safe to call from any thread, e.g. a monitoring one, while the
+     *        queue is in use.
+     * @return All zeros unless built with SHAREDQUEUE_STATS (see QueueStats).
+     */
+    virtual QueueStats stats () const;
+
+    /**
+     * @brief Rejects every enqueue from now on and wakes all blocked threads:
+     *        producers fail, consumers drain what is left. Idempotent.
+     */
+    virtual void close () = 0;
+
+    virtual bool isClosed () const = 0;
+
+    /**
+     * @throw QueueClosed if the queue is closed before _pNewValue gets in.
+     */
     virtual void enqueue ( _T * _pNewValue ) = 0;
 
+    /**
+     * @return false on timeout, or if the queue is closed.
+     */
     virtual bool enqueue ( _T * _pNewValue, int _millisecondsTimeout ) = 0;
 
+    /**
+     * @brief Never waits: a full (or closed) queue is seen with a lock-free
+     *        check and refused without taking a lock or making a syscall.
+     * @return false if _pNewValue did not get in.
+     */
+    virtual bool tryEnqueue ( _T * _pNewValue ) = 0;
+
+    /**
+     * @return nullptr only once the queue is closed and drained.
+     */
     virtual _T * dequeue () = 0;
 
+    /**
+     * @return nullptr on timeout, or once the queue is closed and drained.
+     *         A caller that must tell the two apart checks isClosed() after
+     *         getting nullptr: true means nothing more will ever come.
+     */
     virtual _T * dequeue ( int _millisecondsTimeout ) = 0;
+
+    /**
+     * @brief Never waits, for consumers that poll: an empty queue is seen
+     *        with a lock-free check and costs no lock and no syscall.
+     * @return nullptr if the queue is empty.
+     */
+    virtual _T * tryDequeue () = 0;
+
+    /**
+     * @brief Enqueues all _count items, blocking while the queue is full.
+     * @throw QueueClosed if the queue is closed before all of them get in;
+     *        the leading items already enqueued stay in the queue.
+     */
+    virtual void enqueueBulk ( _T ** _ppItems, std::size_t _count ) = 0;
+
+    /**
+     * @return The number of leading items of _ppItems that were enqueued
+     *         before the timeout expired or the queue was closed.
+     */
+    virtual std::size_t enqueueBulk (
+            _T ** _ppItems
+        ,   std::size_t _count
+        ,   int _millisecondsTimeout
+    ) = 0;
+
+    /**
+     * @return The number of leading items that fitted without waiting.
+     */
+    virtual std::size_t tryEnqueueBulk (
+            _T ** _ppItems
+        ,   std::size_t _count
+    ) = 0;
+
+    /**
+     * @brief Blocks until at least one item is available, then dequeues as
+     *        many as are available, up to _maxCount.
+     * @return 0 only once the queue is closed and drained.
+     */
+    virtual std::size_t dequeueBulk (
+            _T ** _ppItems
+        ,   std::size_t _maxCount
+    ) = 0;
+
+    /**
+     * @return 0 if nothing became available before the timeout expired, or
+     *         once the queue is closed and drained; as for the timed
+     *         dequeue(), isClosed() tells them apart.
+     */
+    virtual std::size_t dequeueBulk (
+            _T ** _ppItems
+        ,   std::size_t _maxCount
+        ,   int _millisecondsTimeout
+    ) = 0;
+
+    virtual std::size_t tryDequeueBulk (
+            _T ** _ppItems
+        ,   std::size_t _maxCount
+    ) = 0;
+
+    /**
+     * @brief Appends every item queued right now to _rItems, in FIFO order,
+     *        without waiting; producers blocked on a full queue are woken.
+     * @return The number of items appended.
+     */
+    virtual std::size_t drainAll ( std::vector< _T * > & _rItems );
+
+    /**
+     * @brief Drops every item queued right now. The pointers are not
+     *        deleted: the queue does not own them.
+     */
+    virtual void clear ();
+
+    /**
+     * @brief "Linger" mode: keeps collecting items until _maxCount have been
+     *        dequeued or the timeout expires, whichever comes first; returns
+     *        what it has as soon as the queue is closed and drained.
+     */
+    std::size_t dequeueBulkLinger (
+            _T ** _ppItems
+        ,   std::size_t _maxCount
+        ,   int _millisecondsTimeout
+    );
+
+protected:
+
+    /**
+     * @brief For the asserts of the bulk enqueue calls.
+     */
+    static bool noneIsNull (
+            _T * const * _ppItems
+        ,   std::size_t _count
+    ) noexcept;
 };
 
 /*----------------------------------------------------------------------------*/
@@ -38,4 +225,109 @@ IQueue< _T >::~IQueue() {}
 
 /*----------------------------------------------------------------------------*/
 
+template < typename _T >
+bool IQueue< _T >::setCapacity ( std::size_t )
+{
+    return false;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool IQueue< _T >::setAutoGrow ( std::size_t )
+{
+    return false;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+QueueStats IQueue< _T >::stats () const
+{
+    return QueueStats();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool IQueue< _T >::noneIsNull (
+        _T * const * _ppItems
+    ,   std::size_t _count
+) noexcept
+{
+    _T * const * const pEnd = _ppItems + _count;
+    return std::find( _ppItems, pEnd, nullptr ) == pEnd;
+}
+
+/*----------------------------------------------------------------------------*/
+
+// One bulk call, so queues that dequeue a batch under one lock drain under
+// one lock too; whatever is enqueued meanwhile is left for later.
+template < typename _T >
+std::size_t IQueue< _T >::drainAll ( std::vector< _T * > & _rItems )
+{
+    const int queued = count();
+    if ( queued <= 0 )
+        return 0;
+
+    const std::size_t first = _rItems.size();
+    _rItems.resize( first + queued );
+
+    const std::size_t drained =
+        tryDequeueBulk( _rItems.data() + first, queued );
+    _rItems.resize( first + drained );
+
+    return drained;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+void IQueue< _T >::clear ()
+{
+    std::vector< _T * > items;
+    drainAll( items );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t IQueue< _T >::dequeueBulkLinger (
+        _T ** _ppItems
+    ,   std::size_t _maxCount
+    ,   int _millisecondsTimeout
+)
+{
+    using namespace std::chrono;
+
+    const auto deadline =
+        steady_clock::now() + milliseconds( _millisecondsTimeout );
+
+    std::size_t dequeued = 0;
+
+    while ( dequeued < _maxCount )
+    {
+        const auto left =
+            ceil< milliseconds >( deadline - steady_clock::now() );
+
+        const std::size_t got = left.count() > 0
+            ?   dequeueBulk(
+                        _ppItems + dequeued
+                    ,   _maxCount - dequeued
+                    ,   static_cast< int >( left.count() )
+                )
+            :   tryDequeueBulk( _ppItems + dequeued, _maxCount - dequeued )
+        ;
+
+        dequeued += got;
+
+        if ( got == 0 || left.count() <= 0 )
+            break;
+    }
+
+    return dequeued;
+}
+
+/*----------------------------------------------------------------------------*/
+
 #endif // __SHAREDQUEUE_SRC_IQUEUE_H__
@@ -3,30 +3,249 @@
 
 /*----------------------------------------------------------------------------*/
 
+#include "impl/DelayQueue.h"
+#include "impl/LockFreeQueue.h"
+#include "impl/PriorityQueue.h"
+#include "impl/QueueSelector.h"
+#include "impl/SegmentedQueue.h"
 #include "impl/SharedQueue.h"
 #include "impl/SharedQueuePImpl.h"
+#include "impl/ShardedQueue.h"
+#include "impl/SpscQueue.h"
+#include "impl/ValueQueue.h"
+#include "impl/WorkStealingDeque.h"
+
+#if defined( __cpp_impl_coroutine )
+#include "impl/AsyncQueue.h"
+#endif
+
+#if defined( __linux__ )
+#include "impl/EventFdQueue.h"
+#include "impl/ShmQueue.h"
+#endif
 
 /*----------------------------------------------------------------------------*/
 
 #include <memory>
 
+/**
+ * Every queue takes a WaitStrategy for its blocking operations; Block keeps
+ * the threads asleep while they wait, the spinning ones trade a busy core for
+ * a faster handoff.
+ */
 class QueueFactory
 {
 public:
 
     template < typename _T >
     static std::unique_ptr< IQueue< _T > >
-    createStandardSharedQueue ( std::size_t _size )
+    createStandardSharedQueue (
+            std::size_t _size
+        ,   WaitStrategy _waitStrategy = WaitStrategy::Block
+    )
+    {
+        return std::make_unique< SharedQueue< _T > >( _size, _waitStrategy );
+    }
+
+    template < typename _T >
+    static std::unique_ptr< IQueue< _T > >
+    createSharedQueueWithPImpl (
+            std::size_t _size
+        ,   WaitStrategy _waitStrategy = WaitStrategy::Block
+    )
+    {
+        return std::make_unique< SharedQueuePImpl< _T > >(
+            _size, _waitStrategy
+        );
+    }
+
+    template < typename _T >
+    static std::unique_ptr< IQueue< _T > >
+    createLockFreeQueue (
+            std::size_t _size
+        ,   WaitStrategy _waitStrategy = WaitStrategy::Block
+    )
     {
-        return std::make_unique< SharedQueue< _T > >( _size );
+        return std::make_unique< LockFreeQueue< _T > >( _size, _waitStrategy );
     }
 
+    /**
+     * Trades global FIFO order for throughput that scales with the number of
+     * threads: see ShardedQueue. _laneCount 0 means one lane per hardware
+     * thread.
+     */
     template < typename _T >
     static std::unique_ptr< IQueue< _T > >
-    createSharedQueueWithPImpl ( std::size_t _size )
+    createShardedQueue (
+            std::size_t _size
+        ,   WaitStrategy _waitStrategy = WaitStrategy::Block
+        ,   std::size_t _laneCount = 0
+    )
+    {
+        return std::make_unique< ShardedQueue< _T > >(
+            _size, _waitStrategy, _laneCount
+        );
+    }
+
+    /**
+     * Stores items in linked arrays instead of one node each, so memory
+     * follows count() rather than _size: meant for deep backlogs.
+     */
+    template < typename _T >
+    static std::unique_ptr< IQueue< _T > >
+    createSegmentedQueue (
+            std::size_t _size
+        ,   WaitStrategy _waitStrategy = WaitStrategy::Block
+    )
+    {
+        return std::make_unique< SegmentedQueue< _T > >(
+            _size, _waitStrategy
+        );
+    }
+
+    /**
+     * The returned queue must be used by exactly one producer thread and one
+     * consumer thread.
+     */
+    template < typename _T >
+    static std::unique_ptr< IQueue< _T > >
+    createSpscQueue (
+            std::size_t _size
+        ,   WaitStrategy _waitStrategy = WaitStrategy::Block
+    )
+    {
+        return std::make_unique< SpscQueue< _T > >( _size, _waitStrategy );
+    }
+
+    /**
+     * The plain IQueue calls enqueue at the lowest of the _levelCount levels;
+     * the returned type has the overloads that take a Priority.
+     */
+    template < typename _T >
+    static std::unique_ptr< PriorityQueue< _T > >
+    createPriorityQueue (
+            std::size_t _size
+        ,   std::size_t _levelCount
+        ,   WaitStrategy _waitStrategy = WaitStrategy::Block
+    )
+    {
+        return std::make_unique< PriorityQueue< _T > >(
+            _size, _levelCount, _waitStrategy
+        );
+    }
+
+    /**
+     * Unlike the IQueue family, the returned queue stores T itself.
+     */
+    template < typename _T >
+    static std::unique_ptr< ValueQueue< _T > >
+    createValueQueue (
+            std::size_t _size
+        ,   WaitStrategy _waitStrategy = WaitStrategy::Block
+    )
+    {
+        return std::make_unique< ValueQueue< _T > >( _size, _waitStrategy );
+    }
+
+    /**
+     * Not a queue shared by equals: one owner thread pushes and pops, the
+     * others may only steal.
+     */
+    template < typename _T >
+    static std::unique_ptr< WorkStealingDeque< _T > >
+    createWorkStealingDeque ( std::size_t _initialCapacity = 64 )
+    {
+        return std::make_unique< WorkStealingDeque< _T > >( _initialCapacity );
+    }
+
+    /**
+     * Not a queue itself: queues handed to the returned selector's add() can
+     * be waited on together with select() and waitAny().
+     */
+    template < typename _T >
+    static std::unique_ptr< QueueSelector< _T > >
+    createQueueSelector (
+            typename QueueSelector< _T >::Order _order =
+                QueueSelector< _T >::Order::Priority
+        ,   WaitStrategy _waitStrategy = WaitStrategy::Block
+    )
+    {
+        return std::make_unique< QueueSelector< _T > >(
+            _order, _waitStrategy
+        );
+    }
+
+    /**
+     * Not a FIFO: each item comes out once the readyAt it was enqueued with
+     * has passed, and the queue never blocks producers.
+     */
+    template < typename _T >
+    static std::unique_ptr< DelayQueue< _T > >
+    createDelayQueue ( std::size_t _reserve = 0 )
+    {
+        return std::make_unique< DelayQueue< _T > >( _reserve );
+    }
+
+#if defined( __cpp_impl_coroutine )
+
+    /**
+     * Needs C++20: the returned type adds the co_await-able asyncEnqueue()
+     * and asyncDequeue() to the IQueue calls.
+     */
+    template < typename _T >
+    static std::unique_ptr< AsyncQueue< _T > >
+    createAsyncQueue (
+            std::size_t _size
+        ,   WaitStrategy _waitStrategy = WaitStrategy::Block
+    )
     {
-        return std::make_unique< SharedQueuePImpl< _T > >( _size );
+        return std::make_unique< AsyncQueue< _T > >( _size, _waitStrategy );
     }
+
+#endif
+
+#if defined( __linux__ )
+
+    /**
+     * Linux only: wraps _pQueue so that an epoll loop can wait for it through
+     * the returned queue's fd().
+     */
+    template < typename _T >
+    static std::unique_ptr< EventFdQueue< _T > >
+    createEventFdQueue ( std::unique_ptr< IQueue< _T > > _pQueue )
+    {
+        return std::make_unique< EventFdQueue< _T > >( std::move( _pQueue ) );
+    }
+
+    /**
+     * Linux only: creates the shared memory queue _name, which other
+     * processes open with attachShmQueue(); the name goes away with the
+     * returned object.
+     */
+    template < typename _T >
+    static std::unique_ptr< ShmQueue< _T > >
+    createShmQueue (
+            const std::string & _name
+        ,   std::size_t _size
+        ,   WaitStrategy _waitStrategy = WaitStrategy::Block
+    )
+    {
+        return std::make_unique< ShmQueue< _T > >(
+            _name, _size, _waitStrategy
+        );
+    }
+
+    template < typename _T >
+    static std::unique_ptr< ShmQueue< _T > >
+    attachShmQueue (
+            const std::string & _name
+        ,   WaitStrategy _waitStrategy = WaitStrategy::Block
+    )
+    {
+        return std::make_unique< ShmQueue< _T > >( _name, _waitStrategy );
+    }
+
+#endif
 };
 
 /*----------------------------------------------------------------------------*/
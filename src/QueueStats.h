@@ -0,0 +1,53 @@
+#ifndef __SHAREDQUEUE_SRC_QUEUESTATS_H__
+#define __SHAREDQUEUE_SRC_QUEUESTATS_H__
+
+/*----------------------------------------------------------------------------*/
+
+#include <chrono>
+#include <cstdint>
+
+/*----------------------------------------------------------------------------*/
+
+/**
+ * @brief Snapshot of a queue's counters, as returned by IQueue::stats().
+ *
+ * The counters are only kept when the whole program is compiled with
+ * SHAREDQUEUE_STATS defined (CMake option SHAREDQUEUE_STATS); otherwise
+ * s_enabled is false, recording compiles away and every field reads 0.
+ *
+ * A snapshot is taken without stopping the queue: each counter is exact, but
+ * counters updated while it is taken may be read before or after the update.
+ */
+struct QueueStats
+{
+#if defined( SHAREDQUEUE_STATS )
+    static constexpr bool s_enabled = true;
+#else
+    static constexpr bool s_enabled = false;
+#endif
+
+    std::uint64_t enqueued = 0;
+    std::uint64_t dequeued = 0;
+
+    // Largest count() seen right after an enqueue
+    std::uint64_t highWaterMark = 0;
+
+    // Calls that found the queue full (empty) and had to wait for room (an
+    // item), whether they then spun, yielded, slept or were suspended
+    std::uint64_t producerWaits = 0;
+    std::uint64_t consumerWaits = 0;
+
+    // Time spent in those waits by threads; suspended coroutines not included
+    std::chrono::nanoseconds producerBlockedTime { 0 };
+    std::chrono::nanoseconds consumerBlockedTime { 0 };
+
+    // Waits that ended with the timeout
+    std::uint64_t timeouts = 0;
+
+    // Lock acquisitions that found the lock taken
+    std::uint64_t lockContentions = 0;
+};
+
+/*----------------------------------------------------------------------------*/
+
+#endif // __SHAREDQUEUE_SRC_QUEUESTATS_H__
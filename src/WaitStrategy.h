@@ -0,0 +1,25 @@
+#ifndef __SHAREDQUEUE_SRC_WAITSTRATEGY_H__
+#define __SHAREDQUEUE_SRC_WAITSTRATEGY_H__
+
+/*----------------------------------------------------------------------------*/
+
+/**
+ * @brief How a blocking queue operation waits for an item or for room.
+ *
+ * Block         - sleep straight away; cheapest on CPU, slowest handoff.
+ * Spin          - busy-spin with a pause instruction, never sleep: burns a
+ *                 core for sub-microsecond handoff.
+ * SpinThenYield - spin for a short while, then keep retrying with yields.
+ * SpinThenBlock - spin for a short while, then sleep as Block does.
+ */
+enum class WaitStrategy
+{
+        Block
+    ,   Spin
+    ,   SpinThenYield
+    ,   SpinThenBlock
+};
+
+/*----------------------------------------------------------------------------*/
+
+#endif // __SHAREDQUEUE_SRC_WAITSTRATEGY_H__
@@ -0,0 +1,763 @@
+#include "impl/AsyncQueue.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+AsyncQueue< _T >::AsyncQueue (
+        std::size_t _size
+    ,   WaitStrategy _waitStrategy
+)
+    :   m_events( *this, m_stats, _waitStrategy )
+    ,   m_pRing( std::make_unique< _T *[] >( _size ) )
+    ,   m_ringSize( _size )
+    ,   m_head( 0 )
+    ,   m_size( 0 )
+    ,   m_currentQueueSizeLockable( 0 )
+    ,   m_queueSize( _size )
+    ,   m_closed( false )
+{
+    assert( _size > 0 );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+AsyncQueue< _T >::~AsyncQueue ()
+{
+    assert( m_consumers.empty() && m_producers.empty() );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+int AsyncQueue< _T >::count () const noexcept
+{
+    return static_cast< int >( m_currentQueueSizeLockable.load() );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t AsyncQueue< _T >::capacity () const noexcept
+{
+    return m_queueSize.load();
+}
+
+/*----------------------------------------------------------------------------*/
+
+// The items are moved to the front of the new ring. Room gained goes to
+// parked coroutines first, as a dequeue would give it, then to blocked
+// threads.
+template < typename _T >
+bool AsyncQueue< _T >::setCapacity ( std::size_t _capacity )
+{
+    assert( _capacity > 0 );
+
+    WaiterList woken;
+    std::size_t oldCapacity;
+    {
+        std::lock_guard< StatsMutex > lck( m_mutex );
+
+        const std::size_t ringSize = std::max( _capacity, m_size );
+        if ( ringSize != m_ringSize )
+        {
+            auto pRing = std::make_unique< _T *[] >( ringSize );
+            for ( std::size_t i = 0; i < m_size; ++i )
+                pRing[ i ] = m_pRing[ ( m_head + i ) % m_ringSize ];
+
+            m_pRing = std::move( pRing );
+            m_ringSize = ringSize;
+            m_head = 0;
+        }
+
+        oldCapacity = m_queueSize.exchange( _capacity );
+
+        refillLocked( woken );
+        m_currentQueueSizeLockable.store( m_size, std::memory_order_release );
+    }
+
+    const bool refilled = !woken.empty();
+    wake( woken );
+
+    if ( refilled )
+        m_events.onEnqueued();
+
+    if ( _capacity > oldCapacity )
+        m_events.onRoomMade();
+
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+QueueStats AsyncQueue< _T >::stats () const
+{
+    QueueStats stats = m_stats.snapshot();
+    stats.lockContentions = m_mutex.contentions();
+    return stats;
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Parked consumers only exist while the ring is empty and parked producers
+// while it is full, so all of them can be resumed at once: the consumers
+// have nothing left to drain and the producers will never get in.
+template < typename _T >
+void AsyncQueue< _T >::close ()
+{
+    WaiterList woken;
+    {
+        std::lock_guard< StatsMutex > lck( m_mutex );
+        if ( m_closed.exchange( true ) )
+            return;
+
+        for ( WaiterList * pList: { &m_consumers, &m_producers } )
+            while ( !pList->empty() )
+            {
+                Waiter * const pWaiter = pList->popFront();
+                pWaiter->closed = true;
+                woken.pushBack( pWaiter );
+            }
+    }
+
+    wake( woken );
+
+    m_events.onClosed();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool AsyncQueue< _T >::isClosed () const noexcept
+{
+    return m_closed.load();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+void AsyncQueue< _T >::enqueue ( _T * _pNewValue )
+{
+    assert( _pNewValue );
+
+    if ( !enqueueUntil( _pNewValue, nullptr ) )
+        throw QueueClosed();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool AsyncQueue< _T >::enqueue ( _T * _pNewValue, int _millisecondsTimeout )
+{
+    assert( _pNewValue );
+
+    const TimePoint deadline =
+            EventCount::Clock::now()
+        +   std::chrono::milliseconds( _millisecondsTimeout )
+    ;
+    return enqueueUntil( _pNewValue, &deadline );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool AsyncQueue< _T >::tryEnqueue ( _T * _pNewValue )
+{
+    assert( _pNewValue );
+
+    if ( tryPushBulk( &_pNewValue, 1 ) == 0 )
+        return false;
+
+    m_events.onEnqueued();
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+_T * AsyncQueue< _T >::dequeue ()
+{
+    return dequeueUntil( nullptr );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+_T * AsyncQueue< _T >::dequeue ( int _millisecondsTimeout )
+{
+    const TimePoint deadline =
+            EventCount::Clock::now()
+        +   std::chrono::milliseconds( _millisecondsTimeout )
+    ;
+    return dequeueUntil( &deadline );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+_T * AsyncQueue< _T >::tryDequeue ()
+{
+    _T * pReturnVal = nullptr;
+    if ( tryPopBulk( &pReturnVal, 1 ) == 0 )
+        return nullptr;
+
+    m_events.onDequeued();
+    return pReturnVal;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+void AsyncQueue< _T >::enqueueBulk ( _T ** _ppItems, std::size_t _count )
+{
+    assert( IQueue< _T >::noneIsNull( _ppItems, _count ) );
+
+    if ( enqueueBulkUntil( _ppItems, _count, nullptr ) < _count )
+        throw QueueClosed();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t AsyncQueue< _T >::enqueueBulk (
+        _T ** _ppItems
+    ,   std::size_t _count
+    ,   int _millisecondsTimeout
+)
+{
+    assert( IQueue< _T >::noneIsNull( _ppItems, _count ) );
+
+    const TimePoint deadline =
+            EventCount::Clock::now()
+        +   std::chrono::milliseconds( _millisecondsTimeout )
+    ;
+    return enqueueBulkUntil( _ppItems, _count, &deadline );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t AsyncQueue< _T >::tryEnqueueBulk (
+        _T ** _ppItems
+    ,   std::size_t _count
+)
+{
+    assert( IQueue< _T >::noneIsNull( _ppItems, _count ) );
+
+    const std::size_t enqueued = tryPushBulk( _ppItems, _count );
+    if ( enqueued > 0 )
+        m_events.onEnqueued();
+
+    return enqueued;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t AsyncQueue< _T >::dequeueBulk (
+        _T ** _ppItems
+    ,   std::size_t _maxCount
+)
+{
+    return dequeueBulkUntil( _ppItems, _maxCount, nullptr );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t AsyncQueue< _T >::dequeueBulk (
+        _T ** _ppItems
+    ,   std::size_t _maxCount
+    ,   int _millisecondsTimeout
+)
+{
+    const TimePoint deadline =
+            EventCount::Clock::now()
+        +   std::chrono::milliseconds( _millisecondsTimeout )
+    ;
+    return dequeueBulkUntil( _ppItems, _maxCount, &deadline );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t AsyncQueue< _T >::tryDequeueBulk (
+        _T ** _ppItems
+    ,   std::size_t _maxCount
+)
+{
+    const std::size_t dequeued = tryPopBulk( _ppItems, _maxCount );
+    if ( dequeued > 0 )
+        m_events.onDequeued();
+
+    return dequeued;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+typename AsyncQueue< _T >::DequeueAwaiter
+AsyncQueue< _T >::asyncDequeue () noexcept
+{
+    return DequeueAwaiter( *this, nullptr );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+typename AsyncQueue< _T >::DequeueAwaiter
+AsyncQueue< _T >::asyncDequeue ( CoroutineScheduler & _rScheduler ) noexcept
+{
+    return DequeueAwaiter( *this, &_rScheduler );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+typename AsyncQueue< _T >::EnqueueAwaiter
+AsyncQueue< _T >::asyncEnqueue ( _T * _pNewValue ) noexcept
+{
+    assert( _pNewValue );
+
+    return EnqueueAwaiter( *this, _pNewValue, nullptr );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+typename AsyncQueue< _T >::EnqueueAwaiter
+AsyncQueue< _T >::asyncEnqueue (
+        _T * _pNewValue
+    ,   CoroutineScheduler & _rScheduler
+) noexcept
+{
+    assert( _pNewValue );
+
+    return EnqueueAwaiter( *this, _pNewValue, &_rScheduler );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool AsyncQueue< _T >::enqueueUntil (
+        _T * _pNewValue
+    ,   const TimePoint * _pDeadline
+)
+{
+    const bool enqueued = m_events.awaitRoom(
+            [ this, &_pNewValue ] () {
+                return tryPushBulk( &_pNewValue, 1 ) == 1;
+            }
+        ,   _pDeadline
+    );
+
+    if ( !enqueued )
+        return false; // timed out or closed
+
+    m_events.onEnqueued();
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+_T * AsyncQueue< _T >::dequeueUntil ( const TimePoint * _pDeadline )
+{
+    _T * pReturnVal = nullptr;
+
+    const bool dequeued = m_events.awaitItems(
+            [ this, &pReturnVal ] () {
+                return tryPopBulk( &pReturnVal, 1 ) == 1;
+            }
+        ,   _pDeadline
+    );
+
+    if ( !dequeued )
+        return nullptr; // timed out, or closed and drained
+
+    m_events.onDequeued();
+    return pReturnVal;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t AsyncQueue< _T >::enqueueBulkUntil (
+        _T ** _ppItems
+    ,   std::size_t _count
+    ,   const TimePoint * _pDeadline
+)
+{
+    std::size_t enqueued = 0;
+    while ( enqueued < _count )
+    {
+        std::size_t pushed = 0;
+        m_events.awaitRoom(
+                [ & ] () {
+                    pushed = tryPushBulk(
+                        _ppItems + enqueued, _count - enqueued
+                    );
+                    return pushed > 0;
+                }
+            ,   _pDeadline
+        );
+
+        if ( pushed == 0 )
+            break; // timed out or closed
+
+        enqueued += pushed;
+
+        // One wakeup per pushed batch
+        m_events.onEnqueued();
+    }
+
+    return enqueued;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t AsyncQueue< _T >::dequeueBulkUntil (
+        _T ** _ppItems
+    ,   std::size_t _maxCount
+    ,   const TimePoint * _pDeadline
+)
+{
+    if ( _maxCount == 0 )
+        return 0;
+
+    std::size_t dequeued = 0;
+    m_events.awaitItems(
+            [ & ] () {
+                dequeued = tryPopBulk( _ppItems, _maxCount );
+                return dequeued > 0;
+            }
+        ,   _pDeadline
+    );
+
+    if ( dequeued == 0 )
+        return 0; // timed out, or closed and drained
+
+    // One wakeup for the whole batch
+    m_events.onDequeued();
+
+    return dequeued;
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Consumers only park on an empty ring, so a visibly full ring leaves
+// nobody to hand an item to and the mutex can be skipped
+template < typename _T >
+std::size_t AsyncQueue< _T >::tryPushBulk (
+        _T ** _ppItems
+    ,   std::size_t _count
+)
+{
+    if (
+            _count == 0
+        ||  m_currentQueueSizeLockable.load() >= m_queueSize.load()
+    )
+        return 0;
+
+    WaiterList woken;
+    std::size_t pushed;
+    {
+        std::lock_guard< StatsMutex > lck( m_mutex );
+        pushed = pushLocked( _ppItems, _count, woken );
+    }
+
+    wake( woken );
+    return pushed;
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Producers only park on a full ring, so the same holds for an empty one
+template < typename _T >
+std::size_t AsyncQueue< _T >::tryPopBulk (
+        _T ** _ppItems
+    ,   std::size_t _maxCount
+)
+{
+    if ( _maxCount == 0 || m_currentQueueSizeLockable.load() == 0 )
+        return 0;
+
+    WaiterList woken;
+    std::size_t popped;
+    {
+        std::lock_guard< StatsMutex > lck( m_mutex );
+        popped = popLocked( _ppItems, _maxCount, woken );
+    }
+
+    wake( woken );
+    return popped;
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Trying and parking under one lock acquisition, so no enqueue can slip in
+// between a failed attempt and the awaiter joining the list. Once parked,
+// the awaiter may be resumed on another thread before we even return, so it
+// must not be touched after the lock is dropped.
+template < typename _T >
+bool AsyncQueue< _T >::pushOrPark ( Waiter & _rWaiter )
+{
+    WaiterList woken;
+    {
+        std::lock_guard< StatsMutex > lck( m_mutex );
+        if ( m_closed.load() )
+        {
+            _rWaiter.closed = true;
+            return false;
+        }
+
+        if ( pushLocked( &_rWaiter.pItem, 1, woken ) == 0 )
+        {
+            m_producers.pushBack( &_rWaiter );
+            m_stats.onParked( StatsCounters::Side::Producer );
+            return true;
+        }
+    }
+
+    wake( woken );
+    m_events.onEnqueued();
+    return false;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool AsyncQueue< _T >::popOrPark ( Waiter & _rWaiter )
+{
+    WaiterList woken;
+    {
+        std::lock_guard< StatsMutex > lck( m_mutex );
+        if ( popLocked( &_rWaiter.pItem, 1, woken ) == 0 )
+        {
+            if ( m_closed.load() )
+            {
+                _rWaiter.closed = true;
+                return false; // drained, pItem is still nullptr
+            }
+
+            m_consumers.pushBack( &_rWaiter );
+            m_stats.onParked( StatsCounters::Side::Consumer );
+            return true;
+        }
+    }
+
+    wake( woken );
+    m_events.onDequeued();
+    return false;
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Must be called with m_mutex held. Parked consumers get the first items,
+// they only exist while the ring is empty, so FIFO order is kept.
+template < typename _T >
+std::size_t AsyncQueue< _T >::pushLocked (
+        _T ** _ppItems
+    ,   std::size_t _count
+    ,   WaiterList & _rWoken
+) noexcept
+{
+    if ( m_closed.load() )
+        return 0;
+
+    std::size_t pushed = 0;
+
+    while ( pushed < _count && !m_consumers.empty() )
+    {
+        Waiter * const pConsumer = m_consumers.popFront();
+        pConsumer->pItem = _ppItems[ pushed++ ];
+        _rWoken.pushBack( pConsumer );
+    }
+    const std::size_t handedOver = pushed;
+
+    while ( pushed < _count && m_size < m_queueSize.load() )
+    {
+        std::size_t tail = m_head + m_size++;
+        if ( tail >= m_ringSize )
+            tail -= m_ringSize;
+
+        m_pRing[ tail ] = _ppItems[ pushed++ ];
+    }
+
+    m_currentQueueSizeLockable.store( m_size, std::memory_order_release );
+
+    // Items handed to parked consumers are dequeued at once
+    m_stats.onEnqueued( pushed, [ this ] () { return m_size; } );
+    m_stats.onDequeued( handedOver );
+    return pushed;
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Must be called with m_mutex held. Refills the freed slots from parked
+// producers, which only exist while the ring is full.
+template < typename _T >
+std::size_t AsyncQueue< _T >::popLocked (
+        _T ** _ppItems
+    ,   std::size_t _maxCount
+    ,   WaiterList & _rWoken
+) noexcept
+{
+    std::size_t popped = 0;
+
+    while ( popped < _maxCount && m_size > 0 )
+    {
+        _ppItems[ popped++ ] = m_pRing[ m_head ];
+        if ( ++m_head == m_ringSize )
+            m_head = 0;
+        --m_size;
+    }
+
+    m_stats.onDequeued( popped );
+
+    refillLocked( _rWoken );
+
+    m_currentQueueSizeLockable.store( m_size, std::memory_order_release );
+    return popped;
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Must be called with m_mutex held. Fills whatever room there is from parked
+// producers, oldest first.
+template < typename _T >
+void AsyncQueue< _T >::refillLocked ( WaiterList & _rWoken ) noexcept
+{
+    std::size_t refilled = 0;
+    while ( m_size < m_queueSize.load() && !m_producers.empty() )
+    {
+        Waiter * const pProducer = m_producers.popFront();
+
+        std::size_t tail = m_head + m_size++;
+        if ( tail >= m_ringSize )
+            tail -= m_ringSize;
+
+        m_pRing[ tail ] = pProducer->pItem;
+        _rWoken.pushBack( pProducer );
+        ++refilled;
+    }
+
+    if ( refilled > 0 )
+        m_stats.onEnqueued( refilled, [ this ] () { return m_size; } );
+}
+
+/*----------------------------------------------------------------------------*/
+
+// A resumed coroutine may finish and free the frame holding its waiter, so
+// the link is read before resuming
+template < typename _T >
+void AsyncQueue< _T >::wake ( WaiterList & _rWoken )
+{
+    Waiter * pWaiter = _rWoken.pHead;
+    while ( pWaiter )
+    {
+        Waiter * const pNext = pWaiter->pNext;
+
+        if ( pWaiter->pScheduler )
+            pWaiter->pScheduler->schedule( pWaiter->handle );
+        else
+            pWaiter->handle.resume();
+
+        pWaiter = pNext;
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+void AsyncQueue< _T >::WaiterList::pushBack ( Waiter * _pWaiter ) noexcept
+{
+    _pWaiter->pNext = nullptr;
+
+    if ( pTail )
+        pTail->pNext = _pWaiter;
+    else
+        pHead = _pWaiter;
+    pTail = _pWaiter;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+typename AsyncQueue< _T >::Waiter *
+AsyncQueue< _T >::WaiterList::popFront () noexcept
+{
+    Waiter * const pWaiter = pHead;
+
+    pHead = pWaiter->pNext;
+    if ( !pHead )
+        pTail = nullptr;
+
+    return pWaiter;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+AsyncQueue< _T >::DequeueAwaiter::DequeueAwaiter (
+        AsyncQueue & _rQueue
+    ,   CoroutineScheduler * _pScheduler
+) noexcept
+    :   Waiter { nullptr, {}, _pScheduler, nullptr, false }
+    ,   m_rQueue( _rQueue )
+{
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Always goes through await_suspend: the attempt and the parking have to
+// happen under the same lock
+template < typename _T >
+bool AsyncQueue< _T >::DequeueAwaiter::await_suspend (
+        std::coroutine_handle<> _handle
+)
+{
+    this->handle = _handle;
+    return m_rQueue.popOrPark( *this );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+AsyncQueue< _T >::EnqueueAwaiter::EnqueueAwaiter (
+        AsyncQueue & _rQueue
+    ,   _T * _pNewValue
+    ,   CoroutineScheduler * _pScheduler
+) noexcept
+    :   Waiter { nullptr, {}, _pScheduler, _pNewValue, false }
+    ,   m_rQueue( _rQueue )
+{
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool AsyncQueue< _T >::EnqueueAwaiter::await_suspend (
+        std::coroutine_handle<> _handle
+)
+{
+    this->handle = _handle;
+    return m_rQueue.pushOrPark( *this );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+void AsyncQueue< _T >::EnqueueAwaiter::await_resume () const
+{
+    if ( this->closed )
+        throw QueueClosed();
+}
+
+/*----------------------------------------------------------------------------*/
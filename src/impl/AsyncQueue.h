@@ -0,0 +1,308 @@
+#ifndef __SHAREDQUEUE_SRC_IMPL_ASYNCQUEUE_H__
+#define __SHAREDQUEUE_SRC_IMPL_ASYNCQUEUE_H__
+
+/*----------------------------------------------------------------------------*/
+
+#include "IQueue.h"
+#include "impl/CoroutineScheduler.h"
+#include "impl/QueueEvents.h"
+#include "impl/SpinWait.h"
+#include "impl/StatsCounters.h"
+
+#include <atomic>
+#include <coroutine>
+#include <memory>
+#include <mutex>
+
+/*----------------------------------------------------------------------------*/
+
+/**
+ * @class AsyncQueue
+ *
+ * @brief Bounded FIFO queue that coroutines can co_await on as well as
+ *        threads block on.
+ *
+ * co_await asyncDequeue() on an empty queue (or asyncEnqueue() on a full one)
+ * suspends the coroutine and parks its awaiter, which lives in the coroutine
+ * frame, in an intrusive FIFO list; no thread blocks. An enqueue then hands
+ * its item straight to the oldest parked consumer, and a dequeue refills the
+ * ring from the oldest parked producer, before waking it.
+ *
+ * A parked coroutine is woken after the queue lock is released: resumed
+ * inline by the thread that made progress possible, or, if it was awaited
+ * with a CoroutineScheduler, handed to that scheduler. Inline resumption
+ * runs the coroutine on the producer's (consumer's) stack; pass a scheduler
+ * when that thread must not be held up.
+ *
+ * The IQueue calls keep blocking threads through the WaitStrategy and may be
+ * mixed with the awaitables; parked coroutines are served first. close()
+ * resumes every parked coroutine as well: consumers with nullptr, producers
+ * with QueueClosed thrown from the co_await.
+ *
+ * Please note: a suspended awaiter cannot be cancelled, so a coroutine must
+ * not be destroyed while it waits on the queue, and the queue must outlive
+ * its waiters.
+ */
+template < typename _T >
+class AsyncQueue
+    :   public IQueue < _T >
+{
+    struct Waiter;
+
+public:
+
+    class DequeueAwaiter;
+    class EnqueueAwaiter;
+
+    AsyncQueue (
+            std::size_t _size
+        ,   WaitStrategy _waitStrategy = WaitStrategy::Block
+    );
+
+    ~AsyncQueue ();
+
+    int count () const noexcept override;
+
+    std::size_t capacity () const noexcept override;
+
+    /**
+     * @brief Reallocates the ring to the new capacity, or to the items it
+     *        holds if there are more, under the queue lock.
+     */
+    bool setCapacity ( std::size_t _capacity ) override;
+
+    /**
+     * @brief A coroutine suspended in asyncEnqueue() (asyncDequeue()) counts
+     *        as a producer (consumer) wait, with no blocked time.
+     */
+    QueueStats stats () const override;
+
+    void close () override;
+
+    bool isClosed () const noexcept override;
+
+    void enqueue ( _T * _pNewValue ) override;
+
+    bool enqueue ( _T * _pNewValue, int _millisecondsTimeout ) override;
+
+    bool tryEnqueue ( _T * _pNewValue ) override;
+
+    _T * dequeue () override;
+
+    _T * dequeue ( int _millisecondsTimeout ) override;
+
+    _T * tryDequeue () override;
+
+    void enqueueBulk ( _T ** _ppItems, std::size_t _count ) override;
+
+    std::size_t enqueueBulk (
+            _T ** _ppItems
+        ,   std::size_t _count
+        ,   int _millisecondsTimeout
+    ) override;
+
+    std::size_t tryEnqueueBulk (
+            _T ** _ppItems
+        ,   std::size_t _count
+    ) override;
+
+    std::size_t dequeueBulk (
+            _T ** _ppItems
+        ,   std::size_t _maxCount
+    ) override;
+
+    std::size_t dequeueBulk (
+            _T ** _ppItems
+        ,   std::size_t _maxCount
+        ,   int _millisecondsTimeout
+    ) override;
+
+    std::size_t tryDequeueBulk (
+            _T ** _ppItems
+        ,   std::size_t _maxCount
+    ) override;
+
+    /**
+     * @brief co_await asyncDequeue() yields the next item, suspending the
+     *        coroutine while the queue is empty, or nullptr once the queue is
+     *        closed and drained.
+     */
+    DequeueAwaiter asyncDequeue () noexcept;
+
+    /**
+     * @param _rScheduler Resumes the coroutine if it had to be suspended.
+     */
+    DequeueAwaiter asyncDequeue ( CoroutineScheduler & _rScheduler ) noexcept;
+
+    /**
+     * @brief co_await asyncEnqueue( p ) enqueues p, suspending the coroutine
+     *        while the queue is full; it throws QueueClosed if the queue is
+     *        closed first.
+     */
+    EnqueueAwaiter asyncEnqueue ( _T * _pNewValue ) noexcept;
+
+    EnqueueAwaiter asyncEnqueue (
+            _T * _pNewValue
+        ,   CoroutineScheduler & _rScheduler
+    ) noexcept;
+
+private:
+
+    struct WaiterList;
+
+    using TimePoint = EventCount::Clock::time_point;
+
+    bool enqueueUntil ( _T * _pNewValue, const TimePoint * _pDeadline );
+
+    _T * dequeueUntil ( const TimePoint * _pDeadline );
+
+    std::size_t enqueueBulkUntil (
+            _T ** _ppItems
+        ,   std::size_t _count
+        ,   const TimePoint * _pDeadline
+    );
+
+    std::size_t dequeueBulkUntil (
+            _T ** _ppItems
+        ,   std::size_t _maxCount
+        ,   const TimePoint * _pDeadline
+    );
+
+    std::size_t tryPushBulk ( _T ** _ppItems, std::size_t _count );
+
+    std::size_t tryPopBulk ( _T ** _ppItems, std::size_t _maxCount );
+
+    bool pushOrPark ( Waiter & _rWaiter );
+
+    bool popOrPark ( Waiter & _rWaiter );
+
+    std::size_t pushLocked (
+            _T ** _ppItems
+        ,   std::size_t _count
+        ,   WaiterList & _rWoken
+    ) noexcept;
+
+    std::size_t popLocked (
+            _T ** _ppItems
+        ,   std::size_t _maxCount
+        ,   WaiterList & _rWoken
+    ) noexcept;
+
+    void refillLocked ( WaiterList & _rWoken ) noexcept;
+
+    static void wake ( WaiterList & _rWoken );
+
+private:
+
+    struct Waiter
+    {
+        Waiter * pNext;
+        std::coroutine_handle<> handle;
+        CoroutineScheduler * pScheduler;
+
+        // The producer's item, or the slot a consumer receives its item in
+        _T * pItem;
+
+        // Resumed by close() rather than by an item or a free slot
+        bool closed;
+    };
+
+    struct WaiterList
+    {
+        Waiter * pHead = nullptr;
+        Waiter * pTail = nullptr;
+
+        bool empty () const noexcept { return pHead == nullptr; }
+
+        void pushBack ( Waiter * _pWaiter ) noexcept;
+
+        Waiter * popFront () noexcept;
+    };
+
+    mutable StatsMutex m_mutex;
+
+    QueueEvents< _T > m_events;
+
+    std::unique_ptr< _T *[] > m_pRing;
+    std::size_t m_ringSize;
+    std::size_t m_head;
+    std::size_t m_size;
+
+    WaiterList m_consumers;
+    WaiterList m_producers;
+
+    std::atomic< std::size_t > m_currentQueueSizeLockable;
+    std::atomic< std::size_t > m_queueSize;
+
+    // Written only under m_mutex
+    std::atomic< bool > m_closed;
+
+    [[no_unique_address]] StatsCounters m_stats;
+
+public:
+
+    /*------------------------------------------------------------------------*/
+
+    class DequeueAwaiter
+        :   private Waiter
+    {
+    public:
+
+        DequeueAwaiter ( const DequeueAwaiter & ) = delete;
+        DequeueAwaiter & operator = ( const DequeueAwaiter & ) = delete;
+
+        bool await_ready () const noexcept { return false; }
+
+        bool await_suspend ( std::coroutine_handle<> _handle );
+
+        _T * await_resume () const noexcept { return this->pItem; }
+
+    private:
+
+        friend class AsyncQueue;
+
+        DequeueAwaiter (
+                AsyncQueue & _rQueue
+            ,   CoroutineScheduler * _pScheduler
+        ) noexcept;
+
+        AsyncQueue & m_rQueue;
+    };
+
+    /*------------------------------------------------------------------------*/
+
+    class EnqueueAwaiter
+        :   private Waiter
+    {
+    public:
+
+        EnqueueAwaiter ( const EnqueueAwaiter & ) = delete;
+        EnqueueAwaiter & operator = ( const EnqueueAwaiter & ) = delete;
+
+        bool await_ready () const noexcept { return false; }
+
+        bool await_suspend ( std::coroutine_handle<> _handle );
+
+        void await_resume () const;
+
+    private:
+
+        friend class AsyncQueue;
+
+        EnqueueAwaiter (
+                AsyncQueue & _rQueue
+            ,   _T * _pNewValue
+            ,   CoroutineScheduler * _pScheduler
+        ) noexcept;
+
+        AsyncQueue & m_rQueue;
+    };
+};
+
+/*----------------------------------------------------------------------------*/
+
+#include "impl/AsyncQueue.cpp"
+
+/*----------------------------------------------------------------------------*/
+
+#endif // __SHAREDQUEUE_SRC_IMPL_ASYNCQUEUE_H__
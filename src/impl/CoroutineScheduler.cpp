@@ -0,0 +1,105 @@
+#include "impl/CoroutineScheduler.h"
+#include "impl/LockFreeQueue.h"
+
+#include <algorithm>
+
+/*----------------------------------------------------------------------------*/
+
+namespace
+{
+
+// What the workers are told to stop with: nullptr cannot be queued
+char g_stopMarker;
+
+} // namespace
+
+/*----------------------------------------------------------------------------*/
+
+CoroutineScheduler::~CoroutineScheduler () {}
+
+/*----------------------------------------------------------------------------*/
+
+void ManualScheduler::schedule ( std::coroutine_handle<> _handle )
+{
+    m_ready.push_back( _handle );
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Resumed coroutines may schedule others, so take the list over in rounds
+// rather than iterating over it
+std::size_t ManualScheduler::run ()
+{
+    std::size_t resumed = 0;
+    std::vector< std::coroutine_handle<> > round;
+
+    while ( !m_ready.empty() )
+    {
+        round.swap( m_ready );
+        for ( std::coroutine_handle<> handle: round )
+            handle.resume();
+
+        resumed += round.size();
+        round.clear();
+    }
+
+    return resumed;
+}
+
+/*----------------------------------------------------------------------------*/
+
+ThreadPoolScheduler::ThreadPoolScheduler (
+        std::size_t _threadCount
+    ,   std::size_t _queueSize
+)
+    :   m_pReady( std::make_unique< LockFreeQueue< void > >( _queueSize ) )
+{
+    const std::size_t threadCount = _threadCount > 0
+        ?   _threadCount
+        :   std::max( std::thread::hardware_concurrency(), 1u )
+    ;
+
+    m_workers.reserve( threadCount );
+    for ( std::size_t i = 0; i < threadCount; ++i )
+        m_workers.emplace_back( [ this ] () { workerLoop(); } );
+}
+
+/*----------------------------------------------------------------------------*/
+
+ThreadPoolScheduler::~ThreadPoolScheduler ()
+{
+    // One stop marker per thread, queued behind everything scheduled so far
+    for ( std::size_t i = 0; i < m_workers.size(); ++i )
+        m_pReady->enqueue( &g_stopMarker );
+
+    for ( auto & worker: m_workers )
+        worker.join();
+}
+
+/*----------------------------------------------------------------------------*/
+
+std::size_t ThreadPoolScheduler::threadCount () const noexcept
+{
+    return m_workers.size();
+}
+
+/*----------------------------------------------------------------------------*/
+
+void ThreadPoolScheduler::schedule ( std::coroutine_handle<> _handle )
+{
+    m_pReady->enqueue( _handle.address() );
+}
+
+/*----------------------------------------------------------------------------*/
+
+void ThreadPoolScheduler::workerLoop ()
+{
+    for (
+            void * pAddress = m_pReady->dequeue();
+            pAddress != &g_stopMarker;
+            pAddress = m_pReady->dequeue()
+    )
+        std::coroutine_handle<>::from_address( pAddress ).resume();
+}
+
+/*----------------------------------------------------------------------------*/
@@ -0,0 +1,155 @@
+#ifndef __SHAREDQUEUE_SRC_IMPL_COROUTINESCHEDULER_H__
+#define __SHAREDQUEUE_SRC_IMPL_COROUTINESCHEDULER_H__
+
+/*----------------------------------------------------------------------------*/
+
+#if !defined( __cpp_impl_coroutine )
+#error "CoroutineScheduler.h needs C++20 coroutines"
+#endif
+
+#include "IQueue.h"
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/*----------------------------------------------------------------------------*/
+
+/**
+ * @class CoroutineScheduler
+ *
+ * @brief Somewhere to resume a coroutine other than the thread that woke it.
+ */
+class CoroutineScheduler
+{
+public:
+
+    virtual ~CoroutineScheduler () = 0;
+
+    virtual void schedule ( std::coroutine_handle<> _handle ) = 0;
+};
+
+/*----------------------------------------------------------------------------*/
+
+/**
+ * @class DetachedTask
+ *
+ * @brief Return type of a fire-and-forget coroutine: it starts suspended,
+ *        is started by CoroutineScheduler::spawn(), and frees its own frame
+ *        when it returns.
+ */
+class DetachedTask
+{
+public:
+
+    struct promise_type
+    {
+        DetachedTask get_return_object () noexcept
+        {
+            return DetachedTask(
+                std::coroutine_handle< promise_type >::from_promise( *this )
+            );
+        }
+
+        std::suspend_always initial_suspend () noexcept { return {}; }
+
+        std::suspend_never final_suspend () noexcept { return {}; }
+
+        void return_void () noexcept {}
+
+        void unhandled_exception () noexcept { std::terminate(); }
+    };
+
+    explicit DetachedTask ( std::coroutine_handle<> _handle ) noexcept
+        :   m_handle( _handle )
+    {
+    }
+
+    /**
+     * @brief Hands the coroutine to _rScheduler, which runs it up to its
+     *        first suspension point.
+     */
+    void spawn ( CoroutineScheduler & _rScheduler ) &&
+    {
+        _rScheduler.schedule( m_handle );
+    }
+
+private:
+
+    std::coroutine_handle<> m_handle;
+};
+
+/*----------------------------------------------------------------------------*/
+
+/**
+ * @class ManualScheduler
+ *
+ * @brief Single-threaded scheduler: schedule() only records the coroutine,
+ *        run() resumes recorded coroutines on the calling thread until there
+ *        are none left.
+ *
+ * Please note: not thread-safe; every call must come from one thread.
+ */
+class ManualScheduler
+    :   public CoroutineScheduler
+{
+public:
+
+    void schedule ( std::coroutine_handle<> _handle ) override;
+
+    /**
+     * @return The number of coroutines resumed.
+     */
+    std::size_t run ();
+
+private:
+
+    std::vector< std::coroutine_handle<> > m_ready;
+};
+
+/*----------------------------------------------------------------------------*/
+
+/**
+ * @class ThreadPoolScheduler
+ *
+ * @brief Multi-threaded scheduler: a fixed set of threads resumes scheduled
+ *        coroutines taken from a lock-free ring.
+ *
+ * The destructor resumes whatever was scheduled before it, then joins the
+ * threads. schedule() blocks while the ring is full.
+ */
+class ThreadPoolScheduler
+    :   public CoroutineScheduler
+{
+public:
+
+    /**
+     * @param _threadCount 0 means one thread per hardware thread.
+     */
+    explicit ThreadPoolScheduler (
+            std::size_t _threadCount = 0
+        ,   std::size_t _queueSize = 65536
+    );
+
+    ~ThreadPoolScheduler ();
+
+    std::size_t threadCount () const noexcept;
+
+    void schedule ( std::coroutine_handle<> _handle ) override;
+
+private:
+
+    void workerLoop ();
+
+private:
+
+    std::unique_ptr< IQueue< void > > m_pReady;
+    std::vector< std::thread > m_workers;
+};
+
+/*----------------------------------------------------------------------------*/
+
+#endif // __SHAREDQUEUE_SRC_IMPL_COROUTINESCHEDULER_H__
@@ -0,0 +1,372 @@
+#include "impl/DelayQueue.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+struct DelayQueue< _T >::Entry
+{
+    TimePoint readyAt;
+    std::uint64_t sequence;
+    _T * pItem;
+};
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+DelayQueue< _T >::DelayQueue ( std::size_t _reserve )
+    :   m_sequence( 0 )
+    ,   m_nextReadyAt( s_noReadyAt )
+    ,   m_count( 0 )
+    ,   m_closed( false )
+{
+    m_heap.reserve( _reserve );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+int DelayQueue< _T >::count () const noexcept
+{
+    return m_count.load( std::memory_order_acquire );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+typename DelayQueue< _T >::TimePoint
+DelayQueue< _T >::nextReadyAt () const noexcept
+{
+    return TimePoint(
+        Clock::duration( m_nextReadyAt.load( std::memory_order_acquire ) )
+    );
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Set under the lock, so that no enqueue gets in once close() returns
+template < typename _T >
+void DelayQueue< _T >::close ()
+{
+    {
+        std::lock_guard< std::mutex > lck( m_mutex );
+        m_closed.store( true, std::memory_order_release );
+    }
+
+    m_readyEvent.notifyAll();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool DelayQueue< _T >::isClosed () const noexcept
+{
+    return m_closed.load( std::memory_order_acquire );
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Only an item that goes to the top moves the deadline consumers sleep until;
+// any other one is due after an item some consumer already waits for
+template < typename _T >
+bool DelayQueue< _T >::enqueue ( _T * _pNewValue, TimePoint _readyAt )
+{
+    // nullptr is what a dequeue returns when there is nothing
+    assert( _pNewValue );
+
+    bool first;
+    {
+        std::lock_guard< std::mutex > lck( m_mutex );
+        if ( m_closed.load( std::memory_order_relaxed ) )
+            return false;
+
+        first = pushEntry( Entry{ _readyAt, m_sequence++, _pNewValue } );
+    }
+
+    if ( first )
+        m_readyEvent.notifyOne();
+
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+_T * DelayQueue< _T >::dequeue ()
+{
+    return dequeueUntil( nullptr );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+_T * DelayQueue< _T >::dequeue ( int _millisecondsTimeout )
+{
+    const TimePoint deadline =
+            Clock::now()
+        +   std::chrono::milliseconds( _millisecondsTimeout )
+    ;
+    return dequeueUntil( &deadline );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+_T * DelayQueue< _T >::tryDequeue ()
+{
+    const TimePoint now = Clock::now();
+    if (
+            now.time_since_epoch().count()
+        <   m_nextReadyAt.load( std::memory_order_acquire )
+    )
+        return nullptr;
+
+    TimePoint nextReadyAt;
+    return takeReady( now, nextReadyAt );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t DelayQueue< _T >::tryDequeueBulk (
+        _T ** _ppItems
+    ,   std::size_t _maxCount
+)
+{
+    const TimePoint now = Clock::now();
+    if (
+            _maxCount == 0
+        ||  now.time_since_epoch().count()
+        <   m_nextReadyAt.load( std::memory_order_acquire )
+    )
+        return 0;
+
+    std::lock_guard< std::mutex > lck( m_mutex );
+
+    std::size_t dequeued = 0;
+    while (
+            dequeued < _maxCount
+        &&  !m_heap.empty()
+        &&  !( now < m_heap.front().readyAt )
+    )
+        _ppItems[ dequeued++ ] = popEntry();
+
+    return dequeued;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t DelayQueue< _T >::drainAll ( std::vector< _T * > & _rItems )
+{
+    std::vector< Entry > entries;
+    detachAll( entries );
+
+    std::sort( entries.begin(), entries.end(), &DelayQueue::precedes );
+
+    _rItems.reserve( _rItems.size() + entries.size() );
+    for ( const Entry & entry: entries )
+        _rItems.push_back( entry.pItem );
+
+    return entries.size();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+void DelayQueue< _T >::clear ()
+{
+    std::vector< Entry > entries;
+    detachAll( entries );
+}
+
+/*----------------------------------------------------------------------------*/
+
+// A sleeping consumer wakes at the earliest readyAt it saw, at its own
+// deadline, or when an enqueue moves the earliest readyAt before that
+template < typename _T >
+_T * DelayQueue< _T >::dequeueUntil ( const TimePoint * _pDeadline )
+{
+    TimePoint wakeAt;
+    if ( _T * const pItem = takeReady( Clock::now(), wakeAt ) )
+        return pItem;
+
+    _T * pItem;
+    for ( ;; )
+    {
+        const EventCount::Key key = m_readyEvent.prepareWait();
+
+        const TimePoint now = Clock::now();
+        pItem = takeReady( now, wakeAt );
+
+        const bool drained = wakeAt == TimePoint::max() && isClosed();
+        const bool expired = _pDeadline && now >= *_pDeadline;
+        if ( pItem || drained || expired )
+        {
+            m_readyEvent.cancelWait( key );
+            break;
+        }
+
+        if ( _pDeadline && *_pDeadline < wakeAt )
+            wakeAt = *_pDeadline;
+
+        if ( wakeAt == TimePoint::max() )
+            m_readyEvent.wait( key );
+        else
+            m_readyEvent.waitUntil( key, wakeAt );
+    }
+
+    passOn();
+    return pItem;
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Pops the earliest item if its time has come; otherwise reports when it will
+template < typename _T >
+_T * DelayQueue< _T >::takeReady ( TimePoint _now, TimePoint & _rNextReadyAt )
+{
+    std::lock_guard< std::mutex > lck( m_mutex );
+
+    if ( m_heap.empty() )
+    {
+        _rNextReadyAt = TimePoint::max();
+        return nullptr;
+    }
+
+    if ( _now < m_heap.front().readyAt )
+    {
+        _rNextReadyAt = m_heap.front().readyAt;
+        return nullptr;
+    }
+
+    return popEntry();
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Sifts a hole up from the new last slot instead of swapping at each level
+template < typename _T >
+bool DelayQueue< _T >::pushEntry ( const Entry & _entry )
+{
+    m_heap.push_back( _entry );
+
+    std::size_t hole = m_heap.size() - 1;
+    while ( hole > 0 )
+    {
+        const std::size_t parent = ( hole - 1 ) / s_arity;
+        if ( !precedes( _entry, m_heap[ parent ] ) )
+            break;
+
+        m_heap[ hole ] = m_heap[ parent ];
+        hole = parent;
+    }
+    m_heap[ hole ] = _entry;
+
+    publishState();
+    return hole == 0;
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Sifts the last entry down from the root's hole, moving the earliest of the
+// four children up at each level
+template < typename _T >
+_T * DelayQueue< _T >::popEntry ()
+{
+    _T * const pItem = m_heap.front().pItem;
+
+    const Entry last = m_heap.back();
+    m_heap.pop_back();
+
+    const std::size_t size = m_heap.size();
+    if ( size > 0 )
+    {
+        std::size_t hole = 0;
+        for ( ;; )
+        {
+            const std::size_t first = hole * s_arity + 1;
+            if ( first >= size )
+                break;
+
+            const std::size_t end = std::min( first + s_arity, size );
+
+            std::size_t child = first;
+            for ( std::size_t i = first + 1; i < end; ++i )
+                if ( precedes( m_heap[ i ], m_heap[ child ] ) )
+                    child = i;
+
+            if ( !precedes( m_heap[ child ], last ) )
+                break;
+
+            m_heap[ hole ] = m_heap[ child ];
+            hole = child;
+        }
+        m_heap[ hole ] = last;
+    }
+
+    publishState();
+    return pItem;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+void DelayQueue< _T >::detachAll ( std::vector< Entry > & _rEntries )
+{
+    std::lock_guard< std::mutex > lck( m_mutex );
+
+    m_heap.swap( _rEntries );
+    publishState();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+void DelayQueue< _T >::publishState () noexcept
+{
+    m_count.store(
+        static_cast< int >( m_heap.size() ), std::memory_order_release
+    );
+    m_nextReadyAt.store(
+            m_heap.empty()
+        ?   s_noReadyAt
+        :   m_heap.front().readyAt.time_since_epoch().count()
+        ,   std::memory_order_release
+    );
+}
+
+/*----------------------------------------------------------------------------*/
+
+// A consumer leaving may have been the one due to wake first, with the
+// others asleep until a later readyAt or for good; one of them has to look
+// at the heap again
+template < typename _T >
+void DelayQueue< _T >::passOn ()
+{
+    m_readyEvent.notifyOneIf( [ this ] () {
+        return m_nextReadyAt.load( std::memory_order_acquire ) != s_noReadyAt;
+    } );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool DelayQueue< _T >::precedes (
+        const Entry & _lhs
+    ,   const Entry & _rhs
+) noexcept
+{
+    return
+            _lhs.readyAt < _rhs.readyAt
+        ||  (
+                    _lhs.readyAt == _rhs.readyAt
+                &&  _lhs.sequence < _rhs.sequence
+            )
+    ;
+}
+
+/*----------------------------------------------------------------------------*/
@@ -0,0 +1,161 @@
+#ifndef __SHAREDQUEUE_SRC_IMPL_DELAYQUEUE_H__
+#define __SHAREDQUEUE_SRC_IMPL_DELAYQUEUE_H__
+
+/*----------------------------------------------------------------------------*/
+
+#include "impl/EventCount.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+/*----------------------------------------------------------------------------*/
+
+/**
+ * @class DelayQueue
+ *
+ * @brief Unbounded multi-producer/multi-consumer queue of pointers to T in
+ *        which an item becomes visible to consumers only once its readyAt
+ *        time has come: retries and timers without a thread per timer.
+ *
+ * Items are kept in a 4-ary min-heap ordered by readyAt, FIFO among equal
+ * times, in one vector under a mutex. An insert compares against a parent
+ * per level, and a level holds four times the one above, so a random readyAt
+ * stops after a level or two on average; a readyAt no earlier than the last
+ * one, as with a fixed retry delay, stops after one comparison. Pops cost
+ * log4( n ) levels of four children each.
+ *
+ * Consumers sleep on an EventCount with the earliest readyAt as the deadline
+ * (an absolute CLOCK_MONOTONIC futex timeout on Linux), so nobody polls; an
+ * enqueue only wakes a consumer when it moves that deadline earlier.
+ *
+ * Like the IQueue family it does not own the pointers. close() refuses
+ * further items; the ones already queued still come out at their readyAt.
+ */
+template < typename _T >
+class DelayQueue
+{
+public:
+
+    using Clock = EventCount::Clock;
+    using TimePoint = Clock::time_point;
+
+    /**
+     * @param _reserve Heap slots allocated up front, so that a known number
+     *        of pending timers never reallocates the vector.
+     */
+    explicit DelayQueue ( std::size_t _reserve = 0 );
+
+    DelayQueue ( const DelayQueue & ) = delete;
+    DelayQueue & operator = ( const DelayQueue & ) = delete;
+
+    /**
+     * @return The number of items queued, whether their time has come or not.
+     */
+    int count () const noexcept;
+
+    /**
+     * @return The earliest readyAt queued, or TimePoint::max() if empty; an
+     *         event loop can sleep until then and poll with tryDequeue().
+     */
+    TimePoint nextReadyAt () const noexcept;
+
+    void close ();
+
+    bool isClosed () const noexcept;
+
+    /**
+     * @brief Never waits: the queue has no capacity to block on.
+     * @return false if the queue is closed.
+     */
+    bool enqueue ( _T * _pNewValue, TimePoint _readyAt );
+
+    /**
+     * @brief Blocks until the earliest item's readyAt comes.
+     * @return nullptr only once the queue is closed and drained.
+     */
+    _T * dequeue ();
+
+    /**
+     * @return nullptr if no item became ready before the timeout, or once
+     *         the queue is closed and drained; isClosed() tells them apart.
+     */
+    _T * dequeue ( int _millisecondsTimeout );
+
+    /**
+     * @brief Never waits: an empty queue, or one whose earliest item is not
+     *        ready yet, is seen without taking the lock.
+     * @return nullptr if no item is ready.
+     */
+    _T * tryDequeue ();
+
+    /**
+     * @brief Takes up to _maxCount ready items, earliest first, under one
+     *        lock acquisition.
+     */
+    std::size_t tryDequeueBulk ( _T ** _ppItems, std::size_t _maxCount );
+
+    /**
+     * @brief Appends every item queued right now to _rItems, ordered by
+     *        readyAt whether it has come or not, e.g. to cancel the pending
+     *        timers at shutdown. The heap is swapped out under the lock in
+     *        O(1) and sorted outside it.
+     * @return The number of items appended.
+     */
+    std::size_t drainAll ( std::vector< _T * > & _rItems );
+
+    void clear ();
+
+private:
+
+    struct Entry;
+
+    _T * dequeueUntil ( const TimePoint * _pDeadline );
+
+    _T * takeReady ( TimePoint _now, TimePoint & _rNextReadyAt );
+
+    bool pushEntry ( const Entry & _entry );
+
+    _T * popEntry ();
+
+    void detachAll ( std::vector< Entry > & _rEntries );
+
+    void publishState () noexcept;
+
+    void passOn ();
+
+    static bool precedes ( const Entry & _lhs, const Entry & _rhs ) noexcept;
+
+private:
+
+    static constexpr std::size_t s_arity = 4;
+
+    // m_nextReadyAt of an empty heap
+    static constexpr Clock::rep s_noReadyAt =
+        TimePoint::max().time_since_epoch().count();
+
+    mutable std::mutex m_mutex;
+
+    std::vector< Entry > m_heap;
+
+    // Breaks ties between equal readyAt in enqueue order
+    std::uint64_t m_sequence;
+
+    // Mirrors of the heap for the lock-free checks, written under m_mutex
+    std::atomic< Clock::rep > m_nextReadyAt;
+    std::atomic< int > m_count;
+
+    std::atomic< bool > m_closed;
+
+    EventCount m_readyEvent;
+};
+
+/*----------------------------------------------------------------------------*/
+
+#include "impl/DelayQueue.cpp"
+
+/*----------------------------------------------------------------------------*/
+
+#endif // __SHAREDQUEUE_SRC_IMPL_DELAYQUEUE_H__
@@ -0,0 +1,364 @@
+#ifndef __SHAREDQUEUE_SRC_IMPL_EVENTCOUNT_H__
+#define __SHAREDQUEUE_SRC_IMPL_EVENTCOUNT_H__
+
+/*----------------------------------------------------------------------------*/
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#if defined( __linux__ )
+#include <climits>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#include <condition_variable>
+#include <mutex>
+#endif
+
+/*----------------------------------------------------------------------------*/
+
+/**
+ * @class EventCount
+ *
+ * @brief Lets lock-free code block on a condition without paying for a
+ *        mutex or a notification when nobody is waiting.
+ *
+ * Waiter side:
+ *      auto key = ec.prepareWait();
+ *      if ( conditionHolds() ) { ec.cancelWait( key ); ... }
+ *      else ec.wait( key );
+ *
+ * Notifier side: make the condition true, then call notifyOne()/notifyAll().
+ *
+ * await()/awaitUntil() wrap the waiter side around a non-blocking attempt.
+ *
+ * On Linux waiters sleep on a futex over the epoch word, so neither side
+ * takes a mutex; elsewhere a mutex and a condition variable stand in for it.
+ */
+class EventCount
+{
+public:
+
+    using Key = std::uint32_t;
+    using Clock = std::chrono::steady_clock;
+
+    EventCount ()
+        :   m_epoch( 0 )
+        ,   m_state( 0 )
+#if defined( __linux__ )
+        ,   m_futexPrivateFlag( FUTEX_PRIVATE_FLAG )
+#endif
+    {
+    }
+
+#if defined( __linux__ )
+
+    struct ProcessShared {};
+
+    /**
+     * @brief For an EventCount placed in memory that several processes map:
+     *        uses shared futexes, which the kernel keys on the page rather
+     *        than on the address space.
+     */
+    explicit EventCount ( ProcessShared )
+        :   m_epoch( 0 )
+        ,   m_state( 0 )
+        ,   m_futexPrivateFlag( 0 )
+    {
+    }
+
+#endif
+
+    EventCount ( const EventCount & ) = delete;
+    EventCount & operator = ( const EventCount & ) = delete;
+
+    Key prepareWait () noexcept
+    {
+        // The key is read before registering: a notifier that counts this
+        // waiter moves the epoch past it, so leave() always hands the wakeup
+        // back. Read afterwards, it could already be the moved epoch, and the
+        // wakeup would stay counted against the waiters left.
+        const Key key = m_epoch.load( std::memory_order_acquire );
+        m_state.fetch_add( s_oneWaiter, std::memory_order_seq_cst );
+        std::atomic_thread_fence( std::memory_order_seq_cst );
+        return key;
+    }
+
+    /**
+     * @brief Unregisters without sleeping. A notifier may have counted this
+     *        waiter already; the key tells, and the wakeup is handed back.
+     */
+    void cancelWait ( Key _key ) noexcept
+    {
+        leave( _key );
+    }
+
+    void wait ( Key _key )
+    {
+        while ( m_epoch.load( std::memory_order_acquire ) == _key )
+            sleep( _key, nullptr );
+
+        leave( _key );
+    }
+
+    /**
+     * @return false if the deadline passed without a notification.
+     */
+    bool waitUntil ( Key _key, Clock::time_point _deadline )
+    {
+        while (
+                m_epoch.load( std::memory_order_acquire ) == _key
+            &&  Clock::now() < _deadline
+        )
+            sleep( _key, &_deadline );
+
+        // A notifier may count this waiter right as the deadline passes
+        return leave( _key );
+    }
+
+    /**
+     * @brief Retries _tryOp until it succeeds, sleeping in between.
+     */
+    template < typename _TryOpT >
+    void await ( _TryOpT _tryOp )
+    {
+        while ( !_tryOp() )
+        {
+            const Key key = prepareWait();
+            if ( _tryOp() )
+            {
+                cancelWait( key );
+                return;
+            }
+            wait( key );
+        }
+    }
+
+    /**
+     * @return false if _tryOp did not succeed before the deadline.
+     */
+    template < typename _TryOpT >
+    bool awaitUntil ( _TryOpT _tryOp, Clock::time_point _deadline )
+    {
+        while ( !_tryOp() )
+        {
+            const Key key = prepareWait();
+            if ( _tryOp() )
+            {
+                cancelWait( key );
+                return true;
+            }
+            if ( !waitUntil( key, _deadline ) )
+                return _tryOp();
+        }
+        return true;
+    }
+
+    void notifyOne ()
+    {
+        if ( hasUnsignaledWaiters() && signal( 1 ) )
+            wake( 1 );
+    }
+
+    /**
+     * @brief Wakes one more waiter only if _predicate still holds, so that a
+     *        thread woken for a batch can pass the wakeup on.
+     */
+    template < typename _PredicateT >
+    void notifyOneIf ( _PredicateT _predicate )
+    {
+        if ( hasUnsignaledWaiters() && _predicate() && signal( 1 ) )
+            wake( 1 );
+    }
+
+    void notifyAll ()
+    {
+        if ( hasUnsignaledWaiters() && signal( s_waitersMask ) )
+            wake( INT_MAX );
+    }
+
+private:
+
+    // m_state keeps the registered waiters in the low half and the wakeups
+    // already sent to them in the high half. A woken thread stays registered
+    // until it gets the CPU back, so without the second count every notify
+    // in between would make another syscall for the same sleeper.
+    static constexpr std::uint64_t s_oneWaiter = 1;
+    static constexpr std::uint64_t s_oneSignal = std::uint64_t( 1 ) << 32;
+    static constexpr std::uint64_t s_waitersMask = s_oneSignal - 1;
+
+    static std::uint64_t waiters ( std::uint64_t _state ) noexcept
+    {
+        return _state & s_waitersMask;
+    }
+
+    static std::uint64_t signals ( std::uint64_t _state ) noexcept
+    {
+        return _state >> 32;
+    }
+
+    bool hasUnsignaledWaiters () const noexcept
+    {
+        std::atomic_thread_fence( std::memory_order_seq_cst );
+        const std::uint64_t state = m_state.load( std::memory_order_relaxed );
+        return waiters( state ) > signals( state );
+    }
+
+    /**
+     * @brief Counts up to _count more waiters as woken.
+     * @return false if every waiter had been woken already.
+     */
+    bool signal ( std::uint64_t _count ) noexcept
+    {
+        std::uint64_t state = m_state.load( std::memory_order_relaxed );
+        for ( ;; )
+        {
+            if ( waiters( state ) <= signals( state ) )
+                return false;
+
+            const std::uint64_t unsignaled =
+                waiters( state ) - signals( state );
+            const std::uint64_t added =
+                _count < unsignaled ? _count : unsignaled;
+
+            if ( m_state.compare_exchange_weak(
+                    state, state + added * s_oneSignal
+            ) )
+                return true;
+        }
+    }
+
+    /**
+     * @brief Unregisters a waiter. One whose key the epoch has moved past
+     *        takes a wakeup with it; one that was not notified leaves the
+     *        others' wakeups be.
+     *
+     * The epoch is read after the state on every attempt: a notifier counts
+     * its signal before moving the epoch, so if the move is missed, the CAS
+     * only succeeds when nobody registered since, and every waiter left read
+     * its key before the move and will see it.
+     *
+     * @return true if this waiter was notified.
+     */
+    bool leave ( Key _key ) noexcept
+    {
+        std::uint64_t state = m_state.load( std::memory_order_acquire );
+        for ( ;; )
+        {
+            const bool notified =
+                m_epoch.load( std::memory_order_acquire ) != _key;
+
+            const std::uint64_t waitersLeft = waiters( state ) - 1;
+            std::uint64_t signalsLeft = signals( state );
+
+            if ( notified && signalsLeft > 0 )
+                --signalsLeft;
+            if ( signalsLeft > waitersLeft )
+                signalsLeft = waitersLeft;
+
+            if ( m_state.compare_exchange_weak(
+                    state, signalsLeft * s_oneSignal + waitersLeft
+            ) )
+                return notified;
+        }
+    }
+
+#if defined( __linux__ )
+
+    // Sleeps until the epoch moves away from _key, a signal or the deadline
+    void sleep ( Key _key, const Clock::time_point * _pDeadline ) noexcept
+    {
+        static_assert(
+                sizeof( m_epoch ) == sizeof( Key )
+            &&  std::atomic< Key >::is_always_lock_free
+            ,   "the futex word must be the plain epoch value"
+        );
+
+        timespec deadline;
+        if ( _pDeadline )
+        {
+            // FUTEX_WAIT_BITSET takes an absolute CLOCK_MONOTONIC time,
+            // which is what steady_clock reads
+            const auto sinceEpoch = _pDeadline->time_since_epoch();
+            const auto seconds =
+                std::chrono::duration_cast< std::chrono::seconds >(
+                    sinceEpoch
+                );
+            deadline.tv_sec = seconds.count();
+            deadline.tv_nsec =
+                std::chrono::duration_cast< std::chrono::nanoseconds >(
+                    sinceEpoch - seconds
+                ).count();
+        }
+
+        syscall(
+                SYS_futex
+            ,   reinterpret_cast< Key * >( &m_epoch )
+            ,   FUTEX_WAIT_BITSET | m_futexPrivateFlag
+            ,   _key
+            ,   _pDeadline ? &deadline : nullptr
+            ,   nullptr
+            ,   FUTEX_BITSET_MATCH_ANY
+        );
+    }
+
+    void wake ( int _count ) noexcept
+    {
+        m_epoch.fetch_add( 1, std::memory_order_release );
+        syscall(
+                SYS_futex
+            ,   reinterpret_cast< Key * >( &m_epoch )
+            ,   FUTEX_WAKE | m_futexPrivateFlag
+            ,   _count
+        );
+    }
+
+#else
+
+    void sleep ( Key _key, const Clock::time_point * _pDeadline )
+    {
+        std::unique_lock< std::mutex > lck( m_mutex );
+        const auto moved = [ this, _key ] () {
+            return m_epoch.load( std::memory_order_relaxed ) != _key;
+        };
+
+        if ( _pDeadline )
+            m_cond.wait_until( lck, *_pDeadline, moved );
+        else
+            m_cond.wait( lck, moved );
+    }
+
+    void wake ( int _count )
+    {
+        {
+            std::lock_guard< std::mutex > lck( m_mutex );
+            m_epoch.fetch_add( 1, std::memory_order_release );
+        }
+
+        if ( _count == 1 )
+            m_cond.notify_one();
+        else
+            m_cond.notify_all();
+    }
+
+#endif
+
+private:
+
+    std::atomic< Key > m_epoch;
+    std::atomic< std::uint64_t > m_state;
+
+#if defined( __linux__ )
+    const int m_futexPrivateFlag;
+#else
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+#endif
+};
+
+/*----------------------------------------------------------------------------*/
+
+#endif // __SHAREDQUEUE_SRC_IMPL_EVENTCOUNT_H__
@@ -0,0 +1,77 @@
+#include "impl/EventFd.h"
+
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <system_error>
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+/*----------------------------------------------------------------------------*/
+
+namespace
+{
+
+int createEventFd ()
+{
+    const int fd = ::eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+    if ( fd < 0 )
+        throw std::system_error( errno, std::system_category(), "eventfd" );
+
+    return fd;
+}
+
+} // namespace
+
+/*----------------------------------------------------------------------------*/
+
+EventFd::EventFd ()
+    :   m_fd( createEventFd() )
+{
+}
+
+/*----------------------------------------------------------------------------*/
+
+EventFd::~EventFd ()
+{
+    ::close( m_fd );
+}
+
+/*----------------------------------------------------------------------------*/
+
+int EventFd::fd () const noexcept
+{
+    return m_fd;
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Only fails with EAGAIN once the counter is about to overflow, and then the
+// descriptor is readable anyway
+void EventFd::signal () noexcept
+{
+    const std::uint64_t one = 1;
+    ssize_t written;
+    do
+        written = ::write( m_fd, &one, sizeof( one ) );
+    while ( written < 0 && errno == EINTR );
+
+    assert( written == sizeof( one ) || errno == EAGAIN );
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Reading resets the counter; EAGAIN just means it was already zero
+void EventFd::clear () noexcept
+{
+    std::uint64_t counter;
+    ssize_t read;
+    do
+        read = ::read( m_fd, &counter, sizeof( counter ) );
+    while ( read < 0 && errno == EINTR );
+
+    assert( read == sizeof( counter ) || errno == EAGAIN );
+}
+
+/*----------------------------------------------------------------------------*/
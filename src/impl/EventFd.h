@@ -0,0 +1,47 @@
+#ifndef __SHAREDQUEUE_SRC_IMPL_EVENTFD_H__
+#define __SHAREDQUEUE_SRC_IMPL_EVENTFD_H__
+
+/*----------------------------------------------------------------------------*/
+
+#if !defined( __linux__ )
+#error "EventFd.h needs Linux eventfd"
+#endif
+
+/*----------------------------------------------------------------------------*/
+
+/**
+ * @class EventFd
+ *
+ * @brief Owns a non-blocking eventfd: readable from signal() until clear().
+ *
+ * The descriptor can be watched by epoll/poll/select like a socket; it is
+ * opened with close-on-exec.
+ */
+class EventFd
+{
+public:
+
+    /**
+     * @throw std::system_error if no descriptor could be created.
+     */
+    EventFd ();
+
+    ~EventFd ();
+
+    EventFd ( const EventFd & ) = delete;
+    EventFd & operator = ( const EventFd & ) = delete;
+
+    int fd () const noexcept;
+
+    void signal () noexcept;
+
+    void clear () noexcept;
+
+private:
+
+    const int m_fd;
+};
+
+/*----------------------------------------------------------------------------*/
+
+#endif // __SHAREDQUEUE_SRC_IMPL_EVENTFD_H__
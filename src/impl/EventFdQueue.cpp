@@ -0,0 +1,259 @@
+#include "impl/EventFdQueue.h"
+
+#include <cassert>
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+EventFdQueue< _T >::EventFdQueue ( std::unique_ptr< IQueue< _T > > _pQueue )
+    :   m_pQueue( std::move( _pQueue ) )
+    ,   m_signalled( false )
+{
+    assert( m_pQueue );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+int EventFdQueue< _T >::fd () const noexcept
+{
+    return m_eventFd.fd();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+int EventFdQueue< _T >::count () const
+{
+    return m_pQueue->count();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t EventFdQueue< _T >::capacity () const
+{
+    return m_pQueue->capacity();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool EventFdQueue< _T >::setCapacity ( std::size_t _capacity )
+{
+    return m_pQueue->setCapacity( _capacity );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool EventFdQueue< _T >::setAutoGrow ( std::size_t _maxCapacity )
+{
+    return m_pQueue->setAutoGrow( _maxCapacity );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+QueueStats EventFdQueue< _T >::stats () const
+{
+    return m_pQueue->stats();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+void EventFdQueue< _T >::close ()
+{
+    m_pQueue->close();
+    onEnqueued();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool EventFdQueue< _T >::isClosed () const
+{
+    return m_pQueue->isClosed();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+void EventFdQueue< _T >::enqueue ( _T * _pNewValue )
+{
+    m_pQueue->enqueue( _pNewValue );
+    onEnqueued();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool EventFdQueue< _T >::enqueue ( _T * _pNewValue, int _millisecondsTimeout )
+{
+    if ( !m_pQueue->enqueue( _pNewValue, _millisecondsTimeout ) )
+        return false;
+
+    onEnqueued();
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool EventFdQueue< _T >::tryEnqueue ( _T * _pNewValue )
+{
+    if ( !m_pQueue->tryEnqueue( _pNewValue ) )
+        return false;
+
+    onEnqueued();
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+_T * EventFdQueue< _T >::dequeue ()
+{
+    return m_pQueue->dequeue();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+_T * EventFdQueue< _T >::dequeue ( int _millisecondsTimeout )
+{
+    return m_pQueue->dequeue( _millisecondsTimeout );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+_T * EventFdQueue< _T >::tryDequeue ()
+{
+    _T * const pReturnVal = m_pQueue->tryDequeue();
+
+    onDequeued();
+    return pReturnVal;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+void EventFdQueue< _T >::enqueueBulk ( _T ** _ppItems, std::size_t _count )
+{
+    m_pQueue->enqueueBulk( _ppItems, _count );
+    if ( _count > 0 )
+        onEnqueued();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t EventFdQueue< _T >::enqueueBulk (
+        _T ** _ppItems
+    ,   std::size_t _count
+    ,   int _millisecondsTimeout
+)
+{
+    const std::size_t enqueued =
+        m_pQueue->enqueueBulk( _ppItems, _count, _millisecondsTimeout );
+    if ( enqueued > 0 )
+        onEnqueued();
+
+    return enqueued;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t EventFdQueue< _T >::tryEnqueueBulk (
+        _T ** _ppItems
+    ,   std::size_t _count
+)
+{
+    const std::size_t enqueued = m_pQueue->tryEnqueueBulk( _ppItems, _count );
+    if ( enqueued > 0 )
+        onEnqueued();
+
+    return enqueued;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t EventFdQueue< _T >::dequeueBulk (
+        _T ** _ppItems
+    ,   std::size_t _maxCount
+)
+{
+    return m_pQueue->dequeueBulk( _ppItems, _maxCount );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t EventFdQueue< _T >::dequeueBulk (
+        _T ** _ppItems
+    ,   std::size_t _maxCount
+    ,   int _millisecondsTimeout
+)
+{
+    return m_pQueue->dequeueBulk( _ppItems, _maxCount, _millisecondsTimeout );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t EventFdQueue< _T >::tryDequeueBulk (
+        _T ** _ppItems
+    ,   std::size_t _maxCount
+)
+{
+    const std::size_t dequeued =
+        m_pQueue->tryDequeueBulk( _ppItems, _maxCount );
+
+    onDequeued();
+    return dequeued;
+}
+
+/*----------------------------------------------------------------------------*/
+
+// The fence pairs with the one in onDequeued(): either we see the flag
+// cleared and signal, or the consumer's second look at the queue sees our
+// item. While the flag is set the whole burst stays off the syscall.
+template < typename _T >
+void EventFdQueue< _T >::onEnqueued () noexcept
+{
+    std::atomic_thread_fence( std::memory_order_seq_cst );
+
+    if ( m_signalled.load( std::memory_order_relaxed ) )
+        return;
+
+    if ( !m_signalled.exchange( true, std::memory_order_acq_rel ) )
+        m_eventFd.signal();
+}
+
+/*----------------------------------------------------------------------------*/
+
+// While items are left, or the queue is closed, the descriptor just stays
+// readable. Only a take that finds the queue empty resets it, and then looks
+// again for items whose producers still saw the flag set and did not signal.
+// The reset does not trust the flag: a producer may set it just before our
+// check and write the descriptor only after it.
+template < typename _T >
+void EventFdQueue< _T >::onDequeued () noexcept
+{
+    if ( m_pQueue->count() > 0 || m_pQueue->isClosed() )
+        return;
+
+    m_eventFd.clear();
+    m_signalled.store( false, std::memory_order_relaxed );
+
+    std::atomic_thread_fence( std::memory_order_seq_cst );
+
+    if ( m_pQueue->count() > 0 || m_pQueue->isClosed() )
+        onEnqueued();
+}
+
+/*----------------------------------------------------------------------------*/
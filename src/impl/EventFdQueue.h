@@ -0,0 +1,133 @@
+#ifndef __SHAREDQUEUE_SRC_IMPL_EVENTFDQUEUE_H__
+#define __SHAREDQUEUE_SRC_IMPL_EVENTFDQUEUE_H__
+
+/*----------------------------------------------------------------------------*/
+
+#include "IQueue.h"
+#include "impl/EventFd.h"
+
+#include <atomic>
+#include <memory>
+
+/*----------------------------------------------------------------------------*/
+
+/**
+ * @class EventFdQueue
+ *
+ * @brief Wraps any IQueue and exposes a file descriptor that is readable
+ *        while the queue may hold items, for threads running an epoll loop.
+ *
+ * Producers write to the eventfd only when they find it unsignalled, i.e.
+ * on the empty to non-empty transition as the event loop sees it, so a
+ * burst of enqueues costs one syscall. The event loop watches fd() for
+ * EPOLLIN (level-triggered) and, when it fires, calls tryDequeue() or
+ * tryDequeueBulk(): these leave the eventfd alone while items remain and
+ * reset it only once they find the queue empty, so a burst costs one write
+ * and one read however many calls drain it. A bounded drain per wakeup
+ * keeps the descriptor readable without losing wakeups.
+ *
+ * The blocking dequeue calls are forwarded untouched; a thread using them
+ * can leave the descriptor readable over an empty queue, which only costs
+ * the event loop a spurious wakeup.
+ *
+ * Once the queue is closed the descriptor stays readable, like a socket at
+ * end of file: the event loop drains what is left and, when a drain comes
+ * back empty and isClosed() is true, unregisters it.
+ */
+template < typename _T >
+class EventFdQueue
+    :   public IQueue < _T >
+{
+public:
+
+    /**
+     * @throw std::system_error if no eventfd could be created.
+     */
+    explicit EventFdQueue ( std::unique_ptr< IQueue< _T > > _pQueue );
+
+    /**
+     * @brief The descriptor to register with epoll for EPOLLIN.
+     */
+    int fd () const noexcept;
+
+    int count () const override;
+
+    std::size_t capacity () const override;
+
+    bool setCapacity ( std::size_t _capacity ) override;
+
+    bool setAutoGrow ( std::size_t _maxCapacity ) override;
+
+    QueueStats stats () const override;
+
+    void close () override;
+
+    bool isClosed () const override;
+
+    void enqueue ( _T * _pNewValue ) override;
+
+    bool enqueue ( _T * _pNewValue, int _millisecondsTimeout ) override;
+
+    bool tryEnqueue ( _T * _pNewValue ) override;
+
+    _T * dequeue () override;
+
+    _T * dequeue ( int _millisecondsTimeout ) override;
+
+    _T * tryDequeue () override;
+
+    void enqueueBulk ( _T ** _ppItems, std::size_t _count ) override;
+
+    std::size_t enqueueBulk (
+            _T ** _ppItems
+        ,   std::size_t _count
+        ,   int _millisecondsTimeout
+    ) override;
+
+    std::size_t tryEnqueueBulk (
+            _T ** _ppItems
+        ,   std::size_t _count
+    ) override;
+
+    std::size_t dequeueBulk (
+            _T ** _ppItems
+        ,   std::size_t _maxCount
+    ) override;
+
+    std::size_t dequeueBulk (
+            _T ** _ppItems
+        ,   std::size_t _maxCount
+        ,   int _millisecondsTimeout
+    ) override;
+
+    /**
+     * @brief Drains up to _maxCount items without blocking.
+     */
+    std::size_t tryDequeueBulk (
+            _T ** _ppItems
+        ,   std::size_t _maxCount
+    ) override;
+
+private:
+
+    void onEnqueued () noexcept;
+
+    void onDequeued () noexcept;
+
+private:
+
+    std::unique_ptr< IQueue< _T > > m_pQueue;
+
+    EventFd m_eventFd;
+
+    // Whether the eventfd has been written since it was last reset
+    std::atomic< bool > m_signalled;
+};
+
+/*----------------------------------------------------------------------------*/
+
+#include "impl/EventFdQueue.cpp"
+
+/*----------------------------------------------------------------------------*/
+
+#endif // __SHAREDQUEUE_SRC_IMPL_EVENTFDQUEUE_H__
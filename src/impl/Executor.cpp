@@ -0,0 +1,116 @@
+#include "impl/Executor.h"
+
+/*----------------------------------------------------------------------------*/
+
+namespace
+{
+
+// 0 is left for "no executor" in Executor::reservePool()
+std::atomic< std::uint64_t > g_nextExecutorId( 1 );
+
+} // namespace
+
+/*----------------------------------------------------------------------------*/
+
+Executor::Executor (
+        std::unique_ptr< TaskQueue > _pQueue
+    ,   std::size_t _threadCount
+)
+    :   m_pQueue( std::move( _pQueue ) )
+    ,   m_pendingTasks( 0 )
+    ,   m_stopped( false )
+    ,   m_id( g_nextExecutorId.fetch_add( 1, std::memory_order_relaxed ) )
+{
+    const std::size_t threadCount = _threadCount > 0
+        ?   _threadCount
+        :   std::max( std::thread::hardware_concurrency(), 1u )
+    ;
+
+    // States are acquired by submitters and released by workers, and each
+    // thread's pool cache holds up to a batch before handing it on; besides
+    // those, the pool keeps enough for a deep queue. The reservation only
+    // caps what a pool keeps, so nothing is allocated for it up front. A
+    // parallelFor control block lives as long as its helpers are queued, so
+    // the same goes for it.
+    m_poolReserve =
+            s_maxPooledTasks
+        +   ( threadCount + 1 ) * ControlPool::s_batchSize
+    ;
+
+    m_workers.reserve( threadCount );
+    for ( std::size_t i = 0; i < threadCount; ++i )
+        m_workers.emplace_back( [ this ] () { workerLoop(); } );
+
+    ControlPool::instance().reserve( m_poolReserve );
+}
+
+/*----------------------------------------------------------------------------*/
+
+Executor::~Executor ()
+{
+    shutdown();
+
+    for ( auto pUnreserve: m_unreservePools )
+        pUnreserve( m_poolReserve );
+
+    ControlPool::instance().unreserve( m_poolReserve );
+}
+
+/*----------------------------------------------------------------------------*/
+
+std::size_t Executor::threadCount () const noexcept
+{
+    return m_workers.size();
+}
+
+/*----------------------------------------------------------------------------*/
+
+void Executor::shutdown ()
+{
+    std::lock_guard< std::mutex > lck( m_shutdownMutex );
+    if ( m_stopped.load() )
+        return;
+
+    // Running tasks may still submit more, so wait for the count rather than
+    // for the queue to look empty
+    m_idleEvent.await( [ this ] () {
+        return m_pendingTasks.load( std::memory_order_acquire ) == 0;
+    } );
+
+    m_stopped.store( true );
+
+    // Nothing is queued any more, so every worker's dequeue() returns nullptr
+    m_pQueue->close();
+
+    for ( auto & worker: m_workers )
+        worker.join();
+}
+
+/*----------------------------------------------------------------------------*/
+
+void Executor::releaseControl ( ParallelForControl * _pControl ) noexcept
+{
+    if ( _pControl->references.fetch_sub( 1, std::memory_order_acq_rel ) == 1 )
+        ControlPool::instance().release( _pControl );
+}
+
+/*----------------------------------------------------------------------------*/
+
+void Executor::workerLoop ()
+{
+    while ( ExecutorTask * pTask = m_pQueue->dequeue() )
+    {
+        pTask->run();
+        onTaskDone();
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+void Executor::onTaskDone () noexcept
+{
+    if ( m_pendingTasks.fetch_sub( 1, std::memory_order_acq_rel ) == 1 )
+        m_idleEvent.notifyAll();
+}
+
+/*----------------------------------------------------------------------------*/
@@ -0,0 +1,330 @@
+#ifndef __SHAREDQUEUE_SRC_IMPL_EXECUTOR_H__
+#define __SHAREDQUEUE_SRC_IMPL_EXECUTOR_H__
+
+/*----------------------------------------------------------------------------*/
+
+#include "IQueue.h"
+#include "impl/EventCount.h"
+#include "impl/Future.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*----------------------------------------------------------------------------*/
+
+/**
+ * @class Executor
+ *
+ * @brief Fixed pool of worker threads running tasks taken from any IQueue.
+ *
+ * submit() wraps a callable in a pooled TaskState, which doubles as the
+ * queue item and as the shared state of the returned Future. A bounded
+ * queue makes submit() block while it is full.
+ *
+ * Each task type's pool is allowed to keep a deep queue's worth of states,
+ * plus a cache batch per thread, for as long as the executor lives, so that
+ * a warm executor submits without touching the heap.
+ *
+ * shutdown() (also run by the destructor) drains gracefully: it waits until
+ * every submitted task has run, including the ones those tasks submit, and
+ * only then stops the workers. It counts tasks rather than relying on queue
+ * order, so it works with the non-FIFO queues as well.
+ *
+ * Please note: a task that submits more tasks to a full queue blocks its
+ * worker, so bounded queues should leave room for nested submissions.
+ */
+class Executor
+{
+public:
+
+    using TaskQueue = IQueue< ExecutorTask >;
+
+    /**
+     * @param _threadCount 0 means one worker per hardware thread.
+     */
+    explicit Executor (
+            std::unique_ptr< TaskQueue > _pQueue
+        ,   std::size_t _threadCount = 0
+    );
+
+    ~Executor ();
+
+    Executor ( const Executor & ) = delete;
+    Executor & operator = ( const Executor & ) = delete;
+
+    std::size_t threadCount () const noexcept;
+
+    /**
+     * @throw QueueClosed after shutdown(); nothing is left pending then.
+     */
+    template < typename _FunctionT >
+    Future< std::invoke_result_t< std::decay_t< _FunctionT > & > >
+    submit ( _FunctionT && _function );
+
+    /**
+     * @brief Calls _body( i ) for every i in [ _begin, _end ) and returns once
+     *        all calls are done, rethrowing the first exception thrown.
+     *
+     * The range is cut into chunks of _grainSize indices (0 picks a size that
+     * gives every worker a few chunks). The calling thread works on chunks
+     * too and only waits for chunks already running, so parallelFor may be
+     * nested inside a task; after shutdown() it runs every chunk itself.
+     */
+    template < typename _BodyT >
+    void parallelFor (
+            std::size_t _begin
+        ,   std::size_t _end
+        ,   _BodyT && _body
+        ,   std::size_t _grainSize = 0
+    );
+
+    /**
+     * @brief Runs every submitted task, then stops and joins the workers.
+     *        Idempotent; nothing may be submitted afterwards.
+     */
+    void shutdown ();
+
+private:
+
+    // What the helpers of one parallelFor call share; pooled and released by
+    // whoever is last, as helpers may only get to run after the call returned
+    struct ParallelForControl
+    {
+        std::atomic< std::size_t > nextChunk;
+        std::atomic< std::size_t > doneChunks;
+        std::atomic< std::size_t > references;
+        EventCount doneEvent;
+        std::mutex errorMutex;
+        std::exception_ptr pError;
+    };
+
+    using ControlPool = NodePool< ParallelForControl >;
+
+    // Queued tasks the pools keep states for; a deeper backlog goes back to
+    // the heap as it drains
+    static constexpr std::size_t s_maxPooledTasks = 65536;
+
+    template < typename _R, typename _FunctionT >
+    FutureState< _R > * post ( _FunctionT && _function, int _references );
+
+    template < typename _TaskT >
+    void reservePool ();
+
+    template < typename _TaskT >
+    static void unreservePool ( std::size_t _nodesCount );
+
+    static void releaseControl ( ParallelForControl * _pControl ) noexcept;
+
+    void workerLoop ();
+
+    void onTaskDone () noexcept;
+
+private:
+
+    std::unique_ptr< TaskQueue > m_pQueue;
+    std::vector< std::thread > m_workers;
+
+    std::atomic< std::size_t > m_pendingTasks;
+    EventCount m_idleEvent;
+
+    std::mutex m_shutdownMutex;
+    std::atomic< bool > m_stopped;
+
+    // Tells executors apart in the per-thread check of reservePool(), where
+    // an address could be reused
+    const std::uint64_t m_id;
+
+    // Nodes reserved in the control pool and in the pool of each task type
+    // this executor has posted
+    std::size_t m_poolReserve;
+
+    std::mutex m_reserveMutex;
+    std::vector< void ( * ) ( std::size_t ) > m_unreservePools;
+};
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _FunctionT >
+Future< std::invoke_result_t< std::decay_t< _FunctionT > & > >
+Executor::submit ( _FunctionT && _function )
+{
+    using Result = std::invoke_result_t< std::decay_t< _FunctionT > & >;
+
+    // One reference for the worker, one for the Future
+    return Future< Result >(
+        post< Result >( std::forward< _FunctionT >( _function ), 2 )
+    );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _BodyT >
+void Executor::parallelFor (
+        std::size_t _begin
+    ,   std::size_t _end
+    ,   _BodyT && _body
+    ,   std::size_t _grainSize
+)
+{
+    if ( _begin >= _end )
+        return;
+
+    constexpr std::size_t chunksPerWorker = 4;
+
+    const std::size_t count = _end - _begin;
+    const std::size_t chunkSize = _grainSize > 0
+        ?   _grainSize
+        :   std::max< std::size_t >(
+                1, count / ( chunksPerWorker * m_workers.size() )
+            )
+    ;
+    const std::size_t chunkCount = ( count + chunkSize - 1 ) / chunkSize;
+
+    const std::size_t helpers = std::min( m_workers.size(), chunkCount - 1 );
+
+    // Helpers touch _body only after claiming a chunk, and we wait for every
+    // claimed chunk; the control block itself outlives us if need be
+    ParallelForControl * const pControl = ControlPool::instance().acquire();
+    pControl->nextChunk.store( 0, std::memory_order_relaxed );
+    pControl->doneChunks.store( 0, std::memory_order_relaxed );
+    pControl->references.store( 1, std::memory_order_relaxed );
+
+    auto runChunks = [ pControl, &_body, _begin, _end, chunkSize, chunkCount ]
+    {
+        ParallelForControl & rControl = *pControl;
+        for ( ;; )
+        {
+            const std::size_t chunk = rControl.nextChunk.fetch_add( 1 );
+            if ( chunk >= chunkCount )
+                return;
+
+            const std::size_t first = _begin + chunk * chunkSize;
+            const std::size_t last = std::min( _end, first + chunkSize );
+            try
+            {
+                for ( std::size_t i = first; i < last; ++i )
+                    _body( i );
+            }
+            catch ( ... )
+            {
+                std::lock_guard< std::mutex > lck( rControl.errorMutex );
+                if ( !rControl.pError )
+                    rControl.pError = std::current_exception();
+            }
+
+            if ( rControl.doneChunks.fetch_add( 1 ) + 1 == chunkCount )
+                rControl.doneEvent.notifyAll();
+        }
+    };
+
+    // A helper that cannot be posted, as once the queue is closed, leaves its
+    // chunks to us
+    for ( std::size_t i = 0; i < helpers; ++i )
+    {
+        pControl->references.fetch_add( 1, std::memory_order_relaxed );
+        try
+        {
+            post< void >(
+                    [ runChunks, pControl ] () {
+                        runChunks();
+                        releaseControl( pControl );
+                    }
+                ,   1
+            );
+        }
+        catch ( ... )
+        {
+            releaseControl( pControl );
+            break;
+        }
+    }
+
+    runChunks();
+
+    pControl->doneEvent.await( [ &rControl = *pControl, chunkCount ] () {
+        return rControl.doneChunks.load() == chunkCount;
+    } );
+
+    const std::exception_ptr pError = std::move( pControl->pError );
+    releaseControl( pControl );
+
+    if ( pError )
+        std::rethrow_exception( pError );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _R, typename _FunctionT >
+FutureState< _R > * Executor::post ( _FunctionT && _function, int _references )
+{
+    using Task = TaskState< _R, std::decay_t< _FunctionT > >;
+
+    reservePool< Task >();
+
+    Task * const pTask = Task::Pool::instance().acquire(
+        std::decay_t< _FunctionT >( std::forward< _FunctionT >( _function ) )
+    ,   _references
+    );
+
+    m_pendingTasks.fetch_add( 1, std::memory_order_relaxed );
+    try
+    {
+        m_pQueue->enqueue( pTask );
+    }
+    catch ( ... )
+    {
+        // Nobody else has seen the task yet
+        Task::Pool::instance().release( pTask );
+        onTaskDone();
+        throw;
+    }
+
+    return pTask;
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Only the first post of a task type from a thread takes the lock
+template < typename _TaskT >
+void Executor::reservePool ()
+{
+    static thread_local std::uint64_t s_reservedFor = 0;
+    if ( s_reservedFor == m_id )
+        return;
+
+    void ( * const pUnreserve ) ( std::size_t ) = &unreservePool< _TaskT >;
+    {
+        std::lock_guard< std::mutex > lck( m_reserveMutex );
+        if (
+                std::find(
+                    m_unreservePools.begin(), m_unreservePools.end(), pUnreserve
+                )
+            ==  m_unreservePools.end()
+        )
+        {
+            _TaskT::Pool::instance().reserve( m_poolReserve );
+            m_unreservePools.push_back( pUnreserve );
+        }
+    }
+
+    s_reservedFor = m_id;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _TaskT >
+void Executor::unreservePool ( std::size_t _nodesCount )
+{
+    _TaskT::Pool::instance().unreserve( _nodesCount );
+}
+
+/*----------------------------------------------------------------------------*/
+
+#endif // __SHAREDQUEUE_SRC_IMPL_EXECUTOR_H__
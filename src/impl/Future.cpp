@@ -0,0 +1,229 @@
+#include "impl/Future.h"
+
+#include <cassert>
+#include <chrono>
+#include <utility>
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _R >
+FutureState< _R >::FutureState ( int _references )
+    :   m_references( _references )
+    ,   m_ready( false )
+{
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _R >
+bool FutureState< _R >::ready () const noexcept
+{
+    return m_ready.load( std::memory_order_acquire );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _R >
+void FutureState< _R >::wait ()
+{
+    m_readyEvent.await( [ this ] () { return ready(); } );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _R >
+bool FutureState< _R >::waitUntil ( EventCount::Clock::time_point _deadline )
+{
+    return m_readyEvent.awaitUntil(
+        [ this ] () { return ready(); }, _deadline
+    );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _R >
+_R FutureState< _R >::takeResult ()
+{
+    assert( ready() );
+
+    if ( m_pError )
+        std::rethrow_exception( m_pError );
+
+    if constexpr ( !std::is_void< _R >::value )
+        return std::move( *m_value );
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Whoever drops the last reference, the worker or the Future, hands the
+// storage back to the pool
+template < typename _R >
+void FutureState< _R >::release () noexcept
+{
+    if ( m_references.fetch_sub( 1, std::memory_order_acq_rel ) == 1 )
+        destroy();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _R >
+template < typename _FunctionT >
+void FutureState< _R >::complete ( _FunctionT & _rFunction ) noexcept
+{
+    try
+    {
+        if constexpr ( std::is_void< _R >::value )
+        {
+            _rFunction();
+            m_value.emplace();
+        }
+        else
+        {
+            m_value.emplace( _rFunction() );
+        }
+    }
+    catch ( ... )
+    {
+        m_pError = std::current_exception();
+    }
+
+    m_ready.store( true, std::memory_order_release );
+
+    // Still holding our reference, so a woken waiter cannot free the event
+    // under our feet
+    m_readyEvent.notifyAll();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _R, typename _FunctionT >
+TaskState< _R, _FunctionT >::TaskState (
+        _FunctionT && _function
+    ,   int _references
+)
+    :   FutureState< _R >( _references )
+    ,   m_function( std::move( _function ) )
+{
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _R, typename _FunctionT >
+void TaskState< _R, _FunctionT >::run () noexcept
+{
+    this->complete( m_function );
+    this->release();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _R, typename _FunctionT >
+void TaskState< _R, _FunctionT >::destroy () noexcept
+{
+    Pool::instance().release( this );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _R >
+Future< _R >::Future () noexcept
+    :   m_pState( nullptr )
+{
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _R >
+Future< _R >::Future ( FutureState< _R > * _pState ) noexcept
+    :   m_pState( _pState )
+{
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _R >
+Future< _R >::Future ( Future && _other ) noexcept
+    :   m_pState( std::exchange( _other.m_pState, nullptr ) )
+{
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _R >
+Future< _R > & Future< _R >::operator = ( Future && _other ) noexcept
+{
+    if ( this != &_other )
+    {
+        if ( m_pState )
+            m_pState->release();
+        m_pState = std::exchange( _other.m_pState, nullptr );
+    }
+    return *this;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _R >
+Future< _R >::~Future ()
+{
+    if ( m_pState )
+        m_pState->release();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _R >
+bool Future< _R >::valid () const noexcept
+{
+    return m_pState != nullptr;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _R >
+bool Future< _R >::ready () const noexcept
+{
+    assert( valid() );
+    return m_pState->ready();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _R >
+void Future< _R >::wait () const
+{
+    assert( valid() );
+    m_pState->wait();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _R >
+bool Future< _R >::wait ( int _millisecondsTimeout ) const
+{
+    assert( valid() );
+    return m_pState->waitUntil(
+            EventCount::Clock::now()
+        +   std::chrono::milliseconds( _millisecondsTimeout )
+    );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _R >
+_R Future< _R >::get ()
+{
+    assert( valid() );
+    m_pState->wait();
+
+    // Give the state back even if the task threw
+    struct Releaser
+    {
+        ~Releaser () { pState->release(); }
+        FutureState< _R > * pState;
+    } releaser { std::exchange( m_pState, nullptr ) };
+
+    return releaser.pState->takeResult();
+}
+
+/*----------------------------------------------------------------------------*/
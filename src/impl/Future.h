@@ -0,0 +1,180 @@
+#ifndef __SHAREDQUEUE_SRC_IMPL_FUTURE_H__
+#define __SHAREDQUEUE_SRC_IMPL_FUTURE_H__
+
+/*----------------------------------------------------------------------------*/
+
+#include "impl/EventCount.h"
+#include "impl/NodePool.h"
+
+#include <atomic>
+#include <exception>
+#include <optional>
+#include <type_traits>
+
+/*----------------------------------------------------------------------------*/
+
+/**
+ * @class ExecutorTask
+ *
+ * @brief What an Executor's queue carries: a pointer to a task that knows how
+ *        to run itself and hand its storage back.
+ */
+class ExecutorTask
+{
+public:
+
+    /**
+     * @brief Runs the task and drops the executor's reference to it; the
+     *        task must not be touched afterwards.
+     */
+    virtual void run () noexcept = 0;
+
+protected:
+
+    ~ExecutorTask () = default;
+};
+
+/*----------------------------------------------------------------------------*/
+
+/**
+ * @class FutureState
+ *
+ * @brief Shared state of a Future: the result slot, the ready flag and the
+ *        references held by the executor and by the Future.
+ *
+ * Every task type gets its storage from a NodePool, which the Executor
+ * reserves room in, so submitting a task costs no heap allocation once the
+ * pool is warm.
+ */
+template < typename _R >
+class FutureState
+    :   public ExecutorTask
+{
+public:
+
+    bool ready () const noexcept;
+
+    void wait ();
+
+    /**
+     * @return false if the result was not ready before the deadline.
+     */
+    bool waitUntil ( EventCount::Clock::time_point _deadline );
+
+    /**
+     * @brief Moves the result out, or rethrows what the function threw.
+     */
+    _R takeResult ();
+
+    void release () noexcept;
+
+protected:
+
+    explicit FutureState ( int _references );
+
+    ~FutureState () = default;
+
+    template < typename _FunctionT >
+    void complete ( _FunctionT & _rFunction ) noexcept;
+
+    virtual void destroy () noexcept = 0;
+
+private:
+
+    struct Empty {};
+
+    using Stored = std::conditional_t< std::is_void< _R >::value, Empty, _R >;
+
+    std::atomic< int > m_references;
+    std::atomic< bool > m_ready;
+    EventCount m_readyEvent;
+    std::optional< Stored > m_value;
+    std::exception_ptr m_pError;
+};
+
+/*----------------------------------------------------------------------------*/
+
+/**
+ * @class TaskState
+ *
+ * @brief FutureState that runs one particular callable type.
+ */
+template < typename _R, typename _FunctionT >
+class TaskState final
+    :   public FutureState< _R >
+{
+public:
+
+    using Pool = NodePool< TaskState >;
+
+    TaskState ( _FunctionT && _function, int _references );
+
+    void run () noexcept override;
+
+private:
+
+    void destroy () noexcept override;
+
+private:
+
+    _FunctionT m_function;
+};
+
+/*----------------------------------------------------------------------------*/
+
+/**
+ * @class Future
+ *
+ * @brief Result of Executor::submit(); a move-only handle on a pooled
+ *        FutureState.
+ */
+template < typename _R >
+class Future
+{
+public:
+
+    Future () noexcept;
+
+    explicit Future ( FutureState< _R > * _pState ) noexcept;
+
+    Future ( Future && _other ) noexcept;
+
+    Future & operator = ( Future && _other ) noexcept;
+
+    Future ( const Future & ) = delete;
+    Future & operator = ( const Future & ) = delete;
+
+    ~Future ();
+
+    /**
+     * @return false once get() was called, or for a default-constructed one.
+     */
+    bool valid () const noexcept;
+
+    bool ready () const noexcept;
+
+    void wait () const;
+
+    /**
+     * @return false if the result was not ready before the timeout expired.
+     */
+    bool wait ( int _millisecondsTimeout ) const;
+
+    /**
+     * @brief Waits for the result and moves it out (or rethrows what the
+     *        task threw); the Future is no longer valid afterwards.
+     */
+    _R get ();
+
+private:
+
+    FutureState< _R > * m_pState;
+};
+
+/*----------------------------------------------------------------------------*/
+
+#include "impl/Future.cpp"
+
+/*----------------------------------------------------------------------------*/
+
+#endif // __SHAREDQUEUE_SRC_IMPL_FUTURE_H__
@@ -0,0 +1,597 @@
+#include "impl/LockFreeQueue.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+struct LockFreeQueue< _T >::Cell
+{
+    // Sequences advance by two per position, otherwise a one-slot ring could
+    // not tell a published value from a slot that is free for the next lap
+    static constexpr std::size_t freeFor ( std::size_t _pos ) noexcept
+    {
+        return 2 * _pos;
+    }
+
+    static constexpr std::size_t publishedFor ( std::size_t _pos ) noexcept
+    {
+        return 2 * _pos + 1;
+    }
+
+    std::atomic< std::size_t > sequence;
+    _T * data;
+};
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+LockFreeQueue< _T >::LockFreeQueue (
+        std::size_t _size
+    ,   WaitStrategy _waitStrategy
+)
+    :   m_queueSize( _size )
+    ,   m_pBuffer( std::make_unique< Cell[] >( _size ) )
+    ,   m_enqueuePos( 0 )
+    ,   m_dequeuePos( 0 )
+    ,   m_events( *this, m_stats, _waitStrategy )
+{
+    assert( _size > 0 );
+
+    for ( std::size_t i = 0; i < m_queueSize; ++i )
+        m_pBuffer[ i ].sequence.store(
+            Cell::freeFor( i ), std::memory_order_relaxed
+        );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+LockFreeQueue< _T >::~LockFreeQueue ()
+{
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+int LockFreeQueue< _T >::count () const noexcept
+{
+    // Read the consumer position first: the producer position can only grow
+    // afterwards, so the difference never goes negative.
+    const std::size_t dequeuePos =
+        m_dequeuePos.load( std::memory_order_acquire );
+    const std::size_t enqueuePos =
+        m_enqueuePos.load( std::memory_order_acquire ) & ~s_closedBit;
+
+    const std::size_t size = enqueuePos - dequeuePos;
+    return static_cast< int >( size < m_queueSize ? size : m_queueSize );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t LockFreeQueue< _T >::capacity () const noexcept
+{
+    return m_queueSize;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+QueueStats LockFreeQueue< _T >::stats () const
+{
+    return m_stats.snapshot();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+void LockFreeQueue< _T >::close ()
+{
+    if ( m_enqueuePos.fetch_or( s_closedBit ) & s_closedBit )
+        return;
+
+    m_events.onClosed();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool LockFreeQueue< _T >::isClosed () const noexcept
+{
+    return m_enqueuePos.load() & s_closedBit;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+void LockFreeQueue< _T >::enqueue ( _T * _pNewValue )
+{
+    assert( _pNewValue );
+
+    const bool pushed = m_events.awaitRoom(
+            [ this, _pNewValue ] () { return tryPush( _pNewValue ); }
+        ,   nullptr
+    );
+
+    if ( !pushed )
+        throw QueueClosed();
+
+    m_events.onEnqueued();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool LockFreeQueue< _T >::enqueue ( _T * _pNewValue, int _millisecondsTimeout )
+{
+    assert( _pNewValue );
+
+    using namespace std::chrono;
+
+    const auto deadline =
+        EventCount::Clock::now() + milliseconds( _millisecondsTimeout );
+
+    const bool pushed = m_events.awaitRoom(
+            [ this, _pNewValue ] () { return tryPush( _pNewValue ); }
+        ,   &deadline
+    );
+
+    if ( !pushed )
+        return false; // timed out or closed
+
+    m_events.onEnqueued();
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool LockFreeQueue< _T >::tryEnqueue ( _T * _pNewValue )
+{
+    assert( _pNewValue );
+
+    if ( !tryPush( _pNewValue ) )
+        return false;
+
+    m_events.onEnqueued();
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+_T * LockFreeQueue< _T >::dequeue ()
+{
+    _T * pReturnVal = nullptr;
+
+    const bool popped = m_events.awaitItems(
+            [ this, &pReturnVal ] () { return tryPop( pReturnVal ); }
+        ,   nullptr
+    );
+
+    if ( !popped )
+        return nullptr; // closed and drained
+
+    m_events.onDequeued();
+    return pReturnVal;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+_T * LockFreeQueue< _T >::dequeue ( int _millisecondsTimeout )
+{
+    using namespace std::chrono;
+
+    _T * pReturnVal = nullptr;
+
+    const auto deadline =
+        EventCount::Clock::now() + milliseconds( _millisecondsTimeout );
+
+    const bool popped = m_events.awaitItems(
+            [ this, &pReturnVal ] () { return tryPop( pReturnVal ); }
+        ,   &deadline
+    );
+
+    if ( !popped )
+        return nullptr; // timed out, or closed and drained
+
+    m_events.onDequeued();
+    return pReturnVal;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+_T * LockFreeQueue< _T >::tryDequeue ()
+{
+    _T * pReturnVal = nullptr;
+    if ( !tryPop( pReturnVal ) )
+        return nullptr;
+
+    m_events.onDequeued();
+    return pReturnVal;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+void LockFreeQueue< _T >::enqueueBulk ( _T ** _ppItems, std::size_t _count )
+{
+    assert( IQueue< _T >::noneIsNull( _ppItems, _count ) );
+
+    std::size_t enqueued = 0;
+    while ( enqueued < _count )
+    {
+        const bool progressed = m_events.awaitRoom(
+                [ & ] () {
+                    const std::size_t pushed =
+                        tryPushBulk( _ppItems + enqueued, _count - enqueued );
+                    enqueued += pushed;
+                    return pushed > 0;
+                }
+            ,   nullptr
+        );
+
+        if ( !progressed )
+            throw QueueClosed();
+
+        m_events.onEnqueued();
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t LockFreeQueue< _T >::enqueueBulk (
+        _T ** _ppItems
+    ,   std::size_t _count
+    ,   int _millisecondsTimeout
+)
+{
+    assert( IQueue< _T >::noneIsNull( _ppItems, _count ) );
+
+    using namespace std::chrono;
+
+    const auto deadline =
+        EventCount::Clock::now() + milliseconds( _millisecondsTimeout );
+
+    std::size_t enqueued = 0;
+    while ( enqueued < _count )
+    {
+        std::size_t pushed = 0;
+        m_events.awaitRoom(
+                [ & ] () {
+                    pushed =
+                        tryPushBulk( _ppItems + enqueued, _count - enqueued );
+                    return pushed > 0;
+                }
+            ,   &deadline
+        );
+
+        if ( pushed == 0 )
+            break; // timed out or closed
+
+        enqueued += pushed;
+        m_events.onEnqueued();
+    }
+
+    return enqueued;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t LockFreeQueue< _T >::tryEnqueueBulk (
+        _T ** _ppItems
+    ,   std::size_t _count
+)
+{
+    assert( IQueue< _T >::noneIsNull( _ppItems, _count ) );
+
+    const std::size_t enqueued = tryPushBulk( _ppItems, _count );
+    if ( enqueued > 0 )
+        m_events.onEnqueued();
+    return enqueued;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t LockFreeQueue< _T >::dequeueBulk (
+        _T ** _ppItems
+    ,   std::size_t _maxCount
+)
+{
+    if ( _maxCount == 0 )
+        return 0;
+
+    std::size_t dequeued = 0;
+    m_events.awaitItems(
+            [ & ] () {
+                dequeued = tryPopBulk( _ppItems, _maxCount );
+                return dequeued > 0;
+            }
+        ,   nullptr
+    );
+
+    if ( dequeued == 0 )
+        return 0; // closed and drained
+
+    m_events.onDequeued();
+    return dequeued;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t LockFreeQueue< _T >::dequeueBulk (
+        _T ** _ppItems
+    ,   std::size_t _maxCount
+    ,   int _millisecondsTimeout
+)
+{
+    using namespace std::chrono;
+
+    if ( _maxCount == 0 )
+        return 0;
+
+    const auto deadline =
+        EventCount::Clock::now() + milliseconds( _millisecondsTimeout );
+
+    std::size_t dequeued = 0;
+    m_events.awaitItems(
+            [ & ] () {
+                dequeued = tryPopBulk( _ppItems, _maxCount );
+                return dequeued > 0;
+            }
+        ,   &deadline
+    );
+
+    if ( dequeued > 0 )
+        m_events.onDequeued();
+    return dequeued;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t LockFreeQueue< _T >::tryDequeueBulk (
+        _T ** _ppItems
+    ,   std::size_t _maxCount
+)
+{
+    const std::size_t dequeued = tryPopBulk( _ppItems, _maxCount );
+    if ( dequeued > 0 )
+        m_events.onDequeued();
+    return dequeued;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool LockFreeQueue< _T >::tryPush ( _T * _pNewValue ) noexcept
+{
+    Cell * pCell;
+    std::size_t pos = m_enqueuePos.load( std::memory_order_relaxed );
+
+    for ( ;; )
+    {
+        if ( pos & s_closedBit )
+            return false;
+
+        pCell = &m_pBuffer[ pos % m_queueSize ];
+        const std::size_t sequence =
+            pCell->sequence.load( std::memory_order_acquire );
+        const std::intptr_t diff =
+            static_cast< std::intptr_t >( sequence )
+        -   static_cast< std::intptr_t >( Cell::freeFor( pos ) );
+
+        if ( diff == 0 )
+        {
+            // Slot is free for this position, try to claim it
+            if ( m_enqueuePos.compare_exchange_weak(
+                    pos, pos + 1, std::memory_order_relaxed
+            ) )
+                break;
+        }
+        else if ( diff < 0 )
+        {
+            return false; // full: slot still holds the previous lap
+        }
+        else
+        {
+            pos = m_enqueuePos.load( std::memory_order_relaxed );
+        }
+    }
+
+    pCell->data = _pNewValue;
+    pCell->sequence.store(
+        Cell::publishedFor( pos ), std::memory_order_release
+    );
+    m_stats.onEnqueued( 1, [ this ] () { return count(); } );
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool LockFreeQueue< _T >::tryPop ( _T * & _pValue ) noexcept
+{
+    Cell * pCell;
+    std::size_t pos = m_dequeuePos.load( std::memory_order_relaxed );
+
+    for ( ;; )
+    {
+        pCell = &m_pBuffer[ pos % m_queueSize ];
+        const std::size_t sequence =
+            pCell->sequence.load( std::memory_order_acquire );
+        const std::intptr_t diff =
+            static_cast< std::intptr_t >( sequence )
+        -   static_cast< std::intptr_t >( Cell::publishedFor( pos ) );
+
+        if ( diff == 0 )
+        {
+            // Slot holds a value for this position, try to claim it
+            if ( m_dequeuePos.compare_exchange_weak(
+                    pos, pos + 1, std::memory_order_relaxed
+            ) )
+                break;
+        }
+        else if ( diff < 0 )
+        {
+            return false; // empty: producer has not published this slot yet
+        }
+        else
+        {
+            pos = m_dequeuePos.load( std::memory_order_relaxed );
+        }
+    }
+
+    _pValue = pCell->data;
+    pCell->sequence.store(
+        Cell::freeFor( pos + m_queueSize ), std::memory_order_release
+    );
+    m_stats.onDequeued( 1 );
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Claims the run of consecutive positions whose slots consumers have already
+// released, checking each one before the CAS as tryPush() does, so that no
+// slot claimed here is still in another thread's hands.
+template < typename _T >
+std::size_t LockFreeQueue< _T >::tryPushBulk (
+        _T ** _ppItems
+    ,   std::size_t _count
+) noexcept
+{
+    if ( _count == 0 )
+        return 0;
+
+    const std::size_t maxCount = std::min( _count, m_queueSize );
+
+    std::size_t pos = m_enqueuePos.load( std::memory_order_relaxed );
+    std::size_t claimed;
+
+    for ( ;; )
+    {
+        if ( pos & s_closedBit )
+            return 0;
+
+        const std::intptr_t diff =
+            static_cast< std::intptr_t >(
+                m_pBuffer[ pos % m_queueSize ].sequence.load(
+                    std::memory_order_acquire
+                )
+            )
+        -   static_cast< std::intptr_t >( Cell::freeFor( pos ) );
+
+        if ( diff < 0 )
+            return 0; // full: slot still holds the previous lap
+
+        if ( diff > 0 )
+        {
+            pos = m_enqueuePos.load( std::memory_order_relaxed );
+            continue;
+        }
+
+        claimed = 1;
+        while (
+                claimed < maxCount
+            &&  m_pBuffer[ ( pos + claimed ) % m_queueSize ].sequence.load(
+                    std::memory_order_acquire
+                ) == Cell::freeFor( pos + claimed )
+        )
+            ++claimed;
+
+        if ( m_enqueuePos.compare_exchange_weak(
+                pos, pos + claimed, std::memory_order_relaxed
+        ) )
+            break;
+    }
+
+    for ( std::size_t i = 0; i < claimed; ++i )
+    {
+        Cell & rCell = m_pBuffer[ ( pos + i ) % m_queueSize ];
+        rCell.data = _ppItems[ i ];
+        rCell.sequence.store(
+            Cell::publishedFor( pos + i ), std::memory_order_release
+        );
+    }
+
+    m_stats.onEnqueued( claimed, [ this ] () { return count(); } );
+    return claimed;
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Claims the run of consecutive positions producers have already published,
+// checked slot by slot before the CAS as in tryPop().
+template < typename _T >
+std::size_t LockFreeQueue< _T >::tryPopBulk (
+        _T ** _ppItems
+    ,   std::size_t _maxCount
+) noexcept
+{
+    if ( _maxCount == 0 )
+        return 0;
+
+    const std::size_t maxCount = std::min( _maxCount, m_queueSize );
+
+    std::size_t pos = m_dequeuePos.load( std::memory_order_relaxed );
+    std::size_t claimed;
+
+    for ( ;; )
+    {
+        const std::intptr_t diff =
+            static_cast< std::intptr_t >(
+                m_pBuffer[ pos % m_queueSize ].sequence.load(
+                    std::memory_order_acquire
+                )
+            )
+        -   static_cast< std::intptr_t >( Cell::publishedFor( pos ) );
+
+        if ( diff < 0 )
+            return 0; // empty: producer has not published this slot yet
+
+        if ( diff > 0 )
+        {
+            pos = m_dequeuePos.load( std::memory_order_relaxed );
+            continue;
+        }
+
+        claimed = 1;
+        while (
+                claimed < maxCount
+            &&  m_pBuffer[ ( pos + claimed ) % m_queueSize ].sequence.load(
+                    std::memory_order_acquire
+                ) == Cell::publishedFor( pos + claimed )
+        )
+            ++claimed;
+
+        if ( m_dequeuePos.compare_exchange_weak(
+                pos, pos + claimed, std::memory_order_relaxed
+        ) )
+            break;
+    }
+
+    for ( std::size_t i = 0; i < claimed; ++i )
+    {
+        Cell & rCell = m_pBuffer[ ( pos + i ) % m_queueSize ];
+        _ppItems[ i ] = rCell.data;
+        rCell.sequence.store(
+            Cell::freeFor( pos + i + m_queueSize ), std::memory_order_release
+        );
+    }
+
+    m_stats.onDequeued( claimed );
+    return claimed;
+}
+
+/*----------------------------------------------------------------------------*/
@@ -0,0 +1,132 @@
+#ifndef __SHAREDQUEUE_SRC_IMPL_LOCKFREEQUEUE_H__
+#define __SHAREDQUEUE_SRC_IMPL_LOCKFREEQUEUE_H__
+
+/*----------------------------------------------------------------------------*/
+
+#include "IQueue.h"
+#include "impl/EventCount.h"
+#include "impl/QueueEvents.h"
+#include "impl/SpinWait.h"
+#include "impl/StatsCounters.h"
+
+#include <atomic>
+#include <memory>
+
+/*----------------------------------------------------------------------------*/
+
+/**
+ * @class LockFreeQueue
+ *
+ * @brief Bounded multi-producer/multi-consumer ring of sequence-stamped slots.
+ *
+ * Every slot carries a sequence number telling whether it is ready to be
+ * written (sequence == 2 * position) or read (2 * position + 1), so
+ * producers and consumers only contend on their own position counter.
+ * Blocking overloads wait according to the WaitStrategy; parking ones sleep
+ * on an EventCount, which costs nothing while no thread is waiting.
+ *
+ * close() sets the top bit of the producer position, which fails every
+ * later claim. Positions claimed before it still count in count(), so
+ * consumers wait for them to be published before they see the queue drained.
+ */
+template < typename _T >
+class LockFreeQueue
+    :   public IQueue < _T >
+{
+public:
+
+    explicit LockFreeQueue (
+            std::size_t _size
+        ,   WaitStrategy _waitStrategy = WaitStrategy::Block
+    );
+
+    ~LockFreeQueue ();
+
+    int count () const noexcept override;
+
+    std::size_t capacity () const noexcept override;
+
+    QueueStats stats () const override;
+
+    void close () override;
+
+    bool isClosed () const noexcept override;
+
+    void enqueue ( _T * _pNewValue ) override;
+
+    bool enqueue ( _T * _pNewValue, int _millisecondsTimeout ) override;
+
+    bool tryEnqueue ( _T * _pNewValue ) override;
+
+    _T * dequeue () override;
+
+    _T * dequeue ( int _millisecondsTimeout ) override;
+
+    _T * tryDequeue () override;
+
+    void enqueueBulk ( _T ** _ppItems, std::size_t _count ) override;
+
+    std::size_t enqueueBulk (
+            _T ** _ppItems
+        ,   std::size_t _count
+        ,   int _millisecondsTimeout
+    ) override;
+
+    std::size_t tryEnqueueBulk (
+            _T ** _ppItems
+        ,   std::size_t _count
+    ) override;
+
+    std::size_t dequeueBulk (
+            _T ** _ppItems
+        ,   std::size_t _maxCount
+    ) override;
+
+    std::size_t dequeueBulk (
+            _T ** _ppItems
+        ,   std::size_t _maxCount
+        ,   int _millisecondsTimeout
+    ) override;
+
+    std::size_t tryDequeueBulk (
+            _T ** _ppItems
+        ,   std::size_t _maxCount
+    ) override;
+
+private:
+
+    struct Cell;
+
+    bool tryPush ( _T * _pNewValue ) noexcept;
+
+    bool tryPop ( _T * & _pValue ) noexcept;
+
+    std::size_t tryPushBulk ( _T ** _ppItems, std::size_t _count ) noexcept;
+
+    std::size_t tryPopBulk ( _T ** _ppItems, std::size_t _maxCount ) noexcept;
+
+private:
+
+    static constexpr std::size_t s_cacheLineSize = 64;
+
+    // Set in m_enqueuePos by close(); positions never get that far
+    static constexpr std::size_t s_closedBit = ~( ~std::size_t( 0 ) >> 1 );
+
+    const std::size_t m_queueSize;
+    std::unique_ptr< Cell[] > m_pBuffer;
+
+    alignas( s_cacheLineSize ) std::atomic< std::size_t > m_enqueuePos;
+    alignas( s_cacheLineSize ) std::atomic< std::size_t > m_dequeuePos;
+
+    alignas( s_cacheLineSize ) QueueEvents< _T > m_events;
+
+    [[no_unique_address]] StatsCounters m_stats;
+};
+
+/*----------------------------------------------------------------------------*/
+
+#include "impl/LockFreeQueue.cpp"
+
+/*----------------------------------------------------------------------------*/
+
+#endif // __SHAREDQUEUE_SRC_IMPL_LOCKFREEQUEUE_H__
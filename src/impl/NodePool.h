@@ -0,0 +1,233 @@
+#ifndef __SHAREDQUEUE_SRC_IMPL_NODEPOOL_H__
+#define __SHAREDQUEUE_SRC_IMPL_NODEPOOL_H__
+
+/*----------------------------------------------------------------------------*/
+
+#include <algorithm>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <utility>
+
+/*----------------------------------------------------------------------------*/
+
+/**
+ * @class NodePool
+ *
+ * @brief Recycles fixed-size nodes so that steady-state queue traffic does not
+ *        hit the heap.
+ *
+ * There is one pool per node type. Every thread keeps a small private cache
+ * of free nodes; full caches are handed over to a shared free list as a whole
+ * batch and empty caches take a whole batch back, so the shared lock is taken
+ * once per s_batchSize operations. The shared list keeps at most as many
+ * nodes as the live queues reserved through reserve(); anything above that
+ * goes back to the heap.
+ */
+template < typename _NodeT >
+class NodePool
+{
+public:
+
+    static constexpr std::size_t s_batchSize = 64;
+
+    static NodePool & instance ()
+    {
+        static NodePool s_pool;
+        return s_pool;
+    }
+
+    NodePool ( const NodePool & ) = delete;
+    NodePool & operator = ( const NodePool & ) = delete;
+
+    template < typename ... _ArgsT >
+    _NodeT * acquire ( _ArgsT && ... _args )
+    {
+        LocalCache & rCache = localCache();
+
+        if ( !rCache.m_pFirst )
+        {
+            rCache.m_pFirst = popBatch();
+            rCache.m_count = chainLength( rCache.m_pFirst );
+        }
+
+        void * pStorage;
+        if ( Slot * pSlot = rCache.m_pFirst )
+        {
+            rCache.m_pFirst = pSlot->link.pNext;
+            --rCache.m_count;
+            pStorage = pSlot;
+        }
+        else
+        {
+            pStorage = new Slot;
+        }
+
+        return new ( pStorage ) _NodeT{ std::forward< _ArgsT >( _args )... };
+    }
+
+    void release ( _NodeT * _pNode ) noexcept
+    {
+        _pNode->~_NodeT();
+        Slot * pSlot = reinterpret_cast< Slot * >( _pNode );
+
+        LocalCache & rCache = localCache();
+
+        if ( rCache.m_count == s_batchSize )
+        {
+            pushBatch( rCache.m_pFirst );
+            rCache.m_pFirst = nullptr;
+            rCache.m_count = 0;
+        }
+
+        pSlot->link.pNext = rCache.m_pFirst;
+        rCache.m_pFirst = pSlot;
+        ++rCache.m_count;
+    }
+
+    /**
+     * @brief Lets the shared free list retain _nodesCount more nodes.
+     */
+    void reserve ( std::size_t _nodesCount )
+    {
+        std::lock_guard< std::mutex > lck( m_mutex );
+        m_reservedNodes += _nodesCount;
+    }
+
+    void unreserve ( std::size_t _nodesCount )
+    {
+        Slot * pTrimmed = nullptr;
+        {
+            std::lock_guard< std::mutex > lck( m_mutex );
+            m_reservedNodes -= std::min( m_reservedNodes, _nodesCount );
+
+            while ( m_pBatches && m_batchesCount > batchesLimit() )
+            {
+                Slot * pBatch = m_pBatches;
+                m_pBatches = pBatch->link.pNextBatch;
+                --m_batchesCount;
+
+                pBatch->link.pNextBatch = pTrimmed;
+                pTrimmed = pBatch;
+            }
+        }
+
+        while ( pTrimmed )
+        {
+            Slot * pNextBatch = pTrimmed->link.pNextBatch;
+            deleteChain( pTrimmed );
+            pTrimmed = pNextBatch;
+        }
+    }
+
+private:
+
+    union Slot
+    {
+        struct
+        {
+            Slot * pNext;       // next free node of the same batch
+            Slot * pNextBatch;  // next batch, set on a batch's first node
+        } link;
+
+        alignas( _NodeT ) unsigned char storage[ sizeof( _NodeT ) ];
+    };
+
+    struct LocalCache
+    {
+        ~LocalCache ()
+        {
+            if ( m_pFirst )
+                NodePool::instance().pushBatch( m_pFirst );
+        }
+
+        Slot * m_pFirst = nullptr;
+        std::size_t m_count = 0;
+    };
+
+    NodePool ()
+        :   m_pBatches( nullptr )
+        ,   m_batchesCount( 0 )
+        ,   m_reservedNodes( 0 )
+    {
+    }
+
+    ~NodePool ()
+    {
+        while ( m_pBatches )
+        {
+            Slot * pNextBatch = m_pBatches->link.pNextBatch;
+            deleteChain( m_pBatches );
+            m_pBatches = pNextBatch;
+        }
+    }
+
+    static LocalCache & localCache () noexcept
+    {
+        static thread_local LocalCache s_cache;
+        return s_cache;
+    }
+
+    std::size_t batchesLimit () const noexcept
+    {
+        return ( m_reservedNodes + s_batchSize - 1 ) / s_batchSize;
+    }
+
+    void pushBatch ( Slot * _pBatch ) noexcept
+    {
+        {
+            std::lock_guard< std::mutex > lck( m_mutex );
+            if ( m_batchesCount < batchesLimit() )
+            {
+                _pBatch->link.pNextBatch = m_pBatches;
+                m_pBatches = _pBatch;
+                ++m_batchesCount;
+                return;
+            }
+        }
+        deleteChain( _pBatch );
+    }
+
+    Slot * popBatch () noexcept
+    {
+        std::lock_guard< std::mutex > lck( m_mutex );
+        Slot * pBatch = m_pBatches;
+        if ( pBatch )
+        {
+            m_pBatches = pBatch->link.pNextBatch;
+            --m_batchesCount;
+        }
+        return pBatch;
+    }
+
+    // Batches pushed on thread exit may be partial, so they are counted
+    // when taken rather than assumed to be full
+    static std::size_t chainLength ( const Slot * _pSlot ) noexcept
+    {
+        std::size_t length = 0;
+        for ( ; _pSlot; _pSlot = _pSlot->link.pNext )
+            ++length;
+        return length;
+    }
+
+    static void deleteChain ( Slot * _pSlot ) noexcept
+    {
+        while ( _pSlot )
+        {
+            Slot * pNext = _pSlot->link.pNext;
+            delete _pSlot;
+            _pSlot = pNext;
+        }
+    }
+
+private:
+
+    std::mutex m_mutex;
+    Slot * m_pBatches;
+    std::size_t m_batchesCount;
+    std::size_t m_reservedNodes;
+};
+
+/*----------------------------------------------------------------------------*/
+
+#endif // __SHAREDQUEUE_SRC_IMPL_NODEPOOL_H__
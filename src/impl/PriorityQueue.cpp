@@ -0,0 +1,801 @@
+#include "impl/PriorityQueue.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+
+#if defined( _MSC_VER )
+#include <intrin.h>
+#endif
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+struct PriorityQueue< _T >::Node
+{
+    _T * data;
+    Node * next;
+};
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+struct PriorityQueue< _T >::Level
+{
+    Node * pHead = nullptr;
+    Node * pTail = nullptr;
+};
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+PriorityQueue< _T >::PriorityQueue (
+        std::size_t _size
+    ,   std::size_t _levelCount
+    ,   WaitStrategy _waitStrategy
+)
+    :   m_rPool( Pool::instance() )
+    ,   m_events( *this, m_stats, _waitStrategy )
+    ,   m_pLevels( std::make_unique< Level[] >( _levelCount ) )
+    ,   m_nonEmptyLevels( 0 )
+    ,   m_currentQueueSizeLockable( 0 )
+    ,   m_queueSize( _size )
+    ,   m_maxQueueSize( 0 )
+    ,   m_levelCount( _levelCount )
+    ,   m_closed( false )
+{
+    assert( _size > 0 );
+    assert( _levelCount > 0 && _levelCount <= s_maxLevelCount );
+
+    m_rPool.reserve( _size );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+PriorityQueue< _T >::~PriorityQueue ()
+{
+    for ( std::size_t level = 0; level < m_levelCount; ++level )
+        releaseChain( m_pLevels[ level ].pHead );
+
+    m_rPool.unreserve( m_queueSize.load() );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t PriorityQueue< _T >::levelCount () const noexcept
+{
+    return m_levelCount;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+int PriorityQueue< _T >::count () const noexcept
+{
+    return static_cast< int >( m_currentQueueSizeLockable.load() );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t PriorityQueue< _T >::capacity () const noexcept
+{
+    return m_queueSize.load();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool PriorityQueue< _T >::setCapacity ( std::size_t _capacity )
+{
+    assert( _capacity > 0 );
+
+    std::size_t oldCapacity;
+    {
+        std::lock_guard< StatsMutex > lck( m_mutex );
+        oldCapacity = m_queueSize.exchange( _capacity );
+    }
+
+    if ( _capacity > oldCapacity )
+    {
+        m_rPool.reserve( _capacity - oldCapacity );
+
+        m_events.onRoomMade();
+    }
+    else
+    {
+        m_rPool.unreserve( oldCapacity - _capacity );
+    }
+
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool PriorityQueue< _T >::setAutoGrow ( std::size_t _maxCapacity )
+{
+    std::size_t oldMaxCapacity;
+    {
+        std::lock_guard< StatsMutex > lck( m_mutex );
+        oldMaxCapacity = m_maxQueueSize.exchange( _maxCapacity );
+    }
+
+    if ( _maxCapacity > oldMaxCapacity )
+        m_events.onRoomMade();
+
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+QueueStats PriorityQueue< _T >::stats () const
+{
+    QueueStats stats = m_stats.snapshot();
+    stats.lockContentions = m_mutex.contentions();
+    return stats;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+void PriorityQueue< _T >::close ()
+{
+    {
+        std::lock_guard< StatsMutex > lck( m_mutex );
+        if ( m_closed.exchange( true ) )
+            return;
+    }
+
+    m_events.onClosed();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool PriorityQueue< _T >::isClosed () const noexcept
+{
+    return m_closed.load();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+void PriorityQueue< _T >::enqueue ( _T * _pNewValue )
+{
+    assert( _pNewValue );
+
+    if ( !enqueueUntil( _pNewValue, m_levelCount - 1, nullptr ) )
+        throw QueueClosed();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool PriorityQueue< _T >::enqueue ( _T * _pNewValue, int _millisecondsTimeout )
+{
+    assert( _pNewValue );
+
+    const TimePoint deadline =
+            EventCount::Clock::now()
+        +   std::chrono::milliseconds( _millisecondsTimeout )
+    ;
+    return enqueueUntil( _pNewValue, m_levelCount - 1, &deadline );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool PriorityQueue< _T >::tryEnqueue ( _T * _pNewValue )
+{
+    assert( _pNewValue );
+
+    return tryEnqueueAt( _pNewValue, m_levelCount - 1 );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+void PriorityQueue< _T >::enqueue ( _T * _pNewValue, Priority _priority )
+{
+    assert( _pNewValue );
+
+    if ( !enqueueUntil( _pNewValue, levelOf( _priority ), nullptr ) )
+        throw QueueClosed();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool PriorityQueue< _T >::enqueue (
+        _T * _pNewValue
+    ,   Priority _priority
+    ,   int _millisecondsTimeout
+)
+{
+    assert( _pNewValue );
+
+    const TimePoint deadline =
+            EventCount::Clock::now()
+        +   std::chrono::milliseconds( _millisecondsTimeout )
+    ;
+    return enqueueUntil( _pNewValue, levelOf( _priority ), &deadline );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool PriorityQueue< _T >::tryEnqueue ( _T * _pNewValue, Priority _priority )
+{
+    assert( _pNewValue );
+
+    return tryEnqueueAt( _pNewValue, levelOf( _priority ) );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+_T * PriorityQueue< _T >::dequeue ()
+{
+    return dequeueUntil( nullptr );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+_T * PriorityQueue< _T >::dequeue ( int _millisecondsTimeout )
+{
+    const TimePoint deadline =
+            EventCount::Clock::now()
+        +   std::chrono::milliseconds( _millisecondsTimeout )
+    ;
+    return dequeueUntil( &deadline );
+}
+
+/*----------------------------------------------------------------------------*/
+
+// tryUnlink() loads the size before it goes near m_mutex
+template < typename _T >
+_T * PriorityQueue< _T >::tryDequeue ()
+{
+    Node * const pNode = tryUnlink();
+    if ( !pNode )
+        return nullptr;
+
+    _T * const pReturnVal = pNode->data;
+    m_rPool.release( pNode );
+
+    m_events.onDequeued();
+    return pReturnVal;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+void PriorityQueue< _T >::enqueueBulk ( _T ** _ppItems, std::size_t _count )
+{
+    assert( IQueue< _T >::noneIsNull( _ppItems, _count ) );
+
+    if ( enqueueBulkUntil( _ppItems, _count, nullptr ) < _count )
+        throw QueueClosed();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t PriorityQueue< _T >::enqueueBulk (
+        _T ** _ppItems
+    ,   std::size_t _count
+    ,   int _millisecondsTimeout
+)
+{
+    assert( IQueue< _T >::noneIsNull( _ppItems, _count ) );
+
+    const TimePoint deadline =
+            EventCount::Clock::now()
+        +   std::chrono::milliseconds( _millisecondsTimeout )
+    ;
+    return enqueueBulkUntil( _ppItems, _count, &deadline );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t PriorityQueue< _T >::tryEnqueueBulk (
+        _T ** _ppItems
+    ,   std::size_t _count
+)
+{
+    assert( IQueue< _T >::noneIsNull( _ppItems, _count ) );
+
+    // Size the chain from a lock-free estimate of the free room, counting
+    // whatever auto-growth may add
+    const std::size_t currentSize = m_currentQueueSizeLockable.load();
+    const std::size_t limit =
+        std::max( m_queueSize.load(), m_maxQueueSize.load() );
+    if ( _count == 0 || currentSize >= limit )
+        return 0;
+
+    const std::size_t count = std::min( _count, limit - currentSize );
+
+    Node * pChain = buildChain( _ppItems, count );
+    const std::size_t enqueued =
+        tryLinkChain( pChain, count, m_levelCount - 1 );
+    releaseChain( pChain );
+
+    if ( enqueued > 0 )
+        m_events.onEnqueued();
+
+    return enqueued;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t PriorityQueue< _T >::dequeueBulk (
+        _T ** _ppItems
+    ,   std::size_t _maxCount
+)
+{
+    return dequeueBulkUntil( _ppItems, _maxCount, nullptr );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t PriorityQueue< _T >::dequeueBulk (
+        _T ** _ppItems
+    ,   std::size_t _maxCount
+    ,   int _millisecondsTimeout
+)
+{
+    const TimePoint deadline =
+            EventCount::Clock::now()
+        +   std::chrono::milliseconds( _millisecondsTimeout )
+    ;
+    return dequeueBulkUntil( _ppItems, _maxCount, &deadline );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t PriorityQueue< _T >::tryDequeueBulk (
+        _T ** _ppItems
+    ,   std::size_t _maxCount
+)
+{
+    if ( _maxCount == 0 )
+        return 0;
+
+    std::size_t dequeued;
+    Node * const pChain = tryUnlinkChain( _ppItems, _maxCount, dequeued );
+
+    if ( dequeued > 0 )
+    {
+        releaseChain( pChain );
+        m_events.onDequeued();
+    }
+
+    return dequeued;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t PriorityQueue< _T >::levelOf ( Priority _priority ) const noexcept
+{
+    return std::min(
+        static_cast< std::size_t >( _priority ), m_levelCount - 1
+    );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool PriorityQueue< _T >::enqueueUntil (
+        _T * _pNewValue
+    ,   std::size_t _level
+    ,   const TimePoint * _pDeadline
+)
+{
+    Node * const pNode = m_rPool.acquire( _pNewValue, nullptr );
+
+    const bool linked = m_events.awaitRoom(
+            [ this, pNode, _level ] () { return tryLink( pNode, _level ); }
+        ,   _pDeadline
+    );
+
+    if ( !linked )
+    {
+        m_rPool.release( pNode );
+        return false; // timed out or closed
+    }
+
+    m_events.onEnqueued();
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool PriorityQueue< _T >::tryEnqueueAt ( _T * _pNewValue, std::size_t _level )
+{
+    // Refused on the lock-free view alone, before a node is even acquired
+    if ( visiblyFull() || m_closed.load() )
+        return false;
+
+    Node * const pNode = m_rPool.acquire( _pNewValue, nullptr );
+    if ( !tryLink( pNode, _level ) )
+    {
+        m_rPool.release( pNode );
+        return false;
+    }
+
+    m_events.onEnqueued();
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+_T * PriorityQueue< _T >::dequeueUntil ( const TimePoint * _pDeadline )
+{
+    Node * pNode = nullptr;
+
+    m_events.awaitItems(
+            [ this, &pNode ] () {
+                pNode = tryUnlink();
+                return pNode != nullptr;
+            }
+        ,   _pDeadline
+    );
+
+    if ( !pNode )
+        return nullptr; // timed out, or closed and drained
+
+    _T * const pReturnVal = pNode->data;
+    m_rPool.release( pNode );
+
+    m_events.onDequeued();
+    return pReturnVal;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t PriorityQueue< _T >::enqueueBulkUntil (
+        _T ** _ppItems
+    ,   std::size_t _count
+    ,   const TimePoint * _pDeadline
+)
+{
+    if ( _count == 0 )
+        return 0;
+
+    Node * pChain = buildChain( _ppItems, _count );
+
+    std::size_t enqueued = 0;
+    while ( enqueued < _count )
+    {
+        std::size_t linked = 0;
+        m_events.awaitRoom(
+                [ & ] () {
+                    linked = tryLinkChain(
+                        pChain, _count - enqueued, m_levelCount - 1
+                    );
+                    return linked > 0;
+                }
+            ,   _pDeadline
+        );
+
+        if ( linked == 0 )
+            break; // timed out or closed
+
+        enqueued += linked;
+
+        // One wakeup per linked batch
+        m_events.onEnqueued();
+    }
+
+    releaseChain( pChain );
+
+    return enqueued;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t PriorityQueue< _T >::dequeueBulkUntil (
+        _T ** _ppItems
+    ,   std::size_t _maxCount
+    ,   const TimePoint * _pDeadline
+)
+{
+    if ( _maxCount == 0 )
+        return 0;
+
+    std::size_t dequeued = 0;
+    Node * pChain = nullptr;
+    m_events.awaitItems(
+            [ & ] () {
+                pChain = tryUnlinkChain( _ppItems, _maxCount, dequeued );
+                return dequeued > 0;
+            }
+        ,   _pDeadline
+    );
+
+    if ( dequeued == 0 )
+        return 0; // timed out, or closed and drained
+
+    releaseChain( pChain );
+
+    // One wakeup for the whole batch
+    m_events.onDequeued();
+
+    return dequeued;
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Full, and not allowed to grow
+template < typename _T >
+bool PriorityQueue< _T >::visiblyFull () const noexcept
+{
+    const std::size_t capacity = m_queueSize.load();
+    return m_currentQueueSizeLockable.load() >= capacity
+        && m_maxQueueSize.load() <= capacity
+    ;
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Must be called with m_mutex held. Grows the queue the same way SharedQueue
+// does, by at least doubling it up to the auto-growth ceiling.
+template < typename _T >
+std::size_t PriorityQueue< _T >::roomLocked ( std::size_t _wanted ) noexcept
+{
+    const std::size_t currentSize = m_currentQueueSizeLockable.load();
+    const std::size_t maxCapacity = m_maxQueueSize.load();
+    std::size_t capacity = m_queueSize.load();
+
+    if ( currentSize + _wanted > capacity && maxCapacity > capacity )
+    {
+        const std::size_t grownCapacity = std::min(
+                maxCapacity
+            ,   std::max( 2 * capacity, currentSize + _wanted )
+        );
+
+        m_queueSize.store( grownCapacity );
+        m_rPool.reserve( grownCapacity - capacity );
+        capacity = grownCapacity;
+    }
+
+    return currentSize < capacity ? capacity - currentSize : 0;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool PriorityQueue< _T >::tryLink ( Node * _pNode, std::size_t _level )
+{
+    // Do not touch the mutex while the queue is visibly full
+    if ( visiblyFull() )
+        return false;
+
+    std::lock_guard< StatsMutex > lck( m_mutex );
+    if ( m_closed.load() || roomLocked( 1 ) == 0 )
+        return false;
+
+    linkAtTail( _pNode, _pNode, 1, _level );
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+typename PriorityQueue< _T >::Node * PriorityQueue< _T >::tryUnlink ()
+{
+    if ( m_currentQueueSizeLockable.load() == 0 )
+        return nullptr;
+
+    std::lock_guard< StatsMutex > lck( m_mutex );
+    if ( m_nonEmptyLevels == 0 )
+        return nullptr;
+
+    const std::size_t level = firstLevel( m_nonEmptyLevels );
+    Level & rLevel = m_pLevels[ level ];
+
+    Node * const pNode = rLevel.pHead;
+    rLevel.pHead = pNode->next;
+    if ( !rLevel.pHead )
+    {
+        rLevel.pTail = nullptr;
+        m_nonEmptyLevels &= ~( std::uint64_t( 1 ) << level );
+    }
+
+    m_currentQueueSizeLockable.fetch_sub( 1, std::memory_order_release );
+    m_stats.onDequeued( 1 );
+
+    pNode->next = nullptr;
+    return pNode;
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Links as many leading nodes of _pChain as there is room for and leaves the
+// rest in _pChain for the next attempt.
+template < typename _T >
+std::size_t PriorityQueue< _T >::tryLinkChain (
+        Node * & _pChain
+    ,   std::size_t _count
+    ,   std::size_t _level
+)
+{
+    if ( visiblyFull() )
+        return 0;
+
+    std::lock_guard< StatsMutex > lck( m_mutex );
+    if ( m_closed.load() )
+        return 0;
+
+    const std::size_t room = roomLocked( _count );
+    if ( room == 0 )
+        return 0;
+
+    const std::size_t linked = std::min( _count, room );
+
+    Node * const pFirst = _pChain;
+    Node * pLast = pFirst;
+    for ( std::size_t i = 1; i < linked; ++i )
+        pLast = pLast->next;
+
+    _pChain = pLast->next;
+    pLast->next = nullptr;
+
+    linkAtTail( pFirst, pLast, linked, _level );
+    return linked;
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Takes up to _maxCount items, most urgent level first, and returns their
+// nodes as a null-terminated chain.
+template < typename _T >
+typename PriorityQueue< _T >::Node * PriorityQueue< _T >::tryUnlinkChain (
+        _T ** _ppItems
+    ,   std::size_t _maxCount
+    ,   std::size_t & _unlinkedCount
+)
+{
+    _unlinkedCount = 0;
+    if ( m_currentQueueSizeLockable.load() == 0 )
+        return nullptr;
+
+    std::lock_guard< StatsMutex > lck( m_mutex );
+
+    Node * pFirst = nullptr;
+    Node * pLast = nullptr;
+
+    while ( _unlinkedCount < _maxCount && m_nonEmptyLevels != 0 )
+    {
+        const std::size_t level = firstLevel( m_nonEmptyLevels );
+        Level & rLevel = m_pLevels[ level ];
+
+        Node * const pLevelFirst = rLevel.pHead;
+        Node * pLevelLast = nullptr;
+        while ( _unlinkedCount < _maxCount && rLevel.pHead )
+        {
+            _ppItems[ _unlinkedCount++ ] = rLevel.pHead->data;
+            pLevelLast = rLevel.pHead;
+            rLevel.pHead = rLevel.pHead->next;
+        }
+
+        if ( !rLevel.pHead )
+        {
+            rLevel.pTail = nullptr;
+            m_nonEmptyLevels &= ~( std::uint64_t( 1 ) << level );
+        }
+
+        if ( pLast )
+            pLast->next = pLevelFirst;
+        else
+            pFirst = pLevelFirst;
+        pLast = pLevelLast;
+    }
+
+    if ( pLast )
+    {
+        pLast->next = nullptr;
+        m_currentQueueSizeLockable.fetch_sub(
+            _unlinkedCount, std::memory_order_release
+        );
+        m_stats.onDequeued( _unlinkedCount );
+    }
+
+    return pFirst;
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Must be called with m_mutex held
+template < typename _T >
+void PriorityQueue< _T >::linkAtTail (
+        Node * _pFirst
+    ,   Node * _pLast
+    ,   std::size_t _count
+    ,   std::size_t _level
+) noexcept
+{
+    Level & rLevel = m_pLevels[ _level ];
+
+    if ( rLevel.pTail )
+        rLevel.pTail->next = _pFirst;
+    else
+        rLevel.pHead = _pFirst;
+    rLevel.pTail = _pLast;
+
+    m_nonEmptyLevels |= std::uint64_t( 1 ) << _level;
+
+    const std::size_t size = _count
+        +   m_currentQueueSizeLockable.fetch_add(
+                _count, std::memory_order_release
+            );
+    m_stats.onEnqueued( _count, [ size ] () { return size; } );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+typename PriorityQueue< _T >::Node * PriorityQueue< _T >::buildChain (
+        _T ** _ppItems
+    ,   std::size_t _count
+)
+{
+    Node * pFirst = nullptr;
+    for ( std::size_t i = _count; i > 0; --i )
+        pFirst = m_rPool.acquire( _ppItems[ i - 1 ], pFirst );
+    return pFirst;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+void PriorityQueue< _T >::releaseChain ( Node * _pChain ) noexcept
+{
+    while ( _pChain )
+    {
+        Node * pNext = _pChain->next;
+        m_rPool.release( _pChain );
+        _pChain = pNext;
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Index of the lowest set bit, i.e. the most urgent non-empty level
+template < typename _T >
+std::size_t PriorityQueue< _T >::firstLevel (
+        std::uint64_t _nonEmptyLevels
+) noexcept
+{
+#if defined( __GNUC__ ) || defined( __clang__ )
+    return static_cast< std::size_t >( __builtin_ctzll( _nonEmptyLevels ) );
+#elif defined( _MSC_VER ) && defined( _M_X64 )
+    unsigned long index;
+    _BitScanForward64( &index, _nonEmptyLevels );
+    return index;
+#else
+    std::size_t level = 0;
+    while ( !( _nonEmptyLevels & 1 ) )
+    {
+        _nonEmptyLevels >>= 1;
+        ++level;
+    }
+    return level;
+#endif
+}
+
+/*----------------------------------------------------------------------------*/
@@ -0,0 +1,231 @@
+#ifndef __SHAREDQUEUE_SRC_IMPL_PRIORITYQUEUE_H__
+#define __SHAREDQUEUE_SRC_IMPL_PRIORITYQUEUE_H__
+
+/*----------------------------------------------------------------------------*/
+
+#include "IQueue.h"
+#include "impl/NodePool.h"
+#include "impl/QueueEvents.h"
+#include "impl/SpinWait.h"
+#include "impl/StatsCounters.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+/*----------------------------------------------------------------------------*/
+
+/**
+ * @brief Priority level of a PriorityQueue item; Highest (0) comes out first.
+ *
+ * A scoped enum rather than a plain integer, so that enqueue( p, 5 ) keeps
+ * meaning a 5 ms timeout and a priority has to be spelled Priority{ 5 }.
+ */
+enum class Priority : std::size_t
+{
+        Highest = 0
+};
+
+/*----------------------------------------------------------------------------*/
+
+/**
+ * @class PriorityQueue
+ *
+ * @brief Bounded queue with a fixed number of priority levels, FIFO within
+ *        each level.
+ *
+ * Every level is a linked list of pooled nodes and a bitmap tells which
+ * levels hold items, so both enqueue and dequeue are O(1): dequeue takes the
+ * head of the lowest set bit. The capacity is shared by all levels.
+ *
+ * The IQueue overloads enqueue at the lowest priority, so existing producers
+ * need no change and urgent items sent with a Priority overtake them.
+ * Priorities past the last level are treated as the last level.
+ */
+template < typename _T >
+class PriorityQueue
+    :   public IQueue < _T >
+{
+public:
+
+    static constexpr std::size_t s_maxLevelCount = 64;
+
+    /**
+     * @param _levelCount Between 1 and s_maxLevelCount.
+     */
+    PriorityQueue (
+            std::size_t _size
+        ,   std::size_t _levelCount
+        ,   WaitStrategy _waitStrategy = WaitStrategy::Block
+    );
+
+    ~PriorityQueue ();
+
+    std::size_t levelCount () const noexcept;
+
+    int count () const noexcept override;
+
+    std::size_t capacity () const noexcept override;
+
+    bool setCapacity ( std::size_t _capacity ) override;
+
+    bool setAutoGrow ( std::size_t _maxCapacity ) override;
+
+    QueueStats stats () const override;
+
+    void close () override;
+
+    bool isClosed () const noexcept override;
+
+    void enqueue ( _T * _pNewValue ) override;
+
+    bool enqueue ( _T * _pNewValue, int _millisecondsTimeout ) override;
+
+    bool tryEnqueue ( _T * _pNewValue ) override;
+
+    void enqueue ( _T * _pNewValue, Priority _priority );
+
+    bool enqueue (
+            _T * _pNewValue
+        ,   Priority _priority
+        ,   int _millisecondsTimeout
+    );
+
+    bool tryEnqueue ( _T * _pNewValue, Priority _priority );
+
+    _T * dequeue () override;
+
+    _T * dequeue ( int _millisecondsTimeout ) override;
+
+    _T * tryDequeue () override;
+
+    void enqueueBulk ( _T ** _ppItems, std::size_t _count ) override;
+
+    std::size_t enqueueBulk (
+            _T ** _ppItems
+        ,   std::size_t _count
+        ,   int _millisecondsTimeout
+    ) override;
+
+    std::size_t tryEnqueueBulk (
+            _T ** _ppItems
+        ,   std::size_t _count
+    ) override;
+
+    /**
+     * @brief Dequeues the highest priority items first, in FIFO order within
+     *        each level.
+     */
+    std::size_t dequeueBulk (
+            _T ** _ppItems
+        ,   std::size_t _maxCount
+    ) override;
+
+    std::size_t dequeueBulk (
+            _T ** _ppItems
+        ,   std::size_t _maxCount
+        ,   int _millisecondsTimeout
+    ) override;
+
+    std::size_t tryDequeueBulk (
+            _T ** _ppItems
+        ,   std::size_t _maxCount
+    ) override;
+
+private:
+
+    struct Node;
+    struct Level;
+
+    using Pool = NodePool< Node >;
+    using TimePoint = EventCount::Clock::time_point;
+
+    std::size_t levelOf ( Priority _priority ) const noexcept;
+
+    bool enqueueUntil (
+            _T * _pNewValue
+        ,   std::size_t _level
+        ,   const TimePoint * _pDeadline
+    );
+
+    bool tryEnqueueAt ( _T * _pNewValue, std::size_t _level );
+
+    _T * dequeueUntil ( const TimePoint * _pDeadline );
+
+    std::size_t enqueueBulkUntil (
+            _T ** _ppItems
+        ,   std::size_t _count
+        ,   const TimePoint * _pDeadline
+    );
+
+    std::size_t dequeueBulkUntil (
+            _T ** _ppItems
+        ,   std::size_t _maxCount
+        ,   const TimePoint * _pDeadline
+    );
+
+    bool visiblyFull () const noexcept;
+
+    std::size_t roomLocked ( std::size_t _wanted ) noexcept;
+
+    bool tryLink ( Node * _pNode, std::size_t _level );
+
+    Node * tryUnlink ();
+
+    std::size_t tryLinkChain (
+            Node * & _pChain
+        ,   std::size_t _count
+        ,   std::size_t _level
+    );
+
+    Node * tryUnlinkChain (
+            _T ** _ppItems
+        ,   std::size_t _maxCount
+        ,   std::size_t & _unlinkedCount
+    );
+
+    void linkAtTail (
+            Node * _pFirst
+        ,   Node * _pLast
+        ,   std::size_t _count
+        ,   std::size_t _level
+    ) noexcept;
+
+    Node * buildChain ( _T ** _ppItems, std::size_t _count );
+
+    void releaseChain ( Node * _pChain ) noexcept;
+
+    static std::size_t firstLevel ( std::uint64_t _nonEmptyLevels ) noexcept;
+
+private:
+
+    Pool & m_rPool;
+
+    mutable StatsMutex m_mutex;
+
+    QueueEvents< _T > m_events;
+
+    std::unique_ptr< Level[] > m_pLevels;
+    std::uint64_t m_nonEmptyLevels;
+
+    std::atomic< std::size_t > m_currentQueueSizeLockable;
+
+    // Both are written only under m_mutex; 0 turns auto-growth off
+    std::atomic< std::size_t > m_queueSize;
+    std::atomic< std::size_t > m_maxQueueSize;
+    const std::size_t m_levelCount;
+
+    // Written only under m_mutex, so no item is linked after it is set
+    std::atomic< bool > m_closed;
+
+    [[no_unique_address]] StatsCounters m_stats;
+};
+
+/*----------------------------------------------------------------------------*/
+
+#include "impl/PriorityQueue.cpp"
+
+/*----------------------------------------------------------------------------*/
+
+#endif // __SHAREDQUEUE_SRC_IMPL_PRIORITYQUEUE_H__
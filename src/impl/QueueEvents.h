@@ -0,0 +1,175 @@
+#ifndef __SHAREDQUEUE_SRC_IMPL_QUEUEEVENTS_H__
+#define __SHAREDQUEUE_SRC_IMPL_QUEUEEVENTS_H__
+
+/*----------------------------------------------------------------------------*/
+
+#include "IQueue.h"
+#include "WaitStrategy.h"
+#include "impl/EventCount.h"
+#include "impl/SpinWait.h"
+#include "impl/StatsCounters.h"
+
+#include <cstddef>
+
+/*----------------------------------------------------------------------------*/
+
+/**
+ * @class QueueEvents
+ *
+ * @brief The notEmpty/notFull event pair a bounded IQueue parks its threads
+ *        on, together with the wakeups and the waits every such queue shares.
+ *
+ * The queue reports each change through onEnqueued()/onDequeued(), which
+ * wake one thread of the other side and pass a wakeup on to their own side
+ * when a bulk call left work for more than one. Neither takes a lock or
+ * makes a syscall unless a thread is actually asleep, and neither does
+ * anything at all under a strategy that never parks.
+ *
+ * Waits end once the queue is closed: at once for producers, once the queue
+ * is drained for consumers. Only count(), capacity() and isClosed() of the
+ * queue are used, so it may be constructed from the queue's own initializer
+ * list.
+ */
+template < typename _T >
+class QueueEvents
+{
+public:
+
+    using Clock = EventCount::Clock;
+
+    QueueEvents (
+            const IQueue< _T > & _rQueue
+        ,   StatsCounters & _rStats
+        ,   WaitStrategy _waitStrategy
+    ) noexcept
+        :   m_rQueue( _rQueue )
+        ,   m_rStats( _rStats )
+        ,   m_waitStrategy( _waitStrategy )
+    {
+    }
+
+    QueueEvents ( const QueueEvents & ) = delete;
+    QueueEvents & operator = ( const QueueEvents & ) = delete;
+
+    /**
+     * @brief Runs the wait strategy until _tryOp makes room for an item, the
+     *        deadline passes or the queue is closed.
+     * @return Whether _tryOp succeeded.
+     */
+    template < typename _TryOpT >
+    bool awaitRoom ( _TryOpT _tryOp, const Clock::time_point * _pDeadline )
+    {
+        return await(
+                StatsCounters::Side::Producer
+            ,   m_notFullEvent
+            ,   _tryOp
+            ,   [ this ] () { return m_rQueue.isClosed(); }
+            ,   _pDeadline
+        );
+    }
+
+    /**
+     * @brief Runs the wait strategy until _tryOp takes an item, the deadline
+     *        passes or the queue is closed and drained.
+     * @return Whether _tryOp succeeded.
+     */
+    template < typename _TryOpT >
+    bool awaitItems ( _TryOpT _tryOp, const Clock::time_point * _pDeadline )
+    {
+        return await(
+                StatsCounters::Side::Consumer
+            ,   m_notEmptyEvent
+            ,   _tryOp
+            ,   [ this ] () {
+                    return m_rQueue.isClosed() && m_rQueue.count() == 0;
+                }
+            ,   _pDeadline
+        );
+    }
+
+    void onEnqueued ()
+    {
+        if ( !SpinWait::parks( m_waitStrategy ) )
+            return; // nobody ever sleeps on the events
+
+        m_notEmptyEvent.notifyOne();
+
+        // Pass the wakeup on if a bulk dequeue made room for more producers
+        m_notFullEvent.notifyOneIf( [ this ] () {
+            return
+                    static_cast< std::size_t >( m_rQueue.count() )
+                <   m_rQueue.capacity()
+            ;
+        } );
+    }
+
+    void onDequeued ()
+    {
+        if ( !SpinWait::parks( m_waitStrategy ) )
+            return;
+
+        m_notFullEvent.notifyOne();
+
+        // Pass the wakeup on if a bulk enqueue left more items behind
+        m_notEmptyEvent.notifyOneIf( [ this ] () {
+            return m_rQueue.count() > 0;
+        } );
+    }
+
+    /**
+     * @brief Wakes every producer, for when room was made for more than one
+     *        at once: the capacity grew, or the queue was emptied in a go.
+     */
+    void onRoomMade ()
+    {
+        if ( SpinWait::parks( m_waitStrategy ) )
+            m_notFullEvent.notifyAll();
+    }
+
+    /**
+     * @brief Wakes every waiter of both sides; call once the queue is closed.
+     */
+    void onClosed ()
+    {
+        m_notFullEvent.notifyAll();
+        m_notEmptyEvent.notifyAll();
+    }
+
+private:
+
+    template < typename _TryOpT, typename _IsOverT >
+    bool await (
+            StatsCounters::Side _side
+        ,   EventCount & _rEvent
+        ,   _TryOpT & _tryOp
+        ,   _IsOverT _isOver
+        ,   const Clock::time_point * _pDeadline
+    )
+    {
+        bool done = false;
+        m_rStats.await(
+                _side
+            ,   _rEvent
+            ,   m_waitStrategy
+            ,   [ & ] () {
+                    done = _tryOp();
+                    return done || _isOver();
+                }
+            ,   _pDeadline
+        );
+        return done;
+    }
+
+private:
+
+    const IQueue< _T > & m_rQueue;
+    StatsCounters & m_rStats;
+    const WaitStrategy m_waitStrategy;
+
+    EventCount m_notEmptyEvent;
+    EventCount m_notFullEvent;
+};
+
+/*----------------------------------------------------------------------------*/
+
+#endif // __SHAREDQUEUE_SRC_IMPL_QUEUEEVENTS_H__
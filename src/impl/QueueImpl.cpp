@@ -1,218 +1,204 @@
 #include "impl/QueueImpl.h"
-
-#include <chrono>
-#include <condition_variable>
-#include <iostream>
-#include <mutex>
+#include "impl/SharedQueue.h"
 
 /*----------------------------------------------------------------------------*/
 
-struct SharedQueueImpl::Node
-{
-    IData * data;
-    std::unique_ptr<Node> next;
-};
+template class SharedQueue< void >;
 
 /*----------------------------------------------------------------------------*/
 
 struct SharedQueueImpl::ImplData
 {
-    ImplData ( std::size_t _size )
-        :   m_pHead( std::make_unique< Node >() )
-        ,   m_pTail( m_pHead.get() )
-        ,   m_currentQueueSizeLockable( 0 )
-        ,   m_queueSize( _size )
+    ImplData ( std::size_t _size, WaitStrategy _waitStrategy )
+        :   m_queue( _size, _waitStrategy )
     {
     }
 
-    std::mutex m_headMutex;
-    std::unique_ptr< Node > m_pHead;
-    std::mutex m_tailMutex;
-    mutable std::mutex m_sizeMutex;
-    Node * m_pTail;
-    std::condition_variable m_pushDataCond;
-    std::condition_variable m_popDataCond;
-
-    mutable std::size_t m_currentQueueSizeLockable;
-    const std::size_t m_queueSize;
+    SharedQueue< void > m_queue;
 };
 
 /*----------------------------------------------------------------------------*/
 
-class EndScopeNotifier
+SharedQueueImpl::SharedQueueImpl (
+        std::size_t _size
+    ,   WaitStrategy _waitStrategy
+)
+    :   pImplData( std::make_unique< ImplData >( _size, _waitStrategy ) )
 {
-public:
-    EndScopeNotifier ( std::condition_variable & _rCond )
-        :   m_rCond( _rCond )
-    {
-    }
+}
 
-    ~EndScopeNotifier ()
-    {
-        m_rCond.notify_one();
-    }
+/*----------------------------------------------------------------------------*/
 
-private:
-    std::condition_variable & m_rCond;
-};
+SharedQueueImpl::~SharedQueueImpl ()
+{
+}
 
 /*----------------------------------------------------------------------------*/
 
-SharedQueueImpl::SharedQueueImpl ( std::size_t _size )
-    :   pImplData( std::make_unique< ImplData >( _size ) )
+int SharedQueueImpl::count () const noexcept
 {
+    return pImplData->m_queue.count();
 }
 
 /*----------------------------------------------------------------------------*/
 
-SharedQueueImpl::~SharedQueueImpl ()
+std::size_t SharedQueueImpl::capacity () const noexcept
 {
-    while ( pImplData->m_pHead.get() != get_tail() )
-    {
-        auto pOldHead = std::move( pImplData->m_pHead );
-        pImplData->m_pHead = std::move( pOldHead->next );
-        delete pOldHead->data;
-    }
+    return pImplData->m_queue.capacity();
 }
 
 /*----------------------------------------------------------------------------*/
 
-int SharedQueueImpl::count () const noexcept
+bool SharedQueueImpl::setCapacity ( std::size_t _capacity )
 {
-    std::lock_guard< std::mutex > lck( pImplData->m_sizeMutex );
-    return pImplData->m_currentQueueSizeLockable;
+    return pImplData->m_queue.setCapacity( _capacity );
 }
 
 /*----------------------------------------------------------------------------*/
 
-void SharedQueueImpl::enqueue ( IData * _pNewValue )
+bool SharedQueueImpl::setAutoGrow ( std::size_t _maxCapacity )
 {
-    {
-        std::unique_lock< std::mutex > lck( pImplData->m_sizeMutex );
-        pImplData->m_popDataCond.wait( lck, [ & ] {
-            return
-                    pImplData->m_currentQueueSizeLockable
-                <   pImplData->m_queueSize
-            ;
-        } );
-        ++pImplData->m_currentQueueSizeLockable;
-    }
+    return pImplData->m_queue.setAutoGrow( _maxCapacity );
+}
 
-    std::unique_ptr< Node > pNewNode( std::make_unique< Node >() );
-    {
-        std::lock_guard< decltype( pImplData->m_tailMutex ) > tailLock(
-            pImplData->m_tailMutex
-        );
-        pImplData->m_pTail->data = _pNewValue;
-        Node * const pNewTail = pNewNode.get();
-        pImplData->m_pTail->next = std::move( pNewNode );
-        pImplData->m_pTail = pNewTail;
-    }
-    pImplData->m_headMutex.lock();
-    pImplData->m_pushDataCond.notify_one();
-    pImplData->m_headMutex.unlock();
+/*----------------------------------------------------------------------------*/
+
+QueueStats SharedQueueImpl::stats () const
+{
+    return pImplData->m_queue.stats();
 }
 
 /*----------------------------------------------------------------------------*/
 
-bool SharedQueueImpl::enqueue ( IData * _pNewValue, int _millisecondsTimeout )
+void SharedQueueImpl::close ()
 {
-    using namespace std::chrono;
+    pImplData->m_queue.close();
+}
 
-    {
-        std::unique_lock< std::mutex > lck( pImplData->m_sizeMutex );
-        bool notFull = pImplData->m_popDataCond.wait_for(
-                lck
-            ,   milliseconds( _millisecondsTimeout )
-            ,   [ this ]
-            {
-                return
-                        pImplData->m_currentQueueSizeLockable
-                    <   pImplData->m_queueSize
-                ;
-            }
-        );
-        if ( !notFull )
-            return false;
-
-        ++pImplData->m_currentQueueSizeLockable;
-    }
-    EndScopeNotifier notifier( pImplData->m_pushDataCond );
+/*----------------------------------------------------------------------------*/
 
-    std::unique_ptr< Node > pNewNode( std::make_unique< Node >() );
-    {
-        std::lock_guard< decltype( pImplData->m_tailMutex ) > tailLock(
-            pImplData->m_tailMutex
-        );
-        pImplData->m_pTail->data = _pNewValue;
-        Node * const pNewTail = pNewNode.get();
-        pImplData->m_pTail->next = std::move( pNewNode );
-        pImplData->m_pTail = pNewTail;
-    }
-    return true;
+bool SharedQueueImpl::isClosed () const noexcept
+{
+    return pImplData->m_queue.isClosed();
 }
 
 /*----------------------------------------------------------------------------*/
 
-IData * SharedQueueImpl::dequeue ()
+void SharedQueueImpl::enqueue ( void * _pNewValue )
 {
+    pImplData->m_queue.enqueue( _pNewValue );
+}
+
+/*----------------------------------------------------------------------------*/
 
-    EndScopeNotifier notifier( pImplData->m_popDataCond );
+bool SharedQueueImpl::enqueue ( void * _pNewValue, int _millisecondsTimeout )
+{
+    return pImplData->m_queue.enqueue( _pNewValue, _millisecondsTimeout );
+}
 
-    std::unique_lock< std::mutex > headLock( pImplData->m_headMutex );
-    pImplData->m_pushDataCond.wait( headLock, [ this ] {
-        return pImplData->m_pHead.get() != get_tail();
-    } );
+/*----------------------------------------------------------------------------*/
 
-    {
-        std::lock_guard< std::mutex > lck( pImplData->m_sizeMutex );
-        --pImplData->m_currentQueueSizeLockable;
-    }
+bool SharedQueueImpl::tryEnqueue ( void * _pNewValue )
+{
+    return pImplData->m_queue.tryEnqueue( _pNewValue );
+}
+
+/*----------------------------------------------------------------------------*/
 
-    auto pOldHead = std::move( pImplData->m_pHead );
-    pImplData->m_pHead = std::move( pOldHead->next );
-    return pOldHead->data;
+void * SharedQueueImpl::dequeue ()
+{
+    return pImplData->m_queue.dequeue();
 }
 
 /*----------------------------------------------------------------------------*/
 
-IData * SharedQueueImpl::dequeue ( int _millisecondsTimeout )
+void * SharedQueueImpl::dequeue ( int _millisecondsTimeout )
 {
-    EndScopeNotifier notifier( pImplData->m_popDataCond );
+    return pImplData->m_queue.dequeue( _millisecondsTimeout );
+}
 
-    using namespace std::chrono;
+/*----------------------------------------------------------------------------*/
 
-    bool popped;
+void * SharedQueueImpl::tryDequeue ()
+{
+    return pImplData->m_queue.tryDequeue();
+}
+
+/*----------------------------------------------------------------------------*/
 
-    std::unique_lock< std::mutex > headLock( pImplData->m_headMutex );
-    popped = pImplData->m_pushDataCond.wait_for(
-            headLock
-        ,   milliseconds( _millisecondsTimeout )
-        ,   [ this ]
-        {
-            return pImplData->m_pHead.get() != get_tail();
-        }
+void SharedQueueImpl::enqueueBulk ( void ** _ppItems, std::size_t _count )
+{
+    pImplData->m_queue.enqueueBulk( _ppItems, _count );
+}
+
+/*----------------------------------------------------------------------------*/
+
+std::size_t SharedQueueImpl::enqueueBulk (
+        void ** _ppItems
+    ,   std::size_t _count
+    ,   int _millisecondsTimeout
+)
+{
+    return pImplData->m_queue.enqueueBulk(
+        _ppItems, _count, _millisecondsTimeout
     );
+}
 
-    if ( !popped )
-        return nullptr;
+/*----------------------------------------------------------------------------*/
 
-    {
-        std::lock_guard< std::mutex > lck( pImplData->m_sizeMutex );
-        --pImplData->m_currentQueueSizeLockable;
-    }
+std::size_t SharedQueueImpl::tryEnqueueBulk (
+        void ** _ppItems
+    ,   std::size_t _count
+)
+{
+    return pImplData->m_queue.tryEnqueueBulk( _ppItems, _count );
+}
+
+/*----------------------------------------------------------------------------*/
 
-    auto pOldHead = std::move( pImplData->m_pHead );
-    pImplData->m_pHead = std::move( pOldHead->next );
-    return pOldHead->data;
+std::size_t SharedQueueImpl::dequeueBulk (
+        void ** _ppItems
+    ,   std::size_t _maxCount
+)
+{
+    return pImplData->m_queue.dequeueBulk( _ppItems, _maxCount );
+}
+
+/*----------------------------------------------------------------------------*/
+
+std::size_t SharedQueueImpl::dequeueBulk (
+        void ** _ppItems
+    ,   std::size_t _maxCount
+    ,   int _millisecondsTimeout
+)
+{
+    return pImplData->m_queue.dequeueBulk(
+        _ppItems, _maxCount, _millisecondsTimeout
+    );
+}
+
+/*----------------------------------------------------------------------------*/
+
+std::size_t SharedQueueImpl::tryDequeueBulk (
+        void ** _ppItems
+    ,   std::size_t _maxCount
+)
+{
+    return pImplData->m_queue.tryDequeueBulk( _ppItems, _maxCount );
+}
+
+/*----------------------------------------------------------------------------*/
+
+std::size_t SharedQueueImpl::drainAll ( std::vector< void * > & _rItems )
+{
+    return pImplData->m_queue.drainAll( _rItems );
 }
 
 /*----------------------------------------------------------------------------*/
 
-SharedQueueImpl::Node * SharedQueueImpl::get_tail ()
+void SharedQueueImpl::clear ()
 {
-    std::lock_guard< std::mutex > tailLock( pImplData->m_tailMutex );
-    return pImplData->m_pTail;
+    pImplData->m_queue.clear();
 }
 
 /*----------------------------------------------------------------------------*/
@@ -1,38 +1,77 @@
 #ifndef __SHAREDQUEUE_SRC_IMPL_QUEUEIMPL_H__
 #define __SHAREDQUEUE_SRC_IMPL_QUEUEIMPL_H__
 
+#include "QueueStats.h"
+#include "WaitStrategy.h"
+
+#include <cstddef>
 #include <memory>
+#include <vector>
 
 /*----------------------------------------------------------------------------*/
 
-struct IData
-{
-    virtual void * get () = 0;
-
-    virtual ~IData () = default;
-};
-
+/**
+ * @brief Type-erased queue of void * behind a compilation firewall.
+ *
+ * The implementation is SharedQueue< void >, instantiated only in
+ * QueueImpl.cpp: pointers travel through the same pooled nodes and atomic
+ * size counter as in SharedQueue< T >, without any per-item wrapper.
+ */
 struct SharedQueueImpl
 {
-    explicit SharedQueueImpl ( std::size_t _size );
+    SharedQueueImpl ( std::size_t _size, WaitStrategy _waitStrategy );
 
     ~SharedQueueImpl ();
 
     int count () const noexcept;
 
-    void enqueue ( IData * _pNewValue );
+    std::size_t capacity () const noexcept;
 
-    bool enqueue ( IData * _pNewValue, int _millisecondsTimeout );
+    bool setCapacity ( std::size_t _capacity );
 
-    IData * dequeue ();
+    bool setAutoGrow ( std::size_t _maxCapacity );
 
-    IData * dequeue ( int _millisecondsTimeout );
+    QueueStats stats () const;
 
-private:
+    void close ();
+
+    bool isClosed () const noexcept;
+
+    void enqueue ( void * _pNewValue );
+
+    bool enqueue ( void * _pNewValue, int _millisecondsTimeout );
+
+    bool tryEnqueue ( void * _pNewValue );
+
+    void * dequeue ();
+
+    void * dequeue ( int _millisecondsTimeout );
+
+    void * tryDequeue ();
+
+    void enqueueBulk ( void ** _ppItems, std::size_t _count );
+
+    std::size_t enqueueBulk (
+            void ** _ppItems
+        ,   std::size_t _count
+        ,   int _millisecondsTimeout
+    );
+
+    std::size_t tryEnqueueBulk ( void ** _ppItems, std::size_t _count );
+
+    std::size_t dequeueBulk ( void ** _ppItems, std::size_t _maxCount );
+
+    std::size_t dequeueBulk (
+            void ** _ppItems
+        ,   std::size_t _maxCount
+        ,   int _millisecondsTimeout
+    );
+
+    std::size_t tryDequeueBulk ( void ** _ppItems, std::size_t _maxCount );
 
-    struct Node;
+    std::size_t drainAll ( std::vector< void * > & _rItems );
 
-    Node * get_tail ();
+    void clear ();
 
 private:
 
@@ -0,0 +1,494 @@
+#include "impl/QueueSelector.h"
+
+#include <cassert>
+#include <chrono>
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+QueueSelector< _T >::QueueSelector (
+        Order _order
+    ,   WaitStrategy _waitStrategy
+)
+    :   m_order( _order )
+    ,   m_waitStrategy( _waitStrategy )
+    ,   m_next( 0 )
+{
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+IQueue< _T > & QueueSelector< _T >::add (
+        std::unique_ptr< IQueue< _T > > _pQueue
+)
+{
+    assert( _pQueue );
+
+    m_queues.push_back(
+        std::make_unique< Member >( *this, std::move( _pQueue ) )
+    );
+    return *m_queues.back();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t QueueSelector< _T >::queueCount () const noexcept
+{
+    return m_queues.size();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+IQueue< _T > & QueueSelector< _T >::queue ( std::size_t _index )
+{
+    assert( _index < m_queues.size() );
+
+    return *m_queues[ _index ];
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+_T * QueueSelector< _T >::select ( std::size_t * _pIndex )
+{
+    return selectUntil( _pIndex, nullptr );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+_T * QueueSelector< _T >::select (
+        int _millisecondsTimeout
+    ,   std::size_t * _pIndex
+)
+{
+    const TimePoint deadline =
+            EventCount::Clock::now()
+        +   std::chrono::milliseconds( _millisecondsTimeout )
+    ;
+    return selectUntil( _pIndex, &deadline );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+_T * QueueSelector< _T >::trySelect ( std::size_t * _pIndex )
+{
+    std::size_t index = s_noQueue;
+    _T * const pItem = tryTake( index );
+
+    if ( _pIndex )
+        *_pIndex = index;
+
+    if ( pItem )
+        onTaken();
+
+    return pItem;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t QueueSelector< _T >::waitAny ()
+{
+    return waitAnyUntil( nullptr );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t QueueSelector< _T >::waitAny ( int _millisecondsTimeout )
+{
+    const TimePoint deadline =
+            EventCount::Clock::now()
+        +   std::chrono::milliseconds( _millisecondsTimeout )
+    ;
+    return waitAnyUntil( &deadline );
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Closing ends the wait the same way as for a single queue: once nothing is
+// left anywhere, nothing more can arrive either
+template < typename _T >
+_T * QueueSelector< _T >::selectUntil (
+        std::size_t * _pIndex
+    ,   const TimePoint * _pDeadline
+)
+{
+    std::size_t index = s_noQueue;
+    _T * pItem = nullptr;
+
+    SpinWait::await(
+            m_readyEvent
+        ,   m_waitStrategy
+        ,   [ & ] () {
+                pItem = tryTake( index );
+                return pItem || allDrained();
+            }
+        ,   _pDeadline
+    );
+
+    if ( _pIndex )
+        *_pIndex = index;
+
+    if ( pItem )
+        onTaken();
+
+    return pItem;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t QueueSelector< _T >::waitAnyUntil ( const TimePoint * _pDeadline )
+{
+    std::size_t index = s_noQueue;
+
+    SpinWait::await(
+            m_readyEvent
+        ,   m_waitStrategy
+        ,   [ & ] () {
+                index = readyIndex();
+                return index != s_noQueue || allDrained();
+            }
+        ,   _pDeadline
+    );
+
+    return index;
+}
+
+/*----------------------------------------------------------------------------*/
+
+// One pass over the queues; an empty one costs its lock-free tryDequeue()
+template < typename _T >
+_T * QueueSelector< _T >::tryTake ( std::size_t & _rIndex )
+{
+    const std::size_t total = m_queues.size();
+    const std::size_t first = firstIndex();
+
+    for ( std::size_t i = 0; i < total; ++i )
+    {
+        const std::size_t index = ( first + i ) % total;
+
+        _T * const pItem = m_queues[ index ]->tryDequeue();
+        if ( !pItem )
+            continue;
+
+        if ( m_order == Order::RoundRobin )
+            m_next.store( ( index + 1 ) % total, std::memory_order_relaxed );
+
+        _rIndex = index;
+        return pItem;
+    }
+
+    return nullptr;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t QueueSelector< _T >::readyIndex () const
+{
+    const std::size_t total = m_queues.size();
+    const std::size_t first = firstIndex();
+
+    for ( std::size_t i = 0; i < total; ++i )
+    {
+        const std::size_t index = ( first + i ) % total;
+        if ( m_queues[ index ]->count() > 0 )
+            return index;
+    }
+
+    return s_noQueue;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool QueueSelector< _T >::allDrained () const
+{
+    for ( const auto & pQueue: m_queues )
+        if ( !pQueue->isClosed() || pQueue->count() > 0 )
+            return false;
+
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t QueueSelector< _T >::firstIndex () const noexcept
+{
+    return m_order == Order::RoundRobin
+        ?   m_next.load( std::memory_order_relaxed )
+        :   0
+    ;
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Neither notification makes a syscall unless a consumer is actually asleep
+// in select() or waitAny()
+template < typename _T >
+void QueueSelector< _T >::onEnqueued ()
+{
+    if ( SpinWait::parks( m_waitStrategy ) )
+        m_readyEvent.notifyOne();
+}
+
+/*----------------------------------------------------------------------------*/
+
+// A consumer may be waiting only for the last open queue to close
+template < typename _T >
+void QueueSelector< _T >::onClosed ()
+{
+    if ( SpinWait::parks( m_waitStrategy ) )
+        m_readyEvent.notifyAll();
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Pass the wakeup on if a bulk enqueue, or several producers notifying one
+// consumer, left more items behind
+template < typename _T >
+void QueueSelector< _T >::onTaken ()
+{
+    if ( !SpinWait::parks( m_waitStrategy ) )
+        return;
+
+    m_readyEvent.notifyOneIf( [ this ] () {
+        return readyIndex() != s_noQueue;
+    } );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+QueueSelector< _T >::Member::Member (
+        QueueSelector & _rSelector
+    ,   std::unique_ptr< IQueue< _T > > _pQueue
+)
+    :   m_rSelector( _rSelector )
+    ,   m_pQueue( std::move( _pQueue ) )
+{
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+int QueueSelector< _T >::Member::count () const
+{
+    return m_pQueue->count();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t QueueSelector< _T >::Member::capacity () const
+{
+    return m_pQueue->capacity();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool QueueSelector< _T >::Member::setCapacity ( std::size_t _capacity )
+{
+    return m_pQueue->setCapacity( _capacity );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool QueueSelector< _T >::Member::setAutoGrow ( std::size_t _maxCapacity )
+{
+    return m_pQueue->setAutoGrow( _maxCapacity );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+QueueStats QueueSelector< _T >::Member::stats () const
+{
+    return m_pQueue->stats();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+void QueueSelector< _T >::Member::close ()
+{
+    m_pQueue->close();
+    m_rSelector.onClosed();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool QueueSelector< _T >::Member::isClosed () const
+{
+    return m_pQueue->isClosed();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+void QueueSelector< _T >::Member::enqueue ( _T * _pNewValue )
+{
+    m_pQueue->enqueue( _pNewValue );
+    m_rSelector.onEnqueued();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool QueueSelector< _T >::Member::enqueue (
+        _T * _pNewValue
+    ,   int _millisecondsTimeout
+)
+{
+    if ( !m_pQueue->enqueue( _pNewValue, _millisecondsTimeout ) )
+        return false;
+
+    m_rSelector.onEnqueued();
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool QueueSelector< _T >::Member::tryEnqueue ( _T * _pNewValue )
+{
+    if ( !m_pQueue->tryEnqueue( _pNewValue ) )
+        return false;
+
+    m_rSelector.onEnqueued();
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+_T * QueueSelector< _T >::Member::dequeue ()
+{
+    return m_pQueue->dequeue();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+_T * QueueSelector< _T >::Member::dequeue ( int _millisecondsTimeout )
+{
+    return m_pQueue->dequeue( _millisecondsTimeout );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+_T * QueueSelector< _T >::Member::tryDequeue ()
+{
+    return m_pQueue->tryDequeue();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+void QueueSelector< _T >::Member::enqueueBulk (
+        _T ** _ppItems
+    ,   std::size_t _count
+)
+{
+    m_pQueue->enqueueBulk( _ppItems, _count );
+    if ( _count > 0 )
+        m_rSelector.onEnqueued();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t QueueSelector< _T >::Member::enqueueBulk (
+        _T ** _ppItems
+    ,   std::size_t _count
+    ,   int _millisecondsTimeout
+)
+{
+    const std::size_t enqueued =
+        m_pQueue->enqueueBulk( _ppItems, _count, _millisecondsTimeout );
+    if ( enqueued > 0 )
+        m_rSelector.onEnqueued();
+
+    return enqueued;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t QueueSelector< _T >::Member::tryEnqueueBulk (
+        _T ** _ppItems
+    ,   std::size_t _count
+)
+{
+    const std::size_t enqueued = m_pQueue->tryEnqueueBulk( _ppItems, _count );
+    if ( enqueued > 0 )
+        m_rSelector.onEnqueued();
+
+    return enqueued;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t QueueSelector< _T >::Member::dequeueBulk (
+        _T ** _ppItems
+    ,   std::size_t _maxCount
+)
+{
+    return m_pQueue->dequeueBulk( _ppItems, _maxCount );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t QueueSelector< _T >::Member::dequeueBulk (
+        _T ** _ppItems
+    ,   std::size_t _maxCount
+    ,   int _millisecondsTimeout
+)
+{
+    return m_pQueue->dequeueBulk( _ppItems, _maxCount, _millisecondsTimeout );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t QueueSelector< _T >::Member::tryDequeueBulk (
+        _T ** _ppItems
+    ,   std::size_t _maxCount
+)
+{
+    return m_pQueue->tryDequeueBulk( _ppItems, _maxCount );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t QueueSelector< _T >::Member::drainAll (
+        std::vector< _T * > & _rItems
+)
+{
+    return m_pQueue->drainAll( _rItems );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+void QueueSelector< _T >::Member::clear ()
+{
+    m_pQueue->clear();
+}
+
+/*----------------------------------------------------------------------------*/
@@ -0,0 +1,229 @@
+#ifndef __SHAREDQUEUE_SRC_IMPL_QUEUESELECTOR_H__
+#define __SHAREDQUEUE_SRC_IMPL_QUEUESELECTOR_H__
+
+/*----------------------------------------------------------------------------*/
+
+#include "IQueue.h"
+#include "WaitStrategy.h"
+#include "impl/EventCount.h"
+#include "impl/SpinWait.h"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/*----------------------------------------------------------------------------*/
+
+/**
+ * @class QueueSelector
+ *
+ * @brief Blocks a consumer on several queues at once, like select() on
+ *        descriptors: select() returns the first item any of them yields.
+ *
+ * The selector takes its queues over with add(), which wraps each one and
+ * returns the wrapper for producers to enqueue into. After every enqueue the
+ * wrapper notifies the one EventCount the selector's consumers sleep on, so
+ * a consumer waits on all the queues without polling them in turn, and an
+ * enqueue nobody waits for costs a fence and a load.
+ *
+ * Priority order scans the queues in the order they were added, so the first
+ * queue is always served first; RoundRobin starts after the queue served
+ * last, so that a busy queue cannot starve the others.
+ *
+ * Add every queue before selecting. Consumers may also dequeue from a member
+ * queue directly; producers must be done before the selector is destroyed.
+ */
+template < typename _T >
+class QueueSelector
+{
+public:
+
+    enum class Order
+    {
+            Priority
+        ,   RoundRobin
+    };
+
+    // The index reported when nothing was selected
+    static constexpr std::size_t s_noQueue = static_cast< std::size_t >( -1 );
+
+    explicit QueueSelector (
+            Order _order = Order::Priority
+        ,   WaitStrategy _waitStrategy = WaitStrategy::Block
+    );
+
+    QueueSelector ( const QueueSelector & ) = delete;
+    QueueSelector & operator = ( const QueueSelector & ) = delete;
+
+    /**
+     * @brief Takes _pQueue over as the queue with the next index.
+     * @return The queue to enqueue into from now on.
+     */
+    IQueue< _T > & add ( std::unique_ptr< IQueue< _T > > _pQueue );
+
+    std::size_t queueCount () const noexcept;
+
+    IQueue< _T > & queue ( std::size_t _index );
+
+    /**
+     * @brief Blocks until one of the queues yields an item.
+     * @param _pIndex Receives the index of that queue, or s_noQueue.
+     * @return nullptr only once every queue is closed and drained.
+     */
+    _T * select ( std::size_t * _pIndex = nullptr );
+
+    /**
+     * @return nullptr on timeout, or once every queue is closed and drained.
+     */
+    _T * select ( int _millisecondsTimeout, std::size_t * _pIndex = nullptr );
+
+    /**
+     * @brief Never waits.
+     * @return nullptr if every queue is empty.
+     */
+    _T * trySelect ( std::size_t * _pIndex = nullptr );
+
+    /**
+     * @brief Blocks until one of the queues holds an item, without taking
+     *        it; another consumer may get there first.
+     * @return The index of the first such queue in the selector's order, or
+     *         s_noQueue once every queue is closed and drained.
+     */
+    std::size_t waitAny ();
+
+    /**
+     * @return s_noQueue on timeout, or once every queue is closed and drained.
+     */
+    std::size_t waitAny ( int _millisecondsTimeout );
+
+private:
+
+    using TimePoint = EventCount::Clock::time_point;
+
+    class Member;
+
+    _T * selectUntil ( std::size_t * _pIndex, const TimePoint * _pDeadline );
+
+    std::size_t waitAnyUntil ( const TimePoint * _pDeadline );
+
+    _T * tryTake ( std::size_t & _rIndex );
+
+    std::size_t readyIndex () const;
+
+    bool allDrained () const;
+
+    std::size_t firstIndex () const noexcept;
+
+    void onEnqueued ();
+
+    void onClosed ();
+
+    void onTaken ();
+
+private:
+
+    std::vector< std::unique_ptr< Member > > m_queues;
+
+    // The one waiter every member queue notifies
+    EventCount m_readyEvent;
+
+    const Order m_order;
+    const WaitStrategy m_waitStrategy;
+
+    // Where RoundRobin starts the next scan
+    std::atomic< std::size_t > m_next;
+};
+
+/*----------------------------------------------------------------------------*/
+
+/**
+ * @class QueueSelector::Member
+ *
+ * @brief Forwards every call to the queue it wraps and tells the selector
+ *        about each enqueue and about closing.
+ */
+template < typename _T >
+class QueueSelector< _T >::Member
+    :   public IQueue< _T >
+{
+public:
+
+    Member (
+            QueueSelector & _rSelector
+        ,   std::unique_ptr< IQueue< _T > > _pQueue
+    );
+
+    int count () const override;
+
+    std::size_t capacity () const override;
+
+    bool setCapacity ( std::size_t _capacity ) override;
+
+    bool setAutoGrow ( std::size_t _maxCapacity ) override;
+
+    QueueStats stats () const override;
+
+    void close () override;
+
+    bool isClosed () const override;
+
+    void enqueue ( _T * _pNewValue ) override;
+
+    bool enqueue ( _T * _pNewValue, int _millisecondsTimeout ) override;
+
+    bool tryEnqueue ( _T * _pNewValue ) override;
+
+    _T * dequeue () override;
+
+    _T * dequeue ( int _millisecondsTimeout ) override;
+
+    _T * tryDequeue () override;
+
+    void enqueueBulk ( _T ** _ppItems, std::size_t _count ) override;
+
+    std::size_t enqueueBulk (
+            _T ** _ppItems
+        ,   std::size_t _count
+        ,   int _millisecondsTimeout
+    ) override;
+
+    std::size_t tryEnqueueBulk (
+            _T ** _ppItems
+        ,   std::size_t _count
+    ) override;
+
+    std::size_t dequeueBulk (
+            _T ** _ppItems
+        ,   std::size_t _maxCount
+    ) override;
+
+    std::size_t dequeueBulk (
+            _T ** _ppItems
+        ,   std::size_t _maxCount
+        ,   int _millisecondsTimeout
+    ) override;
+
+    std::size_t tryDequeueBulk (
+            _T ** _ppItems
+        ,   std::size_t _maxCount
+    ) override;
+
+    std::size_t drainAll ( std::vector< _T * > & _rItems ) override;
+
+    void clear () override;
+
+private:
+
+    QueueSelector & m_rSelector;
+
+    std::unique_ptr< IQueue< _T > > m_pQueue;
+};
+
+/*----------------------------------------------------------------------------*/
+
+#include "impl/QueueSelector.cpp"
+
+/*----------------------------------------------------------------------------*/
+
+#endif // __SHAREDQUEUE_SRC_IMPL_QUEUESELECTOR_H__
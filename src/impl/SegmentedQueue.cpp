@@ -0,0 +1,617 @@
+#include "impl/SegmentedQueue.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+struct alignas( 64 ) SegmentedQueue< _T >::Segment
+{
+    _T * slots[ s_segmentSize ];
+    Segment * next;
+};
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+SegmentedQueue< _T >::SegmentedQueue (
+        std::size_t _size
+    ,   WaitStrategy _waitStrategy
+)
+    :   m_rPool( Pool::instance() )
+    ,   m_pHead( m_rPool.acquire() )
+    ,   m_headIndex( 0 )
+    ,   m_pTail( m_pHead )
+    ,   m_tailIndex( 0 )
+    ,   m_closed( false )
+    ,   m_events( *this, m_stats, _waitStrategy )
+    ,   m_currentQueueSizeLockable( 0 )
+    ,   m_queueSize( _size )
+{
+    assert( _size > 0 );
+
+    m_pHead->next = nullptr;
+    m_rPool.reserve( segmentsFor( _size ) );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+SegmentedQueue< _T >::~SegmentedQueue ()
+{
+    while ( m_pHead )
+    {
+        Segment * pNext = m_pHead->next;
+        m_rPool.release( m_pHead );
+        m_pHead = pNext;
+    }
+
+    m_rPool.unreserve( segmentsFor( m_queueSize.load() ) );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+int SegmentedQueue< _T >::count () const noexcept
+{
+    return static_cast< int >( m_currentQueueSizeLockable.load() );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t SegmentedQueue< _T >::capacity () const noexcept
+{
+    return m_queueSize.load();
+}
+
+/*----------------------------------------------------------------------------*/
+
+// The bound is only a number here, no storage follows it, so moving it is
+// the same as in SharedQueue
+template < typename _T >
+bool SegmentedQueue< _T >::setCapacity ( std::size_t _capacity )
+{
+    assert( _capacity > 0 );
+
+    std::size_t oldCapacity;
+    {
+        std::lock_guard< StatsMutex > tailLock( m_tailMutex );
+        oldCapacity = m_queueSize.exchange( _capacity );
+    }
+
+    const std::size_t segments = segmentsFor( _capacity );
+    const std::size_t oldSegments = segmentsFor( oldCapacity );
+
+    if ( _capacity > oldCapacity )
+    {
+        m_rPool.reserve( segments - oldSegments );
+
+        m_events.onRoomMade();
+    }
+    else
+    {
+        m_rPool.unreserve( oldSegments - segments );
+    }
+
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+QueueStats SegmentedQueue< _T >::stats () const
+{
+    QueueStats stats = m_stats.snapshot();
+    stats.lockContentions =
+        m_headMutex.contentions() + m_tailMutex.contentions();
+    return stats;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+void SegmentedQueue< _T >::close ()
+{
+    {
+        std::lock_guard< StatsMutex > tailLock( m_tailMutex );
+        if ( m_closed.exchange( true ) )
+            return;
+    }
+
+    m_events.onClosed();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool SegmentedQueue< _T >::isClosed () const noexcept
+{
+    return m_closed.load();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+void SegmentedQueue< _T >::enqueue ( _T * _pNewValue )
+{
+    assert( _pNewValue );
+
+    const bool pushed = m_events.awaitRoom(
+            [ this, _pNewValue ] () { return tryPush( _pNewValue ); }
+        ,   nullptr
+    );
+
+    if ( !pushed )
+        throw QueueClosed();
+
+    m_events.onEnqueued();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool SegmentedQueue< _T >::enqueue (
+        _T * _pNewValue
+    ,   int _millisecondsTimeout
+)
+{
+    assert( _pNewValue );
+
+    const TimePoint deadline =
+            EventCount::Clock::now()
+        +   std::chrono::milliseconds( _millisecondsTimeout )
+    ;
+
+    const bool pushed = m_events.awaitRoom(
+            [ this, _pNewValue ] () { return tryPush( _pNewValue ); }
+        ,   &deadline
+    );
+
+    if ( !pushed )
+        return false; // timed out or closed
+
+    m_events.onEnqueued();
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool SegmentedQueue< _T >::tryEnqueue ( _T * _pNewValue )
+{
+    assert( _pNewValue );
+
+    if ( !tryPush( _pNewValue ) )
+        return false;
+
+    m_events.onEnqueued();
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+_T * SegmentedQueue< _T >::dequeue ()
+{
+    _T * pValue = nullptr;
+
+    const bool popped = m_events.awaitItems(
+            [ this, &pValue ] () { return tryPop( pValue ); }
+        ,   nullptr
+    );
+
+    if ( !popped )
+        return nullptr; // closed and drained
+
+    m_events.onDequeued();
+    return pValue;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+_T * SegmentedQueue< _T >::dequeue ( int _millisecondsTimeout )
+{
+    const TimePoint deadline =
+            EventCount::Clock::now()
+        +   std::chrono::milliseconds( _millisecondsTimeout )
+    ;
+
+    _T * pValue = nullptr;
+
+    const bool popped = m_events.awaitItems(
+            [ this, &pValue ] () { return tryPop( pValue ); }
+        ,   &deadline
+    );
+
+    if ( !popped )
+        return nullptr; // timed out, or closed and drained
+
+    m_events.onDequeued();
+    return pValue;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+_T * SegmentedQueue< _T >::tryDequeue ()
+{
+    _T * pValue = nullptr;
+    if ( !tryPop( pValue ) )
+        return nullptr;
+
+    m_events.onDequeued();
+    return pValue;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+void SegmentedQueue< _T >::enqueueBulk ( _T ** _ppItems, std::size_t _count )
+{
+    assert( IQueue< _T >::noneIsNull( _ppItems, _count ) );
+
+    if ( enqueueBulkUntil( _ppItems, _count, nullptr ) < _count )
+        throw QueueClosed();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t SegmentedQueue< _T >::enqueueBulk (
+        _T ** _ppItems
+    ,   std::size_t _count
+    ,   int _millisecondsTimeout
+)
+{
+    assert( IQueue< _T >::noneIsNull( _ppItems, _count ) );
+
+    const TimePoint deadline =
+            EventCount::Clock::now()
+        +   std::chrono::milliseconds( _millisecondsTimeout )
+    ;
+    return enqueueBulkUntil( _ppItems, _count, &deadline );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t SegmentedQueue< _T >::tryEnqueueBulk (
+        _T ** _ppItems
+    ,   std::size_t _count
+)
+{
+    assert( IQueue< _T >::noneIsNull( _ppItems, _count ) );
+
+    const std::size_t enqueued = tryPushBulk( _ppItems, _count );
+    if ( enqueued > 0 )
+        m_events.onEnqueued();
+    return enqueued;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t SegmentedQueue< _T >::dequeueBulk (
+        _T ** _ppItems
+    ,   std::size_t _maxCount
+)
+{
+    return dequeueBulkUntil( _ppItems, _maxCount, nullptr );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t SegmentedQueue< _T >::dequeueBulk (
+        _T ** _ppItems
+    ,   std::size_t _maxCount
+    ,   int _millisecondsTimeout
+)
+{
+    const TimePoint deadline =
+            EventCount::Clock::now()
+        +   std::chrono::milliseconds( _millisecondsTimeout )
+    ;
+    return dequeueBulkUntil( _ppItems, _maxCount, &deadline );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t SegmentedQueue< _T >::tryDequeueBulk (
+        _T ** _ppItems
+    ,   std::size_t _maxCount
+)
+{
+    const std::size_t dequeued = tryPopBulk( _ppItems, _maxCount );
+    if ( dequeued > 0 )
+        m_events.onDequeued();
+    return dequeued;
+}
+
+/*----------------------------------------------------------------------------*/
+
+// A partly filled segment at either end, and the rest full
+template < typename _T >
+std::size_t SegmentedQueue< _T >::segmentsFor (
+        std::size_t _capacity
+) noexcept
+{
+    return _capacity / s_segmentSize + 2;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool SegmentedQueue< _T >::tryPush ( _T * _pNewValue )
+{
+    // Do not touch the mutex while the queue is visibly full
+    if ( m_currentQueueSizeLockable.load() >= m_queueSize.load() )
+        return false;
+
+    std::lock_guard< StatsMutex > tailLock( m_tailMutex );
+    if (
+            m_closed.load()
+        ||  m_currentQueueSizeLockable.load() >= m_queueSize.load()
+    )
+        return false;
+
+    if ( m_tailIndex == s_segmentSize )
+        appendSegment();
+
+    m_pTail->slots[ m_tailIndex++ ] = _pNewValue;
+
+    const std::size_t size = 1
+        +   m_currentQueueSizeLockable.fetch_add(
+                1, std::memory_order_release
+            );
+    m_stats.onEnqueued( 1, [ size ] () { return size; } );
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool SegmentedQueue< _T >::tryPop ( _T * & _pValue )
+{
+    if ( m_currentQueueSizeLockable.load() == 0 )
+        return false;
+
+    std::lock_guard< StatsMutex > headLock( m_headMutex );
+    if ( m_currentQueueSizeLockable.load( std::memory_order_acquire ) == 0 )
+        return false;
+
+    if ( m_headIndex == s_segmentSize )
+        advanceHead();
+
+    _pValue = m_pHead->slots[ m_headIndex++ ];
+
+    m_currentQueueSizeLockable.fetch_sub( 1, std::memory_order_release );
+    m_stats.onDequeued( 1 );
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t SegmentedQueue< _T >::tryPushBulk (
+        _T ** _ppItems
+    ,   std::size_t _count
+)
+{
+    // Do not touch the mutex while the queue is visibly full
+    if (
+            _count == 0
+        ||  m_currentQueueSizeLockable.load() >= m_queueSize.load()
+    )
+        return 0;
+
+    std::lock_guard< StatsMutex > tailLock( m_tailMutex );
+    if ( m_closed.load() )
+        return 0;
+
+    return pushLocked( _ppItems, _count );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t SegmentedQueue< _T >::tryPopBulk (
+        _T ** _ppItems
+    ,   std::size_t _maxCount
+)
+{
+    if ( _maxCount == 0 || m_currentQueueSizeLockable.load() == 0 )
+        return 0;
+
+    std::lock_guard< StatsMutex > headLock( m_headMutex );
+    return popLocked( _ppItems, _maxCount );
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Must be called with m_tailMutex held, on a full tail segment
+template < typename _T >
+void SegmentedQueue< _T >::appendSegment ()
+{
+    Segment * const pSegment = m_rPool.acquire();
+    pSegment->next = nullptr;
+
+    m_pTail->next = pSegment;
+    m_pTail = pSegment;
+    m_tailIndex = 0;
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Must be called with m_headMutex held, on a drained head segment with items
+// behind it, which guarantees the next segment is linked
+template < typename _T >
+void SegmentedQueue< _T >::advanceHead () noexcept
+{
+    Segment * const pOldHead = m_pHead;
+    m_pHead = pOldHead->next;
+    m_headIndex = 0;
+
+    m_rPool.release( pOldHead );
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Must be called with m_tailMutex held. Items are published a segment's run
+// at a time, each run only after the segment it starts in is linked; if
+// linking a new segment throws, the runs before it stay enqueued.
+template < typename _T >
+std::size_t SegmentedQueue< _T >::pushLocked (
+        _T ** _ppItems
+    ,   std::size_t _count
+)
+{
+    const std::size_t currentSize = m_currentQueueSizeLockable.load();
+    const std::size_t capacity = m_queueSize.load();
+    if ( currentSize >= capacity )
+        return 0;
+
+    const std::size_t count = std::min( _count, capacity - currentSize );
+
+    std::size_t pushed = 0;
+    while ( pushed < count )
+    {
+        if ( m_tailIndex == s_segmentSize )
+            appendSegment();
+
+        const std::size_t run =
+            std::min( count - pushed, s_segmentSize - m_tailIndex );
+
+        std::copy(
+                _ppItems + pushed
+            ,   _ppItems + pushed + run
+            ,   m_pTail->slots + m_tailIndex
+        );
+        m_tailIndex += run;
+        pushed += run;
+
+        const std::size_t size = run
+            +   m_currentQueueSizeLockable.fetch_add(
+                    run, std::memory_order_release
+                );
+        m_stats.onEnqueued( run, [ size ] () { return size; } );
+    }
+
+    return pushed;
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Must be called with m_headMutex held. The size read with acquire covers
+// the slots and the segment links the producers wrote before publishing.
+template < typename _T >
+std::size_t SegmentedQueue< _T >::popLocked (
+        _T ** _ppItems
+    ,   std::size_t _maxCount
+) noexcept
+{
+    const std::size_t count = std::min(
+            _maxCount
+        ,   m_currentQueueSizeLockable.load( std::memory_order_acquire )
+    );
+
+    std::size_t popped = 0;
+    while ( popped < count )
+    {
+        if ( m_headIndex == s_segmentSize )
+            advanceHead();
+
+        const std::size_t run =
+            std::min( count - popped, s_segmentSize - m_headIndex );
+
+        std::copy(
+                m_pHead->slots + m_headIndex
+            ,   m_pHead->slots + m_headIndex + run
+            ,   _ppItems + popped
+        );
+        m_headIndex += run;
+        popped += run;
+    }
+
+    if ( popped > 0 )
+    {
+        m_currentQueueSizeLockable.fetch_sub(
+            popped, std::memory_order_release
+        );
+        m_stats.onDequeued( popped );
+    }
+
+    return popped;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t SegmentedQueue< _T >::enqueueBulkUntil (
+        _T ** _ppItems
+    ,   std::size_t _count
+    ,   const TimePoint * _pDeadline
+)
+{
+    std::size_t enqueued = 0;
+    while ( enqueued < _count )
+    {
+        std::size_t pushed = 0;
+        m_events.awaitRoom(
+                [ & ] () {
+                    pushed = tryPushBulk(
+                        _ppItems + enqueued, _count - enqueued
+                    );
+                    return pushed > 0;
+                }
+            ,   _pDeadline
+        );
+
+        if ( pushed == 0 )
+            break; // timed out or closed
+
+        enqueued += pushed;
+
+        // One wakeup per pushed batch
+        m_events.onEnqueued();
+    }
+
+    return enqueued;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t SegmentedQueue< _T >::dequeueBulkUntil (
+        _T ** _ppItems
+    ,   std::size_t _maxCount
+    ,   const TimePoint * _pDeadline
+)
+{
+    if ( _maxCount == 0 )
+        return 0;
+
+    std::size_t dequeued = 0;
+    m_events.awaitItems(
+            [ & ] () {
+                dequeued = tryPopBulk( _ppItems, _maxCount );
+                return dequeued > 0;
+            }
+        ,   _pDeadline
+    );
+
+    if ( dequeued == 0 )
+        return 0; // timed out, or closed and drained
+
+    // One wakeup for the whole batch
+    m_events.onDequeued();
+
+    return dequeued;
+}
+
+/*----------------------------------------------------------------------------*/
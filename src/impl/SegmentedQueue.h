@@ -0,0 +1,175 @@
+#ifndef __SHAREDQUEUE_SRC_IMPL_SEGMENTEDQUEUE_H__
+#define __SHAREDQUEUE_SRC_IMPL_SEGMENTEDQUEUE_H__
+
+/*----------------------------------------------------------------------------*/
+
+#include "IQueue.h"
+#include "impl/NodePool.h"
+#include "impl/QueueEvents.h"
+#include "impl/SpinWait.h"
+#include "impl/StatsCounters.h"
+
+#include <atomic>
+#include <mutex>
+
+/*----------------------------------------------------------------------------*/
+
+/**
+ * @class SegmentedQueue
+ *
+ * @brief FIFO queue for deep backlogs: items are stored in a linked list of
+ *        cache-aligned arrays (segments) of s_segmentSize slots rather than
+ *        in one node each.
+ *
+ * Producers and consumers only advance an index within their segment; a
+ * segment is linked when the tail fills it and handed back to a NodePool
+ * when the head leaves it. An item costs one pointer plus its share of the
+ * segment link, a quarter of a pooled SharedQueue node with its allocation
+ * header, and a drain walks memory sequentially.
+ *
+ * Memory grows with count(), not with the bound: only the segments in use
+ * are allocated, so a bound of tens of millions costs nothing until the
+ * backlog is there. As in SharedQueue, producers and consumers take separate
+ * locks and meet only on the atomic size, and setCapacity() is supported.
+ */
+template < typename _T >
+class SegmentedQueue
+    :   public IQueue < _T >
+{
+public:
+
+    static constexpr std::size_t s_segmentSize = 256;
+
+    explicit SegmentedQueue (
+            std::size_t _size
+        ,   WaitStrategy _waitStrategy = WaitStrategy::Block
+    );
+
+    ~SegmentedQueue ();
+
+    int count () const noexcept override;
+
+    std::size_t capacity () const noexcept override;
+
+    bool setCapacity ( std::size_t _capacity ) override;
+
+    QueueStats stats () const override;
+
+    void close () override;
+
+    bool isClosed () const noexcept override;
+
+    void enqueue ( _T * _pNewValue ) override;
+
+    bool enqueue ( _T * _pNewValue, int _millisecondsTimeout ) override;
+
+    bool tryEnqueue ( _T * _pNewValue ) override;
+
+    _T * dequeue () override;
+
+    _T * dequeue ( int _millisecondsTimeout ) override;
+
+    _T * tryDequeue () override;
+
+    void enqueueBulk ( _T ** _ppItems, std::size_t _count ) override;
+
+    std::size_t enqueueBulk (
+            _T ** _ppItems
+        ,   std::size_t _count
+        ,   int _millisecondsTimeout
+    ) override;
+
+    std::size_t tryEnqueueBulk (
+            _T ** _ppItems
+        ,   std::size_t _count
+    ) override;
+
+    std::size_t dequeueBulk (
+            _T ** _ppItems
+        ,   std::size_t _maxCount
+    ) override;
+
+    std::size_t dequeueBulk (
+            _T ** _ppItems
+        ,   std::size_t _maxCount
+        ,   int _millisecondsTimeout
+    ) override;
+
+    std::size_t tryDequeueBulk (
+            _T ** _ppItems
+        ,   std::size_t _maxCount
+    ) override;
+
+private:
+
+    struct Segment;
+
+    using Pool = NodePool< Segment >;
+    using TimePoint = EventCount::Clock::time_point;
+
+    static std::size_t segmentsFor ( std::size_t _capacity ) noexcept;
+
+    bool tryPush ( _T * _pNewValue );
+
+    bool tryPop ( _T * & _pValue );
+
+    std::size_t tryPushBulk ( _T ** _ppItems, std::size_t _count );
+
+    std::size_t tryPopBulk ( _T ** _ppItems, std::size_t _maxCount );
+
+    void appendSegment ();
+
+    void advanceHead () noexcept;
+
+    std::size_t pushLocked ( _T ** _ppItems, std::size_t _count );
+
+    std::size_t popLocked ( _T ** _ppItems, std::size_t _maxCount ) noexcept;
+
+    std::size_t enqueueBulkUntil (
+            _T ** _ppItems
+        ,   std::size_t _count
+        ,   const TimePoint * _pDeadline
+    );
+
+    std::size_t dequeueBulkUntil (
+            _T ** _ppItems
+        ,   std::size_t _maxCount
+        ,   const TimePoint * _pDeadline
+    );
+
+private:
+
+    static constexpr std::size_t s_cacheLineSize = 64;
+
+    Pool & m_rPool;
+
+    // Consumers' side
+    alignas( s_cacheLineSize ) mutable StatsMutex m_headMutex;
+    Segment * m_pHead;
+    std::size_t m_headIndex;
+
+    // Producers' side
+    alignas( s_cacheLineSize ) mutable StatsMutex m_tailMutex;
+    Segment * m_pTail;
+    std::size_t m_tailIndex;
+
+    // Written only under m_tailMutex, so no item is pushed after it is set
+    std::atomic< bool > m_closed;
+
+    alignas( s_cacheLineSize ) QueueEvents< _T > m_events;
+
+    std::atomic< std::size_t > m_currentQueueSizeLockable;
+
+    // Written only under m_tailMutex
+    std::atomic< std::size_t > m_queueSize;
+
+    [[no_unique_address]] StatsCounters m_stats;
+};
+
+/*----------------------------------------------------------------------------*/
+
+#include "impl/SegmentedQueue.cpp"
+
+/*----------------------------------------------------------------------------*/
+
+#endif // __SHAREDQUEUE_SRC_IMPL_SEGMENTEDQUEUE_H__
@@ -0,0 +1,451 @@
+#include "impl/ShardedQueue.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <thread>
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+ShardedQueue< _T >::ShardedQueue (
+        std::size_t _size
+    ,   WaitStrategy _waitStrategy
+    ,   std::size_t _laneCount
+)
+    :   m_queueSize( _size )
+    ,   m_events( *this, m_stats, _waitStrategy )
+    ,   m_closed( false )
+{
+    assert( _size > 0 );
+
+    std::size_t laneCount = _laneCount > 0
+        ?   _laneCount
+        :   std::max( std::thread::hardware_concurrency(), 1u )
+    ;
+    laneCount = std::min( laneCount, _size );
+
+    // Lanes are only used through their try operations and this queue does
+    // the waiting itself, so they get a strategy that never notifies.
+    m_lanes.reserve( laneCount );
+    for ( std::size_t i = 0; i < laneCount; ++i )
+    {
+        const std::size_t laneSize =
+            _size / laneCount + ( i < _size % laneCount ? 1 : 0 );
+        m_lanes.push_back(
+            std::make_unique< Lane >( laneSize, WaitStrategy::Spin )
+        );
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+ShardedQueue< _T >::~ShardedQueue ()
+{
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t ShardedQueue< _T >::laneCount () const noexcept
+{
+    return m_lanes.size();
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Each lane is bounded by its own share of the capacity, so the sum never
+// exceeds m_queueSize even though the lanes are read one after the other.
+template < typename _T >
+int ShardedQueue< _T >::count () const noexcept
+{
+    int size = 0;
+    for ( const auto & pLane: m_lanes )
+        size += pLane->count();
+    return size;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t ShardedQueue< _T >::capacity () const noexcept
+{
+    return m_queueSize;
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Counted here rather than summed over the lanes, whose own counters see the
+// spills and steals of tryPushBulk() and tryPopBulk() item by item.
+template < typename _T >
+QueueStats ShardedQueue< _T >::stats () const
+{
+    return m_stats.snapshot();
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Lanes refuse items as soon as they are closed, and still count the ones
+// being published, so consumers that see the flag and no items are done.
+template < typename _T >
+void ShardedQueue< _T >::close ()
+{
+    for ( const auto & pLane: m_lanes )
+        pLane->close();
+
+    if ( m_closed.exchange( true ) )
+        return;
+
+    m_events.onClosed();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool ShardedQueue< _T >::isClosed () const noexcept
+{
+    return m_closed.load();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+void ShardedQueue< _T >::enqueue ( _T * _pNewValue )
+{
+    assert( _pNewValue );
+
+    const bool pushed = m_events.awaitRoom(
+            [ this, &_pNewValue ] () {
+                return tryPushBulk( &_pNewValue, 1 ) > 0;
+            }
+        ,   nullptr
+    );
+
+    if ( !pushed )
+        throw QueueClosed();
+
+    m_events.onEnqueued();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool ShardedQueue< _T >::enqueue ( _T * _pNewValue, int _millisecondsTimeout )
+{
+    assert( _pNewValue );
+
+    using namespace std::chrono;
+
+    const auto deadline =
+        EventCount::Clock::now() + milliseconds( _millisecondsTimeout );
+
+    const bool pushed = m_events.awaitRoom(
+            [ this, &_pNewValue ] () {
+                return tryPushBulk( &_pNewValue, 1 ) > 0;
+            }
+        ,   &deadline
+    );
+
+    if ( !pushed )
+        return false; // timed out or closed
+
+    m_events.onEnqueued();
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Looks at every lane before giving up, but only with their lock-free loads
+template < typename _T >
+bool ShardedQueue< _T >::tryEnqueue ( _T * _pNewValue )
+{
+    assert( _pNewValue );
+
+    if ( tryPushBulk( &_pNewValue, 1 ) == 0 )
+        return false;
+
+    m_events.onEnqueued();
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+_T * ShardedQueue< _T >::dequeue ()
+{
+    _T * pReturnVal = nullptr;
+
+    const bool popped = m_events.awaitItems(
+            [ this, &pReturnVal ] () {
+                return tryPopBulk( &pReturnVal, 1 ) > 0;
+            }
+        ,   nullptr
+    );
+
+    if ( !popped )
+        return nullptr; // closed and drained
+
+    m_events.onDequeued();
+    return pReturnVal;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+_T * ShardedQueue< _T >::dequeue ( int _millisecondsTimeout )
+{
+    using namespace std::chrono;
+
+    _T * pReturnVal = nullptr;
+
+    const auto deadline =
+        EventCount::Clock::now() + milliseconds( _millisecondsTimeout );
+
+    const bool popped = m_events.awaitItems(
+            [ this, &pReturnVal ] () {
+                return tryPopBulk( &pReturnVal, 1 ) > 0;
+            }
+        ,   &deadline
+    );
+
+    if ( !popped )
+        return nullptr; // timed out, or closed and drained
+
+    m_events.onDequeued();
+    return pReturnVal;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+_T * ShardedQueue< _T >::tryDequeue ()
+{
+    _T * pReturnVal = nullptr;
+    if ( tryPopBulk( &pReturnVal, 1 ) == 0 )
+        return nullptr;
+
+    m_events.onDequeued();
+    return pReturnVal;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+void ShardedQueue< _T >::enqueueBulk ( _T ** _ppItems, std::size_t _count )
+{
+    assert( IQueue< _T >::noneIsNull( _ppItems, _count ) );
+
+    std::size_t enqueued = 0;
+    while ( enqueued < _count )
+    {
+        const bool progressed = m_events.awaitRoom(
+                [ & ] () {
+                    const std::size_t pushed =
+                        tryPushBulk( _ppItems + enqueued, _count - enqueued );
+                    enqueued += pushed;
+                    return pushed > 0;
+                }
+            ,   nullptr
+        );
+
+        if ( !progressed )
+            throw QueueClosed();
+
+        m_events.onEnqueued();
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t ShardedQueue< _T >::enqueueBulk (
+        _T ** _ppItems
+    ,   std::size_t _count
+    ,   int _millisecondsTimeout
+)
+{
+    assert( IQueue< _T >::noneIsNull( _ppItems, _count ) );
+
+    using namespace std::chrono;
+
+    const auto deadline =
+        EventCount::Clock::now() + milliseconds( _millisecondsTimeout );
+
+    std::size_t enqueued = 0;
+    while ( enqueued < _count )
+    {
+        std::size_t pushed = 0;
+        m_events.awaitRoom(
+                [ & ] () {
+                    pushed =
+                        tryPushBulk( _ppItems + enqueued, _count - enqueued );
+                    return pushed > 0;
+                }
+            ,   &deadline
+        );
+
+        if ( pushed == 0 )
+            break; // timed out or closed
+
+        enqueued += pushed;
+        m_events.onEnqueued();
+    }
+
+    return enqueued;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t ShardedQueue< _T >::tryEnqueueBulk (
+        _T ** _ppItems
+    ,   std::size_t _count
+)
+{
+    assert( IQueue< _T >::noneIsNull( _ppItems, _count ) );
+
+    const std::size_t enqueued = tryPushBulk( _ppItems, _count );
+    if ( enqueued > 0 )
+        m_events.onEnqueued();
+    return enqueued;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t ShardedQueue< _T >::dequeueBulk (
+        _T ** _ppItems
+    ,   std::size_t _maxCount
+)
+{
+    if ( _maxCount == 0 )
+        return 0;
+
+    std::size_t dequeued = 0;
+    m_events.awaitItems(
+            [ & ] () {
+                dequeued = tryPopBulk( _ppItems, _maxCount );
+                return dequeued > 0;
+            }
+        ,   nullptr
+    );
+
+    if ( dequeued == 0 )
+        return 0; // closed and drained
+
+    m_events.onDequeued();
+    return dequeued;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t ShardedQueue< _T >::dequeueBulk (
+        _T ** _ppItems
+    ,   std::size_t _maxCount
+    ,   int _millisecondsTimeout
+)
+{
+    using namespace std::chrono;
+
+    if ( _maxCount == 0 )
+        return 0;
+
+    const auto deadline =
+        EventCount::Clock::now() + milliseconds( _millisecondsTimeout );
+
+    std::size_t dequeued = 0;
+    m_events.awaitItems(
+            [ & ] () {
+                dequeued = tryPopBulk( _ppItems, _maxCount );
+                return dequeued > 0;
+            }
+        ,   &deadline
+    );
+
+    if ( dequeued > 0 )
+        m_events.onDequeued();
+    return dequeued;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t ShardedQueue< _T >::tryDequeueBulk (
+        _T ** _ppItems
+    ,   std::size_t _maxCount
+)
+{
+    const std::size_t dequeued = tryPopBulk( _ppItems, _maxCount );
+    if ( dequeued > 0 )
+        m_events.onDequeued();
+    return dequeued;
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Threads are spread over the lanes in the order they first touch a sharded
+// queue, which balances them better than hashing their ids.
+template < typename _T >
+std::size_t ShardedQueue< _T >::homeLane () const noexcept
+{
+    static std::atomic< std::size_t > s_nextTicket( 0 );
+    thread_local const std::size_t ticket =
+        s_nextTicket.fetch_add( 1, std::memory_order_relaxed );
+
+    return ticket % m_lanes.size();
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Fills the home lane first and spills whatever does not fit into the next
+// lanes, so a producer only fails when all of them are full.
+template < typename _T >
+std::size_t ShardedQueue< _T >::tryPushBulk (
+        _T ** _ppItems
+    ,   std::size_t _count
+)
+{
+    const std::size_t laneCount = m_lanes.size();
+    const std::size_t home = homeLane();
+
+    std::size_t pushed = 0;
+    for ( std::size_t i = 0; i < laneCount && pushed < _count; ++i )
+    {
+        Lane & rLane = *m_lanes[ ( home + i ) % laneCount ];
+        pushed += rLane.tryEnqueueBulk( _ppItems + pushed, _count - pushed );
+    }
+
+    if ( pushed > 0 )
+        m_stats.onEnqueued( pushed, [ this ] () { return count(); } );
+    return pushed;
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Drains the home lane first and steals from the next lanes for whatever is
+// still missing, so a consumer only fails when all of them are empty.
+template < typename _T >
+std::size_t ShardedQueue< _T >::tryPopBulk (
+        _T ** _ppItems
+    ,   std::size_t _maxCount
+)
+{
+    const std::size_t laneCount = m_lanes.size();
+    const std::size_t home = homeLane();
+
+    std::size_t popped = 0;
+    for ( std::size_t i = 0; i < laneCount && popped < _maxCount; ++i )
+    {
+        Lane & rLane = *m_lanes[ ( home + i ) % laneCount ];
+        popped += rLane.tryDequeueBulk( _ppItems + popped, _maxCount - popped );
+    }
+
+    if ( popped > 0 )
+        m_stats.onDequeued( popped );
+    return popped;
+}
+
+/*----------------------------------------------------------------------------*/
@@ -0,0 +1,136 @@
+#ifndef __SHAREDQUEUE_SRC_IMPL_SHARDEDQUEUE_H__
+#define __SHAREDQUEUE_SRC_IMPL_SHARDEDQUEUE_H__
+
+/*----------------------------------------------------------------------------*/
+
+#include "IQueue.h"
+#include "impl/EventCount.h"
+#include "impl/LockFreeQueue.h"
+#include "impl/QueueEvents.h"
+#include "impl/SpinWait.h"
+#include "impl/StatsCounters.h"
+
+#include <memory>
+#include <vector>
+
+/*----------------------------------------------------------------------------*/
+
+/**
+ * @class ShardedQueue
+ *
+ * @brief Bounded multi-producer/multi-consumer queue split into lanes, so
+ *        threads working on different lanes never touch the same positions.
+ *
+ * Every thread gets a home lane, handed out round-robin on first use.
+ * Producers fill their home lane and only spill into the others when it is
+ * full; consumers drain their home lane and steal from the others when it
+ * is empty. The capacity is split between the lanes, so count() never
+ * exceeds it; a producer only waits once it found every lane full and a
+ * consumer once it found every lane empty.
+ *
+ * Please note: items keep FIFO order within a lane only. Two items from one
+ * producer come out in order unless the second one spilled into another lane.
+ */
+template < typename _T >
+class ShardedQueue
+    :   public IQueue < _T >
+{
+public:
+
+    /**
+     * @param _laneCount 0 means one lane per hardware thread. Never more
+     *        lanes than _size, so that every lane holds at least one item.
+     */
+    explicit ShardedQueue (
+            std::size_t _size
+        ,   WaitStrategy _waitStrategy = WaitStrategy::Block
+        ,   std::size_t _laneCount = 0
+    );
+
+    ~ShardedQueue ();
+
+    std::size_t laneCount () const noexcept;
+
+    int count () const noexcept override;
+
+    std::size_t capacity () const noexcept override;
+
+    QueueStats stats () const override;
+
+    void close () override;
+
+    bool isClosed () const noexcept override;
+
+    void enqueue ( _T * _pNewValue ) override;
+
+    bool enqueue ( _T * _pNewValue, int _millisecondsTimeout ) override;
+
+    bool tryEnqueue ( _T * _pNewValue ) override;
+
+    _T * dequeue () override;
+
+    _T * dequeue ( int _millisecondsTimeout ) override;
+
+    _T * tryDequeue () override;
+
+    void enqueueBulk ( _T ** _ppItems, std::size_t _count ) override;
+
+    std::size_t enqueueBulk (
+            _T ** _ppItems
+        ,   std::size_t _count
+        ,   int _millisecondsTimeout
+    ) override;
+
+    std::size_t tryEnqueueBulk (
+            _T ** _ppItems
+        ,   std::size_t _count
+    ) override;
+
+    std::size_t dequeueBulk (
+            _T ** _ppItems
+        ,   std::size_t _maxCount
+    ) override;
+
+    std::size_t dequeueBulk (
+            _T ** _ppItems
+        ,   std::size_t _maxCount
+        ,   int _millisecondsTimeout
+    ) override;
+
+    std::size_t tryDequeueBulk (
+            _T ** _ppItems
+        ,   std::size_t _maxCount
+    ) override;
+
+private:
+
+    using Lane = LockFreeQueue< _T >;
+
+    std::size_t homeLane () const noexcept;
+
+    std::size_t tryPushBulk ( _T ** _ppItems, std::size_t _count );
+
+    std::size_t tryPopBulk ( _T ** _ppItems, std::size_t _maxCount );
+
+private:
+
+    static constexpr std::size_t s_cacheLineSize = 64;
+
+    const std::size_t m_queueSize;
+    std::vector< std::unique_ptr< Lane > > m_lanes;
+
+    alignas( s_cacheLineSize ) QueueEvents< _T > m_events;
+
+    // Set once every lane is closed
+    std::atomic< bool > m_closed;
+
+    [[no_unique_address]] StatsCounters m_stats;
+};
+
+/*----------------------------------------------------------------------------*/
+
+#include "impl/ShardedQueue.cpp"
+
+/*----------------------------------------------------------------------------*/
+
+#endif // __SHAREDQUEUE_SRC_IMPL_SHARDEDQUEUE_H__
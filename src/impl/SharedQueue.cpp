@@ -1,7 +1,8 @@
 #include "impl/SharedQueue.h"
 
+#include <algorithm>
+#include <cassert>
 #include <chrono>
-#include <iostream>
 
 /*----------------------------------------------------------------------------*/
 
@@ -9,18 +10,27 @@ template < typename _T >
 struct SharedQueue< _T >::Node
 {
     _T * data;
-    std::unique_ptr< Node > next;
+    Node * next;
 };
 
 /*----------------------------------------------------------------------------*/
 
 template < typename _T >
-SharedQueue< _T >::SharedQueue ( std::size_t _size )
-    :   m_pHead( std::make_unique< Node >() )
-    ,   m_pTail( m_pHead.get() )
+SharedQueue< _T >::SharedQueue (
+        std::size_t _size
+    ,   WaitStrategy _waitStrategy
+)
+    :   m_rPool( Pool::instance() )
+    ,   m_events( *this, m_stats, _waitStrategy )
+    ,   m_pHead( m_rPool.acquire() )
+    ,   m_pTail( m_pHead )
     ,   m_currentQueueSizeLockable( 0 )
     ,   m_queueSize( _size )
+    ,   m_maxQueueSize( 0 )
+    ,   m_closed( false )
 {
+    // Let the pool keep enough nodes around to refill the whole queue
+    m_rPool.reserve( _size + 1 );
 }
 
 /*----------------------------------------------------------------------------*/
@@ -28,6 +38,9 @@ SharedQueue< _T >::SharedQueue ( std::size_t _size )
 template < typename _T >
 SharedQueue< _T >::~SharedQueue ()
 {
+    releaseChain( m_pHead );
+
+    m_rPool.unreserve( m_queueSize.load() + 1 );
 }
 
 /*----------------------------------------------------------------------------*/
@@ -41,32 +54,118 @@ int SharedQueue< _T >::count () const noexcept
 /*----------------------------------------------------------------------------*/
 
 template < typename _T >
-void SharedQueue< _T >::enqueue ( _T * _pNewValue )
+std::size_t SharedQueue< _T >::capacity () const noexcept
+{
+    return m_queueSize.load();
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Producers only compare against the capacity under m_tailMutex, so moving it
+// there is enough for every one of them to see either the old or the new
+// bound; the nodes already linked are left alone either way.
+template < typename _T >
+bool SharedQueue< _T >::setCapacity ( std::size_t _capacity )
 {
-    std::unique_ptr< Node > pNewNode( std::make_unique< Node >() );
+    assert( _capacity > 0 );
+
+    std::size_t oldCapacity;
+    {
+        std::lock_guard< StatsMutex > tailLock( m_tailMutex );
+        oldCapacity = m_queueSize.exchange( _capacity );
+    }
 
+    if ( _capacity > oldCapacity )
     {
-        std::unique_lock< std::mutex > tailLock( m_tailMutex );
+        m_rPool.reserve( _capacity - oldCapacity );
+
+        // Every blocked producer may now have room
+        m_events.onRoomMade();
+    }
+    else
+    {
+        m_rPool.unreserve( oldCapacity - _capacity );
+    }
 
-        // Wait while the queue is full
-        m_notFullCond.wait( tailLock, [ this ] () {
-            return m_currentQueueSizeLockable.load() < m_queueSize;
-        } );
+    return true;
+}
 
-        ++m_currentQueueSizeLockable;
+/*----------------------------------------------------------------------------*/
 
-        // Link new node at tail
-        m_pTail->data = _pNewValue;
-        Node* const pNewTail = pNewNode.get();
-        m_pTail->next = std::move(pNewNode);
-        m_pTail = pNewTail;
+template < typename _T >
+bool SharedQueue< _T >::setAutoGrow ( std::size_t _maxCapacity )
+{
+    std::size_t oldMaxCapacity;
+    {
+        std::lock_guard< StatsMutex > tailLock( m_tailMutex );
+        oldMaxCapacity = m_maxQueueSize.exchange( _maxCapacity );
     }
 
-    // Notify a waiting consumer that queue is not empty
+    // Producers blocked at the old ceiling may grow the queue now
+    if ( _maxCapacity > oldMaxCapacity )
+        m_events.onRoomMade();
+
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+QueueStats SharedQueue< _T >::stats () const
+{
+    QueueStats stats = m_stats.snapshot();
+    stats.lockContentions =
+        m_headMutex.contentions() + m_tailMutex.contentions();
+    return stats;
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Setting the flag under m_tailMutex orders it after every link already made,
+// so consumers that see it and an empty queue know nothing more is coming.
+template < typename _T >
+void SharedQueue< _T >::close ()
+{
     {
-        std::lock_guard< std::mutex > headLock( m_headMutex );
-        m_notEmptyCond.notify_one();
+        std::lock_guard< StatsMutex > tailLock( m_tailMutex );
+        if ( m_closed.exchange( true ) )
+            return;
     }
+
+    m_events.onClosed();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool SharedQueue< _T >::isClosed () const noexcept
+{
+    return m_closed.load();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+void SharedQueue< _T >::enqueue ( _T * _pNewValue )
+{
+    assert( _pNewValue );
+
+    Node * const pNewTail = m_rPool.acquire();
+
+    const bool linked = m_events.awaitRoom(
+            [ this, pNewTail, _pNewValue ] () {
+                return tryLink( pNewTail, _pNewValue );
+            }
+        ,   nullptr
+    );
+
+    if ( !linked )
+    {
+        m_rPool.release( pNewTail );
+        throw QueueClosed();
+    }
+
+    m_events.onEnqueued();
 }
 
 /*----------------------------------------------------------------------------*/
@@ -74,39 +173,60 @@ void SharedQueue< _T >::enqueue ( _T * _pNewValue )
 template < typename _T >
 bool SharedQueue< _T >::enqueue ( _T * _pNewValue, int _millisecondsTimeout )
 {
+    assert( _pNewValue );
+
     using namespace std::chrono;
 
-    std::unique_ptr< Node > pNewNode = std::make_unique< Node >();
+    const TimePoint deadline =
+        steady_clock::now() + milliseconds( _millisecondsTimeout );
 
-    std::unique_lock< std::mutex > tailLock( m_tailMutex );
+    // Only take a node once there is room for it, so that a call that
+    // times out on a full queue leaves the pool alone
+    Node * pNewTail = nullptr;
 
-    bool notFull = m_notFullCond.wait_for(
-        tailLock, milliseconds( _millisecondsTimeout ),
-        [ this ] ()
-        {
-            return m_currentQueueSizeLockable.load() < m_queueSize;
-        }
+    const bool linked = m_events.awaitRoom(
+            [ this, &pNewTail, _pNewValue ] () {
+                if ( visiblyFull() || m_closed.load() )
+                    return false;
+
+                if ( !pNewTail )
+                    pNewTail = m_rPool.acquire();
+
+                return tryLink( pNewTail, _pNewValue );
+            }
+        ,   &deadline
     );
 
-    if ( !notFull )
+    if ( !linked )
     {
-        return false; // timed out
+        if ( pNewTail )
+            m_rPool.release( pNewTail );
+        return false; // timed out or closed
     }
 
-    ++m_currentQueueSizeLockable; // increment size
+    m_events.onEnqueued();
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
 
-    // Link new node at tail
-    m_pTail->data = _pNewValue;
-    Node * const pNewTail = pNewNode.get();
-    m_pTail->next = std::move( pNewNode );
-    m_pTail = pNewTail;
+template < typename _T >
+bool SharedQueue< _T >::tryEnqueue ( _T * _pNewValue )
+{
+    assert( _pNewValue );
 
-    // Notify a waiting consumer that queue is not empty
+    // Refused on the lock-free view alone, before a node is even acquired
+    if ( visiblyFull() || m_closed.load() )
+        return false;
+
+    Node * const pNewTail = m_rPool.acquire();
+    if ( !tryLink( pNewTail, _pNewValue ) )
     {
-        std::lock_guard< std::mutex > headLock( m_headMutex );
-        m_notEmptyCond.notify_one();
+        m_rPool.release( pNewTail );
+        return false;
     }
 
+    m_events.onEnqueued();
     return true;
 }
 
@@ -115,81 +235,674 @@ bool SharedQueue< _T >::enqueue ( _T * _pNewValue, int _millisecondsTimeout )
 template < typename _T >
 _T * SharedQueue< _T >::dequeue ()
 {
-    std::unique_ptr< Node > pOldHead;
+    Node * pOldHead;
     _T * pReturnVal = nullptr;
 
-    // Lock m_headMutex for removing from the head
-    {
-        std::unique_lock< std::mutex > headLock( m_headMutex );
+    const bool unlinked = m_events.awaitItems(
+            [ this, &pOldHead, &pReturnVal ] () {
+                return tryUnlink( pOldHead, pReturnVal );
+            }
+        ,   nullptr
+    );
 
-        m_notEmptyCond.wait( headLock, [ this ] () {
-            return m_pHead.get() != getTail(); // queue not empty
-        } );
+    if ( !unlinked )
+        return nullptr; // closed and drained
 
-        // Remove the head node
-        --m_currentQueueSizeLockable;
+    m_rPool.release( pOldHead );
 
-        pOldHead = std::move(m_pHead);
-        m_pHead = std::move(pOldHead->next);
-        pReturnVal = pOldHead->data;
-    }
+    m_events.onDequeued();
+    return pReturnVal;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+_T * SharedQueue< _T >::dequeue ( int _millisecondsTimeout )
+{
+    using namespace std::chrono;
+
+    const TimePoint deadline =
+        steady_clock::now() + milliseconds( _millisecondsTimeout );
+
+    Node * pOldHead;
+    _T * pReturnVal = nullptr;
+
+    const bool unlinked = m_events.awaitItems(
+            [ this, &pOldHead, &pReturnVal ] () {
+                return tryUnlink( pOldHead, pReturnVal );
+            }
+        ,   &deadline
+    );
+
+    if ( !unlinked )
+        return nullptr; // timed out, or closed and drained
+
+    m_rPool.release( pOldHead );
+
+    m_events.onDequeued();
+    return pReturnVal;
+}
+
+/*----------------------------------------------------------------------------*/
+
+// tryUnlink() loads the size before it goes near m_headMutex
+template < typename _T >
+_T * SharedQueue< _T >::tryDequeue ()
+{
+    Node * pOldHead;
+    _T * pReturnVal = nullptr;
+
+    if ( !tryUnlink( pOldHead, pReturnVal ) )
+        return nullptr;
+
+    m_rPool.release( pOldHead );
+
+    m_events.onDequeued();
+    return pReturnVal;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+void SharedQueue< _T >::enqueueBulk ( _T ** _ppItems, std::size_t _count )
+{
+    assert( IQueue< _T >::noneIsNull( _ppItems, _count ) );
+
+    if ( enqueueBulkUntil( _ppItems, _count, nullptr ) < _count )
+        throw QueueClosed();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t SharedQueue< _T >::enqueueBulk (
+        _T ** _ppItems
+    ,   std::size_t _count
+    ,   int _millisecondsTimeout
+)
+{
+    assert( IQueue< _T >::noneIsNull( _ppItems, _count ) );
+
+    const TimePoint deadline =
+            std::chrono::steady_clock::now()
+        +   std::chrono::milliseconds( _millisecondsTimeout )
+    ;
+    return enqueueBulkUntil( _ppItems, _count, &deadline );
+}
 
-    // Signal "not full"
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t SharedQueue< _T >::tryEnqueueBulk (
+        _T ** _ppItems
+    ,   std::size_t _count
+)
+{
+    assert( IQueue< _T >::noneIsNull( _ppItems, _count ) );
+
+    // Size the chain from a lock-free estimate of the free room, counting
+    // whatever auto-growth may add
+    const std::size_t currentSize = m_currentQueueSizeLockable.load();
+    const std::size_t limit =
+        std::max( m_queueSize.load(), m_maxQueueSize.load() );
+    if ( _count == 0 || currentSize >= limit )
+        return 0;
+
+    const std::size_t count = std::min( _count, limit - currentSize );
+
+    Node * pChainLast;
+    Node * pChain = buildChain( _ppItems, count, pChainLast );
+
+    const std::size_t enqueued =
+        tryLinkChain( _ppItems, count, pChain, pChainLast );
+
+    releaseChain( pChain );
+
+    if ( enqueued > 0 )
+        m_events.onEnqueued();
+
+    return enqueued;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t SharedQueue< _T >::dequeueBulk (
+        _T ** _ppItems
+    ,   std::size_t _maxCount
+)
+{
+    return dequeueBulkUntil( _ppItems, _maxCount, nullptr );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t SharedQueue< _T >::dequeueBulk (
+        _T ** _ppItems
+    ,   std::size_t _maxCount
+    ,   int _millisecondsTimeout
+)
+{
+    const TimePoint deadline =
+            std::chrono::steady_clock::now()
+        +   std::chrono::milliseconds( _millisecondsTimeout )
+    ;
+    return dequeueBulkUntil( _ppItems, _maxCount, &deadline );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t SharedQueue< _T >::tryDequeueBulk (
+        _T ** _ppItems
+    ,   std::size_t _maxCount
+)
+{
+    if ( _maxCount == 0 )
+        return 0;
+
+    std::size_t dequeued;
+    Node * const pChain = tryUnlinkChain( _ppItems, _maxCount, dequeued );
+
+    if ( dequeued > 0 )
     {
-        std::lock_guard< std::mutex > tailLock( m_tailMutex );
-        m_notFullCond.notify_one();
+        releaseChain( pChain );
+        m_events.onDequeued();
     }
 
-    return pReturnVal;
+    return dequeued;
 }
 
 /*----------------------------------------------------------------------------*/
 
 template < typename _T >
-_T * SharedQueue< _T >::dequeue ( int _millisecondsTimeout )
+std::size_t SharedQueue< _T >::drainAll ( std::vector< _T * > & _rItems )
 {
-    using namespace std::chrono;
+    std::size_t drained;
+    Node * const pChain = detachAll( drained );
+    if ( drained == 0 )
+        return 0;
+
+    _rItems.reserve( _rItems.size() + drained );
+
+    Node * pNode = pChain;
+    for ( std::size_t i = 0; i < drained; ++i, pNode = pNode->next )
+        _rItems.push_back( pNode->data );
+
+    releaseChain( pChain );
+
+    m_events.onRoomMade();
+    return drained;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+void SharedQueue< _T >::clear ()
+{
+    std::size_t drained;
+    Node * const pChain = detachAll( drained );
+    if ( drained == 0 )
+        return;
+
+    releaseChain( pChain );
+
+    m_events.onRoomMade();
+}
+
+/*----------------------------------------------------------------------------*/
 
-    std::unique_ptr< Node > pOldHead;
-    _T* returnVal = nullptr;
+// std::scoped_lock takes the three mutexes without deadlocking against a
+// splice the other way round. The source chain already follows linkChain()'s
+// layout once its first item goes into the target's dummy tail, and its own
+// dummy tail becomes the target's.
+template < typename _T >
+std::size_t SharedQueue< _T >::spliceInto ( SharedQueue & _rTarget )
+{
+    assert( &_rTarget != this );
 
-    std::unique_lock< std::mutex > headLock( m_headMutex );
+    Node * const pNewDummy = m_rPool.acquire();
 
-    bool notEmpty = m_notEmptyCond.wait_for(
-        headLock, milliseconds( _millisecondsTimeout ),
-        [ this ] ()
+    // The node left over: the new dummy, or the first node of the chain
+    Node * pSpare = pNewDummy;
+    std::size_t moved = 0;
+    {
+        std::scoped_lock< StatsMutex, StatsMutex, StatsMutex > locks(
+                m_headMutex
+            ,   m_tailMutex
+            ,   _rTarget.m_tailMutex
+        );
+
+        Node * pLast = nullptr;
+        Node * const pChain = _rTarget.m_closed.load()
+            ?   nullptr
+            :   detachLocked( pNewDummy, pLast, moved )
+        ;
+
+        if ( pChain )
         {
-            return m_pHead.get() != getTail(); // queue not empty
+            _rTarget.m_pTail->data = pChain->data;
+            _rTarget.m_pTail->next = pChain->next;
+            _rTarget.m_pTail = pLast;
+            pSpare = pChain;
+
+            const std::size_t size = moved
+                +   _rTarget.m_currentQueueSizeLockable.fetch_add(
+                        moved, std::memory_order_release
+                    );
+            _rTarget.m_stats.onEnqueued( moved, [ size ] () { return size; } );
         }
+    }
+
+    m_rPool.release( pSpare );
+    if ( moved == 0 )
+        return 0;
+
+    m_events.onRoomMade();
+    _rTarget.m_events.onEnqueued();
+    return moved;
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Full, and not allowed to grow
+template < typename _T >
+bool SharedQueue< _T >::visiblyFull () const noexcept
+{
+    const std::size_t capacity = m_queueSize.load();
+    return m_currentQueueSizeLockable.load() >= capacity
+        && m_maxQueueSize.load() <= capacity
+    ;
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Must be called with m_tailMutex held. A producer whose items do not fit
+// grows the queue here when auto-growth allows: at least doubling the
+// capacity, so a steady overload costs only a logarithmic number of steps.
+template < typename _T >
+std::size_t SharedQueue< _T >::roomLocked ( std::size_t _wanted ) noexcept
+{
+    const std::size_t currentSize = m_currentQueueSizeLockable.load();
+    const std::size_t maxCapacity = m_maxQueueSize.load();
+    std::size_t capacity = m_queueSize.load();
+
+    if ( currentSize + _wanted > capacity && maxCapacity > capacity )
+    {
+        const std::size_t grownCapacity = std::min(
+                maxCapacity
+            ,   std::max( 2 * capacity, currentSize + _wanted )
+        );
+
+        m_queueSize.store( grownCapacity );
+        m_rPool.reserve( grownCapacity - capacity );
+        capacity = grownCapacity;
+    }
+
+    return currentSize < capacity ? capacity - currentSize : 0;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool SharedQueue< _T >::tryLink ( Node * _pNewTail, _T * _pNewValue )
+{
+    // Do not touch the mutex while the queue is visibly full
+    if ( visiblyFull() )
+        return false;
+
+    std::lock_guard< StatsMutex > tailLock( m_tailMutex );
+    if ( m_closed.load() || roomLocked( 1 ) == 0 )
+        return false;
+
+    linkAtTail( _pNewTail, _pNewValue );
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool SharedQueue< _T >::tryUnlink ( Node * & _pOldHead, _T * & _pValue )
+{
+    if ( m_currentQueueSizeLockable.load() == 0 )
+        return false;
+
+    std::lock_guard< StatsMutex > headLock( m_headMutex );
+    if ( m_currentQueueSizeLockable.load() == 0 )
+        return false;
+
+    _pOldHead = unlinkHead( _pValue );
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t SharedQueue< _T >::tryLinkChain (
+        _T ** _ppItems
+    ,   std::size_t _count
+    ,   Node * & _pChain
+    ,   Node * _pChainLast
+)
+{
+    if ( visiblyFull() )
+        return 0;
+
+    std::lock_guard< StatsMutex > tailLock( m_tailMutex );
+    if ( m_closed.load() )
+        return 0;
+
+    return linkChain( _ppItems, _count, _pChain, _pChainLast );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+typename SharedQueue< _T >::Node * SharedQueue< _T >::tryUnlinkChain (
+        _T ** _ppItems
+    ,   std::size_t _maxCount
+    ,   std::size_t & _unlinkedCount
+)
+{
+    _unlinkedCount = 0;
+    if ( m_currentQueueSizeLockable.load() == 0 )
+        return nullptr;
+
+    std::lock_guard< StatsMutex > headLock( m_headMutex );
+    return unlinkChain( _ppItems, _maxCount, _unlinkedCount );
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Must be called with m_tailMutex held. The size is bumped only once the
+// node is linked: that is what tells consumers it is there.
+template < typename _T >
+void SharedQueue< _T >::linkAtTail (
+        Node * _pNewTail
+    ,   _T * _pNewValue
+) noexcept
+{
+    m_pTail->data = _pNewValue;
+    m_pTail->next = _pNewTail;
+    m_pTail = _pNewTail;
+
+    const std::size_t size = 1
+        +   m_currentQueueSizeLockable.fetch_add(
+                1, std::memory_order_release
+            );
+    m_stats.onEnqueued( 1, [ size ] () { return size; } );
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Must be called with m_headMutex held on a non-empty queue
+template < typename _T >
+typename SharedQueue< _T >::Node * SharedQueue< _T >::unlinkHead (
+        _T * & _pValue
+) noexcept
+{
+    Node * const pOldHead = m_pHead;
+    m_pHead = pOldHead->next;
+    _pValue = pOldHead->data;
+
+    m_currentQueueSizeLockable.fetch_sub( 1, std::memory_order_release );
+    m_stats.onDequeued( 1 );
+    return pOldHead;
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Must be called with both mutexes held. Swaps the whole list for an empty
+// one made of _pNewDummy and returns the old list as a null-terminated chain
+// of _detachedCount item nodes followed by its dummy tail, _pLast; returns
+// nullptr and leaves _pNewDummy unused if the queue is empty.
+template < typename _T >
+typename SharedQueue< _T >::Node * SharedQueue< _T >::detachLocked (
+        Node * _pNewDummy
+    ,   Node * & _pLast
+    ,   std::size_t & _detachedCount
+) noexcept
+{
+    _detachedCount = m_currentQueueSizeLockable.load();
+    if ( _detachedCount == 0 )
+        return nullptr;
+
+    Node * const pChain = m_pHead;
+    _pLast = m_pTail;
+    m_pHead = _pNewDummy;
+    m_pTail = _pNewDummy;
+
+    m_currentQueueSizeLockable.fetch_sub(
+        _detachedCount, std::memory_order_release
     );
+    m_stats.onDequeued( _detachedCount );
+    return pChain;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+typename SharedQueue< _T >::Node * SharedQueue< _T >::detachAll (
+        std::size_t & _detachedCount
+)
+{
+    _detachedCount = 0;
+    if ( m_currentQueueSizeLockable.load() == 0 )
+        return nullptr;
+
+    Node * const pNewDummy = m_rPool.acquire();
 
-    if ( !notEmpty )
+    Node * pChain;
+    Node * pLast = nullptr;
     {
-        return nullptr; // timed out
+        std::scoped_lock< StatsMutex, StatsMutex > locks(
+            m_headMutex, m_tailMutex
+        );
+        pChain = detachLocked( pNewDummy, pLast, _detachedCount );
     }
 
-    --m_currentQueueSizeLockable;
+    if ( !pChain )
+        m_rPool.release( pNewDummy );
 
-    pOldHead = std::move( m_pHead );
-    m_pHead = std::move( pOldHead->next );
-    returnVal = pOldHead->data;
+    return pChain;
+}
 
-    // Notify "not full" after unlocking the head
+/*----------------------------------------------------------------------------*/
+
+// Node i of the chain carries item i + 1: item 0 goes into the current dummy
+// tail and the last node becomes the new dummy tail
+template < typename _T >
+typename SharedQueue< _T >::Node * SharedQueue< _T >::buildChain (
+        _T ** _ppItems
+    ,   std::size_t _count
+    ,   Node * & _pLast
+)
+{
+    Node * const pFirst = m_rPool.acquire();
+    _pLast = pFirst;
+
+    for ( std::size_t i = 1; i < _count; ++i )
     {
-        std::lock_guard< std::mutex > tailLock( m_tailMutex );
-        m_notFullCond.notify_one();
+        _pLast->data = _ppItems[ i ];
+        _pLast->next = m_rPool.acquire();
+        _pLast = _pLast->next;
     }
 
-    return returnVal;
+    return pFirst;
 }
 
 /*----------------------------------------------------------------------------*/
 
+// Must be called with m_tailMutex held. Links as many items as there is room
+// for and leaves the unused part of the chain in _pChain; since node i always
+// carries item i + 1, that remainder is ready to be linked later as is.
 template < typename _T >
-typename SharedQueue< _T >::Node * SharedQueue< _T >::getTail ()
+std::size_t SharedQueue< _T >::linkChain (
+        _T ** _ppItems
+    ,   std::size_t _count
+    ,   Node * & _pChain
+    ,   Node * _pChainLast
+) noexcept
 {
-    std::lock_guard< std::mutex > tailLock( m_tailMutex );
-    return m_pTail;
+    const std::size_t room = roomLocked( _count );
+    if ( room == 0 )
+        return 0;
+
+    const std::size_t linked = std::min( _count, room );
+
+    Node * pLast = _pChainLast;
+    if ( linked < _count )
+    {
+        pLast = _pChain;
+        for ( std::size_t i = 1; i < linked; ++i )
+            pLast = pLast->next;
+    }
+
+    Node * const pRest = pLast->next;
+    pLast->next = nullptr;
+
+    m_pTail->data = _ppItems[ 0 ];
+    m_pTail->next = _pChain;
+    m_pTail = pLast;
+
+    _pChain = pRest;
+
+    const std::size_t size = linked
+        +   m_currentQueueSizeLockable.fetch_add(
+                linked, std::memory_order_release
+            );
+    m_stats.onEnqueued( linked, [ size ] () { return size; } );
+    return linked;
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Must be called with m_headMutex held. Takes only the items the size says
+// are fully linked and returns their nodes as a null-terminated chain.
+template < typename _T >
+typename SharedQueue< _T >::Node * SharedQueue< _T >::unlinkChain (
+        _T ** _ppItems
+    ,   std::size_t _maxCount
+    ,   std::size_t & _unlinkedCount
+) noexcept
+{
+    _unlinkedCount = std::min(
+            _maxCount
+        ,   m_currentQueueSizeLockable.load( std::memory_order_acquire )
+    );
+    if ( _unlinkedCount == 0 )
+        return nullptr;
+
+    Node * const pFirst = m_pHead;
+    Node * pLast = nullptr;
+
+    for ( std::size_t i = 0; i < _unlinkedCount; ++i )
+    {
+        _ppItems[ i ] = m_pHead->data;
+        pLast = m_pHead;
+        m_pHead = m_pHead->next;
+    }
+    pLast->next = nullptr;
+
+    m_currentQueueSizeLockable.fetch_sub(
+        _unlinkedCount, std::memory_order_release
+    );
+    m_stats.onDequeued( _unlinkedCount );
+
+    return pFirst;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+void SharedQueue< _T >::releaseChain ( Node * _pChain ) noexcept
+{
+    while ( _pChain )
+    {
+        Node * pNext = _pChain->next;
+        m_rPool.release( _pChain );
+        _pChain = pNext;
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t SharedQueue< _T >::enqueueBulkUntil (
+        _T ** _ppItems
+    ,   std::size_t _count
+    ,   const TimePoint * _pDeadline
+)
+{
+    if ( _count == 0 )
+        return 0;
+
+    Node * pChainLast;
+    Node * pChain = buildChain( _ppItems, _count, pChainLast );
+
+    std::size_t enqueued = 0;
+    while ( enqueued < _count )
+    {
+        std::size_t linked = 0;
+        m_events.awaitRoom(
+                [ & ] () {
+                    linked = tryLinkChain(
+                            _ppItems + enqueued
+                        ,   _count - enqueued
+                        ,   pChain
+                        ,   pChainLast
+                    );
+                    return linked > 0;
+                }
+            ,   _pDeadline
+        );
+
+        if ( linked == 0 )
+            break; // timed out or closed
+
+        enqueued += linked;
+
+        // One wakeup per linked batch
+        m_events.onEnqueued();
+    }
+
+    releaseChain( pChain );
+
+    return enqueued;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t SharedQueue< _T >::dequeueBulkUntil (
+        _T ** _ppItems
+    ,   std::size_t _maxCount
+    ,   const TimePoint * _pDeadline
+)
+{
+    if ( _maxCount == 0 )
+        return 0;
+
+    std::size_t dequeued = 0;
+    Node * pChain = nullptr;
+    m_events.awaitItems(
+            [ & ] () {
+                pChain = tryUnlinkChain( _ppItems, _maxCount, dequeued );
+                return dequeued > 0;
+            }
+        ,   _pDeadline
+    );
+
+    if ( dequeued == 0 )
+        return 0; // timed out, or closed and drained
+
+    releaseChain( pChain );
+
+    // One wakeup for the whole batch
+    m_events.onDequeued();
+
+    return dequeued;
 }
 
 /*----------------------------------------------------------------------------*/
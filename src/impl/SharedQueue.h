@@ -4,10 +4,16 @@
 /*----------------------------------------------------------------------------*/
 
 #include "IQueue.h"
+#include "impl/NodePool.h"
+#include "impl/QueueEvents.h"
+#include "impl/SpinWait.h"
+#include "impl/StatsCounters.h"
 
-#include <condition_variable>
+#include <atomic>
+#include <chrono>
 #include <memory>
 #include <mutex>
+#include <vector>
 
 /*----------------------------------------------------------------------------*/
 
@@ -17,39 +23,180 @@ class SharedQueue
 {
 public:
 
-    explicit SharedQueue ( std::size_t _size );
+    explicit SharedQueue (
+            std::size_t _size
+        ,   WaitStrategy _waitStrategy = WaitStrategy::Block
+    );
 
     ~SharedQueue ();
 
     int count () const noexcept override;
 
+    std::size_t capacity () const noexcept override;
+
+    bool setCapacity ( std::size_t _capacity ) override;
+
+    bool setAutoGrow ( std::size_t _maxCapacity ) override;
+
+    QueueStats stats () const override;
+
+    void close () override;
+
+    bool isClosed () const noexcept override;
+
     void enqueue ( _T * _pNewValue ) override;
 
     bool enqueue ( _T * _pNewValue, int _millisecondsTimeout ) override;
 
+    bool tryEnqueue ( _T * _pNewValue ) override;
+
     _T * dequeue () override;
 
     _T * dequeue ( int _millisecondsTimeout ) override;
 
+    _T * tryDequeue () override;
+
+    void enqueueBulk ( _T ** _ppItems, std::size_t _count ) override;
+
+    std::size_t enqueueBulk (
+            _T ** _ppItems
+        ,   std::size_t _count
+        ,   int _millisecondsTimeout
+    ) override;
+
+    std::size_t tryEnqueueBulk (
+            _T ** _ppItems
+        ,   std::size_t _count
+    ) override;
+
+    std::size_t dequeueBulk (
+            _T ** _ppItems
+        ,   std::size_t _maxCount
+    ) override;
+
+    std::size_t dequeueBulk (
+            _T ** _ppItems
+        ,   std::size_t _maxCount
+        ,   int _millisecondsTimeout
+    ) override;
+
+    std::size_t tryDequeueBulk (
+            _T ** _ppItems
+        ,   std::size_t _maxCount
+    ) override;
+
+    /**
+     * @brief Detaches the whole list in O(1) under the locks; the items are
+     *        then copied out and the nodes released outside them.
+     */
+    std::size_t drainAll ( std::vector< _T * > & _rItems ) override;
+
+    void clear () override;
+
+    /**
+     * @brief Moves every item queued right now to the tail of _rTarget in
+     *        O(1), keeping their order. _rTarget may end up above its
+     *        capacity, as after shrinking it: its producers then block
+     *        until consumers get under the bound.
+     * @return The number of items moved; 0 if _rTarget is closed.
+     */
+    std::size_t spliceInto ( SharedQueue & _rTarget );
+
 private:
 
     struct Node;
 
-    Node * getTail ();
+    using Pool = NodePool< Node >;
+    using TimePoint = EventCount::Clock::time_point;
+
+    bool visiblyFull () const noexcept;
+
+    std::size_t roomLocked ( std::size_t _wanted ) noexcept;
+
+    bool tryLink ( Node * _pNewTail, _T * _pNewValue );
+
+    bool tryUnlink ( Node * & _pOldHead, _T * & _pValue );
+
+    std::size_t tryLinkChain (
+            _T ** _ppItems
+        ,   std::size_t _count
+        ,   Node * & _pChain
+        ,   Node * _pChainLast
+    );
+
+    Node * tryUnlinkChain (
+            _T ** _ppItems
+        ,   std::size_t _maxCount
+        ,   std::size_t & _unlinkedCount
+    );
+
+    void linkAtTail ( Node * _pNewTail, _T * _pNewValue ) noexcept;
+
+    Node * unlinkHead ( _T * & _pValue ) noexcept;
+
+    Node * detachLocked (
+            Node * _pNewDummy
+        ,   Node * & _pLast
+        ,   std::size_t & _detachedCount
+    ) noexcept;
+
+    Node * detachAll ( std::size_t & _detachedCount );
+
+    Node * buildChain (
+            _T ** _ppItems
+        ,   std::size_t _count
+        ,   Node * & _pLast
+    );
+
+    std::size_t linkChain (
+            _T ** _ppItems
+        ,   std::size_t _count
+        ,   Node * & _pChain
+        ,   Node * _pChainLast
+    ) noexcept;
+
+    Node * unlinkChain (
+            _T ** _ppItems
+        ,   std::size_t _maxCount
+        ,   std::size_t & _unlinkedCount
+    ) noexcept;
+
+    void releaseChain ( Node * _pChain ) noexcept;
+
+    std::size_t enqueueBulkUntil (
+            _T ** _ppItems
+        ,   std::size_t _count
+        ,   const TimePoint * _pDeadline
+    );
+
+    std::size_t dequeueBulkUntil (
+            _T ** _ppItems
+        ,   std::size_t _maxCount
+        ,   const TimePoint * _pDeadline
+    );
 
 private:
 
-    mutable std::mutex m_headMutex;
-    mutable std::mutex m_tailMutex;
+    Pool & m_rPool;
+
+    mutable StatsMutex m_headMutex;
+    mutable StatsMutex m_tailMutex;
 
-    std::condition_variable m_notEmptyCond;
-    std::condition_variable m_notFullCond;
+    QueueEvents< _T > m_events;
 
-    std::unique_ptr< Node > m_pHead;
+    Node * m_pHead;
     Node * m_pTail;
 
     mutable std::atomic< std::size_t > m_currentQueueSizeLockable;
-    const std::size_t m_queueSize;
+
+    // Both are written only under m_tailMutex; 0 turns auto-growth off
+    std::atomic< std::size_t > m_queueSize;
+    std::atomic< std::size_t > m_maxQueueSize;
+
+    // Written only under m_tailMutex, so no item is linked after it is set
+    std::atomic< bool > m_closed;
+
+    [[no_unique_address]] StatsCounters m_stats;
 };
 
 /*----------------------------------------------------------------------------*/
@@ -6,40 +6,40 @@
 #include "IQueue.h"
 #include "QueueImpl.h"
 
-#include <condition_variable>
+#include <algorithm>
+#include <chrono>
 #include <memory>
-#include <mutex>
-
-/*----------------------------------------------------------------------------*/
-
-template < typename _DataT >
-struct Data : IData
-{
-    explicit Data ( _DataT * _pValue )
-        :   m_pValue( _pValue )
-    {}
-
-    void* get() override {
-        return static_cast<void*>(m_pValue);  // Return as void*
-    }
-
-    _DataT * m_pValue;
-};
+#include <vector>
 
 /*----------------------------------------------------------------------------*/
 
+/**
+ * @class SharedQueuePImpl
+ *
+ * @brief Thin typed front end over the type-erased SharedQueueImpl.
+ *
+ * Item pointers are handed over as void * and cast back on the way out, so
+ * the wrapper adds no allocation to SharedQueue< T >. A T ** array may not
+ * be accessed as a void ** one, so bulk calls copy the items through a local
+ * buffer, a chunk at a time.
+ */
 template < typename _T >
 class SharedQueuePImpl
     :   public IQueue < _T >
 {
 private:
 
+    static constexpr std::size_t s_chunkSize = 64;
+
     std::unique_ptr< SharedQueueImpl > pImpl;
 
 public:
 
-    explicit SharedQueuePImpl ( std::size_t _size )
-        :   pImpl( std::make_unique< SharedQueueImpl >( _size ) )
+    explicit SharedQueuePImpl (
+            std::size_t _size
+        ,   WaitStrategy _waitStrategy = WaitStrategy::Block
+    )
+        :   pImpl( std::make_unique< SharedQueueImpl >( _size, _waitStrategy ) )
     {
     }
 
@@ -50,32 +50,246 @@ public:
         return pImpl->count();
     }
 
+    std::size_t capacity () const noexcept override
+    {
+        return pImpl->capacity();
+    }
+
+    bool setCapacity ( std::size_t _capacity ) override
+    {
+        return pImpl->setCapacity( _capacity );
+    }
+
+    bool setAutoGrow ( std::size_t _maxCapacity ) override
+    {
+        return pImpl->setAutoGrow( _maxCapacity );
+    }
+
+    QueueStats stats () const override
+    {
+        return pImpl->stats();
+    }
+
+    void close () override
+    {
+        pImpl->close();
+    }
+
+    bool isClosed () const noexcept override
+    {
+        return pImpl->isClosed();
+    }
+
     void enqueue ( _T * _pNewValue ) override
     {
-        pImpl->enqueue( new Data< _T >( _pNewValue ) );
+        pImpl->enqueue( _pNewValue );
     }
 
     bool enqueue ( _T * _pNewValue, int _millisecondsTimeout ) override
     {
-        return pImpl->enqueue(
-            new Data< _T >( _pNewValue ), _millisecondsTimeout
-        );
+        return pImpl->enqueue( _pNewValue, _millisecondsTimeout );
+    }
+
+    bool tryEnqueue ( _T * _pNewValue ) override
+    {
+        return pImpl->tryEnqueue( _pNewValue );
     }
 
     _T * dequeue () override
     {
-        auto * pData = pImpl->dequeue();
-        auto * pElem = reinterpret_cast< _T * >( pData->get() );
-        delete pData;
-        return pElem;
+        return static_cast< _T * >( pImpl->dequeue() );
     }
 
     _T * dequeue ( int _millisecondsTimeout ) override
     {
-        auto * pData = pImpl->dequeue( _millisecondsTimeout );
-        auto * pElem = reinterpret_cast< _T * >( pData->get() );
-        delete pData;
-        return pElem;
+        // nullptr on timeout goes through the cast unchanged
+        return static_cast< _T * >( pImpl->dequeue( _millisecondsTimeout ) );
+    }
+
+    _T * tryDequeue () override
+    {
+        return static_cast< _T * >( pImpl->tryDequeue() );
+    }
+
+    void enqueueBulk ( _T ** _ppItems, std::size_t _count ) override
+    {
+        putInChunks(
+                _ppItems
+            ,   _count
+            ,   [ this ] ( void ** _ppChunk, std::size_t _n ) {
+                    pImpl->enqueueBulk( _ppChunk, _n );
+                    return _n;
+                }
+        );
+    }
+
+    std::size_t enqueueBulk (
+            _T ** _ppItems
+        ,   std::size_t _count
+        ,   int _millisecondsTimeout
+    ) override
+    {
+        const auto deadline = std::chrono::steady_clock::now()
+            + std::chrono::milliseconds( _millisecondsTimeout );
+
+        return putInChunks(
+                _ppItems
+            ,   _count
+            ,   [ this, &deadline ] ( void ** _ppChunk, std::size_t _n ) {
+                    const int left = millisecondsLeft( deadline );
+                    return left > 0
+                        ?   pImpl->enqueueBulk( _ppChunk, _n, left )
+                        :   pImpl->tryEnqueueBulk( _ppChunk, _n );
+                }
+        );
+    }
+
+    std::size_t tryEnqueueBulk (
+            _T ** _ppItems
+        ,   std::size_t _count
+    ) override
+    {
+        return putInChunks(
+                _ppItems
+            ,   _count
+            ,   [ this ] ( void ** _ppChunk, std::size_t _n ) {
+                    return pImpl->tryEnqueueBulk( _ppChunk, _n );
+                }
+        );
+    }
+
+    std::size_t dequeueBulk (
+            _T ** _ppItems
+        ,   std::size_t _maxCount
+    ) override
+    {
+        return takeInChunks(
+                _ppItems
+            ,   _maxCount
+            ,   [ this ] ( void ** _ppChunk, std::size_t _n ) {
+                    return pImpl->dequeueBulk( _ppChunk, _n );
+                }
+        );
+    }
+
+    std::size_t dequeueBulk (
+            _T ** _ppItems
+        ,   std::size_t _maxCount
+        ,   int _millisecondsTimeout
+    ) override
+    {
+        return takeInChunks(
+                _ppItems
+            ,   _maxCount
+            ,   [ this, _millisecondsTimeout ] (
+                        void ** _ppChunk
+                    ,   std::size_t _n
+                ) {
+                    return pImpl->dequeueBulk(
+                        _ppChunk, _n, _millisecondsTimeout
+                    );
+                }
+        );
+    }
+
+    std::size_t tryDequeueBulk (
+            _T ** _ppItems
+        ,   std::size_t _maxCount
+    ) override
+    {
+        return takeInChunks(
+                _ppItems
+            ,   _maxCount
+            ,   [ this ] ( void ** _ppChunk, std::size_t _n ) {
+                    return pImpl->tryDequeueBulk( _ppChunk, _n );
+                }
+        );
+    }
+
+    // The items cross the firewall in a vector of void *, cast one by one
+    std::size_t drainAll ( std::vector< _T * > & _rItems ) override
+    {
+        std::vector< void * > items;
+        const std::size_t drained = pImpl->drainAll( items );
+
+        _rItems.reserve( _rItems.size() + drained );
+        for ( void * pItem: items )
+            _rItems.push_back( static_cast< _T * >( pItem ) );
+
+        return drained;
+    }
+
+    void clear () override
+    {
+        pImpl->clear();
+    }
+
+private:
+
+    // Hands the items over a chunk at a time; stops at the first chunk that
+    // does not fit in full, as the rest could not have either
+    template < typename _PutChunkT >
+    static std::size_t putInChunks (
+            _T ** _ppItems
+        ,   std::size_t _count
+        ,   _PutChunkT _putChunk
+    )
+    {
+        void * chunk[ s_chunkSize ];
+        std::size_t put = 0;
+
+        while ( put < _count )
+        {
+            const std::size_t n = std::min( s_chunkSize, _count - put );
+            std::copy( _ppItems + put, _ppItems + put + n, chunk );
+
+            const std::size_t chunkPut = _putChunk( chunk, n );
+            put += chunkPut;
+            if ( chunkPut < n )
+                break;
+        }
+
+        return put;
+    }
+
+    // Only the first chunk may wait; the rest takes what is already there
+    template < typename _TakeFirstT >
+    std::size_t takeInChunks (
+            _T ** _ppItems
+        ,   std::size_t _maxCount
+        ,   _TakeFirstT _takeFirst
+    )
+    {
+        void * chunk[ s_chunkSize ];
+        std::size_t taken = 0;
+
+        while ( taken < _maxCount )
+        {
+            const std::size_t n = std::min( s_chunkSize, _maxCount - taken );
+            const std::size_t chunkTaken = taken == 0
+                ?   _takeFirst( chunk, n )
+                :   pImpl->tryDequeueBulk( chunk, n );
+
+            for ( std::size_t i = 0; i < chunkTaken; ++i )
+                _ppItems[ taken + i ] = static_cast< _T * >( chunk[ i ] );
+
+            taken += chunkTaken;
+            if ( chunkTaken < n )
+                break;
+        }
+
+        return taken;
+    }
+
+    static int millisecondsLeft (
+        const std::chrono::steady_clock::time_point & _deadline
+    )
+    {
+        using namespace std::chrono;
+
+        return static_cast< int >(
+            ceil< milliseconds >( _deadline - steady_clock::now() ).count()
+        );
     }
 };
 
@@ -0,0 +1,432 @@
+#include "impl/ShmQueue.h"
+
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+/*----------------------------------------------------------------------------*/
+
+// Lives at the start of the segment; every field keeps its offset for a
+// given s_version
+template < typename _T >
+struct ShmQueue< _T >::Header
+{
+    static constexpr std::uint64_t s_magic = 0x4555455551534853; // "SHSQUEUE"
+
+    explicit Header ( std::size_t _size )
+        :   magic( s_magic )
+        ,   version( s_version )
+        ,   ready( 0 )
+        ,   capacity( _size )
+        ,   payloadSize( sizeof( _T ) )
+        ,   payloadAlignment( alignof( _T ) )
+        ,   cellSize( sizeof( Cell ) )
+        ,   enqueuePos( 0 )
+        ,   dequeuePos( 0 )
+        ,   notEmptyEvent( EventCount::ProcessShared{} )
+        ,   notFullEvent( EventCount::ProcessShared{} )
+    {
+    }
+
+    const std::uint64_t magic;
+    const std::uint32_t version;
+
+    // Set once the creator has laid out every slot
+    std::atomic< std::uint32_t > ready;
+
+    const std::uint64_t capacity;
+    const std::uint64_t payloadSize;
+    const std::uint64_t payloadAlignment;
+    const std::uint64_t cellSize;
+
+    alignas( 64 ) std::atomic< std::uint64_t > enqueuePos;
+    alignas( 64 ) std::atomic< std::uint64_t > dequeuePos;
+
+    alignas( 64 ) EventCount notEmptyEvent;
+    EventCount notFullEvent;
+};
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+struct ShmQueue< _T >::Cell
+{
+    // Same stride-two stamps as ValueQueue
+    static constexpr std::uint64_t freeFor ( std::uint64_t _pos ) noexcept
+    {
+        return 2 * _pos;
+    }
+
+    static constexpr std::uint64_t publishedFor ( std::uint64_t _pos ) noexcept
+    {
+        return 2 * _pos + 1;
+    }
+
+    std::atomic< std::uint64_t > sequence;
+    alignas( _T ) unsigned char storage[ sizeof( _T ) ];
+};
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+ShmQueue< _T >::ShmQueue (
+        const std::string & _name
+    ,   std::size_t _size
+    ,   WaitStrategy _waitStrategy
+)
+    :   m_segment( _name, segmentSize( _size ) )
+    ,   m_pHeader( nullptr )
+    ,   m_pCells( nullptr )
+    ,   m_queueSize( _size )
+    ,   m_waitStrategy( _waitStrategy )
+{
+    static_assert(
+            std::atomic< std::uint64_t >::is_always_lock_free
+        &&  std::atomic< std::uint32_t >::is_always_lock_free
+        ,   "the segment needs address-free atomics"
+    );
+    static_assert( alignof( Cell ) <= alignof( Header ) );
+
+    assert( _size > 0 );
+
+    void * const pAddress = m_segment.address();
+    m_pHeader = new ( pAddress ) Header( _size );
+    m_pCells = reinterpret_cast< Cell * >(
+        static_cast< unsigned char * >( pAddress ) + sizeof( Header )
+    );
+
+    for ( std::size_t i = 0; i < m_queueSize; ++i )
+    {
+        Cell * const pCell = new ( &m_pCells[ i ] ) Cell;
+        pCell->sequence.store( Cell::freeFor( i ), std::memory_order_relaxed );
+    }
+
+    m_pHeader->ready.store( 1, std::memory_order_release );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+ShmQueue< _T >::ShmQueue (
+        const std::string & _name
+    ,   WaitStrategy _waitStrategy
+)
+    :   m_segment( _name )
+    ,   m_pHeader( nullptr )
+    ,   m_pCells( nullptr )
+    ,   m_queueSize( 0 )
+    ,   m_waitStrategy( _waitStrategy )
+{
+    attach();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t ShmQueue< _T >::capacity () const noexcept
+{
+    return m_queueSize;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+int ShmQueue< _T >::count () const noexcept
+{
+    const std::uint64_t dequeuePos =
+        m_pHeader->dequeuePos.load( std::memory_order_acquire );
+    const std::uint64_t enqueuePos =
+        m_pHeader->enqueuePos.load( std::memory_order_acquire );
+
+    const std::uint64_t size = enqueuePos - dequeuePos;
+    return static_cast< int >( size < m_queueSize ? size : m_queueSize );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+void ShmQueue< _T >::enqueue ( const _T & _value )
+{
+    enqueueUntil( _value, nullptr );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool ShmQueue< _T >::enqueue ( const _T & _value, int _millisecondsTimeout )
+{
+    const TimePoint deadline =
+            EventCount::Clock::now()
+        +   std::chrono::milliseconds( _millisecondsTimeout )
+    ;
+    return enqueueUntil( _value, &deadline );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+_T ShmQueue< _T >::dequeue ()
+{
+    return *dequeueUntil( nullptr );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::optional< _T > ShmQueue< _T >::dequeue ( int _millisecondsTimeout )
+{
+    const TimePoint deadline =
+            EventCount::Clock::now()
+        +   std::chrono::milliseconds( _millisecondsTimeout )
+    ;
+    return dequeueUntil( &deadline );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool ShmQueue< _T >::tryEnqueue ( const _T & _value )
+{
+    std::uint64_t pos;
+    Cell * const pCell = tryClaimForPush( pos );
+    if ( !pCell )
+        return false;
+
+    publish( pCell, pos, _value );
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::optional< _T > ShmQueue< _T >::tryDequeue ()
+{
+    std::uint64_t pos;
+    Cell * const pCell = tryClaimForPop( pos );
+    if ( !pCell )
+        return std::nullopt;
+
+    return takeAndRelease( pCell, pos );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool ShmQueue< _T >::enqueueUntil (
+        const _T & _value
+    ,   const TimePoint * _pDeadline
+)
+{
+    Cell * pCell = nullptr;
+    std::uint64_t pos;
+
+    const bool claimed = waitFor(
+            m_pHeader->notFullEvent
+        ,   [ this, &pCell, &pos ] () {
+                return ( pCell = tryClaimForPush( pos ) ) != nullptr;
+            }
+        ,   _pDeadline
+    );
+
+    if ( !claimed )
+        return false; // timed out
+
+    publish( pCell, pos, _value );
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::optional< _T > ShmQueue< _T >::dequeueUntil (
+        const TimePoint * _pDeadline
+)
+{
+    Cell * pCell = nullptr;
+    std::uint64_t pos;
+
+    const bool claimed = waitFor(
+            m_pHeader->notEmptyEvent
+        ,   [ this, &pCell, &pos ] () {
+                return ( pCell = tryClaimForPop( pos ) ) != nullptr;
+            }
+        ,   _pDeadline
+    );
+
+    if ( !claimed )
+        return std::nullopt; // timed out
+
+    return takeAndRelease( pCell, pos );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+typename ShmQueue< _T >::Cell * ShmQueue< _T >::tryClaimForPush (
+        std::uint64_t & _pos
+) noexcept
+{
+    std::atomic< std::uint64_t > & rEnqueuePos = m_pHeader->enqueuePos;
+    _pos = rEnqueuePos.load( std::memory_order_relaxed );
+
+    for ( ;; )
+    {
+        Cell * const pCell = &m_pCells[ _pos % m_queueSize ];
+        const std::int64_t diff =
+            static_cast< std::int64_t >(
+                pCell->sequence.load( std::memory_order_acquire )
+            )
+        -   static_cast< std::int64_t >( Cell::freeFor( _pos ) );
+
+        if ( diff == 0 )
+        {
+            if ( rEnqueuePos.compare_exchange_weak(
+                    _pos, _pos + 1, std::memory_order_relaxed
+            ) )
+                return pCell;
+        }
+        else if ( diff < 0 )
+        {
+            return nullptr; // full
+        }
+        else
+        {
+            _pos = rEnqueuePos.load( std::memory_order_relaxed );
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+typename ShmQueue< _T >::Cell * ShmQueue< _T >::tryClaimForPop (
+        std::uint64_t & _pos
+) noexcept
+{
+    std::atomic< std::uint64_t > & rDequeuePos = m_pHeader->dequeuePos;
+    _pos = rDequeuePos.load( std::memory_order_relaxed );
+
+    for ( ;; )
+    {
+        Cell * const pCell = &m_pCells[ _pos % m_queueSize ];
+        const std::int64_t diff =
+            static_cast< std::int64_t >(
+                pCell->sequence.load( std::memory_order_acquire )
+            )
+        -   static_cast< std::int64_t >( Cell::publishedFor( _pos ) );
+
+        if ( diff == 0 )
+        {
+            if ( rDequeuePos.compare_exchange_weak(
+                    _pos, _pos + 1, std::memory_order_relaxed
+            ) )
+                return pCell;
+        }
+        else if ( diff < 0 )
+        {
+            return nullptr; // empty
+        }
+        else
+        {
+            _pos = rDequeuePos.load( std::memory_order_relaxed );
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+void ShmQueue< _T >::publish (
+        Cell * _pCell
+    ,   std::uint64_t _pos
+    ,   const _T & _value
+)
+{
+    std::memcpy( _pCell->storage, &_value, sizeof( _T ) );
+    _pCell->sequence.store(
+        Cell::publishedFor( _pos ), std::memory_order_release
+    );
+
+    // Another process may wait with a strategy that parks, whatever ours is
+    m_pHeader->notEmptyEvent.notifyOne();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+_T ShmQueue< _T >::takeAndRelease ( Cell * _pCell, std::uint64_t _pos )
+{
+    _T value;
+    std::memcpy( &value, _pCell->storage, sizeof( _T ) );
+
+    _pCell->sequence.store(
+        Cell::freeFor( _pos + m_queueSize ), std::memory_order_release
+    );
+
+    m_pHeader->notFullEvent.notifyOne();
+    return value;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t ShmQueue< _T >::segmentSize ( std::size_t _size ) noexcept
+{
+    return sizeof( Header ) + _size * sizeof( Cell );
+}
+
+/*----------------------------------------------------------------------------*/
+
+// The creator may be another build of this code: check everything the slot
+// layout depends on before trusting the segment
+template < typename _T >
+void ShmQueue< _T >::attach ()
+{
+    if ( m_segment.size() < sizeof( Header ) )
+        throw std::runtime_error( "ShmQueue: segment too small" );
+
+    Header * const pHeader = static_cast< Header * >( m_segment.address() );
+
+    if ( pHeader->magic != Header::s_magic )
+        throw std::runtime_error( "ShmQueue: not a queue segment" );
+    if ( pHeader->version != s_version )
+        throw std::runtime_error( "ShmQueue: layout version mismatch" );
+    if ( pHeader->ready.load( std::memory_order_acquire ) != 1 )
+        throw std::runtime_error( "ShmQueue: not initialised yet" );
+
+    if (
+            pHeader->payloadSize != sizeof( _T )
+        ||  pHeader->payloadAlignment != alignof( _T )
+        ||  pHeader->cellSize != sizeof( Cell )
+    )
+        throw std::runtime_error( "ShmQueue: payload type mismatch" );
+
+    if (
+            pHeader->capacity == 0
+        ||  m_segment.size() < segmentSize( pHeader->capacity )
+    )
+        throw std::runtime_error( "ShmQueue: segment too small" );
+
+    m_pHeader = pHeader;
+    m_pCells = reinterpret_cast< Cell * >(
+        static_cast< unsigned char * >( m_segment.address() ) + sizeof( Header )
+    );
+    m_queueSize = pHeader->capacity;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+template < typename _TryOpT >
+bool ShmQueue< _T >::waitFor (
+        EventCount & _rEvent
+    ,   _TryOpT _tryOp
+    ,   const TimePoint * _pDeadline
+)
+{
+    return SpinWait::await( _rEvent, m_waitStrategy, _tryOp, _pDeadline );
+}
+
+/*----------------------------------------------------------------------------*/
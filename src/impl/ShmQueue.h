@@ -0,0 +1,144 @@
+#ifndef __SHAREDQUEUE_SRC_IMPL_SHMQUEUE_H__
+#define __SHAREDQUEUE_SRC_IMPL_SHMQUEUE_H__
+
+/*----------------------------------------------------------------------------*/
+
+#include "impl/EventCount.h"
+#include "impl/ShmSegment.h"
+#include "impl/SpinWait.h"
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <type_traits>
+
+/*----------------------------------------------------------------------------*/
+
+/**
+ * @class ShmQueue
+ *
+ * @brief Bounded multi-producer/multi-consumer queue of T living in a named
+ *        POSIX shared memory segment, for passing messages between
+ *        processes on the same host without a syscall per message.
+ *
+ * The segment starts with a versioned header (magic, layout version, the
+ * payload size and alignment, the capacity), followed by fixed-size slots
+ * that hold T inline, stamped with sequences like ValueQueue's. Waiting goes
+ * through process-shared futexes, so a notification costs nothing while
+ * nobody sleeps. Each process picks its own WaitStrategy; notifications are
+ * sent whichever it picked, since a peer may be asleep.
+ *
+ * One process creates the queue by name (the name must be free) and owns it:
+ * the name is unlinked when that object is destroyed. Others attach to the
+ * name once the creator is constructed; attaching checks the header against
+ * this build's layout and T.
+ *
+ * T is copied as raw bytes, so it must be trivially copyable (and default
+ * constructible) and must not hold pointers into a process's own memory:
+ * carry offsets or inline data.
+ *
+ * Please note: a process that dies between claiming a slot and filling (or
+ * emptying) it stalls the queue at that slot.
+ */
+template < typename _T >
+class ShmQueue
+{
+    static_assert(
+            std::is_trivially_copyable< _T >::value
+        &&  std::is_default_constructible< _T >::value
+        ,   "ShmQueue copies T as raw bytes between processes"
+    );
+
+public:
+
+    // Bump whenever the segment layout changes
+    static constexpr std::uint32_t s_version = 1;
+
+    /**
+     * @brief Creates the segment _name holding up to _size items.
+     * @throw std::system_error if the name exists or cannot be created.
+     */
+    ShmQueue (
+            const std::string & _name
+        ,   std::size_t _size
+        ,   WaitStrategy _waitStrategy = WaitStrategy::Block
+    );
+
+    /**
+     * @brief Attaches to the segment another ShmQueue created.
+     * @throw std::system_error if it cannot be opened, std::runtime_error if
+     *        its header does not match.
+     */
+    explicit ShmQueue (
+            const std::string & _name
+        ,   WaitStrategy _waitStrategy = WaitStrategy::Block
+    );
+
+    ShmQueue ( const ShmQueue & ) = delete;
+    ShmQueue & operator = ( const ShmQueue & ) = delete;
+
+    std::size_t capacity () const noexcept;
+
+    int count () const noexcept;
+
+    void enqueue ( const _T & _value );
+
+    bool enqueue ( const _T & _value, int _millisecondsTimeout );
+
+    _T dequeue ();
+
+    std::optional< _T > dequeue ( int _millisecondsTimeout );
+
+    bool tryEnqueue ( const _T & _value );
+
+    std::optional< _T > tryDequeue ();
+
+private:
+
+    struct Header;
+    struct Cell;
+
+    using TimePoint = EventCount::Clock::time_point;
+
+    bool enqueueUntil ( const _T & _value, const TimePoint * _pDeadline );
+
+    std::optional< _T > dequeueUntil ( const TimePoint * _pDeadline );
+
+    Cell * tryClaimForPush ( std::uint64_t & _pos ) noexcept;
+
+    Cell * tryClaimForPop ( std::uint64_t & _pos ) noexcept;
+
+    void publish ( Cell * _pCell, std::uint64_t _pos, const _T & _value );
+
+    _T takeAndRelease ( Cell * _pCell, std::uint64_t _pos );
+
+    static std::size_t segmentSize ( std::size_t _size ) noexcept;
+
+    void attach ();
+
+    template < typename _TryOpT >
+    bool waitFor (
+            EventCount & _rEvent
+        ,   _TryOpT _tryOp
+        ,   const TimePoint * _pDeadline
+    );
+
+private:
+
+    ShmSegment m_segment;
+
+    Header * m_pHeader;
+    Cell * m_pCells;
+    std::size_t m_queueSize;
+
+    const WaitStrategy m_waitStrategy;
+};
+
+/*----------------------------------------------------------------------------*/
+
+#include "impl/ShmQueue.cpp"
+
+/*----------------------------------------------------------------------------*/
+
+#endif // __SHAREDQUEUE_SRC_IMPL_SHMQUEUE_H__
@@ -0,0 +1,132 @@
+#include "impl/ShmSegment.h"
+
+#include <cerrno>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*----------------------------------------------------------------------------*/
+
+namespace
+{
+
+[[noreturn]] void throwLastError ( const std::string & _what )
+{
+    throw std::system_error( errno, std::system_category(), _what );
+}
+
+} // namespace
+
+/*----------------------------------------------------------------------------*/
+
+ShmSegment::ShmSegment ( const std::string & _name, std::size_t _size )
+    :   m_name( _name )
+    ,   m_owner( true )
+    ,   m_pAddress( nullptr )
+    ,   m_size( 0 )
+{
+    const int fd = ::shm_open(
+        _name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600
+    );
+    if ( fd < 0 )
+        throwLastError( "shm_open " + _name );
+
+    // New pages read as zeroes, so the caller starts from a clean segment
+    if ( ::ftruncate( fd, static_cast< off_t >( _size ) ) != 0 )
+    {
+        const int error = errno;
+        ::close( fd );
+        ::shm_unlink( _name.c_str() );
+        throw std::system_error( error, std::system_category(), "ftruncate" );
+    }
+
+    try
+    {
+        map( fd, _size );
+    }
+    catch ( ... )
+    {
+        ::shm_unlink( _name.c_str() );
+        throw;
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+ShmSegment::ShmSegment ( const std::string & _name )
+    :   m_name( _name )
+    ,   m_owner( false )
+    ,   m_pAddress( nullptr )
+    ,   m_size( 0 )
+{
+    const int fd = ::shm_open( _name.c_str(), O_RDWR | O_CLOEXEC, 0 );
+    if ( fd < 0 )
+        throwLastError( "shm_open " + _name );
+
+    struct stat status;
+    if ( ::fstat( fd, &status ) != 0 )
+    {
+        const int error = errno;
+        ::close( fd );
+        throw std::system_error( error, std::system_category(), "fstat" );
+    }
+
+    map( fd, static_cast< std::size_t >( status.st_size ) );
+}
+
+/*----------------------------------------------------------------------------*/
+
+ShmSegment::~ShmSegment ()
+{
+    ::munmap( m_pAddress, m_size );
+
+    if ( m_owner )
+        ::shm_unlink( m_name.c_str() );
+}
+
+/*----------------------------------------------------------------------------*/
+
+void * ShmSegment::address () const noexcept
+{
+    return m_pAddress;
+}
+
+/*----------------------------------------------------------------------------*/
+
+std::size_t ShmSegment::size () const noexcept
+{
+    return m_size;
+}
+
+/*----------------------------------------------------------------------------*/
+
+bool ShmSegment::owner () const noexcept
+{
+    return m_owner;
+}
+
+/*----------------------------------------------------------------------------*/
+
+// The mapping keeps the object alive, so the descriptor is closed either way
+void ShmSegment::map ( int _fd, std::size_t _size )
+{
+    void * const pAddress = _size > 0
+        ?   ::mmap(
+                nullptr, _size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0
+            )
+        :   MAP_FAILED
+    ;
+    const int error = _size > 0 ? errno : EINVAL;
+    ::close( _fd );
+
+    if ( pAddress == MAP_FAILED )
+        throw std::system_error( error, std::system_category(), "mmap" );
+
+    m_pAddress = pAddress;
+    m_size = _size;
+}
+
+/*----------------------------------------------------------------------------*/
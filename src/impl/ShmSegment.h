@@ -0,0 +1,65 @@
+#ifndef __SHAREDQUEUE_SRC_IMPL_SHMSEGMENT_H__
+#define __SHAREDQUEUE_SRC_IMPL_SHMSEGMENT_H__
+
+/*----------------------------------------------------------------------------*/
+
+#if !defined( __linux__ )
+#error "ShmSegment.h needs Linux shared memory and futexes"
+#endif
+
+#include <cstddef>
+#include <string>
+
+/*----------------------------------------------------------------------------*/
+
+/**
+ * @class ShmSegment
+ *
+ * @brief A named POSIX shared memory object (shm_open) mapped read/write.
+ *
+ * The object that created the name unlinks it when destroyed; mappings that
+ * other processes already hold stay valid until they are unmapped.
+ */
+class ShmSegment
+{
+public:
+
+    /**
+     * @brief Creates the name, which must not exist yet, sized and zeroed.
+     * @throw std::system_error
+     */
+    ShmSegment ( const std::string & _name, std::size_t _size );
+
+    /**
+     * @brief Maps an existing name, whatever its size.
+     * @throw std::system_error
+     */
+    explicit ShmSegment ( const std::string & _name );
+
+    ~ShmSegment ();
+
+    ShmSegment ( const ShmSegment & ) = delete;
+    ShmSegment & operator = ( const ShmSegment & ) = delete;
+
+    void * address () const noexcept;
+
+    std::size_t size () const noexcept;
+
+    bool owner () const noexcept;
+
+private:
+
+    void map ( int _fd, std::size_t _size );
+
+private:
+
+    const std::string m_name;
+    const bool m_owner;
+
+    void * m_pAddress;
+    std::size_t m_size;
+};
+
+/*----------------------------------------------------------------------------*/
+
+#endif // __SHAREDQUEUE_SRC_IMPL_SHMSEGMENT_H__
@@ -0,0 +1,133 @@
+#ifndef __SHAREDQUEUE_SRC_IMPL_SPINWAIT_H__
+#define __SHAREDQUEUE_SRC_IMPL_SPINWAIT_H__
+
+/*----------------------------------------------------------------------------*/
+
+#include "WaitStrategy.h"
+#include "impl/EventCount.h"
+
+#include <thread>
+
+#if defined( _MSC_VER ) && ( defined( _M_X64 ) || defined( _M_IX86 ) )
+#include <intrin.h>
+#endif
+
+/*----------------------------------------------------------------------------*/
+
+/**
+ * @class SpinWait
+ *
+ * @brief Runs a WaitStrategy on behalf of the queues.
+ */
+class SpinWait
+{
+public:
+
+    using Clock = EventCount::Clock;
+
+    // Bounded spin phase of SpinThenYield/SpinThenBlock, in pause instructions
+    static constexpr unsigned s_spinLimit = 128;
+
+    /**
+     * @brief Tells the CPU we are in a spin loop: saves power and lets the
+     *        sibling hyper-thread run.
+     */
+    static void cpuRelax () noexcept
+    {
+#if defined( __x86_64__ ) || defined( __i386__ )
+        __builtin_ia32_pause();
+#elif defined( _M_X64 ) || defined( _M_IX86 )
+        _mm_pause();
+#elif defined( __aarch64__ ) || defined( __arm__ )
+        asm volatile( "yield" ::: "memory" );
+#endif
+    }
+
+    /**
+     * @return true if a waiter may go to sleep, so notifiers have work to do.
+     */
+    static constexpr bool parks ( WaitStrategy _strategy ) noexcept
+    {
+        return
+                _strategy == WaitStrategy::Block
+            ||  _strategy == WaitStrategy::SpinThenBlock
+        ;
+    }
+
+    /**
+     * @brief Runs the non-sleeping part of _strategy until _predicate holds.
+     *
+     * Spin and SpinThenYield keep going until the deadline (forever without
+     * one); SpinThenBlock gives up after s_spinLimit rounds and Block does not
+     * spin at all. The bounded phase is skipped on a single CPU.
+     *
+     * @return whether _predicate held when we stopped.
+     */
+    template < typename _PredicateT >
+    static bool spinUntil (
+            WaitStrategy _strategy
+        ,   _PredicateT _predicate
+        ,   const Clock::time_point * _pDeadline
+    )
+    {
+        if ( _strategy == WaitStrategy::Block )
+            return _predicate();
+
+        // On a single CPU the other side cannot run while we spin
+        const unsigned spinLimit = isMultiCore() ? s_spinLimit : 0;
+
+        for ( unsigned round = 0; !_predicate(); ++round )
+        {
+            if ( _pDeadline && Clock::now() >= *_pDeadline )
+                return false;
+
+            if ( round < spinLimit || _strategy == WaitStrategy::Spin )
+                cpuRelax();
+            else if ( _strategy == WaitStrategy::SpinThenYield )
+                std::this_thread::yield();
+            else
+                return false; // SpinThenBlock: time to sleep
+        }
+        return true;
+    }
+
+    /**
+     * @brief Retries _tryOp according to _strategy, sleeping on _rEvent when
+     *        the strategy allows it.
+     *
+     * @return false if _tryOp did not succeed before the deadline.
+     */
+    template < typename _TryOpT >
+    static bool await (
+            EventCount & _rEvent
+        ,   WaitStrategy _strategy
+        ,   _TryOpT _tryOp
+        ,   const Clock::time_point * _pDeadline
+    )
+    {
+        if ( spinUntil( _strategy, _tryOp, _pDeadline ) )
+            return true;
+
+        if ( !parks( _strategy ) )
+            return false; // only a deadline stops a spinning strategy
+
+        if ( !_pDeadline )
+        {
+            _rEvent.await( _tryOp );
+            return true;
+        }
+        return _rEvent.awaitUntil( _tryOp, *_pDeadline );
+    }
+
+private:
+
+    static bool isMultiCore () noexcept
+    {
+        static const bool multiCore = std::thread::hardware_concurrency() > 1;
+        return multiCore;
+    }
+};
+
+/*----------------------------------------------------------------------------*/
+
+#endif // __SHAREDQUEUE_SRC_IMPL_SPINWAIT_H__
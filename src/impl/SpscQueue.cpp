@@ -0,0 +1,476 @@
+#include "impl/SpscQueue.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+SpscQueue< _T >::SpscQueue ( std::size_t _size, WaitStrategy _waitStrategy )
+    :   m_queueSize( _size )
+    ,   m_slotsCount( _size + 1 )
+    ,   m_pBuffer( std::make_unique< _T *[] >( _size + 1 ) )
+    ,   m_head( 0 )
+    ,   m_cachedTail( 0 )
+    ,   m_tail( 0 )
+    ,   m_cachedHead( 0 )
+    ,   m_closed( false )
+    ,   m_events( *this, m_stats, _waitStrategy )
+{
+    assert( _size > 0 );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+SpscQueue< _T >::~SpscQueue ()
+{
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+int SpscQueue< _T >::count () const noexcept
+{
+    const std::size_t head = m_head.load( std::memory_order_acquire );
+    const std::size_t tail = m_tail.load( std::memory_order_acquire );
+
+    return static_cast< int >(
+        tail >= head ? tail - head : tail + m_slotsCount - head
+    );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t SpscQueue< _T >::capacity () const noexcept
+{
+    return m_queueSize;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+QueueStats SpscQueue< _T >::stats () const
+{
+    return m_stats.snapshot();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+void SpscQueue< _T >::close ()
+{
+    if ( m_closed.exchange( true ) )
+        return;
+
+    m_events.onClosed();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool SpscQueue< _T >::isClosed () const noexcept
+{
+    return m_closed.load();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+void SpscQueue< _T >::enqueue ( _T * _pNewValue )
+{
+    assert( _pNewValue );
+
+    const bool pushed = m_events.awaitRoom(
+            [ this, _pNewValue ] () { return tryPush( _pNewValue ); }
+        ,   nullptr
+    );
+
+    if ( !pushed )
+        throw QueueClosed();
+
+    m_events.onEnqueued();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool SpscQueue< _T >::enqueue ( _T * _pNewValue, int _millisecondsTimeout )
+{
+    assert( _pNewValue );
+
+    using namespace std::chrono;
+
+    const auto deadline =
+        EventCount::Clock::now() + milliseconds( _millisecondsTimeout );
+
+    const bool pushed = m_events.awaitRoom(
+            [ this, _pNewValue ] () { return tryPush( _pNewValue ); }
+        ,   &deadline
+    );
+
+    if ( !pushed )
+        return false; // timed out or closed
+
+    m_events.onEnqueued();
+
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool SpscQueue< _T >::tryEnqueue ( _T * _pNewValue )
+{
+    assert( _pNewValue );
+
+    if ( !tryPush( _pNewValue ) )
+        return false;
+
+    m_events.onEnqueued();
+
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+_T * SpscQueue< _T >::dequeue ()
+{
+    _T * pReturnVal = nullptr;
+
+    const bool popped = m_events.awaitItems(
+            [ this, &pReturnVal ] () { return tryPop( pReturnVal ); }
+        ,   nullptr
+    );
+
+    if ( !popped )
+        return nullptr; // closed and drained
+
+    m_events.onDequeued();
+
+    return pReturnVal;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+_T * SpscQueue< _T >::dequeue ( int _millisecondsTimeout )
+{
+    using namespace std::chrono;
+
+    const auto deadline =
+        EventCount::Clock::now() + milliseconds( _millisecondsTimeout );
+
+    _T * pReturnVal = nullptr;
+
+    const bool popped = m_events.awaitItems(
+            [ this, &pReturnVal ] () { return tryPop( pReturnVal ); }
+        ,   &deadline
+    );
+
+    if ( !popped )
+        return nullptr; // timed out, or closed and drained
+
+    m_events.onDequeued();
+
+    return pReturnVal;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+_T * SpscQueue< _T >::tryDequeue ()
+{
+    _T * pReturnVal = nullptr;
+    if ( !tryPop( pReturnVal ) )
+        return nullptr;
+
+    m_events.onDequeued();
+
+    return pReturnVal;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+void SpscQueue< _T >::enqueueBulk ( _T ** _ppItems, std::size_t _count )
+{
+    assert( IQueue< _T >::noneIsNull( _ppItems, _count ) );
+
+    if ( enqueueBulkUntil( _ppItems, _count, nullptr ) < _count )
+        throw QueueClosed();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t SpscQueue< _T >::enqueueBulk (
+        _T ** _ppItems
+    ,   std::size_t _count
+    ,   int _millisecondsTimeout
+)
+{
+    assert( IQueue< _T >::noneIsNull( _ppItems, _count ) );
+
+    const auto deadline =
+            EventCount::Clock::now()
+        +   std::chrono::milliseconds( _millisecondsTimeout )
+    ;
+    return enqueueBulkUntil( _ppItems, _count, &deadline );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t SpscQueue< _T >::tryEnqueueBulk (
+        _T ** _ppItems
+    ,   std::size_t _count
+)
+{
+    assert( IQueue< _T >::noneIsNull( _ppItems, _count ) );
+
+    const std::size_t enqueued = tryPushBulk( _ppItems, _count );
+    if ( enqueued > 0 )
+        m_events.onEnqueued();
+    return enqueued;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t SpscQueue< _T >::dequeueBulk (
+        _T ** _ppItems
+    ,   std::size_t _maxCount
+)
+{
+    return dequeueBulkUntil( _ppItems, _maxCount, nullptr );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t SpscQueue< _T >::dequeueBulk (
+        _T ** _ppItems
+    ,   std::size_t _maxCount
+    ,   int _millisecondsTimeout
+)
+{
+    const auto deadline =
+            EventCount::Clock::now()
+        +   std::chrono::milliseconds( _millisecondsTimeout )
+    ;
+    return dequeueBulkUntil( _ppItems, _maxCount, &deadline );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t SpscQueue< _T >::tryDequeueBulk (
+        _T ** _ppItems
+    ,   std::size_t _maxCount
+)
+{
+    const std::size_t dequeued = tryPopBulk( _ppItems, _maxCount );
+    if ( dequeued > 0 )
+        m_events.onDequeued();
+    return dequeued;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool SpscQueue< _T >::tryPush ( _T * _pNewValue ) noexcept
+{
+    if ( m_closed.load( std::memory_order_relaxed ) )
+        return false;
+
+    const std::size_t tail = m_tail.load( std::memory_order_relaxed );
+    const std::size_t nextTail = next( tail );
+
+    if ( nextTail == m_cachedHead )
+    {
+        // Looks full, refresh our view of the consumer
+        m_cachedHead = m_head.load( std::memory_order_acquire );
+        if ( nextTail == m_cachedHead )
+            return false;
+    }
+
+    m_pBuffer[ tail ] = _pNewValue;
+    m_tail.store( nextTail, std::memory_order_release );
+    m_stats.onEnqueued( 1, [ this ] () { return count(); } );
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool SpscQueue< _T >::tryPop ( _T * & _pValue ) noexcept
+{
+    const std::size_t head = m_head.load( std::memory_order_relaxed );
+
+    if ( head == m_cachedTail )
+    {
+        // Looks empty, refresh our view of the producer
+        m_cachedTail = m_tail.load( std::memory_order_acquire );
+        if ( head == m_cachedTail )
+            return false;
+    }
+
+    _pValue = m_pBuffer[ head ];
+    m_head.store( next( head ), std::memory_order_release );
+    m_stats.onDequeued( 1 );
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t SpscQueue< _T >::tryPushBulk (
+        _T ** _ppItems
+    ,   std::size_t _count
+) noexcept
+{
+    if ( m_closed.load( std::memory_order_relaxed ) )
+        return 0;
+
+    const std::size_t tail = m_tail.load( std::memory_order_relaxed );
+
+    const auto freeSlots = [ this, tail ] () {
+        return ( m_cachedHead + m_slotsCount - tail - 1 ) % m_slotsCount;
+    };
+
+    std::size_t available = freeSlots();
+    if ( available < _count )
+    {
+        m_cachedHead = m_head.load( std::memory_order_acquire );
+        available = freeSlots();
+    }
+
+    const std::size_t count = std::min( _count, available );
+
+    std::size_t index = tail;
+    for ( std::size_t i = 0; i < count; ++i )
+    {
+        m_pBuffer[ index ] = _ppItems[ i ];
+        index = next( index );
+    }
+
+    // Publish the whole batch with a single store
+    if ( count > 0 )
+    {
+        m_tail.store( index, std::memory_order_release );
+        m_stats.onEnqueued( count, [ this ] () { return this->count(); } );
+    }
+
+    return count;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t SpscQueue< _T >::tryPopBulk (
+        _T ** _ppItems
+    ,   std::size_t _maxCount
+) noexcept
+{
+    const std::size_t head = m_head.load( std::memory_order_relaxed );
+
+    const auto usedSlots = [ this, head ] () {
+        return ( m_cachedTail + m_slotsCount - head ) % m_slotsCount;
+    };
+
+    std::size_t available = usedSlots();
+    if ( available < _maxCount )
+    {
+        m_cachedTail = m_tail.load( std::memory_order_acquire );
+        available = usedSlots();
+    }
+
+    const std::size_t count = std::min( _maxCount, available );
+
+    std::size_t index = head;
+    for ( std::size_t i = 0; i < count; ++i )
+    {
+        _ppItems[ i ] = m_pBuffer[ index ];
+        index = next( index );
+    }
+
+    if ( count > 0 )
+    {
+        m_head.store( index, std::memory_order_release );
+        m_stats.onDequeued( count );
+    }
+
+    return count;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t SpscQueue< _T >::enqueueBulkUntil (
+        _T ** _ppItems
+    ,   std::size_t _count
+    ,   const EventCount::Clock::time_point * _pDeadline
+)
+{
+    std::size_t enqueued = 0;
+    while ( enqueued < _count )
+    {
+        const bool pushed = m_events.awaitRoom(
+                [ & ] () {
+                    const std::size_t count =
+                        tryPushBulk( _ppItems + enqueued, _count - enqueued );
+                    enqueued += count;
+                    return count > 0;
+                }
+            ,   _pDeadline
+        );
+
+        if ( !pushed )
+            break; // timed out or closed
+
+        m_events.onEnqueued();
+    }
+
+    return enqueued;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t SpscQueue< _T >::dequeueBulkUntil (
+        _T ** _ppItems
+    ,   std::size_t _maxCount
+    ,   const EventCount::Clock::time_point * _pDeadline
+)
+{
+    if ( _maxCount == 0 )
+        return 0;
+
+    std::size_t dequeued = 0;
+    m_events.awaitItems(
+            [ & ] () {
+                dequeued = tryPopBulk( _ppItems, _maxCount );
+                return dequeued > 0;
+            }
+        ,   _pDeadline
+    );
+
+    if ( dequeued > 0 )
+        m_events.onDequeued();
+
+    return dequeued;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t SpscQueue< _T >::next ( std::size_t _index ) const noexcept
+{
+    return _index + 1 == m_slotsCount ? 0 : _index + 1;
+}
+
+/*----------------------------------------------------------------------------*/
@@ -0,0 +1,152 @@
+#ifndef __SHAREDQUEUE_SRC_IMPL_SPSCQUEUE_H__
+#define __SHAREDQUEUE_SRC_IMPL_SPSCQUEUE_H__
+
+/*----------------------------------------------------------------------------*/
+
+#include "IQueue.h"
+#include "impl/EventCount.h"
+#include "impl/QueueEvents.h"
+#include "impl/SpinWait.h"
+#include "impl/StatsCounters.h"
+
+#include <atomic>
+#include <memory>
+
+/*----------------------------------------------------------------------------*/
+
+/**
+ * @class SpscQueue
+ *
+ * @brief Bounded ring for exactly one producer thread and one consumer thread.
+ *
+ * The producer owns the tail index and the consumer owns the head index, each
+ * on its own cache line together with a cached copy of the other side's
+ * index, so the shared indices are only re-read when the ring looks full or
+ * empty. All index traffic uses acquire/release atomics only.
+ *
+ * The blocking overloads wait according to the WaitStrategy: the parking
+ * ones sleep on an EventCount when the ring is empty/full, the others spin.
+ *
+ * Please note: calling enqueue from more than one thread, or dequeue from
+ * more than one thread, is undefined behaviour. close() is best called by
+ * the producer thread: called from another one, it may let a racing enqueue
+ * in after the consumer has already found the queue closed and drained.
+ */
+template < typename _T >
+class SpscQueue
+    :   public IQueue < _T >
+{
+public:
+
+    explicit SpscQueue (
+            std::size_t _size
+        ,   WaitStrategy _waitStrategy = WaitStrategy::Block
+    );
+
+    ~SpscQueue ();
+
+    int count () const noexcept override;
+
+    std::size_t capacity () const noexcept override;
+
+    QueueStats stats () const override;
+
+    void close () override;
+
+    bool isClosed () const noexcept override;
+
+    void enqueue ( _T * _pNewValue ) override;
+
+    bool enqueue ( _T * _pNewValue, int _millisecondsTimeout ) override;
+
+    bool tryEnqueue ( _T * _pNewValue ) override;
+
+    _T * dequeue () override;
+
+    _T * dequeue ( int _millisecondsTimeout ) override;
+
+    _T * tryDequeue () override;
+
+    void enqueueBulk ( _T ** _ppItems, std::size_t _count ) override;
+
+    std::size_t enqueueBulk (
+            _T ** _ppItems
+        ,   std::size_t _count
+        ,   int _millisecondsTimeout
+    ) override;
+
+    std::size_t tryEnqueueBulk (
+            _T ** _ppItems
+        ,   std::size_t _count
+    ) override;
+
+    std::size_t dequeueBulk (
+            _T ** _ppItems
+        ,   std::size_t _maxCount
+    ) override;
+
+    std::size_t dequeueBulk (
+            _T ** _ppItems
+        ,   std::size_t _maxCount
+        ,   int _millisecondsTimeout
+    ) override;
+
+    std::size_t tryDequeueBulk (
+            _T ** _ppItems
+        ,   std::size_t _maxCount
+    ) override;
+
+private:
+
+    bool tryPush ( _T * _pNewValue ) noexcept;
+
+    bool tryPop ( _T * & _pValue ) noexcept;
+
+    std::size_t tryPushBulk ( _T ** _ppItems, std::size_t _count ) noexcept;
+
+    std::size_t tryPopBulk ( _T ** _ppItems, std::size_t _maxCount ) noexcept;
+
+    std::size_t enqueueBulkUntil (
+            _T ** _ppItems
+        ,   std::size_t _count
+        ,   const EventCount::Clock::time_point * _pDeadline
+    );
+
+    std::size_t dequeueBulkUntil (
+            _T ** _ppItems
+        ,   std::size_t _maxCount
+        ,   const EventCount::Clock::time_point * _pDeadline
+    );
+
+    std::size_t next ( std::size_t _index ) const noexcept;
+
+private:
+
+    static constexpr std::size_t s_cacheLineSize = 64;
+
+    // One spare slot tells "full" apart from "empty"
+    const std::size_t m_queueSize;
+    const std::size_t m_slotsCount;
+    std::unique_ptr< _T *[] > m_pBuffer;
+
+    // Consumer side
+    alignas( s_cacheLineSize ) std::atomic< std::size_t > m_head;
+    std::size_t m_cachedTail;
+
+    // Producer side
+    alignas( s_cacheLineSize ) std::atomic< std::size_t > m_tail;
+    std::size_t m_cachedHead;
+    std::atomic< bool > m_closed;
+
+    alignas( s_cacheLineSize ) QueueEvents< _T > m_events;
+
+    [[no_unique_address]] StatsCounters m_stats;
+};
+
+/*----------------------------------------------------------------------------*/
+
+#include "impl/SpscQueue.cpp"
+
+/*----------------------------------------------------------------------------*/
+
+#endif // __SHAREDQUEUE_SRC_IMPL_SPSCQUEUE_H__
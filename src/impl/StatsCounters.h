@@ -0,0 +1,271 @@
+#ifndef __SHAREDQUEUE_SRC_IMPL_STATSCOUNTERS_H__
+#define __SHAREDQUEUE_SRC_IMPL_STATSCOUNTERS_H__
+
+/*----------------------------------------------------------------------------*/
+
+#include "QueueStats.h"
+#include "WaitStrategy.h"
+#include "impl/SpinWait.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+/*----------------------------------------------------------------------------*/
+
+/**
+ * @class StatsCounters
+ *
+ * @brief Records the counters behind IQueue::stats() for one queue.
+ *
+ * Counters are spread over s_shardCount cache-line-sized shards and a thread
+ * always writes to the same one, picked on its first use, so recording does
+ * not make producers and consumers share a cache line; only a snapshot reads
+ * all the shards. Threads beyond s_shardCount share shards, which stays
+ * correct as every update is an atomic add.
+ *
+ * Without SHAREDQUEUE_STATS the class is empty and its calls are no-ops that
+ * do not even evaluate the queue size; queues hold it [[no_unique_address]].
+ */
+class StatsCounters
+{
+public:
+
+    using Clock = SpinWait::Clock;
+
+    enum class Side
+    {
+            Producer
+        ,   Consumer
+    };
+
+#if defined( SHAREDQUEUE_STATS )
+
+    static constexpr std::size_t s_shardCount = 16;
+
+    /**
+     * @param _size Returns count() after the enqueue, for the high-water mark.
+     */
+    template < typename _SizeT >
+    void onEnqueued ( std::size_t _count, _SizeT _size ) noexcept
+    {
+        Shard & rShard = shard();
+        rShard.enqueued.fetch_add( _count, std::memory_order_relaxed );
+
+        const std::uint64_t size = static_cast< std::uint64_t >( _size() );
+        std::uint64_t highWaterMark =
+            rShard.highWaterMark.load( std::memory_order_relaxed );
+        while (
+                size > highWaterMark
+            &&  !rShard.highWaterMark.compare_exchange_weak(
+                        highWaterMark
+                    ,   size
+                    ,   std::memory_order_relaxed
+                )
+        )
+            ;
+    }
+
+    void onDequeued ( std::size_t _count ) noexcept
+    {
+        shard().dequeued.fetch_add( _count, std::memory_order_relaxed );
+    }
+
+    /**
+     * @brief For a coroutine that has to be suspended: counts a wait.
+     */
+    void onParked ( Side _side ) noexcept
+    {
+        Counter & rWaits = _side == Side::Producer
+            ?   shard().producerWaits
+            :   shard().consumerWaits
+        ;
+        rWaits.fetch_add( 1, std::memory_order_relaxed );
+    }
+
+    /**
+     * @brief SpinWait::await(), counting a wait, its duration and whether it
+     *        timed out if _tryOp does not succeed straight away.
+     */
+    template < typename _TryOpT >
+    bool await (
+            Side _side
+        ,   EventCount & _rEvent
+        ,   WaitStrategy _strategy
+        ,   _TryOpT _tryOp
+        ,   const Clock::time_point * _pDeadline
+    )
+    {
+        if ( _tryOp() )
+            return true;
+
+        const Clock::time_point start = Clock::now();
+        const bool done =
+            SpinWait::await( _rEvent, _strategy, _tryOp, _pDeadline );
+        const std::uint64_t blocked =
+            std::chrono::duration_cast< std::chrono::nanoseconds >(
+                Clock::now() - start
+            ).count();
+
+        Shard & rShard = shard();
+        if ( _side == Side::Producer )
+        {
+            rShard.producerWaits.fetch_add( 1, std::memory_order_relaxed );
+            rShard.producerBlocked.fetch_add(
+                blocked, std::memory_order_relaxed
+            );
+        }
+        else
+        {
+            rShard.consumerWaits.fetch_add( 1, std::memory_order_relaxed );
+            rShard.consumerBlocked.fetch_add(
+                blocked, std::memory_order_relaxed
+            );
+        }
+
+        if ( !done )
+            rShard.timeouts.fetch_add( 1, std::memory_order_relaxed );
+
+        return done;
+    }
+
+    /**
+     * @return The counters summed over the shards; lockContentions is left
+     *         to the queue, which owns the mutexes.
+     */
+    QueueStats snapshot () const noexcept
+    {
+        QueueStats stats;
+        for ( const Shard & rShard: m_shards )
+        {
+            stats.enqueued += load( rShard.enqueued );
+            stats.dequeued += load( rShard.dequeued );
+            stats.highWaterMark =
+                std::max( stats.highWaterMark, load( rShard.highWaterMark ) );
+            stats.producerWaits += load( rShard.producerWaits );
+            stats.consumerWaits += load( rShard.consumerWaits );
+            stats.producerBlockedTime +=
+                std::chrono::nanoseconds( load( rShard.producerBlocked ) );
+            stats.consumerBlockedTime +=
+                std::chrono::nanoseconds( load( rShard.consumerBlocked ) );
+            stats.timeouts += load( rShard.timeouts );
+        }
+        return stats;
+    }
+
+private:
+
+    using Counter = std::atomic< std::uint64_t >;
+
+    struct alignas( 64 ) Shard
+    {
+        Counter enqueued { 0 };
+        Counter dequeued { 0 };
+        Counter highWaterMark { 0 };
+        Counter producerWaits { 0 };
+        Counter consumerWaits { 0 };
+
+        // In nanoseconds
+        Counter producerBlocked { 0 };
+        Counter consumerBlocked { 0 };
+
+        Counter timeouts { 0 };
+    };
+
+    static std::uint64_t load ( const Counter & _rCounter ) noexcept
+    {
+        return _rCounter.load( std::memory_order_relaxed );
+    }
+
+    Shard & shard () noexcept
+    {
+        static std::atomic< std::size_t > s_nextTicket( 0 );
+        thread_local const std::size_t ticket =
+            s_nextTicket.fetch_add( 1, std::memory_order_relaxed );
+
+        return m_shards[ ticket % s_shardCount ];
+    }
+
+    Shard m_shards[ s_shardCount ];
+
+#else // SHAREDQUEUE_STATS
+
+    template < typename _SizeT >
+    void onEnqueued ( std::size_t, _SizeT ) noexcept {}
+
+    void onDequeued ( std::size_t ) noexcept {}
+
+    void onParked ( Side ) noexcept {}
+
+    template < typename _TryOpT >
+    bool await (
+            Side
+        ,   EventCount & _rEvent
+        ,   WaitStrategy _strategy
+        ,   _TryOpT _tryOp
+        ,   const Clock::time_point * _pDeadline
+    )
+    {
+        return SpinWait::await( _rEvent, _strategy, _tryOp, _pDeadline );
+    }
+
+    QueueStats snapshot () const noexcept
+    {
+        return QueueStats();
+    }
+
+#endif // SHAREDQUEUE_STATS
+};
+
+/*----------------------------------------------------------------------------*/
+
+/**
+ * @class StatsMutex
+ *
+ * @brief std::mutex that counts the lock() calls which found it taken.
+ *
+ * The count lives next to the mutex, whose cache line a contended lock() is
+ * moving anyway. Without SHAREDQUEUE_STATS it is a plain std::mutex and
+ * contentions() is 0.
+ */
+class StatsMutex
+    :   public std::mutex
+{
+public:
+
+#if defined( SHAREDQUEUE_STATS )
+
+    void lock ()
+    {
+        if ( try_lock() )
+            return;
+
+        m_contentions.fetch_add( 1, std::memory_order_relaxed );
+        std::mutex::lock();
+    }
+
+    std::uint64_t contentions () const noexcept
+    {
+        return m_contentions.load( std::memory_order_relaxed );
+    }
+
+private:
+
+    std::atomic< std::uint64_t > m_contentions { 0 };
+
+#else // SHAREDQUEUE_STATS
+
+    std::uint64_t contentions () const noexcept
+    {
+        return 0;
+    }
+
+#endif // SHAREDQUEUE_STATS
+};
+
+/*----------------------------------------------------------------------------*/
+
+#endif // __SHAREDQUEUE_SRC_IMPL_STATSCOUNTERS_H__
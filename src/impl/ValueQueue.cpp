@@ -0,0 +1,358 @@
+#include "impl/ValueQueue.h"
+
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+struct ValueQueue< _T >::Cell
+{
+    // Sequences advance by two per position, otherwise a one-slot ring could
+    // not tell a published value from a slot that is free for the next lap
+    static constexpr std::size_t freeFor ( std::size_t _pos ) noexcept
+    {
+        return 2 * _pos;
+    }
+
+    static constexpr std::size_t publishedFor ( std::size_t _pos ) noexcept
+    {
+        return 2 * _pos + 1;
+    }
+
+    _T * value () noexcept
+    {
+        return std::launder( reinterpret_cast< _T * >( storage ) );
+    }
+
+    std::atomic< std::size_t > sequence;
+    alignas( _T ) unsigned char storage[ sizeof( _T ) ];
+};
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+ValueQueue< _T >::ValueQueue ( std::size_t _size, WaitStrategy _waitStrategy )
+    :   m_queueSize( _size )
+    ,   m_waitStrategy( _waitStrategy )
+    ,   m_pBuffer( std::make_unique< Cell[] >( _size ) )
+    ,   m_enqueuePos( 0 )
+    ,   m_dequeuePos( 0 )
+{
+    assert( _size > 0 );
+
+    for ( std::size_t i = 0; i < m_queueSize; ++i )
+        m_pBuffer[ i ].sequence.store(
+            Cell::freeFor( i ), std::memory_order_relaxed
+        );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+ValueQueue< _T >::~ValueQueue ()
+{
+    // Nobody else may touch the queue any more: destroy what is left
+    const std::size_t enqueuePos = m_enqueuePos.load();
+    for ( std::size_t pos = m_dequeuePos.load(); pos != enqueuePos; ++pos )
+        m_pBuffer[ pos % m_queueSize ].value()->~_T();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+int ValueQueue< _T >::count () const noexcept
+{
+    const std::size_t dequeuePos =
+        m_dequeuePos.load( std::memory_order_acquire );
+    const std::size_t enqueuePos =
+        m_enqueuePos.load( std::memory_order_acquire );
+
+    const std::size_t size = enqueuePos - dequeuePos;
+    return static_cast< int >( size < m_queueSize ? size : m_queueSize );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+void ValueQueue< _T >::enqueue ( const _T & _value )
+{
+    // Copy before claiming a slot: the copy is allowed to throw
+    enqueue( _T( _value ) );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+void ValueQueue< _T >::enqueue ( _T && _value )
+{
+    emplace( std::move( _value ) );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool ValueQueue< _T >::enqueue ( const _T & _value, int _millisecondsTimeout )
+{
+    return enqueue( _T( _value ), _millisecondsTimeout );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool ValueQueue< _T >::enqueue ( _T && _value, int _millisecondsTimeout )
+{
+    using namespace std::chrono;
+
+    Cell * pCell = nullptr;
+    std::size_t pos;
+
+    const auto deadline =
+        EventCount::Clock::now() + milliseconds( _millisecondsTimeout );
+
+    const bool claimed = waitFor(
+            m_notFullEvent
+        ,   [ this, &pCell, &pos ] () {
+                return ( pCell = tryClaimForPush( pos ) ) != nullptr;
+            }
+        ,   &deadline
+    );
+
+    if ( !claimed )
+        return false; // timed out
+
+    constructAndPublish( pCell, pos, std::move( _value ) );
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+template < typename ... _ArgsT >
+void ValueQueue< _T >::emplace ( _ArgsT && ... _args )
+{
+    if constexpr ( std::is_nothrow_constructible< _T, _ArgsT ... >::value )
+    {
+        Cell * pCell = nullptr;
+        std::size_t pos;
+
+        waitFor(
+                m_notFullEvent
+            ,   [ this, &pCell, &pos ] () {
+                    return ( pCell = tryClaimForPush( pos ) ) != nullptr;
+                }
+            ,   nullptr
+        );
+
+        constructAndPublish( pCell, pos, std::forward< _ArgsT >( _args )... );
+    }
+    else
+    {
+        // Build it outside the ring so that a throwing constructor cannot
+        // leave a claimed slot behind
+        emplace( _T( std::forward< _ArgsT >( _args )... ) );
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+_T ValueQueue< _T >::dequeue ()
+{
+    Cell * pCell = nullptr;
+    std::size_t pos;
+
+    waitFor(
+            m_notEmptyEvent
+        ,   [ this, &pCell, &pos ] () {
+                return ( pCell = tryClaimForPop( pos ) ) != nullptr;
+            }
+        ,   nullptr
+    );
+
+    return moveOutAndRelease( pCell, pos );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::optional< _T > ValueQueue< _T >::dequeue ( int _millisecondsTimeout )
+{
+    using namespace std::chrono;
+
+    Cell * pCell = nullptr;
+    std::size_t pos;
+
+    const auto deadline =
+        EventCount::Clock::now() + milliseconds( _millisecondsTimeout );
+
+    const bool claimed = waitFor(
+            m_notEmptyEvent
+        ,   [ this, &pCell, &pos ] () {
+                return ( pCell = tryClaimForPop( pos ) ) != nullptr;
+            }
+        ,   &deadline
+    );
+
+    if ( !claimed )
+        return std::nullopt; // timed out
+
+    return moveOutAndRelease( pCell, pos );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool ValueQueue< _T >::tryEnqueue ( _T && _value )
+{
+    std::size_t pos;
+    Cell * const pCell = tryClaimForPush( pos );
+    if ( !pCell )
+        return false;
+
+    constructAndPublish( pCell, pos, std::move( _value ) );
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::optional< _T > ValueQueue< _T >::tryDequeue ()
+{
+    std::size_t pos;
+    Cell * const pCell = tryClaimForPop( pos );
+    if ( !pCell )
+        return std::nullopt;
+
+    return moveOutAndRelease( pCell, pos );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+typename ValueQueue< _T >::Cell * ValueQueue< _T >::tryClaimForPush (
+        std::size_t & _pos
+) noexcept
+{
+    _pos = m_enqueuePos.load( std::memory_order_relaxed );
+
+    for ( ;; )
+    {
+        Cell * const pCell = &m_pBuffer[ _pos % m_queueSize ];
+        const std::intptr_t diff =
+            static_cast< std::intptr_t >(
+                pCell->sequence.load( std::memory_order_acquire )
+            )
+        -   static_cast< std::intptr_t >( Cell::freeFor( _pos ) );
+
+        if ( diff == 0 )
+        {
+            if ( m_enqueuePos.compare_exchange_weak(
+                    _pos, _pos + 1, std::memory_order_relaxed
+            ) )
+                return pCell;
+        }
+        else if ( diff < 0 )
+        {
+            return nullptr; // full
+        }
+        else
+        {
+            _pos = m_enqueuePos.load( std::memory_order_relaxed );
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+typename ValueQueue< _T >::Cell * ValueQueue< _T >::tryClaimForPop (
+        std::size_t & _pos
+) noexcept
+{
+    _pos = m_dequeuePos.load( std::memory_order_relaxed );
+
+    for ( ;; )
+    {
+        Cell * const pCell = &m_pBuffer[ _pos % m_queueSize ];
+        const std::intptr_t diff =
+            static_cast< std::intptr_t >(
+                pCell->sequence.load( std::memory_order_acquire )
+            )
+        -   static_cast< std::intptr_t >( Cell::publishedFor( _pos ) );
+
+        if ( diff == 0 )
+        {
+            if ( m_dequeuePos.compare_exchange_weak(
+                    _pos, _pos + 1, std::memory_order_relaxed
+            ) )
+                return pCell;
+        }
+        else if ( diff < 0 )
+        {
+            return nullptr; // empty
+        }
+        else
+        {
+            _pos = m_dequeuePos.load( std::memory_order_relaxed );
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+template < typename ... _ArgsT >
+void ValueQueue< _T >::constructAndPublish (
+        Cell * _pCell
+    ,   std::size_t _pos
+    ,   _ArgsT && ... _args
+) noexcept
+{
+    new ( _pCell->storage ) _T( std::forward< _ArgsT >( _args )... );
+    _pCell->sequence.store(
+        Cell::publishedFor( _pos ), std::memory_order_release
+    );
+
+    if ( SpinWait::parks( m_waitStrategy ) )
+        m_notEmptyEvent.notifyOne();
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+_T ValueQueue< _T >::moveOutAndRelease (
+        Cell * _pCell
+    ,   std::size_t _pos
+) noexcept
+{
+    _T * const pValue = _pCell->value();
+    _T value( std::move( *pValue ) );
+    pValue->~_T();
+
+    _pCell->sequence.store(
+        Cell::freeFor( _pos + m_queueSize ), std::memory_order_release
+    );
+
+    if ( SpinWait::parks( m_waitStrategy ) )
+        m_notFullEvent.notifyOne();
+    return value;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+template < typename _TryOpT >
+bool ValueQueue< _T >::waitFor (
+        EventCount & _rEvent
+    ,   _TryOpT _tryOp
+    ,   const EventCount::Clock::time_point * _pDeadline
+)
+{
+    return SpinWait::await( _rEvent, m_waitStrategy, _tryOp, _pDeadline );
+}
+
+/*----------------------------------------------------------------------------*/
@@ -0,0 +1,115 @@
+#ifndef __SHAREDQUEUE_SRC_IMPL_VALUEQUEUE_H__
+#define __SHAREDQUEUE_SRC_IMPL_VALUEQUEUE_H__
+
+/*----------------------------------------------------------------------------*/
+
+#include "impl/EventCount.h"
+#include "impl/SpinWait.h"
+
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <type_traits>
+
+/*----------------------------------------------------------------------------*/
+
+/**
+ * @class ValueQueue
+ *
+ * @brief Bounded multi-producer/multi-consumer queue that stores T by value.
+ *
+ * Unlike IQueue, items live directly in contiguous ring slots, so sending a
+ * small struct costs neither a heap allocation nor a pointer chase. The ring
+ * uses the same sequence-stamped slots as LockFreeQueue; items are moved in
+ * and out (or constructed in place with emplace()).
+ *
+ * T must be nothrow move constructible: a claimed slot has to be published
+ * or released no matter what, so nothing may throw while it is held.
+ */
+template < typename _T >
+class ValueQueue
+{
+    static_assert(
+            std::is_nothrow_move_constructible< _T >::value
+        ,   "ValueQueue requires a nothrow move constructible type"
+    );
+
+public:
+
+    explicit ValueQueue (
+            std::size_t _size
+        ,   WaitStrategy _waitStrategy = WaitStrategy::Block
+    );
+
+    ValueQueue ( const ValueQueue & ) = delete;
+    ValueQueue & operator = ( const ValueQueue & ) = delete;
+
+    ~ValueQueue ();
+
+    int count () const noexcept;
+
+    void enqueue ( const _T & _value );
+
+    void enqueue ( _T && _value );
+
+    bool enqueue ( const _T & _value, int _millisecondsTimeout );
+
+    bool enqueue ( _T && _value, int _millisecondsTimeout );
+
+    template < typename ... _ArgsT >
+    void emplace ( _ArgsT && ... _args );
+
+    _T dequeue ();
+
+    std::optional< _T > dequeue ( int _millisecondsTimeout );
+
+    bool tryEnqueue ( _T && _value );
+
+    std::optional< _T > tryDequeue ();
+
+private:
+
+    struct Cell;
+
+    Cell * tryClaimForPush ( std::size_t & _pos ) noexcept;
+
+    Cell * tryClaimForPop ( std::size_t & _pos ) noexcept;
+
+    template < typename ... _ArgsT >
+    void constructAndPublish (
+            Cell * _pCell
+        ,   std::size_t _pos
+        ,   _ArgsT && ... _args
+    ) noexcept;
+
+    _T moveOutAndRelease ( Cell * _pCell, std::size_t _pos ) noexcept;
+
+    template < typename _TryOpT >
+    bool waitFor (
+            EventCount & _rEvent
+        ,   _TryOpT _tryOp
+        ,   const EventCount::Clock::time_point * _pDeadline
+    );
+
+private:
+
+    static constexpr std::size_t s_cacheLineSize = 64;
+
+    const std::size_t m_queueSize;
+    const WaitStrategy m_waitStrategy;
+    std::unique_ptr< Cell[] > m_pBuffer;
+
+    alignas( s_cacheLineSize ) std::atomic< std::size_t > m_enqueuePos;
+    alignas( s_cacheLineSize ) std::atomic< std::size_t > m_dequeuePos;
+
+    alignas( s_cacheLineSize ) EventCount m_notEmptyEvent;
+    EventCount m_notFullEvent;
+};
+
+/*----------------------------------------------------------------------------*/
+
+#include "impl/ValueQueue.cpp"
+
+/*----------------------------------------------------------------------------*/
+
+#endif // __SHAREDQUEUE_SRC_IMPL_VALUEQUEUE_H__
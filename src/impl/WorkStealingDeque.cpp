@@ -0,0 +1,195 @@
+#include "impl/WorkStealingDeque.h"
+
+#include <cassert>
+
+/*----------------------------------------------------------------------------*/
+
+// Slots are atomics only so that a thief reading a slot the owner is about to
+// reuse is not a data race; every access is relaxed and ordered by the fences
+// and the accesses to m_top and m_bottom.
+template < typename _T >
+struct WorkStealingDeque< _T >::Buffer
+{
+    explicit Buffer ( std::size_t _capacity )
+        :   capacity( _capacity )
+        ,   mask( _capacity - 1 )
+        ,   pSlots( std::make_unique< std::atomic< _T * >[] >( _capacity ) )
+    {
+        assert( ( _capacity & mask ) == 0 );
+    }
+
+    _T * get ( std::int64_t _index ) const noexcept
+    {
+        return pSlots[ static_cast< std::size_t >( _index ) & mask ].load(
+            std::memory_order_relaxed
+        );
+    }
+
+    void put ( std::int64_t _index, _T * _pValue ) noexcept
+    {
+        pSlots[ static_cast< std::size_t >( _index ) & mask ].store(
+            _pValue, std::memory_order_relaxed
+        );
+    }
+
+    const std::size_t capacity;
+    const std::size_t mask;
+    std::unique_ptr< std::atomic< _T * >[] > pSlots;
+};
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+WorkStealingDeque< _T >::WorkStealingDeque ( std::size_t _initialCapacity )
+    :   m_top( 0 )
+    ,   m_bottom( 0 )
+{
+    std::size_t capacity = 1;
+    while ( capacity < _initialCapacity )
+        capacity <<= 1;
+
+    m_pBuffer.store( new Buffer( capacity ), std::memory_order_relaxed );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+WorkStealingDeque< _T >::~WorkStealingDeque ()
+{
+    delete m_pBuffer.load( std::memory_order_relaxed );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+void WorkStealingDeque< _T >::push ( _T * _pNewValue )
+{
+    const std::int64_t bottom = m_bottom.load( std::memory_order_relaxed );
+    const std::int64_t top = m_top.load( std::memory_order_acquire );
+    Buffer * pBuffer = m_pBuffer.load( std::memory_order_relaxed );
+
+    if ( bottom - top >= static_cast< std::int64_t >( pBuffer->capacity ) )
+        pBuffer = grow( pBuffer, top, bottom );
+
+    pBuffer->put( bottom, _pNewValue );
+
+    // Publish the item before the thieves can see the new bottom
+    std::atomic_thread_fence( std::memory_order_release );
+    m_bottom.store( bottom + 1, std::memory_order_relaxed );
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+_T * WorkStealingDeque< _T >::pop () noexcept
+{
+    const std::int64_t bottom = m_bottom.load( std::memory_order_relaxed ) - 1;
+    Buffer * const pBuffer = m_pBuffer.load( std::memory_order_relaxed );
+
+    // Reserve the bottom item first, then look at what thieves have taken;
+    // the full fence keeps the two from being reordered
+    m_bottom.store( bottom, std::memory_order_relaxed );
+    std::atomic_thread_fence( std::memory_order_seq_cst );
+    std::int64_t top = m_top.load( std::memory_order_relaxed );
+
+    if ( top > bottom )
+    {
+        m_bottom.store( bottom + 1, std::memory_order_relaxed );
+        return nullptr; // empty
+    }
+
+    _T * pValue = pBuffer->get( bottom );
+    if ( top == bottom )
+    {
+        // Last item: race the thieves for it through m_top
+        if ( !m_top.compare_exchange_strong(
+                top
+            ,   top + 1
+            ,   std::memory_order_seq_cst
+            ,   std::memory_order_relaxed
+        ) )
+            pValue = nullptr;
+
+        m_bottom.store( bottom + 1, std::memory_order_relaxed );
+    }
+
+    return pValue;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+_T * WorkStealingDeque< _T >::steal () noexcept
+{
+    std::int64_t top = m_top.load( std::memory_order_acquire );
+    std::atomic_thread_fence( std::memory_order_seq_cst );
+    const std::int64_t bottom = m_bottom.load( std::memory_order_acquire );
+
+    if ( top >= bottom )
+        return nullptr; // empty
+
+    // The item must be read before the CAS: once m_top moves on, the owner
+    // may overwrite its slot
+    Buffer * const pBuffer = m_pBuffer.load( std::memory_order_acquire );
+    _T * const pValue = pBuffer->get( top );
+
+    if ( !m_top.compare_exchange_strong(
+            top
+        ,   top + 1
+        ,   std::memory_order_seq_cst
+        ,   std::memory_order_relaxed
+    ) )
+        return nullptr; // lost the race to another thief or the owner
+
+    return pValue;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t WorkStealingDeque< _T >::size () const noexcept
+{
+    const std::int64_t bottom = m_bottom.load( std::memory_order_relaxed );
+    const std::int64_t top = m_top.load( std::memory_order_relaxed );
+    return bottom > top ? static_cast< std::size_t >( bottom - top ) : 0;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+bool WorkStealingDeque< _T >::empty () const noexcept
+{
+    return size() == 0;
+}
+
+/*----------------------------------------------------------------------------*/
+
+template < typename _T >
+std::size_t WorkStealingDeque< _T >::capacity () const noexcept
+{
+    return m_pBuffer.load( std::memory_order_relaxed )->capacity;
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Owner only. Items keep their indices, so thieves holding the old ring and
+// thieves holding the new one agree on what sits at m_top.
+template < typename _T >
+typename WorkStealingDeque< _T >::Buffer * WorkStealingDeque< _T >::grow (
+        Buffer * _pBuffer
+    ,   std::int64_t _top
+    ,   std::int64_t _bottom
+)
+{
+    auto pGrown = std::make_unique< Buffer >( 2 * _pBuffer->capacity );
+    for ( std::int64_t i = _top; i < _bottom; ++i )
+        pGrown->put( i, _pBuffer->get( i ) );
+
+    m_retiredBuffers.emplace_back( _pBuffer );
+
+    Buffer * const pNewBuffer = pGrown.release();
+    m_pBuffer.store( pNewBuffer, std::memory_order_release );
+    return pNewBuffer;
+}
+
+/*----------------------------------------------------------------------------*/
@@ -0,0 +1,100 @@
+#ifndef __SHAREDQUEUE_SRC_IMPL_WORKSTEALINGDEQUE_H__
+#define __SHAREDQUEUE_SRC_IMPL_WORKSTEALINGDEQUE_H__
+
+/*----------------------------------------------------------------------------*/
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/*----------------------------------------------------------------------------*/
+
+/**
+ * @class WorkStealingDeque
+ *
+ * @brief Chase-Lev deque of pointers to T: one owner thread pushes and pops
+ *        at the bottom without locks, any other thread steals from the top
+ *        with a single CAS.
+ *
+ * The owner works LIFO on its freshest items while thieves take the oldest
+ * ones, so they only meet on the very last item. The ring doubles when the
+ * owner fills it; replaced rings stay alive until the deque is destroyed,
+ * because a thief may still be reading one, and together they never take
+ * more memory than the current ring.
+ *
+ * Please note: push() and pop() must only be called from the owner thread.
+ * Like IQueue, the deque does not own the pointers to T.
+ */
+template < typename _T >
+class WorkStealingDeque
+{
+public:
+
+    /**
+     * @param _initialCapacity Rounded up to a power of two.
+     */
+    explicit WorkStealingDeque ( std::size_t _initialCapacity = 64 );
+
+    ~WorkStealingDeque ();
+
+    WorkStealingDeque ( const WorkStealingDeque & ) = delete;
+    WorkStealingDeque & operator = ( const WorkStealingDeque & ) = delete;
+
+    /**
+     * @brief Owner only: adds an item at the bottom, growing the ring if it
+     *        is full.
+     */
+    void push ( _T * _pNewValue );
+
+    /**
+     * @brief Owner only: takes the most recently pushed item.
+     * @return nullptr if the deque is empty.
+     */
+    _T * pop () noexcept;
+
+    /**
+     * @brief Any thread: takes the oldest item.
+     * @return nullptr if the deque is empty or another thread took the item
+     *         first; callers that need an item simply try again.
+     */
+    _T * steal () noexcept;
+
+    /**
+     * @return A snapshot that may be stale by the time it is used.
+     */
+    std::size_t size () const noexcept;
+
+    bool empty () const noexcept;
+
+    std::size_t capacity () const noexcept;
+
+private:
+
+    struct Buffer;
+
+    Buffer * grow (
+            Buffer * _pBuffer
+        ,   std::int64_t _top
+        ,   std::int64_t _bottom
+    );
+
+private:
+
+    static constexpr std::size_t s_cacheLineSize = 64;
+
+    alignas( s_cacheLineSize ) std::atomic< std::int64_t > m_top;
+    alignas( s_cacheLineSize ) std::atomic< std::int64_t > m_bottom;
+    std::atomic< Buffer * > m_pBuffer;
+
+    // Touched by the owner only
+    std::vector< std::unique_ptr< Buffer > > m_retiredBuffers;
+};
+
+/*----------------------------------------------------------------------------*/
+
+#include "impl/WorkStealingDeque.cpp"
+
+/*----------------------------------------------------------------------------*/
+
+#endif // __SHAREDQUEUE_SRC_IMPL_WORKSTEALINGDEQUE_H__
@@ -4,11 +4,23 @@
 #include "utilities.hpp"
 
 #include "QueueFactory.h"
+#include "impl/CoroutineScheduler.h"
+#include "impl/Executor.h"
 
 #include <algorithm>
 #include <chrono>
 #include <numeric>
 
+#if defined( __GLIBC__ )
+#include <malloc.h>
+#endif
+
+#if defined( __linux__ )
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 /*----------------------------------------------------------------------------*/
 /*-----------------------------------------------------------------------------
 Test plan:
@@ -18,14 +30,57 @@ Done        1.1. Multiple threads - one element
 Done        1.2. One thread - multiple elements
 Done            1.2.1. Queue size less than elements number
 Done            1.2.2. Queue size equal to elements number
+Done        1.3. One thread - throughput
+Done        1.4. One thread - bulk throughput
+Done        1.5. Uncontended - enqueue/dequeue pairs on a single thread
 ////////////////////////////////////////////////////////////////////////////////
-This part is done mainly to reduce the compilation speed, though it can slow
-down queue work a little bit:
+This part is done mainly to reduce the compilation speed; it carries the
+same pooled nodes as 1., so 2.3 and 2.4 should match 1.3 and 1.4:
 Done    2. PImpl
 Done        2.1. Multiple threads - one element
 Done        2.2. One thread - multiple elements
 Done            2.2.1. Queue size less than elements number
 Done            2.2.2. Queue size equal to elements number
+Done        2.3. One thread - throughput
+Done        2.4. One thread - bulk throughput
+Done    3. Lock-free ring
+Done        3.1. Multiple threads - one element
+Done        3.2. One thread - multiple elements
+Done            3.2.1. Queue size less than elements number
+Done            3.2.2. Queue size equal to elements number
+Done    4. Single producer / single consumer ring
+Done        4.1. Multiple threads - one element
+Done        4.2. One thread - multiple elements
+Done        4.3. One thread - throughput (blocking wait)
+Done        4.4. One thread - throughput (spinning wait)
+Done    5. Value queue (32-byte payload stored inline)
+Done        5.1. One thread - throughput
+Done        5.2. Same payload through a pointer queue, one allocation each
+Done    6. Wait strategies - ping-pong latency, one-way
+Done        6.1. Header implementation
+Done        6.2. Lock-free ring
+Done        6.3. Single producer / single consumer ring
+Done    7. Scaling - N producers and N consumers, throughput
+Done        7.1. Lock-free ring (one shared head/tail pair)
+Done        7.2. Sharded queue (one lane per hardware thread)
+Done    8. Priority queue (8 levels)
+Done        8.1. One thread - throughput, every item on one level
+Done        8.2. One thread - throughput, items spread over all levels
+Done    9. Executor versus a thread per task
+Done        9.1. A thread spawned and joined per task
+Done        9.2. submit() and get() one task at a time
+Done        9.3. submit() a batch of tasks, then get() them all
+Done        9.4. parallelFor over an index range
+Done    10. Async queue - 10k coroutines awaiting at once
+Done        10.1. Resumed inline by the producer thread
+Done        10.2. Resumed by a thread pool scheduler
+Done        10.3. Baseline: 1k threads blocked in dequeue()
+Done    11. Between processes - 64-byte messages to a forked consumer
+Done        11.1. Shared memory queue
+Done        11.2. Baseline: socketpair, one write() and one read() per message
+Done    12. Backlog - 10M items queued, then drained, on one thread
+Done        12.1. Header implementation (a pooled node per item)
+Done        12.2. Segmented queue (arrays of 256 items)
 
 ------------------------------------------------------------------------------*/
 
@@ -130,6 +185,294 @@ struct Fixture
         }
     }
 
+    void testThroughput ( int _elementsToPush )
+    {
+        const auto start = steady_clock::now();
+
+        std::thread tConsumer( [ this, _elementsToPush ] {
+            for ( int i = 0; i < _elementsToPush; ++i )
+                m_pElements->dequeue();
+        } );
+
+        std::thread tPusher( [ this, _elementsToPush ] {
+            for ( int i = 0; i < _elementsToPush; ++i )
+                m_pElements->enqueue( m_pElement );
+        } );
+
+        tConsumer.join();
+        tPusher.join();
+
+        const auto elapsed = duration_cast< nanoseconds >(
+            steady_clock::now() - start
+        ).count();
+
+        BOOST_CHECK_EQUAL( m_pElements->count(), 0 );
+        BOOST_TEST_MESSAGE( "Elements passed: " << _elementsToPush );
+        BOOST_TEST_MESSAGE(
+            "Throughput: "
+            << static_cast< long long >(
+                _elementsToPush * 1e9 / std::max< long long >( elapsed, 1 )
+            )
+            << " elements/second"
+        );
+        BOOST_TEST_MESSAGE(
+            "Per element: " << elapsed / _elementsToPush << " nanoseconds"
+        );
+    }
+
+    /**
+     * Nobody ever waits here, so this is the cost of the fast path alone.
+     */
+    void testUncontended ( int _pairs )
+    {
+        const auto start = steady_clock::now();
+
+        for ( int i = 0; i < _pairs; ++i )
+        {
+            m_pElements->enqueue( m_pElement );
+            m_pElements->dequeue();
+        }
+
+        const auto elapsed = duration_cast< nanoseconds >(
+            steady_clock::now() - start
+        ).count();
+
+        BOOST_CHECK_EQUAL( m_pElements->count(), 0 );
+        BOOST_TEST_MESSAGE(
+            "Per enqueue/dequeue pair: " << elapsed / _pairs << " nanoseconds"
+        );
+    }
+
+    /**
+     * Fills the queue to _elementsCount before draining it, so the drain
+     * walks a backlog far bigger than the caches.
+     */
+    void testBacklog ( int _elementsCount )
+    {
+        const std::size_t heapBefore = heapInUse();
+        const auto start = steady_clock::now();
+
+        for ( int i = 0; i < _elementsCount; ++i )
+            m_pElements->enqueue( m_pElement );
+
+        const auto filled = steady_clock::now();
+        const std::size_t heapFilled = heapInUse();
+
+        for ( int i = 0; i < _elementsCount; ++i )
+            m_pElements->dequeue();
+
+        const auto drained = steady_clock::now();
+
+        BOOST_CHECK_EQUAL( m_pElements->count(), 0 );
+        BOOST_TEST_MESSAGE( "Backlog: " << _elementsCount );
+        BOOST_TEST_MESSAGE(
+                "Enqueue: "
+            <<  duration_cast< nanoseconds >( filled - start ).count()
+                    / _elementsCount
+            <<  " nanoseconds per element"
+        );
+        BOOST_TEST_MESSAGE(
+                "Dequeue: "
+            <<  duration_cast< nanoseconds >( drained - filled ).count()
+                    / _elementsCount
+            <<  " nanoseconds per element"
+        );
+        if ( heapFilled > heapBefore )
+            BOOST_TEST_MESSAGE(
+                    "Heap: "
+                <<  double( heapFilled - heapBefore ) / _elementsCount
+                <<  " bytes per element"
+            );
+    }
+
+    // Bytes handed out by malloc, 0 where the C library does not tell
+    static std::size_t heapInUse ()
+    {
+#if defined( __GLIBC__ )
+        const struct mallinfo2 info = ::mallinfo2();
+        return info.uordblks + info.hblkhd;
+#else
+        return 0;
+#endif
+    }
+
+    void testBulkThroughput ( int _elementsToPush, std::size_t _batchSize )
+    {
+        const auto start = steady_clock::now();
+
+        std::thread tConsumer( [ this, _elementsToPush, _batchSize ] {
+            std::vector< int * > batch( _batchSize );
+            for ( int popped = 0; popped < _elementsToPush; )
+                popped += m_pElements->dequeueBulk( batch.data(), _batchSize );
+        } );
+
+        std::thread tPusher( [ this, _elementsToPush, _batchSize ] {
+            std::vector< int * > batch( _batchSize, m_pElement );
+            for ( int pushed = 0; pushed < _elementsToPush; )
+            {
+                const std::size_t count = std::min< std::size_t >(
+                    _batchSize, _elementsToPush - pushed
+                );
+                m_pElements->enqueueBulk( batch.data(), count );
+                pushed += count;
+            }
+        } );
+
+        tConsumer.join();
+        tPusher.join();
+
+        const auto elapsed = duration_cast< nanoseconds >(
+            steady_clock::now() - start
+        ).count();
+
+        BOOST_CHECK_EQUAL( m_pElements->count(), 0 );
+        BOOST_TEST_MESSAGE( "Batch size: " << _batchSize );
+        BOOST_TEST_MESSAGE(
+            "Throughput: "
+            << static_cast< long long >(
+                _elementsToPush * 1e9 / std::max< long long >( elapsed, 1 )
+            )
+            << " elements/second"
+        );
+        BOOST_TEST_MESSAGE(
+            "Per element: " << elapsed / _elementsToPush << " nanoseconds"
+        );
+    }
+
+    /**
+     * Bounces one element between m_pElements and _pReplies and reports the
+     * one-way latency, i.e. half of each round trip.
+     */
+    void testPingPongLatency (
+            std::unique_ptr< IQueue< int > > _pReplies
+        ,   int _roundTrips
+    )
+    {
+        std::thread tEcho( [ this, &_pReplies, _roundTrips ] {
+            for ( int i = 0; i < _roundTrips; ++i )
+                _pReplies->enqueue( m_pElements->dequeue() );
+        } );
+
+        std::vector< long long > latencies;
+        latencies.reserve( _roundTrips );
+
+        for ( int i = 0; i < _roundTrips; ++i )
+        {
+            const auto start = steady_clock::now();
+            m_pElements->enqueue( m_pElement );
+            _pReplies->dequeue();
+            latencies.push_back(
+                duration_cast< nanoseconds >(
+                    steady_clock::now() - start
+                ).count() / 2
+            );
+        }
+
+        tEcho.join();
+
+        std::sort( latencies.begin(), latencies.end() );
+        BOOST_TEST_MESSAGE(
+                "Median: " << latencies[ latencies.size() / 2 ]
+            <<  " nanoseconds, 99th percentile: "
+            <<  latencies[ latencies.size() * 99 / 100 ] << " nanoseconds"
+        );
+    }
+
+    /**
+     * _pairs producers push _elementsPerProducer elements each while _pairs
+     * consumers drain them.
+     */
+    void testManyThreadsThroughput ( int _pairs, int _elementsPerProducer )
+    {
+        std::vector< std::thread > threads;
+
+        const auto start = steady_clock::now();
+
+        for ( int i = 0; i < _pairs; ++i )
+        {
+            threads.emplace_back( [ this, _elementsPerProducer ] {
+                for ( int j = 0; j < _elementsPerProducer; ++j )
+                    m_pElements->enqueue( m_pElement );
+            } );
+            threads.emplace_back( [ this, _elementsPerProducer ] {
+                for ( int j = 0; j < _elementsPerProducer; ++j )
+                    m_pElements->dequeue();
+            } );
+        }
+
+        for ( auto & thread: threads )
+            thread.join();
+
+        const auto elapsed = duration_cast< nanoseconds >(
+            steady_clock::now() - start
+        ).count();
+        const long long elementsCount =
+            static_cast< long long >( _pairs ) * _elementsPerProducer;
+
+        BOOST_CHECK_EQUAL( m_pElements->count(), 0 );
+        BOOST_TEST_MESSAGE(
+                "Producer/consumer pairs: " << _pairs << ", throughput: "
+            <<  static_cast< long long >(
+                    elementsCount * 1e9 / std::max< long long >( elapsed, 1 )
+                )
+            <<  " elements/second"
+        );
+    }
+
+    /**
+     * Runs testManyThreadsThroughput for a growing number of threads,
+     * _createQueue being one of the QueueFactory methods.
+     */
+    template < typename _CreatorT >
+    void testScaling ( _CreatorT _createQueue )
+    {
+        constexpr int queueSize = 1024;
+        constexpr int elementsPerProducer = 200000;
+
+        for ( int pairs: { 1, 2, 4, 8 } )
+        {
+            setQueue( _createQueue( queueSize, WaitStrategy::Block ) );
+            testManyThreadsThroughput( pairs, elementsPerProducer );
+        }
+    }
+
+    /**
+     * Runs testPingPongLatency once per wait strategy, _createQueue being
+     * one of the QueueFactory methods.
+     */
+    template < typename _CreatorT >
+    void testWaitStrategies ( _CreatorT _createQueue )
+    {
+        constexpr int queueSize = 16;
+        constexpr int roundTrips = 20000;
+
+        const std::pair< const char *, WaitStrategy > strategies[] {
+                { "Block", WaitStrategy::Block }
+            ,   { "Spin", WaitStrategy::Spin }
+            ,   { "SpinThenYield", WaitStrategy::SpinThenYield }
+            ,   { "SpinThenBlock", WaitStrategy::SpinThenBlock }
+        };
+
+        for ( const auto & strategy: strategies )
+        {
+            BOOST_TEST_MESSAGE( "Wait strategy: " << strategy.first );
+
+            // Both sides spinning on one core only hand over on preemption
+            if (    strategy.second == WaitStrategy::Spin
+                &&  std::thread::hardware_concurrency() < 2
+            )
+            {
+                BOOST_TEST_MESSAGE( "Skipped: needs two hardware threads" );
+                continue;
+            }
+
+            setQueue( _createQueue( queueSize, strategy.second ) );
+            testPingPongLatency(
+                _createQueue( queueSize, strategy.second ), roundTrips
+            );
+        }
+    }
+
     void printBenchmarks ()
     {
         auto minimumElapsed =
@@ -209,6 +552,45 @@ BOOST_AUTO_TEST_CASE( OneThreadMultipleElements__QueueSizeEqual__1_2_2 )
     printBenchmarks();
 }
 
+BOOST_AUTO_TEST_CASE( OneThreadThroughput__1_3 )
+{
+    constexpr int queueSize = 1000;
+    constexpr int elementsToPush = 1000000;
+
+    setQueue( QueueFactory::createStandardSharedQueue< int >( queueSize ) );
+
+    BOOST_TEST_MESSAGE( "Queue size: " << queueSize );
+
+    testThroughput( elementsToPush );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( OneThreadBulkThroughput__1_4 )
+{
+    constexpr int queueSize = 1000;
+    constexpr int elementsToPush = 1000000;
+    constexpr std::size_t batchSize = 128;
+
+    setQueue( QueueFactory::createStandardSharedQueue< int >( queueSize ) );
+
+    BOOST_TEST_MESSAGE( "Queue size: " << queueSize );
+
+    testBulkThroughput( elementsToPush, batchSize );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( Uncontended__1_5 )
+{
+    constexpr int queueSize = 1000;
+    constexpr int pairs = 1000000;
+
+    setQueue( QueueFactory::createStandardSharedQueue< int >( queueSize ) );
+
+    testUncontended( pairs );
+}
+
 /*----------------------------------------------------------------------------*/
 /*----------------------------------------------------------------------------*/
 /*----------------------------------------------------------------------------*/
@@ -266,6 +648,747 @@ BOOST_AUTO_TEST_CASE( PImpl__OneThreadMultipleElements__QueueSizeEqual__2_2_2 )
 
 /*----------------------------------------------------------------------------*/
 
+BOOST_AUTO_TEST_CASE( PImpl__OneThreadThroughput__2_3 )
+{
+    constexpr int queueSize = 1000;
+    constexpr int elementsToPush = 1000000;
+
+    setQueue( QueueFactory::createSharedQueueWithPImpl< int >( queueSize ) );
+
+    BOOST_TEST_MESSAGE( "Queue size: " << queueSize );
+
+    testThroughput( elementsToPush );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( PImpl__OneThreadBulkThroughput__2_4 )
+{
+    constexpr int queueSize = 1000;
+    constexpr int elementsToPush = 1000000;
+    constexpr std::size_t batchSize = 128;
+
+    setQueue( QueueFactory::createSharedQueueWithPImpl< int >( queueSize ) );
+
+    BOOST_TEST_MESSAGE( "Queue size: " << queueSize );
+
+    testBulkThroughput( elementsToPush, batchSize );
+}
+
+/*----------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( LockFree__0 )
+{
+    BOOST_TEST_MESSAGE( "\nLock-free tests" );
+}
+
+BOOST_AUTO_TEST_CASE( LockFree__MultipleThreadsOneElement__3_1 )
+{
+    constexpr int queueSize = 100;
+
+    setQueue( QueueFactory::createLockFreeQueue< int >( queueSize ) );
+
+    BOOST_TEST_MESSAGE( "Queue size: " << queueSize );
+
+    testOneElementPerThread();
+
+    printBenchmarks();
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( LockFree__OneThreadMultipleElements__QueueSizeLess__3_2_1 )
+{
+    constexpr int queueSize = 100;
+    constexpr int elementsToPush = 10000;
+
+    setQueue( QueueFactory::createLockFreeQueue< int >( queueSize ) );
+
+    testMultipleElementsPerThread( elementsToPush );
+
+    BOOST_TEST_MESSAGE( "Queue size: " << queueSize );
+    BOOST_TEST_MESSAGE( "Elements passed: " << elementsToPush );
+
+    printBenchmarks();
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( LockFree__OneThreadMultipleElements__QueueSizeEqual__3_2_2 )
+{
+    constexpr int queueSize = 10000;
+    constexpr int elementsToPush = 10000;
+
+    setQueue( QueueFactory::createLockFreeQueue< int >( queueSize ) );
+    testMultipleElementsPerThread( elementsToPush );
+
+    BOOST_TEST_MESSAGE( "Queue size: " << queueSize );
+    BOOST_TEST_MESSAGE( "Elements passed: " << elementsToPush );
+
+    printBenchmarks();
+}
+
+/*----------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( Spsc__0 )
+{
+    BOOST_TEST_MESSAGE( "\nSPSC tests" );
+}
+
+BOOST_AUTO_TEST_CASE( Spsc__MultipleThreadsOneElement__4_1 )
+{
+    constexpr int queueSize = 100;
+
+    setQueue( QueueFactory::createSpscQueue< int >( queueSize ) );
+
+    BOOST_TEST_MESSAGE( "Queue size: " << queueSize );
+
+    testOneElementPerThread();
+
+    printBenchmarks();
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( Spsc__OneThreadMultipleElements__4_2 )
+{
+    constexpr int queueSize = 100;
+    constexpr int elementsToPush = 10000;
+
+    setQueue( QueueFactory::createSpscQueue< int >( queueSize ) );
+
+    testMultipleElementsPerThread( elementsToPush );
+
+    BOOST_TEST_MESSAGE( "Queue size: " << queueSize );
+    BOOST_TEST_MESSAGE( "Elements passed: " << elementsToPush );
+
+    printBenchmarks();
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( Spsc__OneThreadThroughput__Blocking__4_3 )
+{
+    constexpr int queueSize = 1000;
+    constexpr int elementsToPush = 1000000;
+
+    setQueue( QueueFactory::createSpscQueue< int >( queueSize ) );
+
+    BOOST_TEST_MESSAGE( "Queue size: " << queueSize );
+
+    testThroughput( elementsToPush );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( Spsc__OneThreadThroughput__Spinning__4_4 )
+{
+    constexpr int queueSize = 1000;
+    constexpr int elementsToPush = 1000000;
+
+    setQueue(
+        QueueFactory::createSpscQueue< int >(
+            queueSize, WaitStrategy::SpinThenYield
+        )
+    );
+
+    BOOST_TEST_MESSAGE( "Queue size: " << queueSize );
+
+    testThroughput( elementsToPush );
+}
+
+/*----------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------*/
+
+struct Payload
+{
+    long id;
+    long values[ 3 ];
+};
+
+BOOST_AUTO_TEST_CASE( ValueQueue__0 )
+{
+    BOOST_TEST_MESSAGE( "\nValue queue tests" );
+}
+
+BOOST_AUTO_TEST_CASE( ValueQueue__OneThreadThroughput__5_1 )
+{
+    constexpr int queueSize = 1000;
+    constexpr int elementsToPush = 1000000;
+
+    auto pQueue = QueueFactory::createValueQueue< Payload >( queueSize );
+
+    const auto start = steady_clock::now();
+
+    std::thread tConsumer( [ &pQueue ] {
+        long sum = 0;
+        for ( int i = 0; i < elementsToPush; ++i )
+            sum += pQueue->dequeue().id;
+        BOOST_CHECK_EQUAL(
+            sum, 1LL * elementsToPush * ( elementsToPush - 1 ) / 2
+        );
+    } );
+
+    std::thread tPusher( [ &pQueue ] {
+        for ( int i = 0; i < elementsToPush; ++i )
+            pQueue->emplace( Payload{ i, { i, i, i } } );
+    } );
+
+    tConsumer.join();
+    tPusher.join();
+
+    const auto elapsed =
+        duration_cast< nanoseconds >( steady_clock::now() - start ).count();
+
+    BOOST_TEST_MESSAGE( "Queue size: " << queueSize );
+    BOOST_TEST_MESSAGE( "Payload size: " << sizeof( Payload ) << " bytes" );
+    BOOST_TEST_MESSAGE(
+        "Per element: " << elapsed / elementsToPush << " nanoseconds"
+    );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( ValueQueue__PointerQueueBaseline__5_2 )
+{
+    constexpr int queueSize = 1000;
+    constexpr int elementsToPush = 1000000;
+
+    auto pQueue = QueueFactory::createLockFreeQueue< Payload >( queueSize );
+
+    const auto start = steady_clock::now();
+
+    std::thread tConsumer( [ &pQueue ] {
+        long sum = 0;
+        for ( int i = 0; i < elementsToPush; ++i )
+        {
+            Payload * pPayload = pQueue->dequeue();
+            sum += pPayload->id;
+            delete pPayload;
+        }
+        BOOST_CHECK_EQUAL(
+            sum, 1LL * elementsToPush * ( elementsToPush - 1 ) / 2
+        );
+    } );
+
+    std::thread tPusher( [ &pQueue ] {
+        for ( int i = 0; i < elementsToPush; ++i )
+            pQueue->enqueue( new Payload{ i, { i, i, i } } );
+    } );
+
+    tConsumer.join();
+    tPusher.join();
+
+    const auto elapsed =
+        duration_cast< nanoseconds >( steady_clock::now() - start ).count();
+
+    BOOST_TEST_MESSAGE( "Queue size: " << queueSize );
+    BOOST_TEST_MESSAGE( "Payload size: " << sizeof( Payload ) << " bytes" );
+    BOOST_TEST_MESSAGE(
+        "Per element: " << elapsed / elementsToPush << " nanoseconds"
+    );
+}
+
+/*----------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( WaitStrategy__0 )
+{
+    BOOST_TEST_MESSAGE( "\nWait strategy tests" );
+}
+
+BOOST_AUTO_TEST_CASE( WaitStrategy__Standard__6_1 )
+{
+    testWaitStrategies( &QueueFactory::createStandardSharedQueue< int > );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( WaitStrategy__LockFree__6_2 )
+{
+    testWaitStrategies( &QueueFactory::createLockFreeQueue< int > );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( WaitStrategy__Spsc__6_3 )
+{
+    testWaitStrategies( &QueueFactory::createSpscQueue< int > );
+}
+
+/*----------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( Scaling__0 )
+{
+    BOOST_TEST_MESSAGE(
+            "\nScaling tests, hardware threads: "
+        <<  std::thread::hardware_concurrency()
+    );
+}
+
+BOOST_AUTO_TEST_CASE( Scaling__LockFree__7_1 )
+{
+    testScaling( &QueueFactory::createLockFreeQueue< int > );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( Scaling__Sharded__7_2 )
+{
+    testScaling( [] ( std::size_t _size, WaitStrategy _waitStrategy ) {
+        return QueueFactory::createShardedQueue< int >( _size, _waitStrategy );
+    } );
+}
+
+/*----------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( Priority__0 )
+{
+    BOOST_TEST_MESSAGE( "\nPriority queue tests" );
+}
+
+BOOST_AUTO_TEST_CASE( Priority__OneThreadThroughput__8_1 )
+{
+    constexpr int queueSize = 1000;
+    constexpr int levelCount = 8;
+    constexpr int elementsToPush = 1000000;
+
+    setQueue(
+        QueueFactory::createPriorityQueue< int >( queueSize, levelCount )
+    );
+
+    BOOST_TEST_MESSAGE( "Queue size: " << queueSize );
+    testThroughput( elementsToPush );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( Priority__OneThreadThroughput__AllLevels__8_2 )
+{
+    constexpr int queueSize = 1000;
+    constexpr std::size_t levelCount = 8;
+    constexpr int elementsToPush = 1000000;
+
+    auto pQueue =
+        QueueFactory::createPriorityQueue< int >( queueSize, levelCount );
+
+    const auto start = steady_clock::now();
+
+    std::thread tConsumer( [ &pQueue ] {
+        for ( int i = 0; i < elementsToPush; ++i )
+            pQueue->dequeue();
+    } );
+
+    std::thread tPusher( [ this, &pQueue ] {
+        for ( int i = 0; i < elementsToPush; ++i )
+            pQueue->enqueue( m_pElement, Priority{ i % levelCount } );
+    } );
+
+    tConsumer.join();
+    tPusher.join();
+
+    const auto elapsed =
+        duration_cast< nanoseconds >( steady_clock::now() - start ).count();
+
+    BOOST_CHECK_EQUAL( pQueue->count(), 0 );
+    BOOST_TEST_MESSAGE( "Queue size: " << queueSize );
+    BOOST_TEST_MESSAGE(
+        "Per element: " << elapsed / elementsToPush << " nanoseconds"
+    );
+}
+
+/*----------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( Executor__0 )
+{
+    BOOST_TEST_MESSAGE( "\nExecutor tests" );
+}
+
+BOOST_AUTO_TEST_CASE( Executor__ThreadPerTask__9_1 )
+{
+    constexpr int tasksCount = 10000;
+
+    std::atomic< int > sum( 0 );
+
+    const auto start = steady_clock::now();
+
+    for ( int i = 0; i < tasksCount; ++i )
+    {
+        std::thread tTask( [ &sum, i ] { sum += i; } );
+        tTask.join();
+    }
+
+    const auto elapsed =
+        duration_cast< nanoseconds >( steady_clock::now() - start ).count();
+
+    BOOST_CHECK_EQUAL( sum.load(), tasksCount * ( tasksCount - 1 ) / 2 );
+    BOOST_TEST_MESSAGE(
+        "Per task: " << elapsed / tasksCount << " nanoseconds"
+    );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( Executor__SubmitAndGet__9_2 )
+{
+    constexpr int tasksCount = 100000;
+
+    Executor executor(
+        QueueFactory::createStandardSharedQueue< ExecutorTask >( 1024 )
+    );
+
+    int sum = 0;
+
+    const auto start = steady_clock::now();
+
+    for ( int i = 0; i < tasksCount; ++i )
+        sum += executor.submit( [ i ] { return i % 2; } ).get();
+
+    const auto elapsed =
+        duration_cast< nanoseconds >( steady_clock::now() - start ).count();
+
+    BOOST_CHECK_EQUAL( sum, tasksCount / 2 );
+    BOOST_TEST_MESSAGE( "Workers: " << executor.threadCount() );
+    BOOST_TEST_MESSAGE(
+        "Per task: " << elapsed / tasksCount << " nanoseconds"
+    );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( Executor__SubmitBatch__9_3 )
+{
+    constexpr int tasksCount = 100000;
+
+    Executor executor(
+        QueueFactory::createLockFreeQueue< ExecutorTask >( tasksCount )
+    );
+
+    std::vector< Future< int > > futures;
+    futures.reserve( tasksCount );
+
+    const auto start = steady_clock::now();
+
+    for ( int i = 0; i < tasksCount; ++i )
+        futures.push_back( executor.submit( [ i ] { return i % 2; } ) );
+
+    int sum = 0;
+    for ( auto & future: futures )
+        sum += future.get();
+
+    const auto elapsed =
+        duration_cast< nanoseconds >( steady_clock::now() - start ).count();
+
+    BOOST_CHECK_EQUAL( sum, tasksCount / 2 );
+    BOOST_TEST_MESSAGE( "Workers: " << executor.threadCount() );
+    BOOST_TEST_MESSAGE(
+        "Per task: " << elapsed / tasksCount << " nanoseconds"
+    );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( Executor__ParallelFor__9_4 )
+{
+    constexpr std::size_t indicesCount = 10000000;
+
+    Executor executor(
+        QueueFactory::createStandardSharedQueue< ExecutorTask >( 1024 )
+    );
+
+    std::vector< int > values( indicesCount );
+
+    const auto start = steady_clock::now();
+
+    executor.parallelFor( 0, indicesCount, [ &values ] ( std::size_t _i ) {
+        values[ _i ] = static_cast< int >( _i % 3 );
+    } );
+
+    const auto elapsed =
+        duration_cast< nanoseconds >( steady_clock::now() - start ).count();
+
+    BOOST_CHECK_EQUAL(
+            std::accumulate( values.begin(), values.end(), 0LL )
+        ,   static_cast< long long >( indicesCount / 3 * 3 )
+    );
+    BOOST_TEST_MESSAGE( "Workers: " << executor.threadCount() );
+    BOOST_TEST_MESSAGE(
+        "Per index: " << elapsed * 1.0 / indicesCount << " nanoseconds"
+    );
+}
+
+/*----------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------*/
+
+DetachedTask awaitItems (
+        AsyncQueue< int > & _rQueue
+    ,   int _count
+    ,   std::atomic< int > & _rConsumed
+    ,   CoroutineScheduler * _pScheduler
+)
+{
+    for ( int i = 0; i < _count; ++i )
+    {
+        if ( _pScheduler )
+            co_await _rQueue.asyncDequeue( *_pScheduler );
+        else
+            co_await _rQueue.asyncDequeue();
+
+        _rConsumed.fetch_add( 1, std::memory_order_relaxed );
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Every consumer is parked before the first item goes in, so each enqueue
+// is a handoff to a suspended coroutine
+void testAwaitingConsumers ( CoroutineScheduler * _pScheduler )
+{
+    constexpr int consumersCount = 10000;
+    constexpr int itemsPerConsumer = 20;
+    constexpr int itemsCount = consumersCount * itemsPerConsumer;
+
+    auto pQueue = QueueFactory::createAsyncQueue< int >( 1024 );
+    int element = 1;
+    std::atomic< int > consumed( 0 );
+
+    ManualScheduler starter;
+    for ( int i = 0; i < consumersCount; ++i )
+        awaitItems( *pQueue, itemsPerConsumer, consumed, _pScheduler )
+            .spawn( starter );
+    starter.run();
+
+    const auto start = steady_clock::now();
+
+    for ( int i = 0; i < itemsCount; ++i )
+        pQueue->enqueue( &element );
+
+    while ( consumed.load() < itemsCount )
+        std::this_thread::yield();
+
+    const auto elapsed =
+        duration_cast< nanoseconds >( steady_clock::now() - start ).count();
+
+    BOOST_CHECK_EQUAL( pQueue->count(), 0 );
+    BOOST_TEST_MESSAGE( "Awaiting consumers: " << consumersCount );
+    BOOST_TEST_MESSAGE(
+        "Per item: " << elapsed / itemsCount << " nanoseconds"
+    );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( Coroutine__0 )
+{
+    BOOST_TEST_MESSAGE( "\nAsync queue tests" );
+}
+
+BOOST_AUTO_TEST_CASE( Coroutine__ResumedInline__10_1 )
+{
+    testAwaitingConsumers( nullptr );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( Coroutine__ResumedOnThreadPool__10_2 )
+{
+    ThreadPoolScheduler scheduler;
+    testAwaitingConsumers( &scheduler );
+    BOOST_TEST_MESSAGE( "Scheduler threads: " << scheduler.threadCount() );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( Coroutine__BlockedThreadsBaseline__10_3 )
+{
+    constexpr int consumersCount = 1000;
+    constexpr int itemsPerConsumer = 20;
+    constexpr int itemsCount = consumersCount * itemsPerConsumer;
+
+    auto pQueue = QueueFactory::createAsyncQueue< int >( 1024 );
+    int element = 1;
+
+    std::vector< std::thread > consumers;
+    consumers.reserve( consumersCount );
+    for ( int i = 0; i < consumersCount; ++i )
+        consumers.emplace_back( [ &pQueue ] {
+            for ( int j = 0; j < itemsPerConsumer; ++j )
+                pQueue->dequeue();
+        } );
+
+    // Let them all go to sleep
+    std::this_thread::sleep_for( milliseconds( 500 ) );
+
+    const auto start = steady_clock::now();
+
+    for ( int i = 0; i < itemsCount; ++i )
+        pQueue->enqueue( &element );
+
+    for ( auto & consumer: consumers )
+        consumer.join();
+
+    const auto elapsed =
+        duration_cast< nanoseconds >( steady_clock::now() - start ).count();
+
+    BOOST_CHECK_EQUAL( pQueue->count(), 0 );
+    BOOST_TEST_MESSAGE( "Blocked consumer threads: " << consumersCount );
+    BOOST_TEST_MESSAGE(
+        "Per item: " << elapsed / itemsCount << " nanoseconds"
+    );
+}
+
+/*----------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------*/
+
+#if defined( __linux__ )
+
+struct Message
+{
+    std::int64_t sequence;
+    char payload[ 56 ];
+};
+
+constexpr int g_messagesCount = 1000000;
+
+/*----------------------------------------------------------------------------*/
+
+// The child only reads; the parent times everything up to the child's exit
+template < typename _SendT, typename _ReceiveT >
+void testBetweenProcesses ( _SendT _send, _ReceiveT _receive )
+{
+    const auto start = steady_clock::now();
+
+    const pid_t child = ::fork();
+    if ( child == 0 )
+    {
+        std::int64_t expected = 0;
+        for ( int i = 0; i < g_messagesCount; ++i )
+            if ( _receive().sequence != expected++ )
+                ::_exit( 1 );
+        ::_exit( 0 );
+    }
+    BOOST_REQUIRE( child > 0 );
+
+    for ( int i = 0; i < g_messagesCount; ++i )
+        _send( Message{ i, "" } );
+
+    int status = 0;
+    ::waitpid( child, &status, 0 );
+
+    const auto elapsed =
+        duration_cast< nanoseconds >( steady_clock::now() - start ).count();
+
+    BOOST_CHECK( WIFEXITED( status ) && WEXITSTATUS( status ) == 0 );
+    BOOST_TEST_MESSAGE(
+        "Per message: " << elapsed / g_messagesCount << " nanoseconds"
+    );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( Processes__0 )
+{
+    BOOST_TEST_MESSAGE( "\nBetween processes tests" );
+}
+
+BOOST_AUTO_TEST_CASE( Processes__ShmQueue__11_1 )
+{
+    const std::string name =
+        "/shared-queue-benchmark-" + std::to_string( ::getpid() );
+    auto pQueue = QueueFactory::createShmQueue< Message >( name, 1024 );
+
+    // The child inherits the mapping, so it needs no attach
+    testBetweenProcesses(
+            [ &pQueue ] ( const Message & _message ) {
+                pQueue->enqueue( _message );
+            }
+        ,   [ &pQueue ] () { return pQueue->dequeue(); }
+    );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( Processes__SocketPair__11_2 )
+{
+    int sockets[ 2 ];
+    BOOST_REQUIRE_EQUAL(
+        ::socketpair( AF_UNIX, SOCK_STREAM, 0, sockets ), 0
+    );
+
+    testBetweenProcesses(
+            [ &sockets ] ( const Message & _message ) {
+                BOOST_REQUIRE_EQUAL(
+                        ::write( sockets[ 0 ], &_message, sizeof( _message ) )
+                    ,   ssize_t( sizeof( _message ) )
+                );
+            }
+        ,   [ &sockets ] () {
+                Message message;
+                char * pBytes = reinterpret_cast< char * >( &message );
+                for ( std::size_t got = 0; got < sizeof( message ); )
+                {
+                    const ssize_t read = ::read(
+                        sockets[ 1 ], pBytes + got, sizeof( message ) - got
+                    );
+                    if ( read <= 0 )
+                        ::_exit( 1 );
+                    got += static_cast< std::size_t >( read );
+                }
+                return message;
+            }
+    );
+
+    ::close( sockets[ 0 ] );
+    ::close( sockets[ 1 ] );
+}
+
+#endif
+
+/*----------------------------------------------------------------------------*/
+
+/*----------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( Backlog__0 )
+{
+    BOOST_TEST_MESSAGE( "\nBacklog tests" );
+}
+
+BOOST_AUTO_TEST_CASE( Backlog__Standard__12_1 )
+{
+    constexpr int elementsCount = 10000000;
+
+    setQueue( QueueFactory::createStandardSharedQueue< int >( elementsCount ) );
+    testBacklog( elementsCount );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( Backlog__Segmented__12_2 )
+{
+    constexpr int elementsCount = 10000000;
+
+    setQueue( QueueFactory::createSegmentedQueue< int >( elementsCount ) );
+    testBacklog( elementsCount );
+}
+
+/*----------------------------------------------------------------------------*/
+
 BOOST_AUTO_TEST_SUITE_END()
 
 /*----------------------------------------------------------------------------*/
@@ -4,23 +4,338 @@
 #include "utilities.hpp"
 
 #include "QueueFactory.h"
+#include "impl/Executor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <stdexcept>
+
+#if defined( __linux__ )
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 /*----------------------------------------------------------------------------*/
 /*-----------------------------------------------------------------------------
 Test plan:
 
 Not done    1. Data correctness
+Done            1.1. A one-slot lock-free ring tells full from free
 Done        2. Enqueue timeout
 Done        3. Dequeue timeout
+Done            3.1. Every queue returns nullptr when the timeout expires
+Done        4. Bulk enqueue/dequeue
+Done            4.1. Blocking bulk through a smaller queue keeps FIFO order
+Done            4.2. Try/timed bulk variants stop at capacity/emptiness
+Done            4.3. Linger returns on a full batch or on the deadline
+Done            4.4. Try bulk calls among many threads move every item once
+Done            4.5. Bulk calls longer than a chunk keep FIFO order
+Done        5. Value queue
+Done            5.1. Move-only values and emplace keep FIFO order
+Done            5.2. Timed and try operations
+Done            5.3. Values left in the queue are destroyed with it
+Done            5.4. A one-slot queue tells full from free
+Done        6. Wait strategies
+Done            6.1. Every queue keeps FIFO order under every strategy
+Done            6.2. Every strategy honours timeouts
+Done            6.3. A cancelled event count waiter hands back its wakeup
+Done        7. Sharded queue
+Done            7.1. Every item comes out exactly once under every strategy
+Done            7.2. Producers spill into other lanes up to the capacity
+Done            7.3. Items that fit in the home lane keep FIFO order
+Done        8. Priority queue (also runs 3.1, 4.x and 6.x at its lowest level)
+Done            8.1. Urgent items overtake, FIFO holds within each level
+Done            8.2. Bulk dequeue drains levels in priority order
+Done            8.3. A blocked urgent producer overtakes once room frees up
+Done        9. Work-stealing deque
+Done            9.1. Owner pops the newest item, thieves steal the oldest
+Done            9.2. Growing keeps every item in place
+Done        10. Executor
+Done            10.1. Futures carry values from every queue kind
+Done            10.2. Exceptions reach get() and parallelFor's caller
+Done            10.3. Shutdown runs nested submissions before stopping
+Done            10.4. parallelFor visits every index once, also nested
+Done            10.5. Submitting after shutdown throws, parallelFor runs inline
+Done        11. Async queue (also runs 3.1, 4.x and 6.x through IQueue)
+Done            11.1. Parked consumers get items in FIFO order, resumed inline
+Done            11.2. Parked producers refill the queue as it drains
+Done            11.3. Awaiters given a scheduler are resumed by it only
+Done            11.4. Coroutines and threads on a thread pool, every item once
+Done        12. Eventfd queue
+Done            12.1. A burst of enqueues signals the descriptor once
+Done            12.2. A partial drain keeps the descriptor readable
+Done            12.3. An epoll loop receives every item, in order per producer
+Done        13. Shared memory queue
+Done            13.1. Create/attach, FIFO and timeouts, header and name checks
+Done            13.2. Forked producers, every message in order per producer
+Done            13.3. Forked consumers report back through a second queue
+Done            13.4. A spinning side still wakes a peer that blocks
+Done        14. Runtime capacity
+Done            14.1. Growing wakes a blocked producer, fixed rings refuse
+Done            14.2. Shrinking below count() blocks producers until drained
+Done            14.3. Auto-growth absorbs a burst up to the ceiling only
+Done            14.4. Resizing under traffic keeps every item, in order
+Done        15. Segmented queue (also runs 3.1, 4.x, 6.x and 14.x)
+Done            15.1. Batches spanning several segments keep FIFO order
+Done            15.2. A huge bound allocates nothing up front
+Done        16. Statistics (all zero unless built with SHAREDQUEUE_STATS)
+Done            16.1. Counters follow traffic, waits and timeouts
+Done            16.2. Counts from many threads add up exactly
+Done        17. Close
+Done            17.1. A closed queue refuses items and drains what it holds
+Done            17.2. Closing wakes every blocked producer and consumer
+Done            17.3. Under traffic every accepted item is dequeued once
+Done            17.4. Parked coroutines resume with the closed result
+Done            17.5. A closed eventfd queue's descriptor stays readable
+Done            17.6. isClosed() tells a timed dequeue's timeout from closure
+Done        18. Try operations
+Done            18.1. Fail at once on a full/empty/closed queue, never wait
+Done            18.2. Successful tries wake blocked threads
+Done            18.3. Priority tryEnqueue honours levels, eventfd signals
+Done        19. Drain all
+Done            19.1. drainAll() appends every item in order, clear() drops them
+Done            19.2. Draining wakes every blocked producer
+Done            19.3. Splicing moves the items in order, past the capacity too
+Done            19.4. A million-item queue clears and tears down
+Done        20. Select
+Done            20.1. Priority and round-robin orders, waitAny() takes nothing
+Done            20.2. A blocked select wakes for whichever queue gets an item
+Done            20.3. Select ends only once every queue is closed and drained
+Done            20.4. Many producers and selecting consumers, every item once
+Done        21. Delay queue
+Done            21.1. Items come out by readyAt, FIFO among equal ones
+Done            21.2. Consumers sleep until the earliest readyAt, earlier wakes
+Done            21.3. Close keeps pending items, drainAll() takes them in order
+Done            21.4. Many producers and consumers, every item once, none early
+Done            21.5. A million pending timers come out in order
 
 ------------------------------------------------------------------------------*/
 
 /*----------------------------------------------------------------------------*/
 
+using QueueCreator =
+    std::unique_ptr< IQueue< int > > ( * ) ( std::size_t, WaitStrategy );
+
+const std::vector< std::pair< const char *, QueueCreator > > g_queueCreators {
+        { "standard", &QueueFactory::createStandardSharedQueue< int > }
+    ,   { "pimpl", &QueueFactory::createSharedQueueWithPImpl< int > }
+    ,   { "lock-free", &QueueFactory::createLockFreeQueue< int > }
+    ,   { "spsc", &QueueFactory::createSpscQueue< int > }
+    ,   { "segmented", &QueueFactory::createSegmentedQueue< int > }
+    ,   {
+                "priority"
+            ,   [] ( std::size_t _size, WaitStrategy _waitStrategy )
+                    -> std::unique_ptr< IQueue< int > >
+                {
+                    return QueueFactory::createPriorityQueue< int >(
+                        _size, 4, _waitStrategy
+                    );
+                }
+        }
+    ,   {
+                "async"
+            ,   [] ( std::size_t _size, WaitStrategy _waitStrategy )
+                    -> std::unique_ptr< IQueue< int > >
+                {
+                    return QueueFactory::createAsyncQueue< int >(
+                        _size, _waitStrategy
+                    );
+                }
+        }
+};
+
+const std::vector< std::pair< const char *, WaitStrategy > > g_waitStrategies {
+        { "block", WaitStrategy::Block }
+    ,   { "spin", WaitStrategy::Spin }
+    ,   { "spin-then-yield", WaitStrategy::SpinThenYield }
+    ,   { "spin-then-block", WaitStrategy::SpinThenBlock }
+};
+
+/*----------------------------------------------------------------------------*/
+
+// g_queueCreators and the sharded queue, which only keeps FIFO order per lane
+std::vector< std::pair< const char *, QueueCreator > > allQueueCreators ()
+{
+    auto queueCreators = g_queueCreators;
+    queueCreators.push_back( {
+            "sharded"
+        ,   [] ( std::size_t _size, WaitStrategy _waitStrategy )
+                -> std::unique_ptr< IQueue< int > >
+            {
+                return QueueFactory::createShardedQueue< int >(
+                    _size, _waitStrategy
+                );
+            }
+    } );
+    return queueCreators;
+}
+
+/*----------------------------------------------------------------------------*/
+
+DetachedTask asyncConsume (
+        AsyncQueue< int > & _rQueue
+    ,   int _count
+    ,   std::vector< int * > & _rReceived
+    ,   CoroutineScheduler * _pScheduler = nullptr
+    ,   std::atomic< int > * _pFinished = nullptr
+)
+{
+    for ( int i = 0; i < _count; ++i )
+    {
+        int * pValue;
+        if ( _pScheduler )
+            pValue = co_await _rQueue.asyncDequeue( *_pScheduler );
+        else
+            pValue = co_await _rQueue.asyncDequeue();
+
+        _rReceived.push_back( pValue );
+    }
+
+    if ( _pFinished )
+        ++*_pFinished;
+}
+
+/*----------------------------------------------------------------------------*/
+
+DetachedTask asyncProduce (
+        AsyncQueue< int > & _rQueue
+    ,   int * _pFirst
+    ,   int _count
+    ,   bool & _rDone
+)
+{
+    for ( int i = 0; i < _count; ++i )
+        co_await _rQueue.asyncEnqueue( _pFirst + i );
+    _rDone = true;
+}
+
+/*----------------------------------------------------------------------------*/
+
+// DetachedTask terminates on an escaping exception, so QueueClosed is caught
+DetachedTask asyncEnqueueUnlessClosed (
+        AsyncQueue< int > & _rQueue
+    ,   int * _pValue
+    ,   bool & _rClosed
+)
+{
+    try
+    {
+        co_await _rQueue.asyncEnqueue( _pValue );
+    }
+    catch ( const QueueClosed & )
+    {
+        _rClosed = true;
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+#if defined( __linux__ )
+
+bool isReadable ( int _fd )
+{
+    pollfd pollFd { _fd, POLLIN, 0 };
+    return ::poll( &pollFd, 1, 0 ) == 1 && ( pollFd.revents & POLLIN );
+}
+
+/*----------------------------------------------------------------------------*/
+
+struct Message
+{
+    int producer;
+    int sequence;
+    char payload[ 56 ];
+};
+
+// A name no other test run can be using
+std::string shmName ( const char * _test )
+{
+    return
+            std::string( "/shared-queue-test-" ) + _test + "-"
+        +   std::to_string( ::getpid() )
+    ;
+}
+
+/**
+ * @brief Runs _body in a forked child, which exits with 0 if it returned
+ *        true and with 1 otherwise (or if it threw).
+ */
+template < typename _BodyT >
+pid_t forkChild ( _BodyT _body )
+{
+    const pid_t pid = ::fork();
+    if ( pid == 0 )
+    {
+        bool succeeded = false;
+        try
+        {
+            succeeded = _body();
+        }
+        catch ( ... )
+        {
+        }
+        ::_exit( succeeded ? 0 : 1 );
+    }
+    return pid;
+}
+
+bool exitedCleanly ( pid_t _pid )
+{
+    int status = 0;
+    return
+            ::waitpid( _pid, &status, 0 ) == _pid
+        &&  WIFEXITED( status )
+        &&  WEXITSTATUS( status ) == 0
+    ;
+}
+
+#endif
+
+/*----------------------------------------------------------------------------*/
+
 BOOST_AUTO_TEST_SUITE( Test )
 
 /*----------------------------------------------------------------------------*/
 
+BOOST_AUTO_TEST_CASE( LockFreeSingleSlot_1_1 )
+{
+    constexpr int elementsCount = 10000;
+
+    auto pQueue = QueueFactory::createLockFreeQueue< int >( 1 );
+
+    std::vector< int > elements( elementsCount );
+    std::iota( elements.begin(), elements.end(), 0 );
+
+    // A published value must not pass for a slot free for the next lap
+    pQueue->enqueue( &elements[ 0 ] );
+    BOOST_CHECK( !pQueue->enqueue( &elements[ 1 ], 100 ) );
+    BOOST_CHECK_EQUAL( pQueue->count(), 1 );
+
+    BOOST_CHECK_EQUAL( pQueue->dequeue( 100 ), &elements[ 0 ] );
+    BOOST_CHECK( pQueue->dequeue( 100 ) == nullptr );
+
+    // Every item goes through the one slot, in order
+    std::thread producer( [ & ] {
+        for ( int & element: elements )
+            pQueue->enqueue( &element );
+    } );
+
+    int misorderedCount = 0;
+    for ( int & element: elements )
+        if ( pQueue->dequeue() != &element )
+            ++misorderedCount;
+
+    producer.join();
+
+    BOOST_CHECK_EQUAL( misorderedCount, 0 );
+    BOOST_CHECK_EQUAL( pQueue->count(), 0 );
+}
+
+/*----------------------------------------------------------------------------*/
+
 BOOST_AUTO_TEST_CASE( EnqueueTimeout_2 )
 {
     auto elements = QueueFactory::createStandardSharedQueue< int >( 10 );
@@ -95,4 +410,2935 @@ BOOST_AUTO_TEST_CASE( DequeueTimeout_3 )
 
 /*----------------------------------------------------------------------------*/
 
-BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
+BOOST_AUTO_TEST_CASE( DequeueTimeoutReturnsNull_3_1 )
+{
+    for ( const auto & creator: g_queueCreators )
+    {
+        BOOST_TEST_CONTEXT( creator.first )
+        {
+            auto pQueue = creator.second( 10, WaitStrategy::Block );
+
+            BOOST_CHECK( pQueue->dequeue( 10 ) == nullptr );
+
+            int value = 7;
+            pQueue->enqueue( &value );
+            BOOST_CHECK( pQueue->dequeue( 10 ) == &value );
+            BOOST_CHECK( pQueue->dequeue( 10 ) == nullptr );
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( BulkKeepsOrder_4_1 )
+{
+    constexpr int queueSize = 10;
+    constexpr int elementsCount = 1000;
+    constexpr std::size_t batchSize = 64;
+
+    for ( const auto & creator: g_queueCreators )
+    {
+        BOOST_TEST_CONTEXT( creator.first )
+        {
+            auto pQueue = creator.second( queueSize, WaitStrategy::Block );
+
+            std::vector< int > numbers( elementsCount );
+            std::vector< int * > pNumbers;
+            for ( int i = 0; i < elementsCount; ++i )
+            {
+                numbers[ i ] = i;
+                pNumbers.push_back( &numbers[ i ] );
+            }
+
+            std::thread tPush( [ & ] {
+                pQueue->enqueueBulk( pNumbers.data(), pNumbers.size() );
+            } );
+
+            std::vector< int > popped;
+            int * batch[ batchSize ];
+            while ( popped.size() < elementsCount )
+            {
+                const std::size_t got = pQueue->dequeueBulk( batch, batchSize );
+                BOOST_CHECK( got > 0 && got <= queueSize );
+                for ( std::size_t i = 0; i < got; ++i )
+                    popped.push_back( *batch[ i ] );
+            }
+
+            tPush.join();
+
+            BOOST_CHECK_EQUAL( pQueue->count(), 0 );
+            BOOST_CHECK( popped == numbers );
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( BulkTryAndTimeout_4_2 )
+{
+    constexpr int queueSize = 10;
+
+    for ( const auto & creator: g_queueCreators )
+    {
+        BOOST_TEST_CONTEXT( creator.first )
+        {
+            auto pQueue = creator.second( queueSize, WaitStrategy::Block );
+
+            int numbers[ 15 ] = {};
+            int * pNumbers[ 15 ];
+            for ( int i = 0; i < 15; ++i )
+                pNumbers[ i ] = &numbers[ i ];
+
+            int * batch[ 20 ];
+            BOOST_CHECK_EQUAL( pQueue->tryDequeueBulk( batch, 20 ), 0u );
+            BOOST_CHECK_EQUAL( pQueue->dequeueBulk( batch, 20, 50 ), 0u );
+
+            BOOST_CHECK_EQUAL( pQueue->tryEnqueueBulk( pNumbers, 15 ), 10u );
+            BOOST_CHECK_EQUAL( pQueue->count(), queueSize );
+            BOOST_CHECK_EQUAL( pQueue->enqueueBulk( pNumbers, 5, 50 ), 0u );
+
+            BOOST_CHECK_EQUAL( pQueue->tryDequeueBulk( batch, 4 ), 4u );
+            BOOST_CHECK_EQUAL( pQueue->enqueueBulk( pNumbers, 5, 50 ), 4u );
+            BOOST_CHECK_EQUAL( pQueue->dequeueBulk( batch, 20, 50 ), 10u );
+            BOOST_CHECK_EQUAL( pQueue->count(), 0 );
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( BulkLinger_4_3 )
+{
+    using namespace std::chrono;
+
+    constexpr int queueSize = 100;
+
+    for ( const auto & creator: g_queueCreators )
+    {
+        BOOST_TEST_CONTEXT( creator.first )
+        {
+            auto pQueue = creator.second( queueSize, WaitStrategy::Block );
+
+            int numbers[ 8 ] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+            int * batch[ 8 ];
+
+            // Deadline first: only 3 items ever arrive
+            for ( int i = 0; i < 3; ++i )
+                pQueue->enqueue( &numbers[ i ] );
+
+            auto start = steady_clock::now();
+            BOOST_CHECK_EQUAL( pQueue->dequeueBulkLinger( batch, 8, 100 ), 3u );
+            BOOST_CHECK( steady_clock::now() - start >= milliseconds( 100 ) );
+
+            // Full batch first: items trickle in well before the deadline
+            std::thread tPush( [ & ] {
+                for ( int i = 0; i < 8; ++i )
+                {
+                    std::this_thread::sleep_for( milliseconds( 5 ) );
+                    pQueue->enqueue( &numbers[ i ] );
+                }
+            } );
+
+            start = steady_clock::now();
+            BOOST_CHECK_EQUAL(
+                pQueue->dequeueBulkLinger( batch, 8, 5000 ), 8u
+            );
+            BOOST_CHECK( steady_clock::now() - start < milliseconds( 5000 ) );
+            for ( int i = 0; i < 8; ++i )
+                BOOST_CHECK_EQUAL( *batch[ i ], i );
+
+            tPush.join();
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( LockFreeTryBulkUnderContention_4_4 )
+{
+    constexpr int queueSize = 4;
+    constexpr int threadsCount = 4;
+    constexpr int elementsPerThread = 20000;
+    constexpr std::size_t batchSize = 3;
+
+    auto pQueue = QueueFactory::createLockFreeQueue< int >( queueSize );
+
+    std::vector< int > numbers( threadsCount * elementsPerThread );
+    std::iota( numbers.begin(), numbers.end(), 0 );
+
+    // Bulk and single calls mix, so runs are cut short by slots that other
+    // threads hold; a try call skips those rather than waiting for them
+    std::vector< std::thread > producers;
+    for ( int t = 0; t < threadsCount; ++t )
+        producers.emplace_back( [ &, t ] {
+            int * pNext = &numbers[ t * elementsPerThread ];
+            int * const pEnd = pNext + elementsPerThread;
+            int * batch[ batchSize ];
+            while ( pNext != pEnd )
+            {
+                std::size_t put;
+                if ( ( pEnd - pNext ) % 2 )
+                    put = pQueue->tryEnqueue( pNext ) ? 1 : 0;
+                else
+                {
+                    const std::size_t count = std::min< std::size_t >(
+                        batchSize, pEnd - pNext
+                    );
+                    for ( std::size_t i = 0; i < count; ++i )
+                        batch[ i ] = pNext + i;
+                    put = pQueue->tryEnqueueBulk( batch, count );
+                }
+
+                if ( put == 0 )
+                    std::this_thread::yield();
+                pNext += put;
+            }
+        } );
+
+    std::vector< std::atomic< int > > seen( numbers.size() );
+    std::atomic< int > dequeuedCount( 0 );
+    std::vector< std::thread > consumers;
+    for ( int t = 0; t < threadsCount; ++t )
+        consumers.emplace_back( [ &, t ] {
+            int * batch[ batchSize ];
+            while ( dequeuedCount.load() < int( numbers.size() ) )
+            {
+                std::size_t got;
+                if ( t % 2 )
+                    got = pQueue->tryDequeueBulk( batch, batchSize );
+                else
+                    got = ( batch[ 0 ] = pQueue->tryDequeue() ) ? 1 : 0;
+
+                if ( got == 0 )
+                    std::this_thread::yield();
+                for ( std::size_t i = 0; i < got; ++i )
+                    ++seen[ *batch[ i ] ];
+                dequeuedCount += int( got );
+            }
+        } );
+
+    for ( auto & producer: producers )
+        producer.join();
+    for ( auto & consumer: consumers )
+        consumer.join();
+
+    BOOST_CHECK_EQUAL( pQueue->count(), 0 );
+    BOOST_CHECK(
+        std::all_of( seen.begin(), seen.end(),
+            [] ( const std::atomic< int > & _seen ) { return _seen == 1; }
+        )
+    );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( LongBulkKeepsOrder_4_5 )
+{
+    // Longer than the chunks some queues hand their bulk calls over in
+    constexpr int elementsCount = 300;
+
+    for ( const auto & creator: g_queueCreators )
+    {
+        BOOST_TEST_CONTEXT( creator.first )
+        {
+            auto pQueue = creator.second( elementsCount, WaitStrategy::Block );
+
+            std::vector< int > numbers( elementsCount );
+            std::iota( numbers.begin(), numbers.end(), 0 );
+
+            std::vector< int * > pNumbers;
+            for ( int & number: numbers )
+                pNumbers.push_back( &number );
+
+            BOOST_CHECK_EQUAL(
+                    pQueue->tryEnqueueBulk( pNumbers.data(), elementsCount )
+                ,   elementsCount
+            );
+
+            std::vector< int * > batch( elementsCount );
+            BOOST_CHECK_EQUAL(
+                    pQueue->dequeueBulk( batch.data(), elementsCount, 100 )
+                ,   elementsCount
+            );
+            BOOST_CHECK( batch == pNumbers );
+
+            BOOST_CHECK_EQUAL(
+                    pQueue->enqueueBulk( pNumbers.data(), elementsCount, 100 )
+                ,   elementsCount
+            );
+            BOOST_CHECK_EQUAL(
+                    pQueue->tryDequeueBulk( batch.data(), elementsCount )
+                ,   elementsCount
+            );
+            BOOST_CHECK( batch == pNumbers );
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( ValueQueueMoveOnly_5_1 )
+{
+    constexpr int elementsCount = 1000;
+
+    auto pQueue =
+        QueueFactory::createValueQueue< std::unique_ptr< int > >( 10 );
+
+    std::thread tPush( [ &pQueue ] {
+        for ( int i = 0; i < elementsCount; ++i )
+        {
+            if ( i % 2 )
+                pQueue->enqueue( std::make_unique< int >( i ) );
+            else
+                pQueue->emplace( new int{ i } );
+        }
+    } );
+
+    for ( int i = 0; i < elementsCount; ++i )
+    {
+        auto pElem = pQueue->dequeue();
+        BOOST_REQUIRE( pElem );
+        BOOST_CHECK_EQUAL( *pElem, i );
+    }
+
+    tPush.join();
+
+    BOOST_CHECK_EQUAL( pQueue->count(), 0 );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( ValueQueueTimeout_5_2 )
+{
+    struct Payload
+    {
+        long id;
+        double values[ 3 ];
+    };
+
+    auto pQueue = QueueFactory::createValueQueue< Payload >( 2 );
+
+    BOOST_CHECK( !pQueue->dequeue( 50 ) );
+    BOOST_CHECK( !pQueue->tryDequeue() );
+
+    const Payload payload{ 7, { 1.0, 2.0, 3.0 } };
+    BOOST_CHECK( pQueue->enqueue( payload, 50 ) );
+    BOOST_CHECK( pQueue->tryEnqueue( Payload{ 8, {} } ) );
+    BOOST_CHECK( !pQueue->enqueue( payload, 50 ) );
+    BOOST_CHECK( !pQueue->tryEnqueue( Payload{ 9, {} } ) );
+    BOOST_CHECK_EQUAL( pQueue->count(), 2 );
+
+    const auto first = pQueue->dequeue( 50 );
+    BOOST_REQUIRE( first );
+    BOOST_CHECK_EQUAL( first->id, 7 );
+    BOOST_CHECK_EQUAL( first->values[ 2 ], 3.0 );
+
+    const auto second = pQueue->tryDequeue();
+    BOOST_REQUIRE( second );
+    BOOST_CHECK_EQUAL( second->id, 8 );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( ValueQueueDestroysLeftovers_5_3 )
+{
+    auto pCounter = std::make_shared< int >( 0 );
+
+    {
+        auto pQueue =
+            QueueFactory::createValueQueue< std::shared_ptr< int > >( 10 );
+
+        for ( int i = 0; i < 5; ++i )
+            pQueue->enqueue( pCounter );
+        pQueue->dequeue();
+
+        BOOST_CHECK_EQUAL( pCounter.use_count(), 5 );
+    }
+
+    BOOST_CHECK_EQUAL( pCounter.use_count(), 1 );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( ValueQueueSingleSlot_5_4 )
+{
+    constexpr int elementsCount = 10000;
+
+    auto pQueue = QueueFactory::createValueQueue< int >( 1 );
+
+    // A published value must not pass for a slot free for the next lap
+    pQueue->enqueue( 0 );
+    BOOST_CHECK( !pQueue->tryEnqueue( 1 ) );
+    BOOST_CHECK_EQUAL( pQueue->count(), 1 );
+
+    const auto first = pQueue->tryDequeue();
+    BOOST_REQUIRE( first );
+    BOOST_CHECK_EQUAL( *first, 0 );
+    BOOST_CHECK( !pQueue->tryDequeue() );
+
+    // Every value goes through the one slot, in order
+    std::thread tPush( [ &pQueue ] {
+        for ( int i = 0; i < elementsCount; ++i )
+            pQueue->enqueue( i );
+    } );
+
+    int misorderedCount = 0;
+    for ( int i = 0; i < elementsCount; ++i )
+        if ( pQueue->dequeue() != i )
+            ++misorderedCount;
+
+    tPush.join();
+
+    BOOST_CHECK_EQUAL( misorderedCount, 0 );
+    BOOST_CHECK_EQUAL( pQueue->count(), 0 );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( WaitStrategiesKeepOrder_6_1 )
+{
+    // Small: with fewer cores than threads a pure spin hands over only once
+    // the scheduler preempts the spinning side
+    constexpr int queueSize = 16;
+    constexpr int elementsCount = 2000;
+
+    std::vector< int > elements( elementsCount );
+    std::iota( elements.begin(), elements.end(), 0 );
+
+    for ( const auto & creator: g_queueCreators )
+    {
+        for ( const auto & strategy: g_waitStrategies )
+        {
+            BOOST_TEST_CONTEXT( creator.first << ", " << strategy.first )
+            {
+                auto pQueue = creator.second( queueSize, strategy.second );
+
+                std::thread tPush( [ & ] {
+                    for ( int & element: elements )
+                        pQueue->enqueue( &element );
+                } );
+
+                bool inOrder = true;
+                for ( int i = 0; i < elementsCount; ++i )
+                    inOrder &= *pQueue->dequeue() == i;
+
+                tPush.join();
+
+                BOOST_CHECK( inOrder );
+                BOOST_CHECK_EQUAL( pQueue->count(), 0 );
+            }
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( WaitStrategiesTimeout_6_2 )
+{
+    using namespace std::chrono;
+
+    constexpr int timeout = 20;
+
+    for ( const auto & creator: g_queueCreators )
+    {
+        for ( const auto & strategy: g_waitStrategies )
+        {
+            BOOST_TEST_CONTEXT( creator.first << ", " << strategy.first )
+            {
+                auto pQueue = creator.second( 1, strategy.second );
+                int value = 1;
+
+                const auto start = steady_clock::now();
+                BOOST_CHECK( pQueue->dequeue( timeout ) == nullptr );
+                BOOST_CHECK( steady_clock::now() - start
+                    >= milliseconds( timeout )
+                );
+
+                BOOST_CHECK( pQueue->enqueue( &value, timeout ) );
+                BOOST_CHECK( !pQueue->enqueue( &value, timeout ) );
+                BOOST_CHECK( pQueue->dequeue( timeout ) == &value );
+            }
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( EventCountCancelHandsWakeupBack_6_3 )
+{
+    using namespace std::chrono;
+
+    // W1 registers and is counted by a notify; W2 registers with the moved
+    // epoch; W1 then takes its item without sleeping. The wakeup W1 was
+    // counted for must not stay charged to W2, or the next notify is skipped
+    const auto countedThenCancelled = [] (
+            EventCount & _rEvent
+        ,   bool _timedOut
+    ) {
+        const EventCount::Key key1 = _rEvent.prepareWait();
+        _rEvent.notifyOne();
+        const EventCount::Key key2 = _rEvent.prepareWait();
+
+        // The timed way out notices the notify that came before it
+        if ( _timedOut )
+            BOOST_CHECK(
+                _rEvent.waitUntil( key1, EventCount::Clock::now() )
+            );
+        else
+            _rEvent.cancelWait( key1 );
+
+        return key2;
+    };
+
+    for ( bool timedOut: { false, true } )
+    {
+        BOOST_TEST_CONTEXT( ( timedOut ? "waitUntil" : "cancelWait" ) )
+        {
+            // notifyOne() and notifyAll() both reach W2
+            {
+                EventCount event;
+                const EventCount::Key key2 =
+                    countedThenCancelled( event, timedOut );
+                event.notifyOne();
+                BOOST_CHECK(
+                    event.waitUntil( key2, EventCount::Clock::now() )
+                );
+            }
+            {
+                EventCount event;
+                const EventCount::Key key2 =
+                    countedThenCancelled( event, timedOut );
+                event.notifyAll();
+                BOOST_CHECK(
+                    event.waitUntil( key2, EventCount::Clock::now() )
+                );
+            }
+
+            // W2 actually asleep on the futex is woken
+            {
+                EventCount event;
+                const EventCount::Key key2 =
+                    countedThenCancelled( event, timedOut );
+
+                bool woken = false;
+                std::thread sleeper( [ & ] {
+                    woken = event.waitUntil(
+                        key2, EventCount::Clock::now() + seconds( 5 )
+                    );
+                } );
+
+                std::this_thread::sleep_for( milliseconds( 10 ) );
+                event.notifyOne();
+                sleeper.join();
+
+                BOOST_CHECK( woken );
+            }
+
+            // Once both have left, a new waiter starts with nothing counted
+            {
+                EventCount event;
+                event.cancelWait( countedThenCancelled( event, timedOut ) );
+
+                const EventCount::Key key3 = event.prepareWait();
+                event.notifyOne();
+                BOOST_CHECK(
+                    event.waitUntil( key3, EventCount::Clock::now() )
+                );
+            }
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( ShardedDeliversOnce_7_1 )
+{
+    constexpr int queueSize = 16;
+    constexpr std::size_t laneCount = 4;
+    constexpr int producersCount = 4;
+    constexpr int consumersCount = 3;
+    constexpr int elementsPerProducer = 1000;
+    constexpr int elementsCount = producersCount * elementsPerProducer;
+
+    std::vector< int > elements( elementsCount );
+    std::iota( elements.begin(), elements.end(), 0 );
+
+    for ( const auto & strategy: g_waitStrategies )
+    {
+        BOOST_TEST_CONTEXT( strategy.first )
+        {
+            auto pQueue = QueueFactory::createShardedQueue< int >(
+                queueSize, strategy.second, laneCount
+            );
+
+            std::vector< std::atomic< int > > seenCounts( elementsCount );
+            std::atomic< int > poppedCount( 0 );
+
+            std::vector< std::thread > threads;
+            for ( int i = 0; i < producersCount; ++i )
+                threads.emplace_back( [ &, i ] {
+                    for ( int j = 0; j < elementsPerProducer; ++j )
+                        pQueue->enqueue(
+                            &elements[ i * elementsPerProducer + j ]
+                        );
+                } );
+
+            for ( int i = 0; i < consumersCount; ++i )
+                threads.emplace_back( [ & ] {
+                    while ( poppedCount.fetch_add( 1 ) < elementsCount )
+                        ++seenCounts[ *pQueue->dequeue() ];
+                } );
+
+            for ( auto & thread: threads )
+                thread.join();
+
+            BOOST_CHECK(
+                std::all_of(
+                    seenCounts.begin(), seenCounts.end(),
+                    [] ( const std::atomic< int > & _count ) {
+                        return _count == 1;
+                    }
+                )
+            );
+            BOOST_CHECK_EQUAL( pQueue->count(), 0 );
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( ShardedSpillsUpToCapacity_7_2 )
+{
+    constexpr int queueSize = 10;
+    constexpr std::size_t laneCount = 4;
+
+    auto pQueue = QueueFactory::createShardedQueue< int >(
+        queueSize, WaitStrategy::Block, laneCount
+    );
+
+    std::vector< int > numbers( 2 * queueSize );
+    std::vector< int * > pNumbers;
+    for ( int & number: numbers )
+        pNumbers.push_back( &number );
+
+    BOOST_CHECK_EQUAL(
+            pQueue->tryEnqueueBulk( pNumbers.data(), pNumbers.size() )
+        ,   queueSize
+    );
+    BOOST_CHECK_EQUAL( pQueue->count(), queueSize );
+    BOOST_CHECK( !pQueue->enqueue( pNumbers.back(), 10 ) );
+
+    BOOST_CHECK_EQUAL(
+            pQueue->tryDequeueBulk( pNumbers.data(), pNumbers.size() )
+        ,   queueSize
+    );
+    BOOST_CHECK_EQUAL( pQueue->count(), 0 );
+    BOOST_CHECK( pQueue->dequeue( 10 ) == nullptr );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( ShardedHomeLaneKeepsOrder_7_3 )
+{
+    constexpr int queueSize = 1000;
+    constexpr std::size_t laneCount = 4;
+    constexpr int elementsCount = queueSize / laneCount;
+
+    auto pQueue = QueueFactory::createShardedQueue< int >(
+        queueSize, WaitStrategy::Block, laneCount
+    );
+
+    std::vector< int > elements( elementsCount );
+    std::iota( elements.begin(), elements.end(), 0 );
+
+    std::thread tPush( [ & ] {
+        for ( int & element: elements )
+            pQueue->enqueue( &element );
+    } );
+    tPush.join();
+
+    // Whichever lane the consumer calls home, it steals the producer's lane
+    // from its head
+    bool inOrder = true;
+    for ( int i = 0; i < elementsCount; ++i )
+        inOrder &= *pQueue->dequeue() == i;
+
+    BOOST_CHECK( inOrder );
+    BOOST_CHECK_EQUAL( pQueue->count(), 0 );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( PriorityOvertakes_8_1 )
+{
+    constexpr int levelCount = 3;
+    constexpr int perLevel = 5;
+
+    auto pQueue = QueueFactory::createPriorityQueue< int >(
+        levelCount * perLevel, levelCount
+    );
+
+    // Values tell the level: 0-4 lowest, 10-14 middle, 20-24 most urgent
+    std::vector< int > values;
+    for ( int i = 0; i < perLevel; ++i )
+        for ( int level = 0; level < levelCount; ++level )
+            values.push_back( ( levelCount - 1 - level ) * 10 + i );
+
+    for ( int & value: values )
+    {
+        if ( value < 10 )
+            pQueue->enqueue( &value ); // plain enqueue: lowest priority
+        else
+            pQueue->enqueue(
+                &value, static_cast< Priority >( 2 - value / 10 )
+            );
+    }
+
+    BOOST_CHECK_EQUAL( pQueue->count(), levelCount * perLevel );
+
+    std::vector< int > popped;
+    while ( pQueue->count() > 0 )
+        popped.push_back( *pQueue->dequeue() );
+
+    const std::vector< int > expected {
+            20, 21, 22, 23, 24
+        ,   10, 11, 12, 13, 14
+        ,   0, 1, 2, 3, 4
+    };
+    BOOST_CHECK( popped == expected );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( PriorityBulkDequeue_8_2 )
+{
+    auto pQueue = QueueFactory::createPriorityQueue< int >( 10, 2 );
+
+    int low[ 3 ] { 0, 1, 2 };
+    int high[ 2 ] { 10, 11 };
+    int * pLow[ 3 ] { &low[ 0 ], &low[ 1 ], &low[ 2 ] };
+
+    BOOST_CHECK_EQUAL( pQueue->tryEnqueueBulk( pLow, 3 ), 3u );
+    pQueue->enqueue( &high[ 0 ], Priority::Highest );
+
+    // Past the last level: clamped to the lowest priority
+    int clamped = 3;
+    BOOST_CHECK( pQueue->enqueue( &clamped, Priority{ 7 }, 10 ) );
+    pQueue->enqueue( &high[ 1 ], Priority::Highest );
+
+    int * batch[ 4 ];
+    BOOST_CHECK_EQUAL( pQueue->tryDequeueBulk( batch, 4 ), 4u );
+    BOOST_CHECK_EQUAL( *batch[ 0 ], 10 );
+    BOOST_CHECK_EQUAL( *batch[ 1 ], 11 );
+    BOOST_CHECK_EQUAL( *batch[ 2 ], 0 );
+    BOOST_CHECK_EQUAL( *batch[ 3 ], 1 );
+
+    BOOST_CHECK_EQUAL( pQueue->dequeueBulk( batch, 4, 10 ), 2u );
+    BOOST_CHECK_EQUAL( *batch[ 0 ], 2 );
+    BOOST_CHECK_EQUAL( *batch[ 1 ], 3 );
+    BOOST_CHECK_EQUAL( pQueue->count(), 0 );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( PriorityBlockedProducer_8_3 )
+{
+    constexpr int queueSize = 4;
+
+    auto pQueue = QueueFactory::createPriorityQueue< int >( queueSize, 2 );
+
+    std::vector< int > bulk( queueSize );
+    std::iota( bulk.begin(), bulk.end(), 0 );
+    int urgent = 100;
+
+    for ( int & value: bulk )
+        pQueue->enqueue( &value );
+
+    std::thread tPush( [ & ] {
+        pQueue->enqueue( &urgent, Priority::Highest );
+    } );
+
+    sleep_for( 50 );
+    BOOST_CHECK_EQUAL( pQueue->count(), queueSize );
+    BOOST_CHECK_EQUAL( *pQueue->dequeue(), 0 );
+
+    tPush.join();
+
+    BOOST_CHECK_EQUAL( *pQueue->dequeue(), urgent );
+    for ( int i = 1; i < queueSize; ++i )
+        BOOST_CHECK_EQUAL( *pQueue->dequeue( 10 ), i );
+    BOOST_CHECK( pQueue->dequeue( 10 ) == nullptr );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( WorkStealingEnds_9_1 )
+{
+    auto pDeque = QueueFactory::createWorkStealingDeque< int >( 8 );
+
+    std::vector< int > tasks( 4 );
+    std::iota( tasks.begin(), tasks.end(), 0 );
+
+    BOOST_CHECK( pDeque->pop() == nullptr );
+    BOOST_CHECK( pDeque->steal() == nullptr );
+
+    for ( int & task: tasks )
+        pDeque->push( &task );
+    BOOST_CHECK_EQUAL( pDeque->size(), 4u );
+
+    int * pStolen = nullptr;
+    std::thread tThief( [ & ] { pStolen = pDeque->steal(); } );
+    tThief.join();
+
+    BOOST_CHECK( pStolen == &tasks[ 0 ] );
+    BOOST_CHECK( pDeque->pop() == &tasks[ 3 ] );
+    BOOST_CHECK( pDeque->steal() == &tasks[ 1 ] );
+    BOOST_CHECK( pDeque->pop() == &tasks[ 2 ] );
+    BOOST_CHECK( pDeque->pop() == nullptr );
+    BOOST_CHECK( pDeque->empty() );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( WorkStealingGrowth_9_2 )
+{
+    constexpr int tasksCount = 100;
+
+    auto pDeque = QueueFactory::createWorkStealingDeque< int >( 3 );
+    BOOST_CHECK_EQUAL( pDeque->capacity(), 4u );
+
+    std::vector< int > tasks( tasksCount );
+    std::iota( tasks.begin(), tasks.end(), 0 );
+
+    // Leave the indices off zero so the copy has to wrap around
+    pDeque->push( &tasks[ 0 ] );
+    pDeque->push( &tasks[ 1 ] );
+    BOOST_CHECK( pDeque->steal() == &tasks[ 0 ] );
+
+    for ( int i = 2; i < tasksCount; ++i )
+        pDeque->push( &tasks[ i ] );
+
+    BOOST_CHECK_EQUAL( pDeque->size(), std::size_t( tasksCount - 1 ) );
+    BOOST_CHECK( pDeque->capacity() >= std::size_t( tasksCount - 1 ) );
+
+    bool inOrder = true;
+    for ( int i = 1; i < tasksCount; ++i )
+        inOrder &= pDeque->steal() == &tasks[ i ];
+
+    BOOST_CHECK( inOrder );
+    BOOST_CHECK( pDeque->empty() );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( ExecutorFutures_10_1 )
+{
+    using TaskQueueCreator = std::unique_ptr< Executor::TaskQueue > ( * ) (
+        std::size_t, WaitStrategy
+    );
+
+    const std::pair< const char *, TaskQueueCreator > creators[] {
+            {
+                    "standard"
+                ,   &QueueFactory::createStandardSharedQueue< ExecutorTask >
+            }
+        ,   { "lock-free", &QueueFactory::createLockFreeQueue< ExecutorTask > }
+        ,   {
+                    "sharded"
+                ,   [] ( std::size_t _size, WaitStrategy _waitStrategy )
+                    {
+                        return QueueFactory::createShardedQueue< ExecutorTask >(
+                            _size, _waitStrategy
+                        );
+                    }
+            }
+    };
+
+    for ( const auto & creator: creators )
+    {
+        BOOST_TEST_CONTEXT( creator.first )
+        {
+            Executor executor( creator.second( 8, WaitStrategy::Block ), 3 );
+            BOOST_CHECK_EQUAL( executor.threadCount(), 3u );
+
+            std::vector< Future< int > > futures;
+            for ( int i = 0; i < 100; ++i )
+                futures.push_back( executor.submit( [ i ] { return i * i; } ) );
+
+            std::atomic< int > sideEffect( 0 );
+            Future< void > done = executor.submit( [ &sideEffect ] {
+                sideEffect = 1;
+            } );
+
+            bool allRight = true;
+            for ( int i = 0; i < 100; ++i )
+            {
+                allRight &= futures[ i ].valid();
+                allRight &= futures[ i ].get() == i * i;
+                allRight &= !futures[ i ].valid();
+            }
+            BOOST_CHECK( allRight );
+
+            BOOST_CHECK( done.wait( 1000 ) );
+            BOOST_CHECK( done.ready() );
+            done.get();
+            BOOST_CHECK_EQUAL( sideEffect.load(), 1 );
+
+            // Dropping a Future without waiting must not leak nor crash
+            executor.submit( [] { return std::vector< int >( 10 ); } );
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( ExecutorExceptions_10_2 )
+{
+    Executor executor(
+        QueueFactory::createStandardSharedQueue< ExecutorTask >( 16 ), 2
+    );
+
+    auto failing = executor.submit( [] () -> int {
+        throw std::runtime_error( "task failed" );
+    } );
+    BOOST_CHECK_THROW( failing.get(), std::runtime_error );
+
+    BOOST_CHECK_THROW(
+        executor.parallelFor( 0, 100, [] ( std::size_t _i ) {
+            if ( _i == 42 )
+                throw std::out_of_range( "index 42" );
+        } ),
+        std::out_of_range
+    );
+
+    // The pool still works afterwards
+    BOOST_CHECK_EQUAL( executor.submit( [] { return 7; } ).get(), 7 );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( ExecutorDrainsOnShutdown_10_3 )
+{
+    constexpr int parentsCount = 50;
+    constexpr int childrenCount = 20;
+
+    std::atomic< int > ran( 0 );
+    {
+        Executor executor(
+            QueueFactory::createLockFreeQueue< ExecutorTask >( 4096 ), 2
+        );
+
+        for ( int i = 0; i < parentsCount; ++i )
+            executor.submit( [ & ] {
+                std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+                for ( int j = 0; j < childrenCount; ++j )
+                    executor.submit( [ & ] { ++ran; } );
+                ++ran;
+            } );
+
+        executor.shutdown();
+        BOOST_CHECK_EQUAL( ran.load(), parentsCount * ( childrenCount + 1 ) );
+
+        executor.shutdown(); // and again from the destructor
+    }
+    BOOST_CHECK_EQUAL( ran.load(), parentsCount * ( childrenCount + 1 ) );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( ExecutorParallelFor_10_4 )
+{
+    constexpr std::size_t outerCount = 8;
+    constexpr std::size_t innerCount = 1000;
+
+    Executor executor(
+        QueueFactory::createStandardSharedQueue< ExecutorTask >( 64 ), 3
+    );
+
+    std::vector< std::atomic< int > > visits( outerCount * innerCount );
+
+    executor.parallelFor( 0, visits.size(), [ & ] ( std::size_t _i ) {
+        ++visits[ _i ];
+    } );
+    BOOST_CHECK(
+        std::all_of( visits.begin(), visits.end(),
+            [] ( const std::atomic< int > & _count ) { return _count == 1; }
+        )
+    );
+
+    // Every worker blocks in an inner loop: that must not deadlock
+    executor.parallelFor( 0, outerCount, [ & ] ( std::size_t _outer ) {
+        executor.parallelFor(
+                _outer * innerCount
+            ,   ( _outer + 1 ) * innerCount
+            ,   [ & ] ( std::size_t _i ) { ++visits[ _i ]; }
+            ,   16
+        );
+    }, 1 );
+    BOOST_CHECK(
+        std::all_of( visits.begin(), visits.end(),
+            [] ( const std::atomic< int > & _count ) { return _count == 2; }
+        )
+    );
+
+    executor.parallelFor( 5, 5, [] ( std::size_t ) { BOOST_FAIL( "empty" ); } );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( ExecutorAfterShutdown_10_5 )
+{
+    std::atomic< int > ran( 0 );
+    {
+        Executor executor(
+            QueueFactory::createStandardSharedQueue< ExecutorTask >( 16 ), 2
+        );
+        executor.submit( [ & ] { ++ran; } );
+        executor.shutdown();
+        BOOST_CHECK_EQUAL( ran.load(), 1 );
+
+        BOOST_CHECK_THROW(
+            executor.submit( [ & ] { ++ran; } ), QueueClosed
+        );
+
+        // No helper gets in, so the caller visits every index itself
+        std::vector< int > visits( 100 );
+        executor.parallelFor( 0, visits.size(), [ & ] ( std::size_t _i ) {
+            ++visits[ _i ];
+        }, 10 );
+        BOOST_CHECK(
+            std::all_of( visits.begin(), visits.end(),
+                [] ( int _count ) { return _count == 1; }
+            )
+        );
+    }
+
+    // The refused task neither ran nor kept the destructor waiting
+    BOOST_CHECK_EQUAL( ran.load(), 1 );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( AsyncHandsOffToParkedConsumers_11_1 )
+{
+    constexpr int consumersCount = 3;
+
+    auto pQueue = QueueFactory::createAsyncQueue< int >( 10 );
+    ManualScheduler scheduler;
+
+    std::vector< std::vector< int * > > received( consumersCount );
+    for ( auto & rReceived: received )
+        asyncConsume( *pQueue, 1, rReceived ).spawn( scheduler );
+
+    BOOST_CHECK_EQUAL( scheduler.run(), std::size_t( consumersCount ) );
+    BOOST_CHECK_EQUAL( pQueue->count(), 0 );
+
+    std::vector< int > values( consumersCount + 1 );
+    std::iota( values.begin(), values.end(), 0 );
+    for ( int & value: values )
+        pQueue->enqueue( &value );
+
+    // Handed over directly, not through the ring
+    for ( int i = 0; i < consumersCount; ++i )
+    {
+        BOOST_REQUIRE_EQUAL( received[ i ].size(), 1u );
+        BOOST_CHECK( received[ i ][ 0 ] == &values[ i ] );
+    }
+    BOOST_CHECK_EQUAL( pQueue->count(), 1 );
+
+    // With an item ready the awaiter does not suspend
+    std::vector< int * > late;
+    asyncConsume( *pQueue, 1, late ).spawn( scheduler );
+    scheduler.run();
+    BOOST_REQUIRE_EQUAL( late.size(), 1u );
+    BOOST_CHECK( late[ 0 ] == &values[ consumersCount ] );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( AsyncParksProducers_11_2 )
+{
+    constexpr int queueSize = 2;
+    constexpr int valuesCount = 7;
+
+    auto pQueue = QueueFactory::createAsyncQueue< int >( queueSize );
+    ManualScheduler scheduler;
+
+    std::vector< int > values( valuesCount );
+    std::iota( values.begin(), values.end(), 0 );
+
+    bool done = false;
+    asyncProduce( *pQueue, values.data(), valuesCount, done )
+        .spawn( scheduler );
+    scheduler.run();
+
+    BOOST_CHECK( !done );
+    BOOST_CHECK_EQUAL( pQueue->count(), queueSize );
+
+    // Every dequeue lets the parked producer put one more item in
+    bool inOrder = true;
+    for ( int i = 0; i < valuesCount - queueSize; ++i )
+    {
+        inOrder &= pQueue->dequeue() == &values[ i ];
+        inOrder &= pQueue->count() == queueSize;
+    }
+    BOOST_CHECK( inOrder );
+    BOOST_CHECK( done );
+
+    int * batch[ queueSize ];
+    BOOST_CHECK_EQUAL(
+        pQueue->tryDequeueBulk( batch, queueSize ), std::size_t( queueSize )
+    );
+    BOOST_CHECK( batch[ 0 ] == &values[ valuesCount - 2 ] );
+    BOOST_CHECK( batch[ 1 ] == &values[ valuesCount - 1 ] );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( AsyncResumesOnScheduler_11_3 )
+{
+    auto pQueue = QueueFactory::createAsyncQueue< int >( 4 );
+    ManualScheduler scheduler;
+
+    std::vector< int * > received;
+    asyncConsume( *pQueue, 2, received, &scheduler ).spawn( scheduler );
+    scheduler.run();
+
+    int values[] = { 1, 2 };
+    pQueue->enqueue( &values[ 0 ] );
+
+    // Handed the item, but left to the scheduler to resume
+    BOOST_CHECK( received.empty() );
+    BOOST_CHECK_EQUAL( pQueue->count(), 0 );
+
+    BOOST_CHECK_EQUAL( scheduler.run(), 1u );
+    BOOST_REQUIRE_EQUAL( received.size(), 1u );
+    BOOST_CHECK( received[ 0 ] == &values[ 0 ] );
+
+    pQueue->enqueue( &values[ 1 ] );
+    scheduler.run();
+    BOOST_REQUIRE_EQUAL( received.size(), 2u );
+    BOOST_CHECK( received[ 1 ] == &values[ 1 ] );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( AsyncOnThreadPool_11_4 )
+{
+    constexpr int coroutinesCount = 100;
+    constexpr int valuesPerCoroutine = 100;
+    constexpr int valuesCount = coroutinesCount * valuesPerCoroutine;
+
+    auto pQueue = QueueFactory::createAsyncQueue< int >( 16 );
+
+    std::vector< int > values( 2 * valuesCount );
+    std::iota( values.begin(), values.end(), 0 );
+
+    std::vector< std::vector< int * > > received( coroutinesCount );
+    std::vector< int * > threadReceived;
+    std::unique_ptr< bool[] > done( new bool[ coroutinesCount ]() );
+    std::atomic< int > finished( 0 );
+    {
+        ThreadPoolScheduler scheduler( 3 );
+        BOOST_CHECK_EQUAL( scheduler.threadCount(), 3u );
+
+        // Coroutine consumers for the first half, a thread for the second
+        for ( int i = 0; i < coroutinesCount; ++i )
+            asyncConsume(
+                    *pQueue
+                ,   valuesPerCoroutine
+                ,   received[ i ]
+                ,   &scheduler
+                ,   &finished
+            ).spawn( scheduler );
+
+        std::thread tPop( [ & ] {
+            threadReceived.resize( valuesCount );
+            for ( std::size_t got = 0; got < threadReceived.size(); )
+                got += pQueue->dequeueBulk(
+                    threadReceived.data() + got, threadReceived.size() - got
+                );
+        } );
+
+        // Coroutine producers for one half, a thread for the other
+        for ( int i = 0; i < coroutinesCount; ++i )
+            asyncProduce(
+                    *pQueue
+                ,   &values[ i * valuesPerCoroutine ]
+                ,   valuesPerCoroutine
+                ,   done[ i ]
+            ).spawn( scheduler );
+
+        for ( int i = valuesCount; i < 2 * valuesCount; ++i )
+            pQueue->enqueue( &values[ i ] );
+
+        tPop.join();
+
+        // Whatever the thread did not take is for the coroutines; wait for
+        // them before the scheduler stops
+        while ( finished.load() < coroutinesCount )
+            std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+    }
+
+    BOOST_CHECK( std::all_of( done.get(), done.get() + coroutinesCount,
+        [] ( bool _done ) { return _done; }
+    ) );
+
+    std::vector< int > seen( values.size(), 0 );
+    for ( const auto & rReceived: received )
+        for ( int * pValue: rReceived )
+            ++seen[ *pValue ];
+    for ( int * pValue: threadReceived )
+        ++seen[ *pValue ];
+
+    BOOST_CHECK( std::all_of( seen.begin(), seen.end(),
+        [] ( int _seen ) { return _seen == 1; }
+    ) );
+    BOOST_CHECK_EQUAL( pQueue->count(), 0 );
+}
+
+/*----------------------------------------------------------------------------*/
+
+#if defined( __linux__ )
+
+BOOST_AUTO_TEST_CASE( EventFdSignalsOnce_12_1 )
+{
+    auto pQueue = QueueFactory::createEventFdQueue< int >(
+        QueueFactory::createStandardSharedQueue< int >( 100 )
+    );
+
+    std::vector< int > values( 50 );
+    std::iota( values.begin(), values.end(), 0 );
+    std::vector< int * > pointers;
+    for ( int & value: values )
+        pointers.push_back( &value );
+
+    BOOST_CHECK( !isReadable( pQueue->fd() ) );
+    BOOST_CHECK( pQueue->tryDequeue() == nullptr );
+
+    for ( int i = 0; i < 25; ++i )
+        pQueue->enqueue( pointers[ i ] );
+    pQueue->enqueueBulk( pointers.data() + 25, 25 );
+
+    // The eventfd counter tells how many times it was written to
+    std::uint64_t writes = 0;
+    BOOST_REQUIRE_EQUAL( ::read( pQueue->fd(), &writes, sizeof( writes ) ), 8 );
+    BOOST_CHECK_EQUAL( writes, 1u );
+
+    int * batch[ 50 ];
+    BOOST_CHECK_EQUAL( pQueue->tryDequeueBulk( batch, 50 ), 50u );
+    BOOST_CHECK( std::equal( batch, batch + 50, pointers.begin() ) );
+    BOOST_CHECK( !isReadable( pQueue->fd() ) );
+
+    // Empty again, so the next enqueue signals again
+    pQueue->enqueue( pointers[ 0 ] );
+    BOOST_CHECK( isReadable( pQueue->fd() ) );
+    BOOST_CHECK( pQueue->tryDequeue() == pointers[ 0 ] );
+    BOOST_CHECK( !isReadable( pQueue->fd() ) );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( EventFdPartialDrain_12_2 )
+{
+    auto pQueue = QueueFactory::createEventFdQueue< int >(
+        QueueFactory::createLockFreeQueue< int >( 16 )
+    );
+
+    std::vector< int > values( 10 );
+    std::iota( values.begin(), values.end(), 0 );
+    for ( int & value: values )
+        pQueue->enqueue( &value );
+
+    int * batch[ 4 ];
+    BOOST_CHECK_EQUAL( pQueue->tryDequeueBulk( batch, 4 ), 4u );
+    BOOST_CHECK( isReadable( pQueue->fd() ) );
+
+    BOOST_CHECK( pQueue->tryDequeue() == &values[ 4 ] );
+    BOOST_CHECK( isReadable( pQueue->fd() ) );
+
+    BOOST_CHECK_EQUAL( pQueue->tryDequeueBulk( batch, 4 ), 4u );
+    BOOST_CHECK( pQueue->tryDequeue() == &values[ 9 ] );
+    BOOST_CHECK( !isReadable( pQueue->fd() ) );
+
+    // Blocking calls still work through the wrapper
+    pQueue->enqueue( &values[ 0 ] );
+    BOOST_CHECK( pQueue->dequeue( 10 ) == &values[ 0 ] );
+    BOOST_CHECK( pQueue->dequeue( 10 ) == nullptr );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( EventFdEpollLoop_12_3 )
+{
+    constexpr int producersCount = 3;
+    constexpr int valuesPerProducer = 20000;
+    constexpr std::size_t batchSize = 32;
+
+    for ( const auto & creator: g_queueCreators )
+    {
+        if ( std::string( creator.first ) == "spsc" )
+            continue; // several producers
+
+        BOOST_TEST_CONTEXT( creator.first )
+        {
+            auto pQueue = QueueFactory::createEventFdQueue< int >(
+                creator.second( 64, WaitStrategy::Block )
+            );
+
+            const int epollFd = ::epoll_create1( EPOLL_CLOEXEC );
+            BOOST_REQUIRE( epollFd >= 0 );
+
+            epoll_event event {};
+            event.events = EPOLLIN;
+            event.data.fd = pQueue->fd();
+            BOOST_REQUIRE_EQUAL(
+                ::epoll_ctl( epollFd, EPOLL_CTL_ADD, pQueue->fd(), &event ), 0
+            );
+
+            // Producer p sends p * valuesPerProducer + i, in order
+            std::vector< int > values( producersCount * valuesPerProducer );
+            std::iota( values.begin(), values.end(), 0 );
+
+            std::vector< std::thread > producers;
+            for ( int p = 0; p < producersCount; ++p )
+                producers.emplace_back( [ &, p ] {
+                    for ( int i = 0; i < valuesPerProducer; ++i )
+                        pQueue->enqueue( &values[ p * valuesPerProducer + i ] );
+                } );
+
+            std::vector< int > next( producersCount, 0 );
+            bool inOrder = true;
+            int received = 0;
+            int wakeups = 0;
+
+            while ( received < int( values.size() ) )
+            {
+                epoll_event ready;
+                const int readyCount = ::epoll_wait( epollFd, &ready, 1, 5000 );
+                BOOST_REQUIRE_EQUAL( readyCount, 1 );
+                ++wakeups;
+
+                int * batch[ batchSize ];
+                const std::size_t got =
+                    pQueue->tryDequeueBulk( batch, batchSize );
+
+                for ( std::size_t i = 0; i < got; ++i )
+                {
+                    const int producer = *batch[ i ] / valuesPerProducer;
+                    inOrder &=
+                        *batch[ i ] % valuesPerProducer == next[ producer ]++;
+                }
+                received += static_cast< int >( got );
+            }
+
+            for ( auto & producer: producers )
+                producer.join();
+
+            BOOST_CHECK( inOrder );
+            BOOST_CHECK( pQueue->tryDequeue() == nullptr );
+            BOOST_CHECK( !isReadable( pQueue->fd() ) );
+            BOOST_TEST_MESSAGE(
+                creator.first << ": " << wakeups << " wakeups for "
+                << received << " items"
+            );
+
+            ::close( epollFd );
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( ShmCreateAndAttach_13_1 )
+{
+    const std::string name = shmName( "13_1" );
+    {
+        auto pCreated = QueueFactory::createShmQueue< Message >( name, 4 );
+        auto pAttached = QueueFactory::attachShmQueue< Message >( name );
+
+        BOOST_CHECK_EQUAL( pAttached->capacity(), 4u );
+        BOOST_CHECK( !pAttached->tryDequeue() );
+        BOOST_CHECK( !pAttached->dequeue( 10 ) );
+
+        for ( int i = 0; i < 4; ++i )
+            BOOST_CHECK( pCreated->tryEnqueue( Message{ 0, i, "abc" } ) );
+        BOOST_CHECK( !pCreated->tryEnqueue( Message{ 0, 4, "" } ) );
+        BOOST_CHECK( !pCreated->enqueue( Message{ 0, 4, "" }, 10 ) );
+        BOOST_CHECK_EQUAL( pAttached->count(), 4 );
+
+        bool inOrder = true;
+        for ( int i = 0; i < 4; ++i )
+        {
+            const Message message = pAttached->dequeue();
+            inOrder &= message.sequence == i;
+            inOrder &= std::string( message.payload ) == "abc";
+        }
+        BOOST_CHECK( inOrder );
+        BOOST_CHECK_EQUAL( pCreated->count(), 0 );
+
+        // The name is taken, and the header pins the payload type
+        BOOST_CHECK_THROW(
+            QueueFactory::createShmQueue< Message >( name, 4 ),
+            std::system_error
+        );
+        BOOST_CHECK_THROW(
+            QueueFactory::attachShmQueue< int >( name ),
+            std::runtime_error
+        );
+    }
+
+    // Gone with its creator
+    BOOST_CHECK_THROW(
+        QueueFactory::attachShmQueue< Message >( name ),
+        std::system_error
+    );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( ShmForkedProducers_13_2 )
+{
+    constexpr int producersCount = 3;
+    constexpr int messagesPerProducer = 50000;
+
+    const std::string name = shmName( "13_2" );
+
+    // Small enough for both sides to sleep on the shared futexes
+    auto pQueue = QueueFactory::createShmQueue< Message >( name, 64 );
+
+    std::vector< pid_t > children;
+    for ( int p = 0; p < producersCount; ++p )
+        children.push_back( forkChild( [ &name, p ] {
+            auto pAttached = QueueFactory::attachShmQueue< Message >( name );
+            for ( int i = 0; i < messagesPerProducer; ++i )
+                pAttached->enqueue( Message{ p, i, "" } );
+            return true;
+        } ) );
+
+    std::vector< int > next( producersCount, 0 );
+    bool inOrder = true;
+    for ( int i = 0; i < producersCount * messagesPerProducer; ++i )
+    {
+        const std::optional< Message > message = pQueue->dequeue( 5000 );
+        BOOST_REQUIRE( message );
+        inOrder &= message->sequence == next[ message->producer ]++;
+    }
+    BOOST_CHECK( inOrder );
+    BOOST_CHECK( !pQueue->tryDequeue() );
+
+    for ( pid_t child: children )
+        BOOST_CHECK( exitedCleanly( child ) );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( ShmForkedConsumers_13_3 )
+{
+    constexpr int consumersCount = 2;
+    constexpr int messagesCount = 100000;
+
+    const std::string name = shmName( "13_3" );
+    const std::string resultsName = shmName( "13_3-results" );
+
+    auto pQueue = QueueFactory::createShmQueue< Message >( name, 128 );
+    auto pResults =
+        QueueFactory::createShmQueue< long long >( resultsName, 4 );
+
+    // Every consumer sends back the sum of the sequences it got, and -1
+    // once it sees the end marker
+    std::vector< pid_t > children;
+    for ( int c = 0; c < consumersCount; ++c )
+        children.push_back( forkChild( [ & ] {
+            auto pAttached = QueueFactory::attachShmQueue< Message >( name );
+            auto pSums =
+                QueueFactory::attachShmQueue< long long >( resultsName );
+
+            long long sum = 0;
+            for ( ;; )
+            {
+                const Message message = pAttached->dequeue();
+                if ( message.sequence < 0 )
+                    break;
+                sum += message.sequence;
+            }
+            pSums->enqueue( sum );
+            return true;
+        } ) );
+
+    for ( int i = 0; i < messagesCount; ++i )
+        pQueue->enqueue( Message{ 0, i, "" } );
+    for ( int c = 0; c < consumersCount; ++c )
+        pQueue->enqueue( Message{ 0, -1, "" } );
+
+    long long total = 0;
+    for ( int c = 0; c < consumersCount; ++c )
+    {
+        const std::optional< long long > sum = pResults->dequeue( 5000 );
+        BOOST_REQUIRE( sum );
+        total += *sum;
+    }
+    const long long expected =
+        static_cast< long long >( messagesCount ) * ( messagesCount - 1 ) / 2;
+    BOOST_CHECK_EQUAL( total, expected );
+
+    for ( pid_t child: children )
+        BOOST_CHECK( exitedCleanly( child ) );
+}
+
+#endif
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( ShmMixedWaitStrategies_13_4 )
+{
+    using namespace std::chrono;
+
+    const std::string name = shmName( "13_4" );
+
+    auto pBlocking = QueueFactory::createShmQueue< Message >( name, 1 );
+    auto pSpinning =
+        QueueFactory::attachShmQueue< Message >( name, WaitStrategy::Spin );
+
+    // A consumer asleep on the futex is woken by a spinning producer
+    std::optional< Message > received;
+    std::thread consumer( [ & ] { received = pBlocking->dequeue( 5000 ); } );
+
+    std::this_thread::sleep_for( milliseconds( 20 ) );
+    const auto start = steady_clock::now();
+    pSpinning->enqueue( Message{ 0, 1, "x" } );
+    consumer.join();
+
+    BOOST_CHECK( received && received->sequence == 1 );
+    BOOST_CHECK( steady_clock::now() - start < seconds( 2 ) );
+
+    // A producer asleep on a full queue is woken by a spinning consumer
+    pBlocking->enqueue( Message{ 0, 2, "y" } );
+
+    bool enqueued = false;
+    std::thread producer( [ & ] {
+        enqueued = pBlocking->enqueue( Message{ 0, 3, "z" }, 5000 );
+    } );
+
+    std::this_thread::sleep_for( milliseconds( 20 ) );
+    const auto dequeuedAt = steady_clock::now();
+    BOOST_CHECK_EQUAL( pSpinning->dequeue().sequence, 2 );
+    producer.join();
+
+    BOOST_CHECK( enqueued );
+    BOOST_CHECK( steady_clock::now() - dequeuedAt < seconds( 2 ) );
+    BOOST_CHECK_EQUAL( pSpinning->dequeue().sequence, 3 );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( GrowWakesBlockedProducers_14_1 )
+{
+    constexpr int queueSize = 2;
+
+    std::vector< int > values( 2 * queueSize );
+    std::iota( values.begin(), values.end(), 0 );
+
+    for ( const auto & creator: g_queueCreators )
+    {
+        for ( const auto & strategy: g_waitStrategies )
+        {
+            BOOST_TEST_CONTEXT( creator.first << ", " << strategy.first )
+            {
+                auto pQueue = creator.second( queueSize, strategy.second );
+                BOOST_CHECK_EQUAL(
+                    pQueue->capacity(), std::size_t( queueSize )
+                );
+
+                int expected = 0;
+                for ( int i = 0; i < queueSize; ++i )
+                    pQueue->enqueue( &values[ i ] );
+
+                std::thread tPush( [ & ] {
+                    pQueue->enqueue( &values[ queueSize ] );
+                } );
+                sleep_for( 20 );
+
+                if ( pQueue->setCapacity( 2 * queueSize ) )
+                {
+                    // Joins without any consumer making room
+                    tPush.join();
+                    BOOST_CHECK_EQUAL(
+                        pQueue->capacity(), std::size_t( 2 * queueSize )
+                    );
+
+                    int * pLast = &values[ queueSize + 1 ];
+                    BOOST_CHECK_EQUAL(
+                        pQueue->tryEnqueueBulk( &pLast, 1 ), 1u
+                    );
+                    BOOST_CHECK( !pQueue->enqueue( pLast, 0 ) );
+                }
+                else
+                {
+                    BOOST_CHECK_EQUAL(
+                        pQueue->capacity(), std::size_t( queueSize )
+                    );
+                    BOOST_CHECK( !pQueue->setAutoGrow( 2 * queueSize ) );
+
+                    BOOST_CHECK_EQUAL( *pQueue->dequeue(), expected++ );
+                    tPush.join();
+                }
+
+                bool inOrder = true;
+                while ( int * pValue = pQueue->dequeue( 0 ) )
+                    inOrder &= *pValue == expected++;
+                BOOST_CHECK( inOrder );
+                BOOST_CHECK_EQUAL( pQueue->count(), 0 );
+            }
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( ShrinkBlocksUntilDrained_14_2 )
+{
+    constexpr int queueSize = 8;
+    constexpr int enqueuedCount = 6;
+    constexpr int shrunkSize = 3;
+
+    std::vector< int > values( enqueuedCount + 1 );
+    std::iota( values.begin(), values.end(), 0 );
+
+    for ( const auto & creator: g_queueCreators )
+    {
+        BOOST_TEST_CONTEXT( creator.first )
+        {
+            auto pQueue = creator.second( queueSize, WaitStrategy::Block );
+            for ( int i = 0; i < enqueuedCount; ++i )
+                pQueue->enqueue( &values[ i ] );
+
+            if ( !pQueue->setCapacity( shrunkSize ) )
+                continue; // fixed capacity, covered by 14.1
+
+            // Nothing already queued is lost
+            BOOST_CHECK_EQUAL( pQueue->capacity(), std::size_t( shrunkSize ) );
+            BOOST_CHECK_EQUAL( pQueue->count(), enqueuedCount );
+
+            int * pExtra = &values[ enqueuedCount ];
+            BOOST_CHECK( !pQueue->enqueue( pExtra, 10 ) );
+            BOOST_CHECK_EQUAL( pQueue->tryEnqueueBulk( &pExtra, 1 ), 0u );
+
+            bool inOrder = true;
+            int expected = 0;
+            while ( expected < enqueuedCount - shrunkSize )
+                inOrder &= *pQueue->dequeue() == expected++;
+
+            // Still at the new bound
+            BOOST_CHECK( !pQueue->enqueue( pExtra, 10 ) );
+
+            std::thread tPush( [ & ] { pQueue->enqueue( pExtra ); } );
+            sleep_for( 20 );
+            BOOST_CHECK_EQUAL( pQueue->count(), shrunkSize );
+
+            inOrder &= *pQueue->dequeue() == expected++;
+            tPush.join();
+
+            while ( expected <= enqueuedCount )
+                inOrder &= *pQueue->dequeue() == expected++;
+
+            BOOST_CHECK( inOrder );
+            BOOST_CHECK_EQUAL( pQueue->count(), 0 );
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( AutoGrowUpToCeiling_14_3 )
+{
+    constexpr int queueSize = 4;
+    constexpr int burstSize = 6;
+    constexpr int maxSize = 10;
+    constexpr int raisedMaxSize = 12;
+
+    std::vector< int > values( maxSize + 1 );
+    std::iota( values.begin(), values.end(), 0 );
+
+    std::vector< int * > pointers;
+    for ( int & value: values )
+        pointers.push_back( &value );
+
+    for ( const auto & creator: g_queueCreators )
+    {
+        BOOST_TEST_CONTEXT( creator.first )
+        {
+            auto pQueue = creator.second( queueSize, WaitStrategy::Block );
+            if ( !pQueue->setAutoGrow( maxSize ) )
+                continue;
+
+            // A batch that does not fit doubles the capacity
+            BOOST_CHECK_EQUAL(
+                    pQueue->tryEnqueueBulk( pointers.data(), burstSize )
+                ,   std::size_t( burstSize )
+            );
+            BOOST_CHECK_EQUAL( pQueue->capacity(), 2u * queueSize );
+
+            // Then growth stops at the ceiling
+            for ( int i = burstSize; i < maxSize; ++i )
+                BOOST_CHECK( pQueue->enqueue( pointers[ i ], 0 ) );
+            BOOST_CHECK_EQUAL( pQueue->capacity(), std::size_t( maxSize ) );
+            BOOST_CHECK( !pQueue->enqueue( pointers[ maxSize ], 10 ) );
+
+            // Raising the ceiling lets a blocked producer grow the queue
+            std::thread tPush( [ & ] {
+                pQueue->enqueue( pointers[ maxSize ] );
+            } );
+            sleep_for( 20 );
+            BOOST_CHECK( pQueue->setAutoGrow( raisedMaxSize ) );
+            tPush.join();
+
+            bool inOrder = true;
+            for ( int i = 0; i <= maxSize; ++i )
+                inOrder &= *pQueue->dequeue() == i;
+            BOOST_CHECK( inOrder );
+
+            // Capacity gained is kept once drained
+            BOOST_CHECK_EQUAL(
+                pQueue->capacity(), std::size_t( raisedMaxSize )
+            );
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( ResizeUnderTraffic_14_4 )
+{
+    constexpr int queueSize = 16;
+    constexpr int elementsCount = 20000;
+
+    std::vector< int > elements( elementsCount );
+    std::iota( elements.begin(), elements.end(), 0 );
+
+    for ( const auto & creator: g_queueCreators )
+    {
+        for ( const auto & strategy: g_waitStrategies )
+        {
+            BOOST_TEST_CONTEXT( creator.first << ", " << strategy.first )
+            {
+                auto pQueue = creator.second( queueSize, strategy.second );
+                if ( !pQueue->setCapacity( queueSize ) )
+                    continue;
+
+                std::atomic< bool > done( false );
+
+                std::thread tPush( [ & ] {
+                    for ( int & element: elements )
+                        pQueue->enqueue( &element );
+                } );
+
+                // Cycles the capacity between 1 and 64 items
+                std::thread tResize( [ & ] {
+                    for ( std::size_t i = 0; !done.load(); ++i )
+                    {
+                        pQueue->setCapacity( i % 64 + 1 );
+                        std::this_thread::yield();
+                    }
+                } );
+
+                bool inOrder = true;
+                for ( int i = 0; i < elementsCount; ++i )
+                    inOrder &= *pQueue->dequeue() == i;
+
+                done = true;
+                tPush.join();
+                tResize.join();
+
+                BOOST_CHECK( inOrder );
+                BOOST_CHECK_EQUAL( pQueue->count(), 0 );
+            }
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( SegmentedAcrossSegments_15_1 )
+{
+    constexpr std::size_t segmentSize = SegmentedQueue< int >::s_segmentSize;
+    constexpr std::size_t elementsCount = 7 * segmentSize / 2;
+    constexpr std::size_t pushBatch = segmentSize + 44;
+    constexpr std::size_t popBatch = 97;
+
+    std::vector< int > elements( elementsCount );
+    std::iota( elements.begin(), elements.end(), 0 );
+
+    std::vector< int * > pointers;
+    for ( int & element: elements )
+        pointers.push_back( &element );
+
+    auto pQueue = QueueFactory::createSegmentedQueue< int >( elementsCount );
+
+    // Several rounds, so that the segments freed by the first one come
+    // back from the pool
+    for ( int round = 0; round < 3; ++round )
+    {
+        BOOST_TEST_CONTEXT( "round " << round )
+        {
+            std::size_t pushed = 0;
+            std::size_t popped = 0;
+            bool inOrder = true;
+
+            std::vector< int * > batch( popBatch );
+            while ( popped < elementsCount )
+            {
+                if ( pushed < elementsCount )
+                {
+                    const std::size_t count =
+                        std::min( pushBatch, elementsCount - pushed );
+                    pQueue->enqueueBulk( pointers.data() + pushed, count );
+                    pushed += count;
+                }
+
+                const std::size_t dequeued =
+                    pQueue->tryDequeueBulk( batch.data(), popBatch );
+                for ( std::size_t i = 0; i < dequeued; ++i )
+                    inOrder &= *batch[ i ] == int( popped + i );
+                popped += dequeued;
+            }
+
+            BOOST_CHECK( inOrder );
+            BOOST_CHECK_EQUAL( pQueue->count(), 0 );
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( SegmentedHugeBound_15_2 )
+{
+    constexpr std::size_t queueSize = std::size_t( 1 ) << 40;
+
+    auto pQueue = QueueFactory::createSegmentedQueue< int >( queueSize );
+    BOOST_CHECK_EQUAL( pQueue->capacity(), queueSize );
+
+    int value = 42;
+    BOOST_CHECK( pQueue->enqueue( &value, 0 ) );
+    BOOST_CHECK_EQUAL( *pQueue->dequeue( 0 ), value );
+    BOOST_CHECK( pQueue->dequeue( 0 ) == nullptr );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( StatsFollowTraffic_16_1 )
+{
+    for ( const auto & creator: allQueueCreators() )
+    {
+        BOOST_TEST_CONTEXT( creator.first )
+        {
+            auto pQueue = creator.second( 3, WaitStrategy::Block );
+
+            int values[ 3 ] = { 1, 2, 3 };
+            for ( int & value: values )
+                pQueue->enqueue( &value );
+            BOOST_CHECK( !pQueue->enqueue( &values[ 0 ], 10 ) );
+
+            for ( int i = 0; i < 3; ++i )
+                pQueue->dequeue();
+            BOOST_CHECK( pQueue->dequeue( 10 ) == nullptr );
+
+            const QueueStats stats = pQueue->stats();
+            if ( QueueStats::s_enabled )
+            {
+                BOOST_CHECK_EQUAL( stats.enqueued, 3u );
+                BOOST_CHECK_EQUAL( stats.dequeued, 3u );
+                BOOST_CHECK_EQUAL( stats.highWaterMark, 3u );
+                BOOST_CHECK_EQUAL( stats.producerWaits, 1u );
+                BOOST_CHECK_EQUAL( stats.consumerWaits, 1u );
+                BOOST_CHECK_EQUAL( stats.timeouts, 2u );
+                BOOST_CHECK( stats.producerBlockedTime.count() > 0 );
+                BOOST_CHECK( stats.consumerBlockedTime.count() > 0 );
+            }
+            else
+            {
+                BOOST_CHECK_EQUAL( stats.enqueued, 0u );
+                BOOST_CHECK_EQUAL( stats.dequeued, 0u );
+                BOOST_CHECK_EQUAL( stats.highWaterMark, 0u );
+                BOOST_CHECK_EQUAL( stats.producerWaits, 0u );
+                BOOST_CHECK_EQUAL( stats.consumerWaits, 0u );
+                BOOST_CHECK_EQUAL( stats.timeouts, 0u );
+                BOOST_CHECK_EQUAL( stats.lockContentions, 0u );
+            }
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( StatsAddUpAcrossThreads_16_2 )
+{
+    constexpr std::size_t producersCount = 4;
+    constexpr std::size_t itemsPerProducer = 2000;
+    constexpr std::size_t itemsCount = producersCount * itemsPerProducer;
+
+    for ( const auto & creator: g_queueCreators )
+    {
+        if ( std::string( creator.first ) == "spsc" )
+            continue; // one producer only
+
+        BOOST_TEST_CONTEXT( creator.first )
+        {
+            auto pQueue = creator.second( 16, WaitStrategy::Block );
+
+            int value = 0;
+            std::vector< std::thread > producers;
+            for ( std::size_t i = 0; i < producersCount; ++i )
+                producers.emplace_back( [ & ] () {
+                    for ( std::size_t j = 0; j < itemsPerProducer; ++j )
+                        pQueue->enqueue( &value );
+                } );
+
+            for ( std::size_t i = 0; i < itemsCount; ++i )
+                pQueue->dequeue();
+
+            for ( std::thread & producer: producers )
+                producer.join();
+
+            const QueueStats stats = pQueue->stats();
+            const std::uint64_t expected = QueueStats::s_enabled
+                ?   itemsCount
+                :   0
+            ;
+            BOOST_CHECK_EQUAL( stats.enqueued, expected );
+            BOOST_CHECK_EQUAL( stats.dequeued, expected );
+            BOOST_CHECK( stats.highWaterMark <= pQueue->capacity() );
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( CloseDrainsThenEnds_17_1 )
+{
+    using namespace std::chrono;
+
+    for ( const auto & creator: allQueueCreators() )
+    {
+        BOOST_TEST_CONTEXT( creator.first )
+        {
+            auto pQueue = creator.second( 4, WaitStrategy::Block );
+
+            int values[ 2 ] = { 1, 2 };
+            int * batch[ 2 ] = { &values[ 0 ], &values[ 1 ] };
+            pQueue->enqueue( &values[ 0 ] );
+            pQueue->enqueue( &values[ 1 ] );
+
+            BOOST_CHECK( !pQueue->isClosed() );
+            pQueue->close();
+            BOOST_CHECK( pQueue->isClosed() );
+
+            // Room is left, yet every enqueue is refused
+            BOOST_CHECK( !pQueue->enqueue( &values[ 0 ], 10 ) );
+            BOOST_CHECK_THROW( pQueue->enqueue( &values[ 0 ] ), QueueClosed );
+            BOOST_CHECK_EQUAL( pQueue->tryEnqueueBulk( batch, 2 ), 0u );
+            BOOST_CHECK_EQUAL( pQueue->enqueueBulk( batch, 2, 10 ), 0u );
+            BOOST_CHECK_THROW( pQueue->enqueueBulk( batch, 2 ), QueueClosed );
+            BOOST_CHECK_EQUAL( pQueue->count(), 2 );
+
+            BOOST_CHECK( pQueue->dequeue() == &values[ 0 ] );
+            BOOST_CHECK( pQueue->dequeue( 1000 ) == &values[ 1 ] );
+
+            // Drained: nothing waits for the timeout any more
+            const auto start = steady_clock::now();
+            BOOST_CHECK( pQueue->dequeue() == nullptr );
+            BOOST_CHECK( pQueue->dequeue( 1000 ) == nullptr );
+            BOOST_CHECK_EQUAL( pQueue->dequeueBulk( batch, 2 ), 0u );
+            BOOST_CHECK_EQUAL( pQueue->dequeueBulk( batch, 2, 1000 ), 0u );
+            BOOST_CHECK_EQUAL(
+                pQueue->dequeueBulkLinger( batch, 2, 1000 ), 0u
+            );
+            BOOST_CHECK( steady_clock::now() - start < milliseconds( 500 ) );
+
+            pQueue->close();
+            BOOST_CHECK( pQueue->isClosed() );
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( CloseWakesBlockedThreads_17_2 )
+{
+    for ( const auto & creator: allQueueCreators() )
+    {
+        for ( const auto & strategy: g_waitStrategies )
+        {
+            BOOST_TEST_CONTEXT( creator.first << ", " << strategy.first )
+            {
+                // One waiter per queue, which the spsc queue allows too
+                auto pEmpty = creator.second( 4, strategy.second );
+                auto pEmptyBulk = creator.second( 4, strategy.second );
+                auto pFull = creator.second( 1, strategy.second );
+
+                int values[ 2 ] = { 1, 2 };
+                pFull->enqueue( &values[ 0 ] );
+
+                int * pDequeued = &values[ 0 ];
+                std::size_t bulkDequeued = 1;
+                bool refused = false;
+
+                std::thread tDequeue( [ & ] {
+                    pDequeued = pEmpty->dequeue();
+                } );
+                std::thread tDequeueBulk( [ & ] {
+                    int * batch[ 2 ];
+                    bulkDequeued = pEmptyBulk->dequeueBulk( batch, 2 );
+                } );
+                std::thread tEnqueue( [ & ] {
+                    try
+                    {
+                        pFull->enqueue( &values[ 1 ] );
+                    }
+                    catch ( const QueueClosed & )
+                    {
+                        refused = true;
+                    }
+                } );
+
+                std::this_thread::sleep_for( std::chrono::milliseconds( 20 ) );
+                pEmpty->close();
+                pEmptyBulk->close();
+                pFull->close();
+
+                tDequeue.join();
+                tDequeueBulk.join();
+                tEnqueue.join();
+
+                BOOST_CHECK( pDequeued == nullptr );
+                BOOST_CHECK_EQUAL( bulkDequeued, 0u );
+                BOOST_CHECK( refused );
+
+                // What was queued before closing is still handed out
+                BOOST_CHECK( pFull->dequeue() == &values[ 0 ] );
+                BOOST_CHECK( pFull->dequeue() == nullptr );
+            }
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( CloseUnderTraffic_17_3 )
+{
+    constexpr int consumersCount = 2;
+    constexpr int itemsBeforeClose = 5000;
+
+    for ( const auto & creator: allQueueCreators() )
+    {
+        BOOST_TEST_CONTEXT( creator.first )
+        {
+            // The spsc queue is best closed by its producer
+            const bool spsc = std::string( creator.first ) == "spsc";
+            const int producersCount = spsc ? 1 : 3;
+
+            auto pQueue = creator.second( 8, WaitStrategy::Block );
+
+            int value = 0;
+            std::atomic< int > accepted( 0 );
+            std::atomic< int > received( 0 );
+
+            std::vector< std::thread > threads;
+            for ( int i = 0; i < producersCount; ++i )
+                threads.emplace_back( [ & ] {
+                    try
+                    {
+                        for ( int j = 0; ; ++j )
+                        {
+                            if ( spsc && j == itemsBeforeClose )
+                                pQueue->close();
+                            pQueue->enqueue( &value );
+                            ++accepted;
+                        }
+                    }
+                    catch ( const QueueClosed & )
+                    {
+                    }
+                } );
+            for ( int i = 0; i < ( spsc ? 1 : consumersCount ); ++i )
+                threads.emplace_back( [ & ] {
+                    while ( pQueue->dequeue() )
+                        ++received;
+                } );
+
+            if ( !spsc )
+            {
+                while ( received < itemsBeforeClose )
+                    std::this_thread::yield();
+                pQueue->close();
+            }
+
+            for ( std::thread & thread: threads )
+                thread.join();
+
+            BOOST_CHECK( accepted >= itemsBeforeClose );
+            BOOST_CHECK_EQUAL( received.load(), accepted.load() );
+            BOOST_CHECK_EQUAL( pQueue->count(), 0 );
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( AsyncCloseResumesParked_17_4 )
+{
+    ManualScheduler scheduler;
+
+    auto pEmpty = QueueFactory::createAsyncQueue< int >( 2 );
+    std::vector< int * > received;
+    asyncConsume( *pEmpty, 1, received ).spawn( scheduler );
+
+    auto pFull = QueueFactory::createAsyncQueue< int >( 1 );
+    int values[ 2 ] = { 1, 2 };
+    pFull->enqueue( &values[ 0 ] );
+    bool refused = false;
+    asyncEnqueueUnlessClosed( *pFull, &values[ 1 ], refused )
+        .spawn( scheduler );
+
+    scheduler.run();
+    BOOST_CHECK( received.empty() );
+    BOOST_CHECK( !refused );
+
+    pEmpty->close();
+    pFull->close();
+
+    // Resumed inline, as they were parked without a scheduler
+    BOOST_REQUIRE_EQUAL( received.size(), 1u );
+    BOOST_CHECK( received[ 0 ] == nullptr );
+    BOOST_CHECK( refused );
+    BOOST_CHECK_EQUAL( pFull->count(), 1 );
+
+    // Awaiting a closed queue does not park at all
+    asyncConsume( *pFull, 2, received ).spawn( scheduler );
+    scheduler.run();
+    BOOST_REQUIRE_EQUAL( received.size(), 3u );
+    BOOST_CHECK( received[ 1 ] == &values[ 0 ] );
+    BOOST_CHECK( received[ 2 ] == nullptr );
+}
+
+/*----------------------------------------------------------------------------*/
+
+#if defined( __linux__ )
+
+BOOST_AUTO_TEST_CASE( EventFdCloseStaysReadable_17_5 )
+{
+    auto pQueue = QueueFactory::createEventFdQueue< int >(
+        QueueFactory::createLockFreeQueue< int >( 16 )
+    );
+
+    int value = 1;
+    pQueue->enqueue( &value );
+    pQueue->close();
+    BOOST_CHECK( pQueue->isClosed() );
+    BOOST_CHECK( isReadable( pQueue->fd() ) );
+
+    // Like EOF on a pipe: readable for good, so the loop notices the end
+    BOOST_CHECK( pQueue->tryDequeue() == &value );
+    BOOST_CHECK( isReadable( pQueue->fd() ) );
+    BOOST_CHECK( pQueue->tryDequeue() == nullptr );
+    BOOST_CHECK( isReadable( pQueue->fd() ) );
+}
+
+#endif
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( TimeoutToldFromClose_17_6 )
+{
+    for ( const auto & creator: allQueueCreators() )
+    {
+        BOOST_TEST_CONTEXT( creator.first )
+        {
+            auto pQueue = creator.second( 4, WaitStrategy::Block );
+
+            int value = 1;
+            int * batch[ 1 ];
+
+            BOOST_CHECK( pQueue->dequeue( 10 ) == nullptr );
+            BOOST_CHECK_EQUAL( pQueue->dequeueBulk( batch, 1, 10 ), 0u );
+            BOOST_CHECK( !pQueue->isClosed() );
+
+            pQueue->enqueue( &value );
+            pQueue->close();
+
+            // Closed but not drained yet: the item still comes out
+            BOOST_CHECK( pQueue->dequeue( 10 ) == &value );
+            BOOST_CHECK( pQueue->dequeue( 10 ) == nullptr );
+            BOOST_CHECK( pQueue->isClosed() );
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( TryOpsNeverWait_18_1 )
+{
+    for ( const auto & creator: allQueueCreators() )
+    {
+        BOOST_TEST_CONTEXT( creator.first )
+        {
+            auto pQueue = creator.second( 2, WaitStrategy::Block );
+
+            // Polling an empty queue, as an event loop would
+            for ( int i = 0; i < 1000; ++i )
+                BOOST_CHECK( pQueue->tryDequeue() == nullptr );
+
+            int values[ 3 ] = { 1, 2, 3 };
+            BOOST_CHECK( pQueue->tryEnqueue( &values[ 0 ] ) );
+            BOOST_CHECK( pQueue->tryEnqueue( &values[ 1 ] ) );
+            BOOST_CHECK( !pQueue->tryEnqueue( &values[ 2 ] ) );
+            BOOST_CHECK_EQUAL( pQueue->count(), 2 );
+
+            BOOST_CHECK( pQueue->tryDequeue() == &values[ 0 ] );
+            BOOST_CHECK( pQueue->tryEnqueue( &values[ 2 ] ) );
+
+            pQueue->close();
+            BOOST_CHECK( !pQueue->tryEnqueue( &values[ 0 ] ) );
+            BOOST_CHECK( pQueue->tryDequeue() == &values[ 1 ] );
+            BOOST_CHECK( pQueue->tryDequeue() == &values[ 2 ] );
+            BOOST_CHECK( pQueue->tryDequeue() == nullptr );
+
+            // Unlike dequeue( 0 ), a failed try is neither a wait nor a
+            // timeout
+            const QueueStats stats = pQueue->stats();
+            BOOST_CHECK_EQUAL( stats.producerWaits, 0u );
+            BOOST_CHECK_EQUAL( stats.consumerWaits, 0u );
+            BOOST_CHECK_EQUAL( stats.timeouts, 0u );
+            if ( QueueStats::s_enabled )
+            {
+                BOOST_CHECK_EQUAL( stats.enqueued, 3u );
+                BOOST_CHECK_EQUAL( stats.dequeued, 3u );
+            }
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( TryOpsWakeBlockedThreads_18_2 )
+{
+    for ( const auto & creator: allQueueCreators() )
+    {
+        BOOST_TEST_CONTEXT( creator.first )
+        {
+            auto pEmpty = creator.second( 1, WaitStrategy::Block );
+            auto pFull = creator.second( 1, WaitStrategy::Block );
+
+            int values[ 2 ] = { 1, 2 };
+            pFull->enqueue( &values[ 0 ] );
+
+            int * pDequeued = nullptr;
+            std::thread tDequeue( [ & ] { pDequeued = pEmpty->dequeue(); } );
+            std::thread tEnqueue( [ & ] { pFull->enqueue( &values[ 1 ] ); } );
+
+            std::this_thread::sleep_for( std::chrono::milliseconds( 20 ) );
+            BOOST_CHECK( pEmpty->tryEnqueue( &values[ 0 ] ) );
+            BOOST_CHECK( pFull->tryDequeue() == &values[ 0 ] );
+
+            tDequeue.join();
+            tEnqueue.join();
+
+            BOOST_CHECK( pDequeued == &values[ 0 ] );
+            BOOST_CHECK( pFull->tryDequeue() == &values[ 1 ] );
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( TryOpsPriorityAndEventFd_18_3 )
+{
+    auto pPriority = QueueFactory::createPriorityQueue< int >( 3, 2 );
+
+    int values[ 3 ] = { 1, 2, 3 };
+    BOOST_CHECK( pPriority->tryEnqueue( &values[ 0 ] ) );
+    BOOST_CHECK( pPriority->tryEnqueue( &values[ 1 ], Priority::Highest ) );
+    BOOST_CHECK( pPriority->tryEnqueue( &values[ 2 ], Priority{ 1 } ) );
+    BOOST_CHECK( !pPriority->tryEnqueue( &values[ 0 ], Priority::Highest ) );
+
+    BOOST_CHECK( pPriority->tryDequeue() == &values[ 1 ] );
+    BOOST_CHECK( pPriority->tryDequeue() == &values[ 0 ] );
+    BOOST_CHECK( pPriority->tryDequeue() == &values[ 2 ] );
+
+#if defined( __linux__ )
+    auto pEventFd = QueueFactory::createEventFdQueue< int >(
+        QueueFactory::createLockFreeQueue< int >( 1 )
+    );
+
+    BOOST_CHECK( !isReadable( pEventFd->fd() ) );
+    BOOST_CHECK( pEventFd->tryEnqueue( &values[ 0 ] ) );
+    BOOST_CHECK( isReadable( pEventFd->fd() ) );
+    BOOST_CHECK( !pEventFd->tryEnqueue( &values[ 1 ] ) );
+
+    BOOST_CHECK( pEventFd->tryDequeue() == &values[ 0 ] );
+    BOOST_CHECK( !isReadable( pEventFd->fd() ) );
+#endif
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( DrainAllInOrder_19_1 )
+{
+    for ( const auto & creator: allQueueCreators() )
+    {
+        BOOST_TEST_CONTEXT( creator.first )
+        {
+            auto pQueue = creator.second( 8, WaitStrategy::Block );
+
+            std::vector< int > values( 5 );
+            std::iota( values.begin(), values.end(), 0 );
+            for ( int & value: values )
+                pQueue->enqueue( &value );
+
+            int other = -1;
+            std::vector< int * > drained { &other };
+            BOOST_CHECK_EQUAL( pQueue->drainAll( drained ), values.size() );
+            BOOST_CHECK_EQUAL( pQueue->count(), 0 );
+
+            BOOST_REQUIRE_EQUAL( drained.size(), values.size() + 1 );
+            BOOST_CHECK( drained[ 0 ] == &other );
+            for ( std::size_t i = 0; i < values.size(); ++i )
+                BOOST_CHECK( drained[ i + 1 ] == &values[ i ] );
+
+            BOOST_CHECK_EQUAL( pQueue->drainAll( drained ), 0u );
+
+            for ( int & value: values )
+                pQueue->enqueue( &value );
+            pQueue->clear();
+            BOOST_CHECK_EQUAL( pQueue->count(), 0 );
+            BOOST_CHECK( pQueue->tryDequeue() == nullptr );
+
+            // Still usable afterwards
+            pQueue->enqueue( &values[ 0 ] );
+            BOOST_CHECK( pQueue->dequeue() == &values[ 0 ] );
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( DrainAllWakesProducers_19_2 )
+{
+    constexpr int queueSize = 2;
+
+    for ( const auto & creator: allQueueCreators() )
+    {
+        if ( std::string( creator.first ) == "spsc" )
+            continue; // one producer only
+
+        BOOST_TEST_CONTEXT( creator.first )
+        {
+            auto pQueue = creator.second( queueSize, WaitStrategy::Block );
+
+            int values[ 2 * queueSize ] = { 0, 1, 2, 3 };
+            for ( int i = 0; i < queueSize; ++i )
+                pQueue->enqueue( &values[ i ] );
+
+            std::vector< std::thread > producers;
+            for ( int i = queueSize; i < 2 * queueSize; ++i )
+                producers.emplace_back( [ &, i ] {
+                    pQueue->enqueue( &values[ i ] );
+                } );
+
+            std::this_thread::sleep_for( std::chrono::milliseconds( 20 ) );
+
+            std::vector< int * > drained;
+            BOOST_CHECK_EQUAL( pQueue->drainAll( drained ), queueSize );
+
+            for ( std::thread & producer: producers )
+                producer.join();
+
+            BOOST_CHECK_EQUAL( pQueue->count(), queueSize );
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( SpliceKeepsOrder_19_3 )
+{
+    SharedQueue< int > source( 4 );
+    SharedQueue< int > target( 4 );
+
+    std::vector< int > values( 8 );
+    std::iota( values.begin(), values.end(), 0 );
+
+    target.enqueue( &values[ 0 ] );
+    for ( int i = 1; i < 4; ++i )
+        source.enqueue( &values[ i ] );
+
+    BOOST_CHECK_EQUAL( source.spliceInto( target ), 3u );
+    BOOST_CHECK_EQUAL( source.count(), 0 );
+    BOOST_CHECK_EQUAL( target.count(), 4 );
+    BOOST_CHECK_EQUAL( source.spliceInto( target ), 0u );
+
+    // Both ends keep working on their new lists
+    source.enqueue( &values[ 4 ] );
+    BOOST_CHECK( !target.tryEnqueue( &values[ 5 ] ) );
+    BOOST_CHECK( source.dequeue() == &values[ 4 ] );
+
+    for ( int i = 0; i < 4; ++i )
+        BOOST_CHECK( target.dequeue() == &values[ i ] );
+    BOOST_CHECK( target.tryDequeue() == nullptr );
+
+    // Past the target's capacity: its producers wait for consumers
+    for ( int i = 0; i < 4; ++i )
+        target.enqueue( &values[ i ] );
+    for ( int i = 4; i < 7; ++i )
+        source.enqueue( &values[ i ] );
+    BOOST_CHECK_EQUAL( source.spliceInto( target ), 3u );
+    BOOST_CHECK_EQUAL( target.count(), 7 );
+    BOOST_CHECK( !target.tryEnqueue( &values[ 7 ] ) );
+
+    std::vector< int * > drained;
+    BOOST_CHECK_EQUAL( target.drainAll( drained ), 7u );
+    for ( int i = 0; i < 7; ++i )
+        BOOST_CHECK( drained[ i ] == &values[ i ] );
+
+    // A closed target takes nothing
+    source.enqueue( &values[ 7 ] );
+    target.close();
+    BOOST_CHECK_EQUAL( source.spliceInto( target ), 0u );
+    BOOST_CHECK_EQUAL( source.count(), 1 );
+    BOOST_CHECK_EQUAL( target.count(), 0 );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( HugeQueueTeardown_19_4 )
+{
+    constexpr std::size_t itemsCount = 1000000;
+
+    int value = 0;
+    std::vector< int * > items( itemsCount, &value );
+
+    auto pQueue = QueueFactory::createStandardSharedQueue< int >( itemsCount );
+    pQueue->enqueueBulk( items.data(), itemsCount );
+    pQueue->clear();
+    BOOST_CHECK_EQUAL( pQueue->count(), 0 );
+
+    // Destroyed full, without recursing through the nodes
+    pQueue->enqueueBulk( items.data(), itemsCount );
+    BOOST_CHECK_EQUAL( pQueue->count(), int( itemsCount ) );
+    pQueue.reset();
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( SelectOrder_20_1 )
+{
+    using Selector = QueueSelector< int >;
+
+    int values[ 6 ] = { 0, 1, 2, 3, 4, 5 };
+    std::size_t index;
+
+    // Priority: the first queue that has an item wins
+    {
+        Selector selector( Selector::Order::Priority );
+        for ( int i = 0; i < 3; ++i )
+            selector.add( QueueFactory::createStandardSharedQueue< int >( 4 ) );
+        BOOST_CHECK_EQUAL( selector.queueCount(), 3u );
+
+        selector.queue( 2 ).enqueue( &values[ 4 ] );
+        selector.queue( 1 ).enqueue( &values[ 2 ] );
+        selector.queue( 1 ).enqueue( &values[ 3 ] );
+        selector.queue( 0 ).enqueue( &values[ 0 ] );
+
+        BOOST_CHECK_EQUAL( selector.waitAny( 0 ), 0u );
+        BOOST_CHECK_EQUAL( selector.queue( 0 ).count(), 1 );
+
+        const std::pair< std::size_t, int * > expected[] {
+                { 0, &values[ 0 ] }
+            ,   { 1, &values[ 2 ] }
+            ,   { 1, &values[ 3 ] }
+            ,   { 2, &values[ 4 ] }
+        };
+        for ( const auto & selected: expected )
+        {
+            BOOST_CHECK( selector.trySelect( &index ) == selected.second );
+            BOOST_CHECK_EQUAL( index, selected.first );
+        }
+
+        BOOST_CHECK( selector.trySelect( &index ) == nullptr );
+        BOOST_CHECK_EQUAL( index, Selector::s_noQueue );
+    }
+
+    // Round robin: a scan starts after the queue served last
+    {
+        Selector selector( Selector::Order::RoundRobin );
+        for ( int i = 0; i < 3; ++i )
+        {
+            IQueue< int > & rQueue =
+                selector.add( QueueFactory::createLockFreeQueue< int >( 4 ) );
+            rQueue.enqueue( &values[ 2 * i ] );
+            rQueue.enqueue( &values[ 2 * i + 1 ] );
+        }
+
+        for ( int round = 0; round < 2; ++round )
+            for ( std::size_t i = 0; i < 3; ++i )
+            {
+                BOOST_CHECK(
+                    selector.select( &index ) == &values[ 2 * i + round ]
+                );
+                BOOST_CHECK_EQUAL( index, i );
+            }
+
+        BOOST_CHECK_EQUAL( selector.waitAny( 10 ), Selector::s_noQueue );
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( SelectWakesOnAnyQueue_20_2 )
+{
+    using namespace std::chrono;
+    using Selector = QueueSelector< int >;
+
+    for ( const auto & creator: allQueueCreators() )
+        for ( const auto & strategy: g_waitStrategies )
+        {
+            BOOST_TEST_CONTEXT( creator.first << ", " << strategy.first )
+            {
+                Selector selector( Selector::Order::Priority, strategy.second );
+                for ( int i = 0; i < 3; ++i )
+                    selector.add( creator.second( 4, strategy.second ) );
+
+                // Nothing to take: both calls give up at the deadline
+                std::size_t index = 0;
+                const auto start = steady_clock::now();
+                BOOST_CHECK( selector.select( 20, &index ) == nullptr );
+                BOOST_CHECK_EQUAL( index, Selector::s_noQueue );
+                BOOST_CHECK(
+                    steady_clock::now() - start >= milliseconds( 20 )
+                );
+                BOOST_CHECK_EQUAL(
+                    selector.waitAny( 10 ), Selector::s_noQueue
+                );
+
+                int value = 7;
+                for ( std::size_t target = 0; target < 3; ++target )
+                {
+                    std::thread consumer( [ & ] {
+                        BOOST_CHECK( selector.select( &index ) == &value );
+                    } );
+
+                    std::this_thread::sleep_for( milliseconds( 10 ) );
+                    selector.queue( 2 - target ).enqueue( &value );
+                    consumer.join();
+
+                    BOOST_CHECK_EQUAL( index, 2 - target );
+                }
+
+                std::thread waiter( [ & ] {
+                    BOOST_CHECK_EQUAL( selector.waitAny(), 1u );
+                } );
+                std::this_thread::sleep_for( milliseconds( 10 ) );
+                selector.queue( 1 ).enqueue( &value );
+                waiter.join();
+                BOOST_CHECK_EQUAL( selector.queue( 1 ).count(), 1 );
+            }
+        }
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( SelectEndsWhenAllClosed_20_3 )
+{
+    using namespace std::chrono;
+    using Selector = QueueSelector< int >;
+
+    for ( const auto & creator: allQueueCreators() )
+    {
+        BOOST_TEST_CONTEXT( creator.first )
+        {
+            Selector selector;
+            for ( int i = 0; i < 2; ++i )
+                selector.add( creator.second( 4, WaitStrategy::Block ) );
+
+            int value = 3;
+            std::atomic< int > selectedCount( 0 );
+            std::size_t index = 0;
+
+            std::thread consumer( [ & ] {
+                while ( selector.select( &index ) )
+                    ++selectedCount;
+            } );
+
+            // One queue closed and empty does not end the wait
+            selector.queue( 0 ).close();
+            std::this_thread::sleep_for( milliseconds( 20 ) );
+            BOOST_CHECK_EQUAL( selectedCount.load(), 0 );
+
+            // Items left in the last queue are taken before it ends
+            selector.queue( 1 ).enqueue( &value );
+            selector.queue( 1 ).enqueue( &value );
+            selector.queue( 1 ).close();
+            consumer.join();
+
+            BOOST_CHECK_EQUAL( selectedCount.load(), 2 );
+            BOOST_CHECK_EQUAL( index, Selector::s_noQueue );
+            BOOST_CHECK( selector.select( 10 ) == nullptr );
+            BOOST_CHECK_EQUAL( selector.waitAny(), Selector::s_noQueue );
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( SelectDeliversOnce_20_4 )
+{
+    using Selector = QueueSelector< int >;
+
+    constexpr std::size_t queueCount = 3;
+    constexpr int consumersCount = 2;
+    constexpr int elementsPerProducer = 1000;
+    constexpr int elementsCount = queueCount * elementsPerProducer;
+
+    std::vector< int > elements( elementsCount );
+    std::iota( elements.begin(), elements.end(), 0 );
+
+    const std::pair< const char *, Selector::Order > orders[] {
+            { "priority", Selector::Order::Priority }
+        ,   { "round-robin", Selector::Order::RoundRobin }
+    };
+
+    for ( const auto & order: orders )
+        for ( const auto & strategy: g_waitStrategies )
+        {
+            BOOST_TEST_CONTEXT( order.first << ", " << strategy.first )
+            {
+                Selector selector( order.second, strategy.second );
+                for ( std::size_t i = 0; i < queueCount; ++i )
+                    selector.add(
+                        QueueFactory::createStandardSharedQueue< int >(
+                            8, strategy.second
+                        )
+                    );
+
+                std::vector< std::atomic< int > > seenCounts( elementsCount );
+                std::atomic< int > misplacedCount( 0 );
+
+                std::vector< std::thread > producers;
+                for ( std::size_t i = 0; i < queueCount; ++i )
+                    producers.emplace_back( [ &, i ] {
+                        int * const pFirst =
+                            &elements[ i * elementsPerProducer ];
+                        int * batch[ 4 ];
+                        for ( int j = 0; j < elementsPerProducer; j += 4 )
+                        {
+                            for ( int k = 0; k < 4; ++k )
+                                batch[ k ] = pFirst + j + k;
+                            selector.queue( i ).enqueueBulk( batch, 4 );
+                        }
+                    } );
+
+                std::vector< std::thread > consumers;
+                for ( int i = 0; i < consumersCount; ++i )
+                    consumers.emplace_back( [ & ] {
+                        std::size_t index;
+                        while ( int * pElement = selector.select( &index ) )
+                        {
+                            const int producer =
+                                *pElement / elementsPerProducer;
+                            if ( producer != int( index ) )
+                                ++misplacedCount;
+                            ++seenCounts[ *pElement ];
+                        }
+                    } );
+
+                for ( auto & producer: producers )
+                    producer.join();
+                for ( std::size_t i = 0; i < queueCount; ++i )
+                    selector.queue( i ).close();
+                for ( auto & consumer: consumers )
+                    consumer.join();
+
+                BOOST_CHECK_EQUAL( misplacedCount.load(), 0 );
+
+                BOOST_CHECK(
+                    std::all_of(
+                        seenCounts.begin(), seenCounts.end(),
+                        [] ( const std::atomic< int > & _count ) {
+                            return _count == 1;
+                        }
+                    )
+                );
+            }
+        }
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( DelayQueueOrdersByReadyAt_21_1 )
+{
+    using namespace std::chrono;
+
+    auto pQueue = QueueFactory::createDelayQueue< int >();
+    int values[ 5 ] { 0, 1, 2, 3, 4 };
+
+    const auto start = steady_clock::now();
+    BOOST_CHECK( pQueue->enqueue( &values[ 3 ], start + milliseconds( 200 ) ) );
+    BOOST_CHECK( pQueue->enqueue( &values[ 1 ], start + milliseconds( 100 ) ) );
+    BOOST_CHECK( pQueue->enqueue( &values[ 2 ], start + milliseconds( 150 ) ) );
+    BOOST_CHECK( pQueue->enqueue( &values[ 4 ], start + milliseconds( 100 ) ) );
+    BOOST_CHECK( pQueue->enqueue( &values[ 0 ], start - milliseconds( 1 ) ) );
+    BOOST_CHECK_EQUAL( pQueue->count(), 5 );
+
+    // Only the item whose time has come is visible
+    BOOST_CHECK( pQueue->nextReadyAt() == start - milliseconds( 1 ) );
+    BOOST_CHECK( pQueue->tryDequeue() == &values[ 0 ] );
+    BOOST_CHECK( pQueue->tryDequeue() == nullptr );
+    BOOST_CHECK( pQueue->nextReadyAt() == start + milliseconds( 100 ) );
+    BOOST_CHECK_EQUAL( pQueue->count(), 4 );
+
+    std::this_thread::sleep_until( start + milliseconds( 200 ) );
+
+    int * items[ 8 ];
+    BOOST_REQUIRE_EQUAL( pQueue->tryDequeueBulk( items, 8 ), 4u );
+    BOOST_CHECK( items[ 0 ] == &values[ 1 ] );
+    BOOST_CHECK( items[ 1 ] == &values[ 4 ] );
+    BOOST_CHECK( items[ 2 ] == &values[ 2 ] );
+    BOOST_CHECK( items[ 3 ] == &values[ 3 ] );
+
+    BOOST_CHECK_EQUAL( pQueue->count(), 0 );
+    BOOST_CHECK( pQueue->nextReadyAt() == steady_clock::time_point::max() );
+    BOOST_CHECK_EQUAL( pQueue->tryDequeueBulk( items, 8 ), 0u );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( DelayQueueSleepsUntilReadyAt_21_2 )
+{
+    using namespace std::chrono;
+
+    auto pQueue = QueueFactory::createDelayQueue< int >();
+    int early = 1;
+    int late = 2;
+
+    // An item that is not due yet does not end a timed wait
+    auto start = steady_clock::now();
+    const auto lateReadyAt = start + milliseconds( 300 );
+    pQueue->enqueue( &late, lateReadyAt );
+    BOOST_CHECK( pQueue->dequeue( 20 ) == nullptr );
+    BOOST_CHECK( steady_clock::now() - start >= milliseconds( 20 ) );
+
+    // A consumer asleep until the late item wakes for an earlier one
+    steady_clock::time_point earlyReadyAt;
+    steady_clock::time_point earlyTakenAt;
+    std::thread consumer( [ & ] {
+        BOOST_CHECK( pQueue->dequeue() == &early );
+        earlyTakenAt = steady_clock::now();
+        BOOST_CHECK( pQueue->dequeue() == &late );
+        BOOST_CHECK( steady_clock::now() >= lateReadyAt );
+    } );
+
+    std::this_thread::sleep_for( milliseconds( 10 ) );
+    earlyReadyAt = steady_clock::now() + milliseconds( 20 );
+    pQueue->enqueue( &early, earlyReadyAt );
+    consumer.join();
+
+    BOOST_CHECK( earlyTakenAt >= earlyReadyAt );
+    BOOST_CHECK( earlyTakenAt < lateReadyAt );
+
+    // Two consumers asleep on an empty queue; the second item does not move
+    // the earliest readyAt, so only the consumer leaving can hand it on
+    std::atomic< int > takenCount( 0 );
+    std::vector< std::thread > consumers;
+    for ( int i = 0; i < 2; ++i )
+        consumers.emplace_back( [ & ] {
+            if ( pQueue->dequeue( 5000 ) )
+                ++takenCount;
+        } );
+
+    std::this_thread::sleep_for( milliseconds( 10 ) );
+    start = steady_clock::now();
+    pQueue->enqueue( &early, start + milliseconds( 10 ) );
+    pQueue->enqueue( &late, start + milliseconds( 20 ) );
+    for ( auto & thread: consumers )
+        thread.join();
+
+    BOOST_CHECK_EQUAL( takenCount.load(), 2 );
+    BOOST_CHECK( steady_clock::now() - start < milliseconds( 2000 ) );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( DelayQueueClose_21_3 )
+{
+    using namespace std::chrono;
+
+    int values[ 4 ] { 0, 1, 2, 3 };
+
+    // Closing wakes a consumer asleep on an empty queue
+    {
+        auto pQueue = QueueFactory::createDelayQueue< int >();
+
+        std::thread consumer( [ & ] {
+            BOOST_CHECK( pQueue->dequeue() == nullptr );
+        } );
+
+        std::this_thread::sleep_for( milliseconds( 10 ) );
+        pQueue->close();
+        consumer.join();
+
+        BOOST_CHECK( pQueue->isClosed() );
+        BOOST_CHECK( pQueue->dequeue( 10 ) == nullptr );
+    }
+
+    // Items queued before closing still come out at their readyAt
+    {
+        auto pQueue = QueueFactory::createDelayQueue< int >();
+        const auto readyAt = steady_clock::now() + milliseconds( 20 );
+        pQueue->enqueue( &values[ 0 ], readyAt );
+        pQueue->close();
+
+        BOOST_CHECK( !pQueue->enqueue( &values[ 1 ], readyAt ) );
+        BOOST_CHECK_EQUAL( pQueue->count(), 1 );
+        BOOST_CHECK( pQueue->tryDequeue() == nullptr );
+
+        BOOST_CHECK( pQueue->dequeue() == &values[ 0 ] );
+        BOOST_CHECK( steady_clock::now() >= readyAt );
+        BOOST_CHECK( pQueue->dequeue() == nullptr );
+    }
+
+    // drainAll() takes pending items by readyAt, due or not
+    {
+        auto pQueue = QueueFactory::createDelayQueue< int >();
+        const auto start = steady_clock::now();
+        pQueue->enqueue( &values[ 2 ], start + hours( 2 ) );
+        pQueue->enqueue( &values[ 0 ], start - hours( 1 ) );
+        pQueue->enqueue( &values[ 3 ], start + hours( 3 ) );
+        pQueue->enqueue( &values[ 1 ], start + hours( 1 ) );
+
+        std::vector< int * > drained { nullptr };
+        BOOST_CHECK_EQUAL( pQueue->drainAll( drained ), 4u );
+        BOOST_REQUIRE_EQUAL( drained.size(), 5u );
+        for ( int i = 0; i < 4; ++i )
+            BOOST_CHECK( drained[ i + 1 ] == &values[ i ] );
+
+        BOOST_CHECK_EQUAL( pQueue->count(), 0 );
+        BOOST_CHECK_EQUAL( pQueue->drainAll( drained ), 0u );
+
+        pQueue->enqueue( &values[ 0 ], start + hours( 1 ) );
+        pQueue->clear();
+        BOOST_CHECK_EQUAL( pQueue->count(), 0 );
+        BOOST_CHECK( pQueue->dequeue( 10 ) == nullptr );
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( DelayQueueDeliversOnceOnTime_21_4 )
+{
+    using namespace std::chrono;
+
+    constexpr int producersCount = 3;
+    constexpr int consumersCount = 3;
+    constexpr int elementsPerProducer = 2000;
+    constexpr int elementsCount = producersCount * elementsPerProducer;
+
+    auto pQueue = QueueFactory::createDelayQueue< int >();
+
+    std::vector< int > elements( elementsCount );
+    std::iota( elements.begin(), elements.end(), 0 );
+
+    std::vector< steady_clock::time_point > readyAts( elementsCount );
+    std::vector< std::atomic< int > > seenCounts( elementsCount );
+    std::atomic< int > earlyCount( 0 );
+
+    std::vector< std::thread > producers;
+    for ( int i = 0; i < producersCount; ++i )
+        producers.emplace_back( [ &, i ] {
+            for ( int j = 0; j < elementsPerProducer; ++j )
+            {
+                const int element = i * elementsPerProducer + j;
+                readyAts[ element ] =
+                        steady_clock::now()
+                    +   microseconds( element * 7919 % 20000 )
+                ;
+                pQueue->enqueue( &elements[ element ], readyAts[ element ] );
+            }
+        } );
+
+    std::vector< std::thread > consumers;
+    for ( int i = 0; i < consumersCount; ++i )
+        consumers.emplace_back( [ & ] {
+            while ( int * pElement = pQueue->dequeue() )
+            {
+                if ( steady_clock::now() < readyAts[ *pElement ] )
+                    ++earlyCount;
+                ++seenCounts[ *pElement ];
+            }
+        } );
+
+    for ( auto & producer: producers )
+        producer.join();
+    pQueue->close();
+    for ( auto & consumer: consumers )
+        consumer.join();
+
+    BOOST_CHECK_EQUAL( earlyCount.load(), 0 );
+    BOOST_CHECK_EQUAL( pQueue->count(), 0 );
+    BOOST_CHECK(
+        std::all_of(
+            seenCounts.begin(), seenCounts.end(),
+            [] ( const std::atomic< int > & _count ) {
+                return _count == 1;
+            }
+        )
+    );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( DelayQueueMillionTimers_21_5 )
+{
+    using namespace std::chrono;
+
+    constexpr int elementsCount = 1000000;
+
+    auto pQueue = QueueFactory::createDelayQueue< int >( elementsCount );
+
+    std::vector< int > elements( elementsCount );
+    std::iota( elements.begin(), elements.end(), 0 );
+
+    // Distinct readyAt in a scrambled order, all due within a millisecond
+    const auto offset = [] ( int _element ) {
+        return nanoseconds( std::int64_t( _element ) * 7919 % elementsCount );
+    };
+
+    const auto start = steady_clock::now();
+    for ( int element: elements )
+        pQueue->enqueue( &elements[ element ], start + offset( element ) );
+
+    BOOST_CHECK_EQUAL( pQueue->count(), elementsCount );
+    BOOST_CHECK( pQueue->nextReadyAt() == start );
+
+    std::this_thread::sleep_until( start + milliseconds( 1 ) );
+
+    int * batch[ 1024 ];
+    int dequeuedCount = 0;
+    int misorderedCount = 0;
+    nanoseconds previous( -1 );
+    while ( const std::size_t got = pQueue->tryDequeueBulk( batch, 1024 ) )
+        for ( std::size_t i = 0; i < got; ++i, ++dequeuedCount )
+        {
+            const nanoseconds current = offset( *batch[ i ] );
+            if ( current <= previous )
+                ++misorderedCount;
+            previous = current;
+        }
+
+    BOOST_CHECK_EQUAL( dequeuedCount, elementsCount );
+    BOOST_CHECK_EQUAL( misorderedCount, 0 );
+    BOOST_CHECK_EQUAL( pQueue->count(), 0 );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -6,6 +6,7 @@
 #include "QueueFactory.h"
 
 #include <algorithm>
+#include <atomic>
 #include <set>
 
 /*----------------------------------------------------------------------------*/
@@ -14,6 +15,28 @@ Test plan:
 
 Done    1. More producers less consumers
 Done    2. Less producers more consumers
+Done    3. Lock-free
+Done        3.1. More producers less consumers
+Done        3.2. Less producers more consumers
+Done    4. Bulk producers and consumers through a small queue
+Done        4.1. Standard
+Done        4.2. PImpl
+Done        4.3. Lock-free
+Done    5. Sharded
+Done        5.1. More producers less consumers
+Done        5.2. Less producers more consumers
+Done        5.3. Bulk producers and consumers through a small queue
+Done    6. Priority (plain calls, lowest level)
+Done        6.1. More producers less consumers
+Done        6.2. Bulk producers and consumers through a small queue
+Done    7. Work-stealing deque: no task lost or run twice
+Done        7.1. Owner pushes and pops while thieves steal
+Done        7.2. Ring grows from 2 slots under stealing
+Done        7.3. Owner and thieves race for the last item
+Done    8. Segmented
+Done        8.1. More producers less consumers
+Done        8.2. Less producers more consumers
+Done        8.3. Bulk producers and consumers through a small queue
 
 ------------------------------------------------------------------------------*/
 
@@ -21,18 +44,16 @@ constexpr int g_queueSize = 10000000;
 
 /*----------------------------------------------------------------------------*/
 
-BOOST_AUTO_TEST_SUITE( Test3 )
-
-/*----------------------------------------------------------------------------*/
-
-BOOST_AUTO_TEST_CASE( MoreProducersLessConsumers_1 )
+void testMoreProducersLessConsumers (
+        std::unique_ptr< IQueue< int > > _pQueue
+)
 {
     constexpr int producersCount = 100;
     constexpr int cunsomersCount = producersCount / 2;
     constexpr int elementsToPush = 10000;
     constexpr int elementsToPop = elementsToPush * 2;
 
-    auto pQueue = QueueFactory::createStandardSharedQueue< int >( g_queueSize );
+    auto pQueue = std::move( _pQueue );
 
     std::vector< std::thread > pushers;
     std::vector< std::thread > poppers;
@@ -108,14 +129,16 @@ BOOST_AUTO_TEST_CASE( MoreProducersLessConsumers_1 )
 
 /*----------------------------------------------------------------------------*/
 
-BOOST_AUTO_TEST_CASE( LessProducersMoreConsumers_2 )
+void testLessProducersMoreConsumers (
+        std::unique_ptr< IQueue< int > > _pQueue
+)
 {
     constexpr int producersCount = 50;
     constexpr int cunsomersCount = producersCount * 2;
     constexpr int elementsToPush = 2000;
     constexpr int elementsToPop = elementsToPush / 2;
 
-    auto pQueue = QueueFactory::createStandardSharedQueue< int >( g_queueSize );
+    auto pQueue = std::move( _pQueue );
 
     std::vector< std::thread > pushers;
     std::vector< std::thread > poppers;
@@ -196,4 +219,328 @@ BOOST_AUTO_TEST_CASE( LessProducersMoreConsumers_2 )
 
 /*----------------------------------------------------------------------------*/
 
+void testBulkProducersConsumers (
+        std::unique_ptr< IQueue< int > > _pQueue
+)
+{
+    constexpr int producersCount = 8;
+    constexpr int cunsomersCount = 8;
+    constexpr int elementsToPush = 20000;
+    constexpr std::size_t batchSize = 100;
+    constexpr int totalElements = producersCount * elementsToPush;
+
+    auto pQueue = std::move( _pQueue );
+
+    std::vector< std::thread > pushers;
+    std::vector< std::thread > poppers;
+    std::vector< int > seenCounts( totalElements, 0 );
+    std::atomic< int > poppedCount( 0 );
+    std::mutex seenMutex;
+
+    std::vector< int > pNumbers;
+    for ( int i = 0; i < totalElements; ++i ) {
+        pNumbers.emplace_back( i );
+    }
+
+    for ( int i = 0; i < producersCount; ++i )
+    {
+        pushers.push_back( std::thread (
+            [ &pQueue, &pNumbers, i ] {
+                std::vector< int * > batch;
+                for ( int j = 0; j < elementsToPush; ++j )
+                {
+                    batch.push_back( &pNumbers.at( j + i * elementsToPush ) );
+                    if ( batch.size() == batchSize || j + 1 == elementsToPush )
+                    {
+                        pQueue->enqueueBulk( batch.data(), batch.size() );
+                        batch.clear();
+                    }
+                }
+            } )
+        );
+    }
+
+    for ( int i = 0; i < cunsomersCount; ++i )
+    {
+        poppers.push_back( std::thread (
+            [ &pQueue, &seenCounts, &poppedCount, &seenMutex ] {
+                int * batch[ batchSize ];
+                while ( poppedCount.load() < totalElements )
+                {
+                    const std::size_t got =
+                        pQueue->dequeueBulk( batch, batchSize, 10 );
+                    poppedCount += static_cast< int >( got );
+
+                    std::lock_guard< std::mutex > lck( seenMutex );
+                    for ( std::size_t j = 0; j < got; ++j )
+                        ++seenCounts.at( *batch[ j ] );
+                }
+            } )
+        );
+    }
+
+    for ( auto & thread: pushers )
+        thread.join();
+
+    for ( auto & thread: poppers )
+        thread.join();
+
+    BOOST_CHECK_EQUAL( poppedCount.load(), totalElements );
+    BOOST_CHECK(
+        std::all_of(
+            seenCounts.begin(), seenCounts.end(),
+            [] ( int _count ) { return _count == 1; }
+        )
+    );
+    BOOST_CHECK_EQUAL( pQueue->count(), 0 );
+}
+
+/*----------------------------------------------------------------------------*/
+
+/**
+ * The owner pushes every task, popping one back after every _popEvery pushes
+ * and draining what is left at the end, while the thieves keep stealing
+ * until the owner is done and the deque is empty.
+ */
+void testWorkStealing (
+        std::size_t _initialCapacity
+    ,   int _popEvery
+)
+{
+    constexpr int thievesCount = 4;
+    constexpr int tasksCount = 1000000;
+
+    auto pDeque =
+        QueueFactory::createWorkStealingDeque< int >( _initialCapacity );
+
+    std::vector< int > tasks( tasksCount );
+    for ( int i = 0; i < tasksCount; ++i )
+        tasks[ i ] = i;
+
+    std::vector< std::atomic< int > > runCounts( tasksCount );
+    std::atomic< bool > ownerDone( false );
+    std::atomic< int > stolenCount( 0 );
+
+    std::vector< std::thread > thieves;
+    for ( int i = 0; i < thievesCount; ++i )
+    {
+        thieves.push_back( std::thread (
+            [ & ] {
+                while ( !ownerDone.load() || !pDeque->empty() )
+                {
+                    if ( int * pTask = pDeque->steal() )
+                    {
+                        ++runCounts.at( *pTask );
+                        ++stolenCount;
+                    }
+                }
+            } )
+        );
+    }
+
+    int poppedCount = 0;
+    for ( int i = 0; i < tasksCount; ++i )
+    {
+        pDeque->push( &tasks[ i ] );
+
+        if ( ( i + 1 ) % _popEvery == 0 )
+        {
+            if ( int * pTask = pDeque->pop() )
+            {
+                ++runCounts.at( *pTask );
+                ++poppedCount;
+            }
+        }
+    }
+
+    while ( int * pTask = pDeque->pop() )
+    {
+        ++runCounts.at( *pTask );
+        ++poppedCount;
+    }
+    ownerDone.store( true );
+
+    for ( auto & thread: thieves )
+        thread.join();
+
+    BOOST_CHECK_EQUAL( poppedCount + stolenCount.load(), tasksCount );
+    BOOST_CHECK(
+        std::all_of(
+            runCounts.begin(), runCounts.end(),
+            [] ( const std::atomic< int > & _count ) { return _count == 1; }
+        )
+    );
+    BOOST_CHECK( pDeque->empty() );
+    BOOST_TEST_MESSAGE(
+            "Popped by the owner: " << poppedCount
+        <<  ", stolen: " << stolenCount.load()
+    );
+}
+
+/*----------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------*/
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_SUITE( Test3 )
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( MoreProducersLessConsumers_1 )
+{
+    testMoreProducersLessConsumers(
+        QueueFactory::createStandardSharedQueue< int >( g_queueSize )
+    );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( LessProducersMoreConsumers_2 )
+{
+    testLessProducersMoreConsumers(
+        QueueFactory::createStandardSharedQueue< int >( g_queueSize )
+    );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( LockFree__MoreProducersLessConsumers_3_1 )
+{
+    testMoreProducersLessConsumers(
+        QueueFactory::createLockFreeQueue< int >( g_queueSize )
+    );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( LockFree__LessProducersMoreConsumers_3_2 )
+{
+    testLessProducersMoreConsumers(
+        QueueFactory::createLockFreeQueue< int >( g_queueSize )
+    );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( Bulk__Standard_4_1 )
+{
+    testBulkProducersConsumers(
+        QueueFactory::createStandardSharedQueue< int >( 1000 )
+    );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( Bulk__PImpl_4_2 )
+{
+    testBulkProducersConsumers(
+        QueueFactory::createSharedQueueWithPImpl< int >( 1000 )
+    );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( Bulk__LockFree_4_3 )
+{
+    testBulkProducersConsumers(
+        QueueFactory::createLockFreeQueue< int >( 1000 )
+    );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( Sharded__MoreProducersLessConsumers_5_1 )
+{
+    testMoreProducersLessConsumers(
+        QueueFactory::createShardedQueue< int >( g_queueSize )
+    );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( Sharded__LessProducersMoreConsumers_5_2 )
+{
+    testLessProducersMoreConsumers(
+        QueueFactory::createShardedQueue< int >( g_queueSize )
+    );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( Sharded__Bulk_5_3 )
+{
+    testBulkProducersConsumers(
+        QueueFactory::createShardedQueue< int >( 1000 )
+    );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( Priority__MoreProducersLessConsumers_6_1 )
+{
+    testMoreProducersLessConsumers(
+        QueueFactory::createPriorityQueue< int >( g_queueSize, 8 )
+    );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( Priority__Bulk_6_2 )
+{
+    testBulkProducersConsumers(
+        QueueFactory::createPriorityQueue< int >( 1000, 8 )
+    );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( WorkStealing__OwnerAndThieves_7_1 )
+{
+    testWorkStealing( 1 << 20, 4 );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( WorkStealing__Growth_7_2 )
+{
+    testWorkStealing( 2, 4 );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( WorkStealing__LastItemRace_7_3 )
+{
+    // Every push is popped straight back, so the deque mostly holds
+    // zero or one item and the owner meets the thieves on almost every pop
+    testWorkStealing( 2, 1 );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( Segmented__MoreProducersLessConsumers_8_1 )
+{
+    testMoreProducersLessConsumers(
+        QueueFactory::createSegmentedQueue< int >( g_queueSize )
+    );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( Segmented__LessProducersMoreConsumers_8_2 )
+{
+    testLessProducersMoreConsumers(
+        QueueFactory::createSegmentedQueue< int >( g_queueSize )
+    );
+}
+
+/*----------------------------------------------------------------------------*/
+
+BOOST_AUTO_TEST_CASE( Segmented__Bulk_8_3 )
+{
+    testBulkProducersConsumers(
+        QueueFactory::createSegmentedQueue< int >( 1000 )
+    );
+}
+
+/*----------------------------------------------------------------------------*/
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file